@@ -1,5 +1,7 @@
 C:/VulkanSDK/1.2.154.1/Bin32/glslc.exe shader.vert -o vert.spv
 C:/VulkanSDK/1.2.154.1/Bin32/glslc.exe shader.frag -o frag.spv
+C:/VulkanSDK/1.2.154.1/Bin32/glslc.exe depth_only.vert -o depth_only.spv
 C:/VulkanSDK/1.2.154.1/Bin32/glslc.exe indirect_cull.comp  -o indirect_cull.spv
+C:/VulkanSDK/1.2.154.1/Bin32/glslc.exe cluster_cull.comp  -o cluster_cull.spv
 C:/VulkanSDK/1.2.154.1/Bin32/glslc.exe depth_pyramid.comp  -o depth_pyramid.spv
 pause
\ No newline at end of file
@@ -0,0 +1,37 @@
+#version 430
+
+// Vertex shader of the depth pre-pass. Only reads the position stream of the packed vertices (see leoscene::PackedVertexPosition).
+// The position computation must stay the same as in shader.vert, so that the forward pass gets the exact same depth.
+
+layout (location = 0) in vec4 inPosition;  // Normalized in the bounding box of the mesh (see ObjectData). w is unused.
+
+invariant gl_Position;
+
+layout(set = 0, binding = 0) uniform UniformBufferObject {
+	mat4 view;
+    mat4 proj;
+    mat4 viewProj;
+    mat4 invProj;
+} camera;
+
+layout (set = 0, binding = 2) buffer IndexMap {
+	uint map[];
+} objectDataIndices;
+
+struct ObjectData{
+	mat4 model;
+	vec4 sphereBounds;  // World space
+	vec4 boxCenter;  // Object space bounding box
+	vec4 boxExtents;
+};
+
+layout(set = 1, binding = 0) readonly buffer ObjectBuffer{
+	ObjectData objects[];
+} objectBuffer;
+
+void main() {
+	uint dataIndex = objectDataIndices.map[gl_InstanceIndex];
+	ObjectData object = objectBuffer.objects[dataIndex];
+	vec4 position = vec4(object.boxCenter.xyz + (inPosition.xyz * 2.0 - 1.0) * object.boxExtents.xyz, 1.0);
+	gl_Position = camera.viewProj * object.model * position;
+}
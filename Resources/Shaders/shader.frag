@@ -19,13 +19,43 @@ layout(set = 0, binding = 3) uniform MiscDynamicData {
 	bool occlusionCulling;
 } misc;
 
-// Material
-layout(set = 2, binding = 0) uniform sampler2D diffuseTexture;
-layout(set = 2, binding = 1) uniform sampler2D specularTexture;
-layout(set = 2, binding = 2) uniform sampler2D ambientTexture;
-layout(set = 2, binding = 3) uniform sampler2D normalTexture;
-layout(set = 2, binding = 4) uniform sampler2D heightTexture;
+// Finest level of detail sampled in the textures of each material during the frame (see leoscene::TextureResidency).
+// Reset to 0xFFFFFFFF before each frame and read back by the renderer, which streams the levels of the textures.
+layout(std430, set = 0, binding = 4) buffer TextureFeedback {
+	uint finestLevels[];
+} textureFeedback;
+
+// Material. All the textures are sampled with the immutable sampler of the set layout (see MaterialBuilder).
+layout(set = 2, binding = 0) uniform texture2D diffuseTexture;
+layout(set = 2, binding = 1) uniform texture2D specularTexture;
+layout(set = 2, binding = 2) uniform texture2D ambientTexture;
+layout(set = 2, binding = 3) uniform texture2D normalTexture;
+layout(set = 2, binding = 4) uniform texture2D heightTexture;
+layout(set = 2, binding = 5) uniform sampler materialSampler;
+
+layout(push_constant) uniform MaterialConstants {
+	uint feedbackSlot;  // Entry of the material in the texture feedback buffer
+} materialConstants;
+
+// Level of detail in a texture of 2^16 texels (leoscene::TextureResidency::FEEDBACK_LOD_BIAS)
+const float FEEDBACK_LOD_BIAS = 16.0;
+
+void writeTextureFeedback() {
+	// The level of detail of the resident levels, relative to their finest level, minus the log2 of its size, does not depend on the
+	// levels that are resident: it is the level of detail in a texture of size 1. All the textures of the material share the UVs.
+	ivec2 residentSize = textureSize(sampler2D(diffuseTexture, materialSampler), 0);
+	float lod = textureQueryLod(sampler2D(diffuseTexture, materialSampler), fragTexCoord).y - log2(float(max(residentSize.x, residentSize.y)));
+	uint level = uint(clamp(floor(lod + FEEDBACK_LOD_BIAS), 0.0, 31.0));
+	if (level < textureFeedback.finestLevels[materialConstants.feedbackSlot]) {
+		atomicMin(textureFeedback.finestLevels[materialConstants.feedbackSlot], level);
+	}
+}
 
 void main() {
-	outColor = texture(diffuseTexture, fragTexCoord) * misc.forcedColoring;
+	// One fragment in 8x8 is enough to know the levels sampled by a material, and keeps the atomics rare
+	if ((uint(gl_FragCoord.x) & 7u) == 0u && (uint(gl_FragCoord.y) & 7u) == 0u) {
+		writeTextureFeedback();
+	}
+
+	outColor = texture(sampler2D(diffuseTexture, materialSampler), fragTexCoord) * misc.forcedColoring;
 }
\ No newline at end of file
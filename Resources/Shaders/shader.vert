@@ -1,12 +1,20 @@
 #version 430
 
-layout (location = 0) in vec3 inPosition;
-layout (location = 1) in vec3 inNormal;
-layout (location = 2) in vec2 inTexCoord;
+// Packed vertex, position stream (see leoscene::PackedVertexPosition)
+layout (location = 0) in vec4 inPosition;  // Normalized in the bounding box of the mesh (see ObjectData). w is unused.
+
+// Packed vertex, attribute stream (see leoscene::PackedVertexAttributes)
+layout (location = 1) in vec2 inNormal;  // Octahedral encoding
+layout (location = 2) in vec2 inTangent;  // Octahedral encoding
+layout (location = 3) in vec2 inTexCoord;
 
 layout (location = 0) out vec3 fragNormal;
 layout (location = 1) out vec2 fragTexCoord;
 layout (location = 2) out vec3 fragCoord;
+layout (location = 3) out vec3 fragTangent;
+
+// Same depth as the depth-only pass (see depth_only.vert)
+invariant gl_Position;
 
 layout(set = 0, binding = 0) uniform UniformBufferObject {
 	mat4 view;
@@ -21,17 +29,30 @@ layout (set = 0, binding = 2) buffer IndexMap {
 
 struct ObjectData{
 	mat4 model;
-	vec4 sphereBounds;
+	vec4 sphereBounds;  // World space
+	vec4 boxCenter;  // Object space bounding box
+	vec4 boxExtents;
 };
 
 layout(set = 1, binding = 0) readonly buffer ObjectBuffer{
 	ObjectData objects[];
 } objectBuffer;
 
+vec3 decodeOctahedral(vec2 encoded) {
+	vec3 direction = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+	if (direction.z < 0) {
+		direction.xy = (1.0 - abs(direction.yx)) * vec2(direction.x >= 0 ? 1.0 : -1.0, direction.y >= 0 ? 1.0 : -1.0);
+	}
+	return normalize(direction);
+}
+
 void main() {
 	uint dataIndex = objectDataIndices.map[gl_InstanceIndex];
-	gl_Position = camera.viewProj * objectBuffer.objects[dataIndex].model * vec4(inPosition, 1.0);
-    fragNormal = inNormal;  // NOTE: Not used for now
+	ObjectData object = objectBuffer.objects[dataIndex];
+	vec4 position = vec4(object.boxCenter.xyz + (inPosition.xyz * 2.0 - 1.0) * object.boxExtents.xyz, 1.0);
+	gl_Position = camera.viewProj * object.model * position;
+    fragNormal = decodeOctahedral(inNormal);  // NOTE: Not used for now
+    fragTangent = decodeOctahedral(inTangent);  // NOTE: Not used for now
 	fragTexCoord = vec2(inTexCoord.x, 1.0 - inTexCoord.y);
-	fragCoord = vec3(objectBuffer.objects[dataIndex].model * vec4(inPosition, 1.0));
+	fragCoord = vec3(object.model * position);
 }
\ No newline at end of file
@@ -12,18 +12,22 @@
 #include "DebugUtils.h"
 #include "Window.h"
 
+const float Application::_ANIMATION_AMPLITUDE = 1.f;
+const float Application::_ANIMATION_PERIOD = 2.f;
+
 Application::Application()
 {
     _window = std::make_unique<Window>(1600, 1200);
     _vulkan = std::make_unique<VulkanInstance>();
     _inputManager = std::make_unique<InputManager>();
     _state = std::make_unique<ApplicationState>();
+    _sceneStreamer = std::make_unique<SceneStreamer>();
     _camera = std::make_unique<leoscene::Camera>(glm::vec3(0, -3, 0), glm::vec3(1, 0, 0), glm::vec3(0, -1, 0), glm::radians(90.f));
 }
 
 Application::~Application() = default;
 
-int Application::init()
+int Application::init(const VulkanRenderer::Options& rendererOptions)
 {
     if (_window->init()) {
         std::cerr << "Error: Failed to create window." << std::endl;
@@ -42,7 +46,7 @@ int Application::init()
         return -1;
     }
 
-    _renderer = std::make_unique<VulkanRenderer>(_vulkan.get(), _state.get(), _camera.get());
+    _renderer = std::make_unique<VulkanRenderer>(_vulkan.get(), _state.get(), _camera.get(), rendererOptions);
 
     try {
         _renderer->init();
@@ -58,17 +62,18 @@ int Application::init()
 
 void Application::cleanup()
 {
+    _sceneStreamer->stop();
     _renderer->cleanup();
     _vulkan->cleanup();
 }
 
-int Application::loadScene(const std::string& filePath)
+int Application::loadScene(const std::string& filePath, const leoscene::SceneLoader::LoadingOptions& loadingOptions)
 {
     leoscene::Scene scene;
     leoscene::SceneLoader sceneLoader;
 
     try {
-        sceneLoader.loadScene(filePath.c_str(), &scene, _camera.get());
+        sceneLoader.loadScene(filePath.c_str(), &scene, _camera.get(), loadingOptions);
     }
     catch (leoscene::SceneLoaderException e) {
         std::cerr << e.what() << std::endl;
@@ -76,7 +81,8 @@ int Application::loadScene(const std::string& filePath)
     }
 
     try {
-        _renderer->loadSceneToDevice(&scene);
+        uint32_t firstObject = _renderer->loadSceneToDevice({ &scene });
+        _addSceneNodes(scene, firstObject);
     }
     catch (VulkanRendererException e) {
         std::cerr << e.what() << std::endl;
@@ -86,10 +92,25 @@ int Application::loadScene(const std::string& filePath)
     return 0;
 }
 
+int Application::streamScene(const std::string& filePath, const leoscene::SceneLoader::LoadingOptions& loadingOptions)
+{
+    _sceneStreamer->start(filePath, *_camera, loadingOptions);
+    _isStreamingScene = true;
+    _nbStreamedObjects = 0;
+    _streamingStartTime = std::chrono::steady_clock::now();
+
+    return 0;
+}
+
 int Application::start()
 {
     try {
         while (_inputManager->processInput()) {
+            if (_isStreamingScene && _updateStreamedScene()) {
+                return -1;
+            }
+            _animateObjects();
+            _updateSceneGraph();
             _renderer->drawFrame();
         }
     } catch (const VulkanRendererException& e) {
@@ -99,3 +120,96 @@ int Application::start()
 
     return 0;
 }
+
+leoscene::SceneGraph& Application::getSceneGraph()
+{
+    return _sceneGraph;
+}
+
+void Application::_addSceneNodes(const leoscene::Scene& scene, uint32_t firstObject)
+{
+    // The HLOD proxies do not follow the objects that move, so they get no node
+    std::vector<bool> isProxy(scene.getNbObjects(), false);
+    for (const leoscene::HlodCluster& cluster : scene.hlodClusters) {
+        isProxy[cluster.proxyObject] = true;
+    }
+
+    uint32_t rootNode = _sceneGraph.addNode(glm::mat4(1), leoscene::SceneGraph::NO_NODE, leoscene::SceneGraph::NO_OBJECT, false);
+    _sceneRootNodes.push_back(rootNode);
+    for (size_t i = 0; i < scene.getNbObjects(); ++i) {
+        if (!isProxy[i]) {
+            _sceneGraph.addNode(scene.worldMatrices[i], rootNode, firstObject + static_cast<uint32_t>(i), false);
+        }
+    }
+}
+
+void Application::_animateObjects()
+{
+    if (!_state->animateObjects && !_isAnimatingObjects) {
+        return;
+    }
+
+    if (!_isAnimatingObjects) {
+        _animationStartTime = std::chrono::steady_clock::now();
+    }
+    float seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - _animationStartTime).count();
+
+    for (size_t i = 0; i < _sceneRootNodes.size(); ++i) {
+        glm::mat4 rootMatrix(1);
+        if (_state->animateObjects) {
+            // Shifted for each scene so that they do not all move together
+            float height = _ANIMATION_AMPLITUDE * sinf(2.f * static_cast<float>(M_PI) * seconds / _ANIMATION_PERIOD + static_cast<float>(i));
+            rootMatrix = glm::translate(glm::mat4(1), glm::vec3(0, height, 0));
+        }
+        _sceneGraph.setLocalMatrix(_sceneRootNodes[i], rootMatrix);
+    }
+    _isAnimatingObjects = _state->animateObjects;
+}
+
+void Application::_updateSceneGraph()
+{
+    if (!_sceneGraph.hasChanges()) {
+        return;
+    }
+
+    _changedObjects.clear();
+    _changedMatrices.clear();
+    _sceneGraph.update(_changedObjects, _changedMatrices);
+    _renderer->updateObjectMatrices(_changedObjects.data(), _changedMatrices.data(), _changedObjects.size());
+}
+
+int Application::_updateStreamedScene()
+{
+    std::vector<std::unique_ptr<leoscene::Scene>> chunks;
+    _isStreamingScene = _sceneStreamer->takeChunks(chunks, *_camera);
+
+    // The chunks loaded since the previous frame are uploaded together
+    std::vector<const leoscene::Scene*> newChunks;
+    for (const std::unique_ptr<leoscene::Scene>& chunk : chunks) {
+        newChunks.push_back(chunk.get());
+        _nbStreamedObjects += chunk->getNbObjects();
+    }
+    if (newChunks.size()) {
+        // The objects of the chunks are numbered one chunk after another
+        uint32_t firstObject = _renderer->loadSceneToDevice(newChunks);
+        for (const leoscene::Scene* chunk : newChunks) {
+            _addSceneNodes(*chunk, firstObject);
+            firstObject += static_cast<uint32_t>(chunk->getNbObjects());
+        }
+    }
+
+    if (!_isStreamingScene) {
+        if (_sceneStreamer->hasFailed()) {
+            std::cerr << "Error: Scene loading failed. " << _sceneStreamer->getErrorMessage() << std::endl;
+            return -1;
+        }
+        if (!_nbStreamedObjects) {
+            std::cerr << "Error: The scene does not contain any objects!" << std::endl;
+            return -1;
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - _streamingStartTime).count();
+        std::cout << "Scene loaded: " << _nbStreamedObjects << " objects in " << seconds << " s" << std::endl;
+    }
+
+    return 0;
+}
@@ -1,11 +1,16 @@
 #pragma once
 
+#include <chrono>
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 #include <scene/Camera.h>
+#include <scene/SceneGraph.h>
+#include <scene/SceneLoader.h>
 
 #include "InputManager.h"
+#include "SceneStreamer.h"
 #include "VulkanInstance.h"
 #include "VulkanRenderer.h"
 
@@ -24,6 +29,11 @@ struct ApplicationState
 	bool occlusionCulling = true;
 	bool makeAllObjectsTransparent = false;
 	bool lockCullingCamera = false;
+	bool depthPrepass = false;
+	bool lodSelection = true;
+	bool clusterCulling = true;
+	bool hlodSelection = true;
+	bool animateObjects = false;
 };
 
 /*
@@ -36,11 +46,30 @@ public:
 	~Application();
 
 public:
-	int init();
-	int loadScene(const std::string& filePath);
+	int init(const VulkanRenderer::Options& rendererOptions = {});
+	int loadScene(const std::string& filePath, const leoscene::SceneLoader::LoadingOptions& loadingOptions = {});
+
+	// Loads the scene in the background while the application runs. Objects show up as soon as they are loaded.
+	int streamScene(const std::string& filePath, const leoscene::SceneLoader::LoadingOptions& loadingOptions = {});
+
 	int start();
 	void cleanup();
 
+	// Hierarchy of the loaded objects, with a root node for each loaded scene. Its changes are sent to the renderer before each frame.
+	leoscene::SceneGraph& getSceneGraph();
+
+private:
+	int _updateStreamedScene();
+
+	// Adds a root node for the scene, with a child node for each of its objects. The objects keep their world matrix
+	// as local matrix, so they are not uploaded again until their root moves.
+	void _addSceneNodes(const leoscene::Scene& scene, uint32_t firstObject);
+
+	// Moves the root nodes of the loaded scenes up and down while the animation is enabled, and puts them back when it stops.
+	void _animateObjects();
+
+	void _updateSceneGraph();
+
 private:
 	std::unique_ptr<VulkanRenderer> _renderer;
 	std::unique_ptr<InputManager> _inputManager;
@@ -48,5 +77,19 @@ private:
 	std::unique_ptr<leoscene::Camera> _camera;
 	std::unique_ptr<Window> _window;
 	std::unique_ptr<ApplicationState> _state;
+	std::unique_ptr<SceneStreamer> _sceneStreamer;
+	bool _isStreamingScene = false;
+	size_t _nbStreamedObjects = 0;
+	std::chrono::steady_clock::time_point _streamingStartTime;
+	leoscene::SceneGraph _sceneGraph;
+	std::vector<uint32_t> _sceneRootNodes;  // One for each loaded scene or streamed chunk
+	bool _isAnimatingObjects = false;
+	std::chrono::steady_clock::time_point _animationStartTime;
+	std::vector<uint32_t> _changedObjects;
+	std::vector<glm::mat4> _changedMatrices;
+
+private:
+	static const float _ANIMATION_AMPLITUDE;
+	static const float _ANIMATION_PERIOD;
 };
 
@@ -1,5 +1,7 @@
 #include "DescriptorUtils.h"
 
+#include "DebugUtils.h"
+
 #include <algorithm>
 
 DescriptorAllocator::DescriptorAllocator(VkDevice device) :
@@ -137,6 +139,12 @@ VkDescriptorSetLayout DescriptorLayoutCache::createDescriptorLayout(const VkDesc
 	std::sort(key.bindings.begin(), key.bindings.end(), [](VkDescriptorSetLayoutBinding& a, VkDescriptorSetLayoutBinding& b) {
 		return a.binding < b.binding;
 		});
+	for (VkDescriptorSetLayoutBinding& binding : key.bindings) {
+		if (binding.pImmutableSamplers) {
+			key.immutableSamplers.insert(key.immutableSamplers.end(), binding.pImmutableSamplers, binding.pImmutableSamplers + binding.descriptorCount);
+			binding.pImmutableSamplers = nullptr;
+		}
+	}
 	if (_cache.find(key) == _cache.end()) {
 		VkDescriptorSetLayout newLayout = VK_NULL_HANDLE;
 		if (vkCreateDescriptorSetLayout(_device, &info, nullptr, &newLayout)) {
@@ -168,7 +176,8 @@ bool DescriptorLayoutCache::DescriptorLayoutInfo::operator==(const DescriptorLay
 		}
 	}
 
-	return true;
+	// Layouts with the same bindings but different immutable samplers are different layouts
+	return immutableSamplers == other.immutableSamplers;
 }
 
 size_t DescriptorLayoutCache::DescriptorLayoutInfo::hash() const
@@ -184,6 +193,90 @@ size_t DescriptorLayoutCache::DescriptorLayoutInfo::hash() const
 		result ^= std::hash<std::size_t>()(binding_hash);
 	}
 
+	for (VkSampler sampler : immutableSamplers) {
+		result ^= std::hash<VkSampler>()(sampler);
+	}
+
+	return result;
+}
+
+SamplerCache::SamplerCache(VkDevice device) :
+	_device(device)
+{
+}
+
+void SamplerCache::cleanup()
+{
+	for (auto& entry : _cache) {
+		vkDestroySampler(_device, entry.second, nullptr);
+	}
+
+	_cache.clear();
+}
+
+VkSampler SamplerCache::getSampler(const VkSamplerCreateInfo& info)
+{
+	SamplerInfo key;
+	key.createInfo = info;
+	key.createInfo.pNext = nullptr;
+	for (const VkBaseInStructure* next = static_cast<const VkBaseInStructure*>(info.pNext); next; next = next->pNext) {
+		if (next->sType != VK_STRUCTURE_TYPE_SAMPLER_REDUCTION_MODE_CREATE_INFO) {
+			throw VulkanRendererException("Sampler parameters not supported by the sampler cache.");
+		}
+		key.reductionMode = reinterpret_cast<const VkSamplerReductionModeCreateInfo*>(next)->reductionMode;
+	}
+
+	auto it = _cache.find(key);
+	if (it == _cache.end()) {
+		VkSampler newSampler = VK_NULL_HANDLE;
+		VK_CHECK(vkCreateSampler(_device, &info, nullptr, &newSampler));
+		it = _cache.emplace(key, newSampler).first;
+	}
+	return it->second;
+}
+
+std::size_t SamplerCache::_SamplerHash::operator()(const SamplerInfo& k) const
+{
+	return k.hash();
+}
+
+bool SamplerCache::SamplerInfo::operator==(const SamplerInfo& other) const
+{
+	// Field by field, since the structure has padding
+	const VkSamplerCreateInfo& a = createInfo;
+	const VkSamplerCreateInfo& b = other.createInfo;
+	return a.flags == b.flags &&
+		a.magFilter == b.magFilter &&
+		a.minFilter == b.minFilter &&
+		a.mipmapMode == b.mipmapMode &&
+		a.addressModeU == b.addressModeU &&
+		a.addressModeV == b.addressModeV &&
+		a.addressModeW == b.addressModeW &&
+		a.mipLodBias == b.mipLodBias &&
+		a.anisotropyEnable == b.anisotropyEnable &&
+		a.maxAnisotropy == b.maxAnisotropy &&
+		a.compareEnable == b.compareEnable &&
+		a.compareOp == b.compareOp &&
+		a.minLod == b.minLod &&
+		a.maxLod == b.maxLod &&
+		a.borderColor == b.borderColor &&
+		a.unnormalizedCoordinates == b.unnormalizedCoordinates &&
+		reductionMode == other.reductionMode;
+}
+
+size_t SamplerCache::SamplerInfo::hash() const
+{
+	// Pack the enums into a single int64, then mix in the floats. Samplers are few, collisions do not matter much.
+	const VkSamplerCreateInfo& info = createInfo;
+	std::size_t packed = info.magFilter | info.minFilter << 2 | info.mipmapMode << 4 | info.addressModeU << 6 | info.addressModeV << 9 |
+		info.addressModeW << 12 | info.anisotropyEnable << 15 | info.compareEnable << 16 | info.compareOp << 17 | info.borderColor << 20 |
+		info.unnormalizedCoordinates << 23 | reductionMode << 24 | static_cast<std::size_t>(info.flags) << 32;
+
+	std::size_t result = std::hash<std::size_t>()(packed);
+	for (float value : { info.mipLodBias, info.maxAnisotropy, info.minLod, info.maxLod }) {
+		result ^= std::hash<float>()(value) + 0x9e3779b9 + (result << 6) + (result >> 2);
+	}
+
 	return result;
 }
 
@@ -242,6 +335,20 @@ DescriptorBuilder& DescriptorBuilder::bindImage(uint32_t binding, VkDescriptorIm
 	return *this;
 }
 
+DescriptorBuilder& DescriptorBuilder::bindImmutableSamplers(uint32_t binding, const VkSampler* samplers, uint32_t nbSamplers, VkShaderStageFlags stageFlags)
+{
+	VkDescriptorSetLayoutBinding newBinding = {};
+
+	newBinding.descriptorCount = nbSamplers;
+	newBinding.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+	newBinding.pImmutableSamplers = samplers;
+	newBinding.stageFlags = stageFlags;
+	newBinding.binding = binding;
+
+	_bindings.push_back(newBinding);
+	return *this;
+}
+
 bool DescriptorBuilder::build(VkDescriptorSet& set, VkDescriptorSetLayout& layout)
 {
 	//build layout first
@@ -43,7 +43,8 @@ public:
 	VkDescriptorSetLayout createDescriptorLayout(const VkDescriptorSetLayoutCreateInfo& info);
 
 	struct DescriptorLayoutInfo {
-		std::vector<VkDescriptorSetLayoutBinding> bindings;
+		std::vector<VkDescriptorSetLayoutBinding> bindings;  // The immutable samplers are not pointed at
+		std::vector<VkSampler> immutableSamplers;  // Of all the bindings, in the order of the bindings
 
 		// Necessary for hashing
 		bool operator==(const DescriptorLayoutInfo& other) const;
@@ -60,6 +61,34 @@ private:
 	VkDevice _device;
 };
 
+// Samplers created once for each set of parameters, and shared by all their users until cleanup
+class SamplerCache {
+public:
+	SamplerCache(VkDevice device);
+	void cleanup();
+
+	// The only structure supported in the pNext chain of info is VkSamplerReductionModeCreateInfo.
+	// Throws a VulkanRendererException when the sampler cannot be created, so that callers never get VK_NULL_HANDLE.
+	VkSampler getSampler(const VkSamplerCreateInfo& info);
+
+	struct SamplerInfo {
+		VkSamplerCreateInfo createInfo = {};  // Without pNext chain
+		VkSamplerReductionMode reductionMode = VK_SAMPLER_REDUCTION_MODE_WEIGHTED_AVERAGE;
+
+		// Necessary for hashing
+		bool operator==(const SamplerInfo& other) const;
+		size_t hash() const;
+	};
+
+private:
+	struct _SamplerHash {
+		std::size_t operator()(const SamplerInfo& k) const;
+	};
+
+	std::unordered_map<SamplerInfo, VkSampler, _SamplerHash> _cache;
+	VkDevice _device;
+};
+
 class DescriptorBuilder {
 public:
 	static DescriptorBuilder begin(VkDevice device, DescriptorLayoutCache& layoutCache, DescriptorAllocator& allocator);
@@ -67,6 +96,9 @@ public:
 	DescriptorBuilder& bindBuffer(uint32_t binding, VkDescriptorBufferInfo& bufferInfo, VkDescriptorType type, VkShaderStageFlags stageFlags);
 	DescriptorBuilder& bindImage(uint32_t binding, VkDescriptorImageInfo& imageInfo, VkDescriptorType type, VkShaderStageFlags stageFlags);
 
+	// Sampler binding whose samplers are part of the layout, so nothing is written in the set. The samplers are read by build.
+	DescriptorBuilder& bindImmutableSamplers(uint32_t binding, const VkSampler* samplers, uint32_t nbSamplers, VkShaderStageFlags stageFlags);
+
 	bool build(VkDescriptorSet& set, VkDescriptorSetLayout& layout);
 	bool build(VkDescriptorSet& set);
 
@@ -77,6 +77,41 @@ bool InputManager::processInput()
         _updateApplicationState(ApplicationToggle::LOCK_FRUSTUM_CULLING_CAMERA);
     }
 
+    if (glfwGetKey(_window, GLFW_KEY_P) == GLFW_PRESS && !_pPressed)
+        _pPressed = true;
+    else if (glfwGetKey(_window, GLFW_KEY_P) == GLFW_RELEASE && _pPressed) {
+        _pPressed = false;
+        _updateApplicationState(ApplicationToggle::DEPTH_PREPASS);
+    }
+
+    if (glfwGetKey(_window, GLFW_KEY_K) == GLFW_PRESS && !_kPressed)
+        _kPressed = true;
+    else if (glfwGetKey(_window, GLFW_KEY_K) == GLFW_RELEASE && _kPressed) {
+        _kPressed = false;
+        _updateApplicationState(ApplicationToggle::LOD_SELECTION);
+    }
+
+    if (glfwGetKey(_window, GLFW_KEY_C) == GLFW_PRESS && !_cPressed)
+        _cPressed = true;
+    else if (glfwGetKey(_window, GLFW_KEY_C) == GLFW_RELEASE && _cPressed) {
+        _cPressed = false;
+        _updateApplicationState(ApplicationToggle::CLUSTER_CULLING);
+    }
+
+    if (glfwGetKey(_window, GLFW_KEY_H) == GLFW_PRESS && !_hPressed)
+        _hPressed = true;
+    else if (glfwGetKey(_window, GLFW_KEY_H) == GLFW_RELEASE && _hPressed) {
+        _hPressed = false;
+        _updateApplicationState(ApplicationToggle::HLOD_SELECTION);
+    }
+
+    if (glfwGetKey(_window, GLFW_KEY_M) == GLFW_PRESS && !_mPressed)
+        _mPressed = true;
+    else if (glfwGetKey(_window, GLFW_KEY_M) == GLFW_RELEASE && _mPressed) {
+        _mPressed = false;
+        _updateApplicationState(ApplicationToggle::OBJECTS_ANIMATION);
+    }
+
     // Closing window if needed
     return !(glfwGetKey(_window, GLFW_KEY_ESCAPE) == GLFW_PRESS || glfwWindowShouldClose(_window));
 }
@@ -146,6 +181,21 @@ void InputManager::_updateApplicationState(ApplicationToggle toggle)
     case ApplicationToggle::LOCK_FRUSTUM_CULLING_CAMERA:
         _applicationState->lockCullingCamera = !_applicationState->lockCullingCamera;
         break;
+    case ApplicationToggle::DEPTH_PREPASS:
+        _applicationState->depthPrepass = !_applicationState->depthPrepass;
+        break;
+    case ApplicationToggle::LOD_SELECTION:
+        _applicationState->lodSelection = !_applicationState->lodSelection;
+        break;
+    case ApplicationToggle::CLUSTER_CULLING:
+        _applicationState->clusterCulling = !_applicationState->clusterCulling;
+        break;
+    case ApplicationToggle::HLOD_SELECTION:
+        _applicationState->hlodSelection = !_applicationState->hlodSelection;
+        break;
+    case ApplicationToggle::OBJECTS_ANIMATION:
+        _applicationState->animateObjects = !_applicationState->animateObjects;
+        break;
     }
 }
 
@@ -27,7 +27,12 @@ private:
 		FRUSTUM_CULLING,
 		OCCLUSION_CULLING,
 		MAKE_ALL_OBJECTS_TRANSPARENT,
-		LOCK_FRUSTUM_CULLING_CAMERA
+		LOCK_FRUSTUM_CULLING_CAMERA,
+		DEPTH_PREPASS,
+		LOD_SELECTION,
+		CLUSTER_CULLING,
+		HLOD_SELECTION,
+		OBJECTS_ANIMATION
 	};
 
 public:
@@ -57,6 +62,11 @@ private:
 	bool _fPressed = false;
 	bool _tPressed = false;
 	bool _lPressed = false;
+	bool _pPressed = false;
+	bool _kPressed = false;
+	bool _cPressed = false;
+	bool _hPressed = false;
+	bool _mPressed = false;
 
 private:
 	static const float _MOVEMENT_SPEED;
@@ -2,17 +2,14 @@
 
 #include "VulkanInstance.h"
 
-#include <scene/Vertex.h>
-
-#include <cstddef>
-
 MaterialBuilder::MaterialBuilder(VkDevice device, const VulkanInstance* instance)
 	: _device(device), _vulkan(instance), _shaderBuilder(_device), _descriptorAllocator(_device), _globalDescriptorLayoutCache(_device)
 {
 	DescriptorAllocator::Options descriptorAllocatorOptions = {};
 	descriptorAllocatorOptions.poolBaseSize = 10;
 	descriptorAllocatorOptions.poolSizes = {
-		{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 5.f },
+		{ VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 5.f },
+		{ VK_DESCRIPTOR_TYPE_SAMPLER, 1.f },
 	};
 	_descriptorAllocator.init(descriptorAllocatorOptions);
 }
@@ -29,29 +26,8 @@ void MaterialBuilder::init(Parameters parameters)
 
 	// Forward pipeline
 
-	VkVertexInputBindingDescription bindingDescription = {};
-	bindingDescription.binding = 0;
-	bindingDescription.stride = sizeof(leoscene::Vertex);
-	bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-
-	std::array<VkVertexInputAttributeDescription, 3> attributeDescriptions{};
-
-	attributeDescriptions[0].binding = 0;
-	attributeDescriptions[0].location = 0;
-	attributeDescriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
-	attributeDescriptions[0].offset = offsetof(leoscene::Vertex, position);
-
-	attributeDescriptions[1].binding = 0;
-	attributeDescriptions[1].location = 1;
-	attributeDescriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
-	attributeDescriptions[1].offset = offsetof(leoscene::Vertex, normal);
-
-	attributeDescriptions[2].binding = 0;
-	attributeDescriptions[2].location = 2;
-	attributeDescriptions[2].format = VK_FORMAT_R32G32_SFLOAT;
-	attributeDescriptions[2].offset = offsetof(leoscene::Vertex, uv);
-	forwardPipelineBuilder.vertexAttributes = attributeDescriptions;
-	forwardPipelineBuilder.vertexBinding = bindingDescription;
+	// Packed vertices, decoded in shader.vert (see leoscene::PackedVertexPosition and leoscene::PackedVertexAttributes)
+	forwardPipelineBuilder.vertexStreams = VERTEX_STREAM_POSITION_BIT | VERTEX_STREAM_ATTRIBUTES_BIT;
 
 	VkPipelineInputAssemblyStateCreateInfo inputAssemblyInfo{};
 	inputAssemblyInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
@@ -98,10 +74,31 @@ void MaterialBuilder::init(Parameters parameters)
 	colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
 	forwardPipelineBuilder.colorBlendAttachment = colorBlendAttachment;
 
-	forwardPipelineBuilder.depthStencil = VulkanUtils::createDepthStencilCreateInfo(true, true, VK_COMPARE_OP_LESS);
+	// Less or equal, so that the forward pass draws over the depth written by the depth pre-pass
+	forwardPipelineBuilder.depthStencil = VulkanUtils::createDepthStencilCreateInfo(true, true, VK_COMPARE_OP_LESS_OR_EQUAL);
 
 	const VulkanInstance::Properties& instanceProperties = _vulkan->getProperties();
 
+	// Sampler of all the material textures. The images only hold their resident mip levels (see VulkanRenderer), so maxLod is not clamped.
+	VkSamplerCreateInfo samplerInfo = {};
+	samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerInfo.magFilter = VK_FILTER_LINEAR;
+	samplerInfo.minFilter = VK_FILTER_LINEAR;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerInfo.anisotropyEnable = VK_TRUE;
+	samplerInfo.maxAnisotropy = instanceProperties.maxSamplerAnisotropy;
+	samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+	samplerInfo.unnormalizedCoordinates = VK_FALSE;
+	samplerInfo.compareEnable = VK_FALSE;
+	samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+	samplerInfo.minLod = 0.0f;
+	samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+	samplerInfo.mipLodBias = 0.0f;
+	_materialSampler = _parameters.samplerCache->getSampler(samplerInfo);
+
 	VkViewport viewport{};
 	forwardPipelineBuilder.viewport.x = 0.0f;
 	forwardPipelineBuilder.viewport.y = 0.0f;
@@ -114,6 +111,14 @@ void MaterialBuilder::init(Parameters parameters)
 	forwardPipelineBuilder.scissor.offset = { 0, 0 };
 	forwardPipelineBuilder.scissor.extent = instanceProperties.swapChainExtent;
 
+	// Depth-only pipeline: same states, but only the position stream is read and no color is written
+
+	PipelineBuilder depthOnlyPipelineBuilder = forwardPipelineBuilder;
+	depthOnlyPipelineBuilder.vertexStreams = VERTEX_STREAM_POSITION_BIT;
+	depthOnlyPipelineBuilder.colorBlendAttachment.colorWriteMask = 0;
+	depthOnlyPipelineBuilder.colorBlendAttachment.blendEnable = VK_FALSE;
+	depthOnlyPipelineBuilder.depthStencil = VulkanUtils::createDepthStencilCreateInfo(true, true, VK_COMPARE_OP_LESS);
+
 	/*
 	* Performance material template
 	*/
@@ -129,9 +134,18 @@ void MaterialBuilder::init(Parameters parameters)
 	forwardPassParams.shaderBuilder = &_shaderBuilder;
 	forwardPassParams.shaderPaths[VK_SHADER_STAGE_VERTEX_BIT] = "resources/shaders/vert.spv";
 	forwardPassParams.shaderPaths[VK_SHADER_STAGE_FRAGMENT_BIT] = "resources/shaders/frag.spv";
+	forwardPassParams.immutableSamplers["materialSampler"] = &_materialSampler;
+
+	// Depth-only pass
+
+	ShaderPass::Parameters depthOnlyPassParams{};
+	depthOnlyPassParams.device = _device;
+	depthOnlyPassParams.shaderBuilder = &_shaderBuilder;
+	depthOnlyPassParams.shaderPaths[VK_SHADER_STAGE_VERTEX_BIT] = "resources/shaders/depth_only.spv";
 
 	_materialTemplates[MaterialType::BASIC] = std::make_unique<MaterialTemplate>();
 	performanceMaterialTemplateParams.passesParameters[ShaderPass::Type::FORWARD] = forwardPassParams;
+	performanceMaterialTemplateParams.passesParameters[ShaderPass::Type::DEPTH_ONLY] = depthOnlyPassParams;
 
 	_materialTemplates[MaterialType::BASIC]->init(performanceMaterialTemplateParams);
 	forwardPipelineBuilder.pipelineLayout = _materialTemplates[MaterialType::BASIC]->getPipelineLayout(ShaderPass::Type::FORWARD);
@@ -140,13 +154,22 @@ void MaterialBuilder::init(Parameters parameters)
 	VkPipeline forwardPassPipeline = forwardPipelineBuilder.buildPipeline(_device, _parameters.forwardRenderPass);
 	_materialTemplates[MaterialType::BASIC]->setPipeline(ShaderPass::Type::FORWARD, forwardPassPipeline);
 
+	// Built with the layout of the forward pass, so that both passes bind the same descriptor sets. The layout reflected from
+	// the depth-only shader alone would not be compatible with them (its sets lack the bindings of the fragment shader).
+	depthOnlyPipelineBuilder.pipelineLayout = forwardPipelineBuilder.pipelineLayout;
+	depthOnlyPipelineBuilder.setShaders(*_materialTemplates[MaterialType::BASIC]->getShaderPass(ShaderPass::Type::DEPTH_ONLY));
+	VkPipeline depthOnlyPassPipeline = depthOnlyPipelineBuilder.buildPipeline(_device, _parameters.forwardRenderPass);
+	_materialTemplates[MaterialType::BASIC]->setPipeline(ShaderPass::Type::DEPTH_ONLY, depthOnlyPassPipeline);
+
 	_materialTemplates[MaterialType::BASIC]->getShaderPass(ShaderPass::Type::FORWARD)->destroyShaderModules();
+	_materialTemplates[MaterialType::BASIC]->getShaderPass(ShaderPass::Type::DEPTH_ONLY)->destroyShaderModules();
 }
 
 void MaterialBuilder::cleanup()
 {
 	_descriptorAllocator.cleanup();
 	_globalDescriptorLayoutCache.cleanup();
+	_materialSampler = VK_NULL_HANDLE;  // Destroyed with the sampler cache
 	_materials.clear();
 	for (auto& [materialType, materialTemplate] : _materialTemplates) {
 		materialTemplate->cleanup();
@@ -161,18 +184,44 @@ Material* MaterialBuilder::createMaterial(MaterialType type)
 }
 
 void MaterialBuilder::setupMaterialDescriptorSets(Material& material)
+{
+	material.getDescriptorSet(ShaderPass::Type::FORWARD) = createMaterialDescriptorSet(material);
+}
+
+VkDescriptorSet MaterialBuilder::createMaterialDescriptorSet(const Material& material)
 {
 	DescriptorBuilder builder = DescriptorBuilder::begin(_device, _globalDescriptorLayoutCache, _descriptorAllocator);
 	std::array<VkDescriptorImageInfo, 5> imageInfos = { {} };
 	for (int i = 0; i < 5; ++i) {
 		imageInfos[i].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 		imageInfos[i].imageView = material.textures[i].view;
-		imageInfos[i].sampler = material.textures[i].sampler;
 
-		builder.bindImage(i, imageInfos[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT);
+		builder.bindImage(i, imageInfos[i], VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_SHADER_STAGE_FRAGMENT_BIT);
+	}
+	builder.bindImmutableSamplers(5, &_materialSampler, 1, VK_SHADER_STAGE_FRAGMENT_BIT);
+
+	VkDescriptorSet set = VK_NULL_HANDLE;
+	builder.build(set);
+	return set;
+}
+
+void MaterialBuilder::writeMaterialDescriptorSet(const Material& material, VkDescriptorSet set)
+{
+	std::array<VkDescriptorImageInfo, 5> imageInfos = { {} };
+	std::array<VkWriteDescriptorSet, 5> writes = { {} };
+	for (uint32_t i = 0; i < 5; ++i) {
+		imageInfos[i].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		imageInfos[i].imageView = material.textures[i].view;
+
+		writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writes[i].dstSet = set;
+		writes[i].dstBinding = i;
+		writes[i].descriptorCount = 1;
+		writes[i].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+		writes[i].pImageInfo = &imageInfos[i];
 	}
 
-	builder.build(material.getDescriptorSet(ShaderPass::Type::FORWARD));
+	vkUpdateDescriptorSets(_device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
 }
 
 const MaterialTemplate* MaterialBuilder::getMaterialTemplate(MaterialType type)
@@ -13,6 +13,7 @@ public:
 	struct Parameters {
 		VkSampleCountFlagBits multisamplingNbSamples = VK_SAMPLE_COUNT_1_BIT;
 		VkRenderPass forwardRenderPass = VK_NULL_HANDLE;
+		SamplerCache* samplerCache = nullptr;  // Owns the sampler of the materials
 	};
 
 public:
@@ -23,6 +24,13 @@ public:
 	Material* createMaterial(MaterialType type);
 	void setupMaterialDescriptorSets(Material& material);
 
+	// New forward pass descriptor set holding the textures of the material. The set of the material is left as it is.
+	// The textures are sampled with the immutable sampler of the set layout.
+	VkDescriptorSet createMaterialDescriptorSet(const Material& material);
+
+	// Writes the textures of the material in a set made by createMaterialDescriptorSet. The set must not be in use by the device.
+	void writeMaterialDescriptorSet(const Material& material, VkDescriptorSet set);
+
 	const MaterialTemplate* getMaterialTemplate(MaterialType type);
 
 private:
@@ -33,6 +41,7 @@ private:
 
 	DescriptorAllocator _descriptorAllocator;
 	DescriptorLayoutCache _globalDescriptorLayoutCache;
+	VkSampler _materialSampler = VK_NULL_HANDLE;  // Shared by all the textures of the materials, immutable in the material set layout
 	std::unordered_map<MaterialType, std::unique_ptr<MaterialTemplate>> _materialTemplates;
 	std::vector<std::unique_ptr<Material>> _materials;
 };
@@ -17,8 +17,8 @@ class VulkanInstance;
 class MaterialBuilder;
 class MaterialTemplate;
 
+// The textures are sampled with the immutable sampler of the material set layout (see MaterialBuilder)
 struct MaterialTexture {
-	VkSampler sampler;
 	VkImageView view;
 };
 
@@ -2,6 +2,9 @@
 
 #include "ShaderPass.h"
 
+#include <scene/PackedVertex.h>
+
+#include <cstddef>
 #include <iostream>
 #include <unordered_map>
 
@@ -11,16 +14,25 @@ VkPipeline PipelineBuilder::buildPipeline(VkDevice device, VkRenderPass pass)
 	vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
 	vertexInputInfo.pNext = nullptr;
 
-	//no vertex bindings or attributes
-	vertexInputInfo.vertexBindingDescriptionCount = 0;
-	vertexInputInfo.vertexAttributeDescriptionCount = 0;
+	// Packed vertices (see leoscene::PackedVertexPosition and leoscene::PackedVertexAttributes), one binding per stream
+	std::vector<VkVertexInputBindingDescription> vertexBindings;
+	std::vector<VkVertexInputAttributeDescription> vertexAttributes;
+	if (vertexStreams & VERTEX_STREAM_POSITION_BIT) {
+		vertexBindings.push_back({ 0, sizeof(leoscene::PackedVertexPosition), VK_VERTEX_INPUT_RATE_VERTEX });
+		vertexAttributes.push_back({ 0, 0, VK_FORMAT_R16G16B16A16_UNORM, offsetof(leoscene::PackedVertexPosition, position) });
+	}
+	if (vertexStreams & VERTEX_STREAM_ATTRIBUTES_BIT) {
+		vertexBindings.push_back({ 1, sizeof(leoscene::PackedVertexAttributes), VK_VERTEX_INPUT_RATE_VERTEX });
+		vertexAttributes.push_back({ 1, 1, VK_FORMAT_R16G16_SNORM, offsetof(leoscene::PackedVertexAttributes, normal) });
+		vertexAttributes.push_back({ 2, 1, VK_FORMAT_R16G16_SNORM, offsetof(leoscene::PackedVertexAttributes, tangent) });
+		vertexAttributes.push_back({ 3, 1, VK_FORMAT_R16G16_SFLOAT, offsetof(leoscene::PackedVertexAttributes, uv) });
+	}
 
-	//connect the pipeline builder vertex input info to the one we get from Vertex
 	vertexInputInfo.pVertexAttributeDescriptions = vertexAttributes.data();
 	vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(vertexAttributes.size());
 
-	vertexInputInfo.pVertexBindingDescriptions = &vertexBinding;
-	vertexInputInfo.vertexBindingDescriptionCount = 1;
+	vertexInputInfo.pVertexBindingDescriptions = vertexBindings.data();
+	vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(vertexBindings.size());
 
 
 	//make viewport state from our stored viewport and scissor.
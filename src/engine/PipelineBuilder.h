@@ -10,6 +10,12 @@
 
 class ShaderPass;
 
+// Vertex buffers of the meshes (see ShapeData). Pipelines only declare the streams their vertex shader reads.
+enum VertexStreamFlagBits : uint32_t {
+	VERTEX_STREAM_POSITION_BIT = 0x1,  // Binding 0: location 0 (position)
+	VERTEX_STREAM_ATTRIBUTES_BIT = 0x2,  // Binding 1: locations 1 to 3 (normal, tangent, uv)
+};
+
 class ComputePipelineBuilder {
 public:
 	VkPipeline buildPipeline(VkDevice device);
@@ -33,8 +39,7 @@ public:
 	VkPipelineMultisampleStateCreateInfo multisampling = {};
 	VkPipelineLayout pipelineLayout = {};
 	VkPipelineDepthStencilStateCreateInfo depthStencil = {};
-	VkVertexInputBindingDescription vertexBinding = {};
-	std::array<VkVertexInputAttributeDescription, 3> vertexAttributes;
+	uint32_t vertexStreams = VERTEX_STREAM_POSITION_BIT | VERTEX_STREAM_ATTRIBUTES_BIT;  // VertexStreamFlagBits
 
 private:
 	std::vector<VkPipelineShaderStageCreateInfo> _shaderStages;
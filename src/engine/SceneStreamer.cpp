@@ -0,0 +1,103 @@
+#include "SceneStreamer.h"
+
+#include <scene/Scene.h>
+
+#include <exception>
+
+SceneStreamer::~SceneStreamer()
+{
+    stop();
+}
+
+void SceneStreamer::start(const std::string& filePath, const leoscene::Camera& camera, leoscene::SceneLoader::LoadingOptions options)
+{
+    stop();
+
+    _chunks.clear();
+    _hasCamera = false;
+    _cameraTaken = false;
+    _stopRequested = false;
+    _done = false;
+    _failed = false;
+    _errorMessage.clear();
+
+    _thread = std::thread([this, filePath, camera, options]() mutable {
+        // Written by the loader on this thread only. Shared once the first chunk is ready, since it is set before.
+        leoscene::Camera loadingCamera = camera;
+
+        options.onChunkLoaded = [this, &loadingCamera](std::unique_ptr<leoscene::Scene> chunk) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (!_hasCamera) {
+                _camera = loadingCamera;
+                _hasCamera = true;
+            }
+            _chunks.push_back(std::move(chunk));
+            return !_stopRequested;
+        };
+
+        leoscene::Scene scene;  // Stays empty, all the objects go through the chunks
+        leoscene::SceneLoader sceneLoader;
+        // Nothing may escape the thread, or the whole application terminates.
+        bool failed = true;
+        std::string errorMessage;
+        try {
+            sceneLoader.loadScene(filePath.c_str(), &scene, &loadingCamera, options);
+            failed = false;
+        }
+        catch (const leoscene::SceneLoaderException& e) {
+            errorMessage = e.what();
+        }
+        catch (const std::exception& e) {
+            errorMessage = std::string("Unexpected error while loading the scene: ") + e.what();
+        }
+        catch (...) {
+            errorMessage = "Unknown error while loading the scene";
+        }
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_hasCamera) {
+            _camera = loadingCamera;
+            _hasCamera = true;
+        }
+        _failed = failed;
+        _errorMessage = std::move(errorMessage);
+        _done = true;
+    });
+}
+
+void SceneStreamer::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopRequested = true;
+    }
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+}
+
+bool SceneStreamer::takeChunks(std::vector<std::unique_ptr<leoscene::Scene>>& chunks, leoscene::Camera& camera)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_hasCamera && !_cameraTaken) {
+        camera = _camera;
+        _cameraTaken = true;
+    }
+    for (std::unique_ptr<leoscene::Scene>& chunk : _chunks) {
+        chunks.push_back(std::move(chunk));
+    }
+    _chunks.clear();
+    return !_done;
+}
+
+bool SceneStreamer::hasFailed() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _failed;
+}
+
+std::string SceneStreamer::getErrorMessage() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _errorMessage;
+}
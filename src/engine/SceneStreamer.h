@@ -0,0 +1,58 @@
+#pragma once
+
+#include <scene/Camera.h>
+#include <scene/SceneLoader.h>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace leoscene {
+	class Scene;
+}
+
+/*
+* Loads a scene on a background thread and hands it over in chunks, so that the renderer can start drawing
+* before the whole scene is loaded. Chunks are taken by the rendering thread between frames.
+*/
+class SceneStreamer
+{
+public:
+	SceneStreamer() = default;
+	~SceneStreamer();
+
+	SceneStreamer(const SceneStreamer& other) = delete;
+	SceneStreamer& operator=(const SceneStreamer& other) = delete;
+
+public:
+	// Starts loading the scene. The given camera is kept if the scene file does not specify one.
+	void start(const std::string& filePath, const leoscene::Camera& camera, leoscene::SceneLoader::LoadingOptions options = {});
+
+	// Asks the loading to stop as soon as possible, and waits for the loading thread.
+	void stop();
+
+	// Moves the chunks loaded since the previous call to the end of chunks. The camera is set once, with the first chunk.
+	// Returns false once the loading is over and every chunk was handed over.
+	bool takeChunks(std::vector<std::unique_ptr<leoscene::Scene>>& chunks, leoscene::Camera& camera);
+
+	bool hasFailed() const;
+
+	// Describes why the loading failed, empty if it did not.
+	std::string getErrorMessage() const;
+
+private:
+	std::thread _thread;
+	mutable std::mutex _mutex;
+
+	// Shared with the loading thread, guarded by the mutex.
+	std::vector<std::unique_ptr<leoscene::Scene>> _chunks;
+	leoscene::Camera _camera;
+	bool _hasCamera = false;
+	bool _cameraTaken = false;
+	bool _stopRequested = false;
+	bool _done = false;
+	bool _failed = false;
+	std::string _errorMessage;
+};
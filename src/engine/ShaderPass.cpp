@@ -74,6 +74,9 @@ VkPipelineLayout ShaderPass::reflectShaderModules(const Parameters& parameters)
 					}
 					bindings[bindingIdx].stageFlags = stageFlag;
 					bindings[bindingIdx].pImmutableSamplers = nullptr;
+					if (parameters.immutableSamplers.find(reflBinding.name) != parameters.immutableSamplers.end()) {
+						bindings[bindingIdx].pImmutableSamplers = parameters.immutableSamplers.at(reflBinding.name);
+					}
 				}
 				else {
 					bindings[bindingIdx].stageFlags |= stageFlag;
@@ -11,6 +11,7 @@ class ShaderPass {
 public:
 	enum class Type {
 		FORWARD,
+		DEPTH_ONLY,  // Reads the position stream of the meshes only (see VertexStreamFlagBits)
 		COMPUTE,
 		NB_TYPES
 	};
@@ -21,6 +22,7 @@ public:
 		ShaderBuilder* shaderBuilder = nullptr;
 		std::unordered_map<VkShaderStageFlagBits, const char*> shaderPaths;
 		std::unordered_map<std::string, VkDescriptorType> descriptorTypeOverwrites;
+		std::unordered_map<std::string, const VkSampler*> immutableSamplers;  // One per descriptor of the sampler binding of that name
 	};
 
 	VkPipelineLayout reflectShaderModules(const Parameters& parameters);
@@ -157,6 +157,7 @@ void VulkanInstance::init(GLFWwindow* window)
     _properties.maxNbMsaaSamples = _getMaxUsableSampleCount();
     vkGetPhysicalDeviceProperties(_physicalDevice, &_physicalDeviceProperties);
     _properties.maxSamplerAnisotropy = _physicalDeviceProperties.limits.maxSamplerAnisotropy;
+    _properties.maxDrawIndirectCount = _physicalDeviceProperties.limits.maxDrawIndirectCount;
 
     _queueFamilyIndices = candidateIndices;
     _swapChainSupportDetails = candidateSwapChainSupportDetails;
@@ -186,6 +187,8 @@ void VulkanInstance::init(GLFWwindow* window)
     deviceFeatures.features.samplerAnisotropy = VK_TRUE;
     deviceFeatures.features.sampleRateShading = VK_FALSE;
     deviceFeatures.features.multiDrawIndirect = VK_TRUE;
+    deviceFeatures.features.textureCompressionBC = VK_TRUE;
+    deviceFeatures.features.fragmentStoresAndAtomics = VK_TRUE;  // Texture streaming feedback, written by shader.frag
 
     VkPhysicalDeviceExtendedDynamicStateFeaturesEXT extendedDynamicStateFeatures{};
     extendedDynamicStateFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_FEATURES_EXT;
@@ -326,6 +329,14 @@ int VulkanInstance::_ratePhysicalDevice(VkPhysicalDevice device, QueueFamilyIndi
         return 0;
     }
 
+    if (!deviceFeatures.features.textureCompressionBC) {
+        return 0;
+    }
+
+    if (!deviceFeatures.features.fragmentStoresAndAtomics) {
+        return 0;
+    }
+
     if (!deviceFeatures.features.sampleRateShading) {
         return 0;
     }
@@ -676,11 +687,12 @@ void VulkanInstance::copyDataToBuffer(uint32_t size, AllocatedBuffer& buffer, co
 }
 
 
-void VulkanInstance::copyBufferToBuffer(VkCommandPool cmdPool, VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) {
+void VulkanInstance::copyBufferToBuffer(VkCommandPool cmdPool, VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize dstOffset) {
     VkCommandBuffer commandBuffer = beginSingleTimeCommands(cmdPool);
 
     VkBufferCopy copyRegion{};
     copyRegion.size = size;
+    copyRegion.dstOffset = dstOffset;
     vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
 
     endSingleTimeCommands(commandBuffer, cmdPool);
@@ -729,83 +741,16 @@ void VulkanInstance::unmapBuffer(AllocatedBuffer& buffer)
     vmaUnmapMemory(_allocator, buffer.vmaAllocation);
 }
 
-void VulkanInstance::generateMipmaps(VkCommandPool cmdPool, AllocatedImage& imageData, VkFormat imageFormat, int32_t texWidth, int32_t texHeight) {
-    // Check if image format supports linear blitting
-    findSupportedFormat({ imageFormat }, VK_IMAGE_TILING_OPTIMAL, VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT);
-
-    VkCommandBuffer commandBuffer = beginSingleTimeCommands(cmdPool);
-
-    VkImageMemoryBarrier barrier = {};
-    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-    barrier.image = imageData.image;
-    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    barrier.subresourceRange.baseArrayLayer = 0;
-    barrier.subresourceRange.layerCount = 1;
-    barrier.subresourceRange.levelCount = 1;
-
-    int32_t mipWidth = texWidth;
-    int32_t mipHeight = texHeight;
-
-    for (uint32_t i = 1; i < imageData.mipLevels; i++) {
-        barrier.subresourceRange.baseMipLevel = i - 1;
-        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-
-        vkCmdPipelineBarrier(commandBuffer,
-            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
-            0, nullptr,
-            0, nullptr,
-            1, &barrier);
-
-        VkImageBlit blit = {};
-        blit.srcOffsets[0] = { 0, 0, 0 };
-        blit.srcOffsets[1] = { mipWidth, mipHeight, 1 };
-        blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        blit.srcSubresource.mipLevel = i - 1;
-        blit.srcSubresource.baseArrayLayer = 0;
-        blit.srcSubresource.layerCount = 1;
-        blit.dstOffsets[0] = { 0, 0, 0 };
-        blit.dstOffsets[1] = { mipWidth > 1 ? mipWidth / 2 : 1, mipHeight > 1 ? mipHeight / 2 : 1, 1 };
-        blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        blit.dstSubresource.mipLevel = i;
-        blit.dstSubresource.baseArrayLayer = 0;
-        blit.dstSubresource.layerCount = 1;
-
-        vkCmdBlitImage(commandBuffer, imageData.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, imageData.image,
-            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
-
-        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-        vkCmdPipelineBarrier(commandBuffer,
-            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
-            0, nullptr,
-            0, nullptr,
-            1, &barrier);
-
-        if (mipWidth > 1) mipWidth /= 2;
-        if (mipHeight > 1) mipHeight /= 2;
-    }
-
-    barrier.subresourceRange.baseMipLevel = imageData.mipLevels - 1;
-    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-    vkCmdPipelineBarrier(commandBuffer,
-        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
-        0, nullptr,
-        0, nullptr,
-        1, &barrier);
+// Makes host writes to a mapped buffer visible to the device. Does nothing on host coherent memory.
+void VulkanInstance::flushBuffer(AllocatedBuffer& buffer, VkDeviceSize offset, VkDeviceSize size)
+{
+    VK_CHECK(vmaFlushAllocation(_allocator, buffer.vmaAllocation, offset, size));
+}
 
-    endSingleTimeCommands(commandBuffer, cmdPool);
+// Makes device writes to a mapped buffer visible to the host. Does nothing on host coherent memory.
+void VulkanInstance::invalidateBuffer(AllocatedBuffer& buffer, VkDeviceSize offset, VkDeviceSize size)
+{
+    VK_CHECK(vmaInvalidateAllocation(_allocator, buffer.vmaAllocation, offset, size));
 }
 
 VkCommandBuffer VulkanInstance::beginSingleTimeCommands(VkCommandPool& commandPool) {
@@ -33,6 +33,7 @@ public:
 		VkExtent2D swapChainExtent = { 0 };
 		VkSampleCountFlagBits maxNbMsaaSamples = VK_SAMPLE_COUNT_1_BIT;
 		float maxSamplerAnisotropy = 0.f;
+		uint32_t maxDrawIndirectCount = 1;
 	};
 
 	struct QueueFamilyIndices {
@@ -61,15 +62,16 @@ public:
 	void destroyImage(AllocatedImage& image);
 	void copyBufferToImage(VkCommandPool cmdPool, VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT);
 	void createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevels, VkImageView& imageView, uint32_t baseMipLevel = 0) const;
-	void generateMipmaps(VkCommandPool cmdPool, AllocatedImage& imageData, VkFormat imageFormat, int32_t texWidth, int32_t texHeight);
 	void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VmaMemoryUsage memoryUsage, AllocatedBuffer& buffer, uint32_t minAlignment = 0);
 	void createGPUBufferFromCPUData(VkCommandPool cmdPool, VkDeviceSize size, VkBufferUsageFlags usage, const void* data, AllocatedBuffer& buffer);
 	void copyDataToBuffer(uint32_t size, AllocatedBuffer& buffer, const void* data, uint32_t offset = 0);
 	void destroyBuffer(AllocatedBuffer& buffer);
-	void copyBufferToBuffer(VkCommandPool cmdPool, VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
+	void copyBufferToBuffer(VkCommandPool cmdPool, VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize dstOffset = 0);
 	size_t padUniformBufferSize(size_t originalSize);
 	void* mapBuffer(AllocatedBuffer& buffer);
 	void unmapBuffer(AllocatedBuffer& buffer);
+	void flushBuffer(AllocatedBuffer& buffer, VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE);
+	void invalidateBuffer(AllocatedBuffer& buffer, VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE);
 	VkCommandBuffer beginSingleTimeCommands(VkCommandPool& commandPool);
 	void endSingleTimeCommands(VkCommandBuffer commandBuffer, VkCommandPool& commandPool);
 	VkFormat findSupportedFormat(const std::vector<VkFormat>& candidates,
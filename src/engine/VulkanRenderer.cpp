@@ -1,8 +1,10 @@
 #include "VulkanRenderer.h"
 
 #include <scene/Scene.h>
+#include <scene/BatchTransforms.h>
 #include <scene/PerformanceMaterial.h>
 #include <scene/Mesh.h>
+#include <scene/PackedVertex.h>
 #include <scene/Transform.h>
 #include <scene/Camera.h>
 #include <scene/Camera.h>
@@ -16,21 +18,26 @@
 #include <array>
 #include <fstream>
 #include <set>
+#include <algorithm>
 
 
 #include <stb_image.h>
 
 namespace {
     uint32_t previousPow2(uint32_t v);
+    leoscene::TextureResidencyOptions getTextureResidencyOptions(const VulkanRenderer::Options& options);
 }
 
-VulkanRenderer::VulkanRenderer(VulkanInstance* vulkan, const ApplicationState* applicationState, const leoscene::Camera* camera) :
+VulkanRenderer::VulkanRenderer(VulkanInstance* vulkan, const ApplicationState* applicationState, const leoscene::Camera* camera, const Options& options) :
+    _options(options),
+    _textureResidency(getTextureResidencyOptions(options)),
     _vulkan(vulkan),
     _device(vulkan->getLogicalDevice()),
     _globalDescriptorAllocator(_device),
     _globalDescriptorLayoutCache(_device),
     _materialBuilder(_device, _vulkan),
     _shaderBuilder(_device),
+    _samplerCache(_device),
     _cullingDescriptorAllocator(_device),
     _depthPyramidDescriptorAllocator(_device),
     _applicationState(applicationState),
@@ -51,6 +58,7 @@ void VulkanRenderer::cleanup()
     _depthPyramidDescriptorAllocator.cleanup();
     _globalDescriptorAllocator.cleanup();
     _globalDescriptorLayoutCache.cleanup();
+    _samplerCache.cleanup();
     _materialDescriptorSets.clear();
     _depthPyramidDescriptorSets.clear();
     _globalDataDescriptorSet = VK_NULL_HANDLE;
@@ -59,6 +67,8 @@ void VulkanRenderer::cleanup()
     _objectsDataDescriptorSetLayout = VK_NULL_HANDLE;
     _cullingDescriptorSet = VK_NULL_HANDLE;
     _cullingDescriptorSetLayout = VK_NULL_HANDLE;
+    _clusterCullingDescriptorSet = VK_NULL_HANDLE;
+    _clusterCullingDescriptorSetLayout = VK_NULL_HANDLE;
 
     /*
     * Cleaning up scene data
@@ -69,24 +79,70 @@ void VulkanRenderer::cleanup()
 
         _vulkan->destroyBuffer(_gpuCullingGlobalData);
         _vulkan->destroyBuffer(_gpuIndexToObjectId);
+        _indexMapCapacity = 0;
         _vulkan->destroyBuffer(_gpuObjectInstances);
         _vulkan->destroyBuffer(_gpuResetBatches);
         _vulkan->destroyBuffer(_gpuBatches);
+        _vulkan->destroyBuffer(_gpuClusters);
+        _vulkan->destroyBuffer(_gpuClusteredInstances);
+        _vulkan->destroyBuffer(_gpuClusterDispatch);
+        _clusters.clear();
+        _vulkan->destroyBuffer(_gpuHlodClusters);
+        _vulkan->destroyBuffer(_gpuObjectsHlod);
+        _hlodClusters.clear();
+        _commandsCapacity = 0;
+        _clustersCapacity = 0;
+        _hlodClustersCapacity = 0;
 
         // Scene objects data
 
         _vulkan->destroyBuffer(_objectsDataBuffer);
-
-        for (const std::unique_ptr<ShapeData>& shapeData : _shapeData) {
-            _vulkan->destroyBuffer(shapeData->indexBuffer);
-            _vulkan->destroyBuffer(shapeData->vertexBuffer);
-        }
+        _objectsCapacity = 0;
+        _objectsLocalBounds.clear();
+        _objectsLocalBoxes.clear();
+        _pendingObjectUpdates.clear();
+        _pendingObjectUpdateSlots.clear();
+        _totalInstancesNb = 0;
+        _nbInstances = 0;
+        _drawCalls.clear();
+        _nbDrawCommands = 0;
+        _drawCallIndices.clear();
+        _materialDraws.clear();
+        _indexTypeDraws.clear();
+        _objectsBatch.clear();
+        _loadedMaterials.clear();
+        _loadedShapes.clear();
+        _loadedImages.clear();
+
+        _vulkan->destroyBuffer(_indexBuffer);
+        _vulkan->destroyBuffer(_positionBuffer);
+        _vulkan->destroyBuffer(_attributeBuffer);
+        _nbVertices = 0;
+        _verticesCapacity = 0;
+        _indexDataSize = 0;
+        _indexDataCapacity = 0;
         _shapeData.clear();
 
-        for (VkSampler materialImageSampler : _materialImagesSamplers) {
-            vkDestroySampler(_device, materialImageSampler, nullptr);
-        }
-        _materialImagesSamplers.clear();
+        // Texture streaming. The spare descriptor sets of the materials were freed with the material builder.
+
+        _freeRetiredTextureData(true);
+        _textureResidency = leoscene::TextureResidency(getTextureResidencyOptions(_options));
+        _streamedTextures.clear();
+        _streamedTextureIds.clear();
+        _streamedMaterials.clear();
+        _feedbackSlots.clear();
+        _vulkan->destroyBuffer(_textureFeedbackBuffer);
+        _vulkan->unmapBuffer(_textureFeedbackReadback);
+        _textureFeedbackReadbackData = nullptr;
+        _vulkan->destroyBuffer(_textureFeedbackReadback);
+        _textureFeedbackCapacity = 0;
+
+        // Scene buffers replaced or used for staging since the last frames
+
+        _pendingSceneCopies.clear();
+        _pendingImageUploads.clear();
+        _freeRetiredBuffers(true);
+        _sceneDescriptorsOutdated = false;
 
         for (const std::unique_ptr<AllocatedImage>& materialImage : _materialImagesData) {
             vkDestroyImageView(_device, materialImage->view, nullptr);
@@ -109,8 +165,7 @@ void VulkanRenderer::cleanup()
     vkDestroyImageView(_device, _depthPyramid.view, nullptr);
     _vulkan->destroyImage(_depthPyramid);
 
-    vkDestroySampler(_device, _depthImageSampler, nullptr);
-    _depthImageSampler = VK_NULL_HANDLE;
+    _depthImageSampler = VK_NULL_HANDLE;  // Destroyed with the sampler cache
 
     // Global data for shaders
 
@@ -118,6 +173,12 @@ void VulkanRenderer::cleanup()
     _vulkan->destroyBuffer(_cameraDataBuffer);
     _vulkan->destroyBuffer(_miscDynamicDataBuffer);
 
+    // Objects data updates
+
+    _vulkan->unmapBuffer(_objectUpdatesStagingRing);
+    _objectUpdatesStagingData = nullptr;
+    _vulkan->destroyBuffer(_objectUpdatesStagingRing);
+
     // Culling pipelines and passes
 
     _cullShaderPass.cleanup();
@@ -126,6 +187,12 @@ void VulkanRenderer::cleanup()
     vkDestroyPipelineLayout(_device, _cullingPipelineLayout, nullptr);
     _cullingPipelineLayout = VK_NULL_HANDLE;
 
+    _clusterCullShaderPass.cleanup();
+    vkDestroyPipeline(_device, _clusterCullingPipeline, nullptr);
+    _clusterCullingPipeline = VK_NULL_HANDLE;
+    vkDestroyPipelineLayout(_device, _clusterCullingPipelineLayout, nullptr);
+    _clusterCullingPipelineLayout = VK_NULL_HANDLE;
+
     _depthPyramidShaderPass.cleanup();
     vkDestroyPipeline(_device, _depthPyramidPipeline, nullptr);
     _depthPyramidPipeline = VK_NULL_HANDLE;
@@ -205,8 +272,7 @@ void VulkanRenderer::cleanupSwapChainDependentObjects()
     vkDestroyImageView(_device, _depthPyramid.view, nullptr);
     _vulkan->destroyImage(_depthPyramid);
 
-    vkDestroySampler(_device, _depthImageSampler, nullptr);
-    _depthImageSampler = VK_NULL_HANDLE;
+    _depthImageSampler = VK_NULL_HANDLE;  // Kept by the sampler cache, and found again when the depth pyramid is made again
 
     /*
     * Framebuffers
@@ -234,6 +300,12 @@ void VulkanRenderer::cleanupSwapChainDependentObjects()
     vkDestroyPipelineLayout(_device, _cullingPipelineLayout, nullptr);
     _cullingPipelineLayout = VK_NULL_HANDLE;
 
+    _clusterCullShaderPass.cleanup();
+    vkDestroyPipeline(_device, _clusterCullingPipeline, nullptr);
+    _clusterCullingPipeline = VK_NULL_HANDLE;
+    vkDestroyPipelineLayout(_device, _clusterCullingPipelineLayout, nullptr);
+    _clusterCullingPipelineLayout = VK_NULL_HANDLE;
+
     _depthPyramidShaderPass.cleanup();
     vkDestroyPipeline(_device, _depthPyramidPipeline, nullptr);
     _depthPyramidPipeline = VK_NULL_HANDLE;
@@ -273,11 +345,14 @@ void VulkanRenderer::recreateSwapChainDependentObjects()
 
     _createComputePipeline("resources/shaders/depth_pyramid.spv", _depthPyramidPipeline, _depthPyramidPipelineLayout, _depthPyramidShaderPass);
     _createComputePipeline("resources/shaders/indirect_cull.spv", _cullingPipeline, _cullingPipelineLayout, _cullShaderPass);
+    _createComputePipeline("resources/shaders/cluster_cull.spv", _clusterCullingPipeline, _clusterCullingPipelineLayout, _clusterCullShaderPass);
 
     _createDepthSampler();
     _createDepthPyramid();
 
-    _createCullingDescriptors(_totalInstancesNb);
+    if (_sceneLoaded) {
+        _createCullingDescriptors(_objectsCapacity);
+    }
     _createDepthPyramidDescriptors();
 
     _createBarriers();
@@ -365,7 +440,7 @@ void VulkanRenderer::init()
     */
 
     // Graphics pipelines for each material type (one!)
-    _materialBuilder.init({ instanceProperties.maxNbMsaaSamples, _renderPass });
+    _materialBuilder.init({ instanceProperties.maxNbMsaaSamples, _renderPass, &_samplerCache });
 
     // Depth pyramid creation from depth buffer. Required for occlusion culling.
     _createComputePipeline("resources/shaders/depth_pyramid.spv", _depthPyramidPipeline, _depthPyramidPipelineLayout, _depthPyramidShaderPass);
@@ -373,6 +448,9 @@ void VulkanRenderer::init()
     // Compute pipeline for culling (occlusion and frustum culling)
     _createComputePipeline("resources/shaders/indirect_cull.spv", _cullingPipeline, _cullingPipelineLayout, _cullShaderPass);
 
+    // Compute pipeline culling the clusters of the objects drawn with their full mesh (frustum, occlusion and back-face culling)
+    _createComputePipeline("resources/shaders/cluster_cull.spv", _clusterCullingPipeline, _clusterCullingPipelineLayout, _clusterCullShaderPass);
+
 
     /*
     * Global, non scene-related buffers
@@ -390,6 +468,9 @@ void VulkanRenderer::init()
     size_t sceneDataBufferSize = sizeof(GPUSceneData);
     _vulkan->createBuffer(sceneDataBufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU, _sceneDataBuffer);
 
+    // Staging ring for the data of the objects that move
+    _createObjectUpdatesStagingRing();
+
     // Depth Sampler
     _createDepthSampler();
 
@@ -552,7 +633,7 @@ void VulkanRenderer::drawFrame()
     submitInfo.pWaitSemaphores = waitSemaphores;
     submitInfo.pWaitDstStageMask = waitStages;
     submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &_framesData[imageIndex].commandBuffer;
+    submitInfo.pCommandBuffers = &frameData.commandBuffer;
     VkSemaphore signalSemaphores[] = { frameData.renderSemaphore };
     submitInfo.signalSemaphoreCount = 1;
     submitInfo.pSignalSemaphores = signalSemaphores;
@@ -566,32 +647,72 @@ void VulkanRenderer::drawFrame()
     beginInfo.flags = 0;
     beginInfo.pInheritanceInfo = nullptr;
 
-    VK_CHECK(vkBeginCommandBuffer(_framesData[imageIndex].commandBuffer, &beginInfo));
+    // Recorded in the command buffer of the frame in flight, whose fence was waited for above, like the segments of the staging ring
+    // and of the feedback readback keyed by _currentFrame. Only the framebuffer is the one of the acquired image.
+    VK_CHECK(vkBeginCommandBuffer(frameData.commandBuffer, &beginInfo));
+
+    // Scene data loaded since the previous frame
 
-    // Culling
+    _freeRetiredBuffers(false);
+    _recordSceneCopies(frameData.commandBuffer);
+    _recordImageUploads(frameData.commandBuffer);
 
-    vkCmdBindPipeline(_framesData[imageIndex].commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, _cullingPipeline);
+    // Data of the objects that moved since the previous frame
+
+    if (_sceneLoaded) {
+        _recordObjectUpdates(frameData.commandBuffer);
+    }
 
-    VkBufferCopy indirectCopy;
-    indirectCopy.dstOffset = 0;
-    indirectCopy.size = static_cast<uint32_t>(_drawCalls.size() * sizeof(GPUIndirectDrawCommand));
-    indirectCopy.srcOffset = 0;
-    vkCmdCopyBuffer(_framesData[imageIndex].commandBuffer, _gpuResetBatches.buffer, _gpuBatches.buffer, 1, &indirectCopy);
+    // Mip levels of the streamed textures, from the feedback of the last frame that used the same fence
 
-    vkCmdPipelineBarrier(_framesData[imageIndex].commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 1, &_gpuBatchesResetBarrier, 0, nullptr);
+    if (_sceneLoaded && _options.textureStreaming) {
+        _updateTextureStreaming(frameData.commandBuffer);
+    }
 
-    vkCmdBindDescriptorSets(_framesData[imageIndex].commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
-        _cullingPipelineLayout, 0, 1, &_cullingDescriptorSet, 0, nullptr);
+    // Culling. Nothing to cull or draw until the first objects of the scene are loaded.
 
-    uint32_t groupCountX = static_cast<uint32_t>((_nbInstances / 256) + 1);
-    vkCmdDispatch(_framesData[imageIndex].commandBuffer, groupCountX, 1, 1);
+    if (_sceneLoaded) {
+        vkCmdBindPipeline(frameData.commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, _cullingPipeline);
+
+        VkBufferCopy indirectCopy;
+        indirectCopy.dstOffset = 0;
+        indirectCopy.size = static_cast<uint32_t>(_nbDrawCommands * sizeof(GPUIndirectDrawCommand));
+        indirectCopy.srcOffset = 0;
+        vkCmdCopyBuffer(frameData.commandBuffer, _gpuResetBatches.buffer, _gpuBatches.buffer, 1, &indirectCopy);
+
+        // No clustered instance yet: the count and the number of work groups are reset
+        vkCmdFillBuffer(frameData.commandBuffer, _gpuClusterDispatch.buffer, 0, 2 * sizeof(uint32_t), 0);
+
+        std::array<VkBufferMemoryBarrier, 2> resetBarriers = { _gpuBatchesResetBarrier, _gpuClusterDispatchResetBarrier };
+        vkCmdPipelineBarrier(frameData.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr,
+            static_cast<uint32_t>(resetBarriers.size()), resetBarriers.data(), 0, nullptr);
+
+        vkCmdBindDescriptorSets(frameData.commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+            _cullingPipelineLayout, 0, 1, &_cullingDescriptorSet, 0, nullptr);
+
+        uint32_t groupCountX = static_cast<uint32_t>((_nbInstances / 256) + 1);
+        vkCmdDispatch(frameData.commandBuffer, groupCountX, 1, 1);
+
+        // Second pass on the clusters of the instances drawn with their LOD 0, with one work group per instance
+        if (_clusters.size()) {
+            vkCmdPipelineBarrier(frameData.commandBuffer,
+                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+                0, 0, nullptr, static_cast<uint32_t>(_clusterCullingBarriers.size()), _clusterCullingBarriers.data(), 0, nullptr);
+
+            vkCmdBindPipeline(frameData.commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, _clusterCullingPipeline);
+            vkCmdBindDescriptorSets(frameData.commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                _clusterCullingPipelineLayout, 0, 1, &_clusterCullingDescriptorSet, 0, nullptr);
+            vkCmdDispatchIndirect(frameData.commandBuffer, _gpuClusterDispatch.buffer, sizeof(uint32_t));
+        }
 
-    std::array<VkBufferMemoryBarrier, 2> barriers = { _gpuIndexToObjectIdBarrier, _gpuBatchesBarrier };
+        std::array<VkBufferMemoryBarrier, 2> barriers = { _gpuIndexToObjectIdBarrier, _gpuBatchesBarrier };
 
-    vkCmdPipelineBarrier(_framesData[imageIndex].commandBuffer,
-        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-        VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
-        0, 0, nullptr, static_cast<uint32_t>(barriers.size()), barriers.data(), 0, nullptr);
+        vkCmdPipelineBarrier(frameData.commandBuffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+            0, 0, nullptr, static_cast<uint32_t>(barriers.size()), barriers.data(), 0, nullptr);
+    }
 
     // Drawing
 
@@ -608,18 +729,24 @@ void VulkanRenderer::drawFrame()
     renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
     renderPassInfo.pClearValues = clearValues.data();
 
-    vkCmdBeginRenderPass(_framesData[imageIndex].commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+    vkCmdBeginRenderPass(frameData.commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
 
     if (PFN_vkCmdSetDepthTestEnableEXT vkCmdSetDepthTestEnableEXTfun = (PFN_vkCmdSetDepthTestEnableEXT)vkGetInstanceProcAddr(_vulkan->getInstance(), "vkCmdSetDepthTestEnableEXT")) {
-        vkCmdSetDepthTestEnableEXTfun(_framesData[imageIndex].commandBuffer, true);
+        vkCmdSetDepthTestEnableEXTfun(frameData.commandBuffer, true);
     }
     else {
         throw VulkanRendererException("Failed to load extension function vkCmdSetDepthTestEnableEXT.");
     }
 
-    _drawObjectsCommands(_framesData[imageIndex].commandBuffer, _framesData[imageIndex].framebuffer);
+    if (_sceneLoaded) {
+        // Optional depth pre-pass, reading only the position stream. The forward pass then only shades the visible fragments.
+        if (_applicationState->depthPrepass && !_applicationState->makeAllObjectsTransparent) {
+            _drawObjectsCommands(frameData.commandBuffer, _framesData[imageIndex].framebuffer, ShaderPass::Type::DEPTH_ONLY);
+        }
+        _drawObjectsCommands(frameData.commandBuffer, _framesData[imageIndex].framebuffer, ShaderPass::Type::FORWARD);
+    }
 
-    if (_applicationState->makeAllObjectsTransparent) {
+    if (_sceneLoaded && _applicationState->makeAllObjectsTransparent) {
         std::array<VkClearAttachment, 1> clearAttachments = {};
         clearAttachments[0].aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
         clearAttachments[0].clearValue = clearValues[0];
@@ -631,25 +758,29 @@ void VulkanRenderer::drawFrame()
         clearRectangle.rect.offset = { 0, 0 };
         clearRectangle.rect.extent = _vulkan->getProperties().swapChainExtent;
 
-        vkCmdClearAttachments(_framesData[imageIndex].commandBuffer, static_cast<uint32_t>(clearAttachments.size()), clearAttachments.data(), 1, &clearRectangle);
+        vkCmdClearAttachments(frameData.commandBuffer, static_cast<uint32_t>(clearAttachments.size()), clearAttachments.data(), 1, &clearRectangle);
 
         if (PFN_vkCmdSetDepthTestEnableEXT vkCmdSetDepthTestEnableEXTfun = (PFN_vkCmdSetDepthTestEnableEXT)vkGetInstanceProcAddr(_vulkan->getInstance(), "vkCmdSetDepthTestEnableEXT")) {
-            vkCmdSetDepthTestEnableEXTfun(_framesData[imageIndex].commandBuffer, false);
+            vkCmdSetDepthTestEnableEXTfun(frameData.commandBuffer, false);
         }
         else {
             throw VulkanRendererException("Failed to load extension function vkCmdSetDepthTestEnableEXT.");
         }
 
-        _drawObjectsCommands(_framesData[imageIndex].commandBuffer, _framesData[imageIndex].framebuffer);
+        _drawObjectsCommands(frameData.commandBuffer, _framesData[imageIndex].framebuffer, ShaderPass::Type::FORWARD);
     }
 
-    vkCmdEndRenderPass(_framesData[imageIndex].commandBuffer);
+    vkCmdEndRenderPass(frameData.commandBuffer);
+
+    if (_sceneLoaded && _options.textureStreaming) {
+        _recordTextureFeedbackReadback(frameData.commandBuffer);
+    }
 
     if (!_applicationState->lockCullingCamera) {
-        _computeDepthPyramid(_framesData[imageIndex].commandBuffer);
+        _computeDepthPyramid(frameData.commandBuffer);
     }
 
-    VK_CHECK(vkEndCommandBuffer(_framesData[imageIndex].commandBuffer));
+    VK_CHECK(vkEndCommandBuffer(frameData.commandBuffer));
 
     VK_CHECK(vkQueueSubmit(_vulkan->getGraphicsQueue(), 1, &submitInfo, frameData.renderFinishedFence));
 
@@ -676,11 +807,14 @@ void VulkanRenderer::drawFrame()
     }
 
     _currentFrame = (_currentFrame + 1) % _MAX_FRAMES_IN_FLIGHT;
+    _frameNumber++;
 }
 
-void VulkanRenderer::_drawObjectsCommands(VkCommandBuffer cmd, VkFramebuffer framebuffer)
+void VulkanRenderer::_drawObjectsCommands(VkCommandBuffer cmd, VkFramebuffer framebuffer, ShaderPass::Type passType)
 {
-    VkPipeline currentPipeline = _materialBuilder.getMaterialTemplate(MaterialType::BASIC)->getPipeline(ShaderPass::Type::FORWARD);
+    // The depth-only pipeline shares the layout of the forward pass (see MaterialBuilder), so the descriptor sets are bound the same way
+    bool depthOnly = passType == ShaderPass::Type::DEPTH_ONLY;
+    VkPipeline currentPipeline = _materialBuilder.getMaterialTemplate(MaterialType::BASIC)->getPipeline(passType);
     VkPipelineLayout graphicsPipelineLayout = _materialBuilder.getMaterialTemplate(MaterialType::BASIC)->getPipelineLayout(ShaderPass::Type::FORWARD);
     vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, currentPipeline);
 
@@ -705,35 +839,44 @@ void VulkanRenderer::_drawObjectsCommands(VkCommandBuffer cmd, VkFramebuffer fra
     vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS,
         graphicsPipelineLayout, 0, 1, &_globalDataDescriptorSet, 0, nullptr);
 
-    uint32_t offset = 0;
-    uint32_t stride = sizeof(GPUIndirectDrawCommand);
-    for (const DrawCallInfo& batch : _drawCalls) {
-        const Material* material = batch.material;
-
-        VkPipeline materialPipeline = _materialBuilder.getMaterialTemplate(MaterialType::BASIC)->getPipeline(ShaderPass::Type::FORWARD);
-        if (currentPipeline != materialPipeline) {
-            currentPipeline = materialPipeline;
-            graphicsPipelineLayout = _materialBuilder.getMaterialTemplate(MaterialType::BASIC)->getPipelineLayout(ShaderPass::Type::FORWARD);
-            vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, currentPipeline);
+    // Objects data descriptor set
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS,
+        graphicsPipelineLayout, 1, 1, &_objectsDataDescriptorSet, 0, nullptr);
+
+    // All the shapes are in the same vertex and index buffers. Positions only for the depth-only pass.
+    VkBuffer vertexBuffers[] = { _positionBuffer.buffer, _attributeBuffer.buffer };
+    VkDeviceSize offsets[] = { 0, 0 };
+    vkCmdBindVertexBuffers(cmd, 0, depthOnly ? 1 : 2, vertexBuffers, offsets);
+
+    // The depth-only pass does not read the materials, so the whole scene is a single draw call per index type
+    const std::vector<MaterialDrawInfo>& draws = depthOnly ? _indexTypeDraws : _materialDraws;
+    const Material* boundMaterial = nullptr;
+    VkIndexType boundIndexType = VK_INDEX_TYPE_MAX_ENUM;
+    for (const MaterialDrawInfo& draw : draws) {
+        if (draw.indexType != boundIndexType) {
+            boundIndexType = draw.indexType;
+            vkCmdBindIndexBuffer(cmd, _indexBuffer.buffer, 0, boundIndexType);
         }
+        if (draw.material && draw.material != boundMaterial) {
+            boundMaterial = draw.material;
+            vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                graphicsPipelineLayout, 2, 1, &boundMaterial->getDescriptorSet(ShaderPass::Type::FORWARD), 0, nullptr);
+            vkCmdPushConstants(cmd, graphicsPipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(uint32_t), &draw.feedbackSlot);
+        }
+        _drawIndirectCommands(cmd, draw.firstCommand, draw.nbCommands);
+    }
+}
 
-        VkDeviceSize offsets[] = { 0 };
-
-        // Materials data descriptor set
-        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS,
-            graphicsPipelineLayout, 2, 1, &material->getDescriptorSet(ShaderPass::Type::FORWARD), 0, nullptr);
-
-        // Objects data descriptor set
-        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS,
-            graphicsPipelineLayout, 1, 1, &_objectsDataDescriptorSet, 0, nullptr);
-
-        vkCmdBindVertexBuffers(cmd, 0, 1, &batch.shape->vertexBuffer.buffer, offsets);
-
-        vkCmdBindIndexBuffer(cmd, batch.shape->indexBuffer.buffer, 0, VK_INDEX_TYPE_UINT32);
-
-        vkCmdDrawIndexedIndirect(cmd, _gpuBatches.buffer, offset, 1, stride);
-
-        offset += stride;
+void VulkanRenderer::_drawIndirectCommands(VkCommandBuffer cmd, uint32_t firstCommand, uint32_t nbCommands)
+{
+    // One command per cluster of LOD 0 and per other LOD of each batch. Only the LOD picked by the culling shader for each object,
+    // or the clusters of LOD 0 left by the cluster culling shader, have instances.
+    // Split only if the device limits the number of commands of a call.
+    uint32_t stride = sizeof(GPUIndirectDrawCommand);
+    uint32_t maxDrawCount = std::max(_vulkan->getProperties().maxDrawIndirectCount, 1u);
+    for (uint32_t command = firstCommand; command < firstCommand + nbCommands; command += maxDrawCount) {
+        uint32_t drawCount = std::min(maxDrawCount, firstCommand + nbCommands - command);
+        vkCmdDrawIndexedIndirect(cmd, _gpuBatches.buffer, command * stride, drawCount, stride);
     }
 }
 
@@ -787,6 +930,9 @@ void VulkanRenderer::_updateDynamicData() {
     GPUDynamicData miscData{};
     miscData.occlusionCulling = _applicationState->occlusionCulling ? 1 : 0;
     miscData.frustumCulling = _applicationState->frustumCulling ? 1 : 0;
+    miscData.lodErrorThreshold = _applicationState->lodSelection ? _LOD_PIXEL_ERROR / _vulkan->getProperties().swapChainExtent.height : 0.f;
+    miscData.clusterCulling = _applicationState->clusterCulling ? 1 : 0;
+    miscData.hlodErrorThreshold = _applicationState->hlodSelection ? _HLOD_PIXEL_ERROR / _vulkan->getProperties().swapChainExtent.height : 0.f;
     miscData.forcedColoring = _applicationState->makeAllObjectsTransparent ? glm::vec4(1.0f, 0.7f, 0.7f, 0.3f) : glm::vec4(1.0);
 
     if (!_applicationState->lockCullingCamera) {
@@ -798,59 +944,119 @@ void VulkanRenderer::_updateDynamicData() {
 }
 
 
-void VulkanRenderer::loadSceneToDevice(const leoscene::Scene* scene)
+uint32_t VulkanRenderer::loadSceneToDevice(const std::vector<const leoscene::Scene*>& scenes)
 {
-    /*
-    * Loading scene objects to device
-    */
+    size_t nbObjects = 0;
+    for (const leoscene::Scene* scene : scenes) {
+        nbObjects += scene->getNbObjects();
+    }
+    if (!nbObjects) {
+        throw VulkanRendererException("The scene does not contain any objects!");
+    }
 
-    struct _ObjectInstanceData {
-        const leoscene::Shape* shape = nullptr;
-        const leoscene::Transform* transform = nullptr;
-    };
-    std::map<const Material*, std::map<const ShapeData*, std::vector<_ObjectInstanceData>>> objectInstances;
+    // Nothing is waited for: the new data and the levels of the new images are copied at the start of the next frame, and the buffers
+    // replaced or used for staging are freed once the frames in flight are done (see _recordSceneCopies and _recordImageUploads).
+    // Only the new objects, shapes, clusters and textures are uploaded.
+
+    uint32_t firstObject = _totalInstancesNb;
+    std::vector<leoscene::PackedVertexPosition> newPositions;
+    std::vector<leoscene::PackedVertexAttributes> newAttributes;
+    std::vector<unsigned char> newIndexData;
+    std::vector<GPUObjectData> newObjectsData;
+    std::vector<uint32_t> newObjectsHlod;
+    size_t nbPreviousBatches = _drawCalls.size();
+    size_t nbPreviousClusters = _clusters.size();
+    size_t nbPreviousHlodClusters = _hlodClusters.size();
+
+    // The object space bounds are kept to compute the bounds again when the object moves.
+    _objectsLocalBounds.resize(firstObject + nbObjects);
+    _objectsLocalBoxes.resize(firstObject + nbObjects);
+    _pendingObjectUpdateSlots.resize(firstObject + nbObjects, UINT32_MAX);
+    _objectsBatch.resize(firstObject + nbObjects);
+
+    for (const leoscene::Scene* scene : scenes) {
+        uint32_t sceneFirstObject = firstObject + static_cast<uint32_t>(newObjectsData.size());
+        size_t nbSceneObjects = scene->getNbObjects();
+
+        /*
+        * Loading scene materials to device. Materials and textures already loaded by a previous call are reused.
+        */
+
+        std::vector<const Material*> loadedMaterials(scene->materials.size(), nullptr);
+
+        for (size_t materialIdx = 0; materialIdx < scene->materials.size(); ++materialIdx) {
+            const std::shared_ptr<const leoscene::Material>& material = scene->materials[materialIdx];
+            auto loadedMaterialIt = _loadedMaterials.find(material.get());
+            if (loadedMaterialIt != _loadedMaterials.end() && !loadedMaterialIt->second.source.expired()) {
+                loadedMaterials[materialIdx] = loadedMaterialIt->second.data;
+                continue;
+            }
 
-    {
-        std::map<const leoscene::Material*, Material*> loadedMaterialsCache;
-        std::map<const leoscene::ImageTexture*, AllocatedImage*> loadedImagesCache;
-        std::map<const leoscene::ImageTexture*, VkSampler> loadedImageSamplersCache;
-        std::map<const leoscene::Shape*, ShapeData*> shapeDataCache;
-
-        for (const leoscene::SceneObject& sceneObject : scene->objects) {
-            const leoscene::PerformanceMaterial* sceneMaterial = static_cast<const leoscene::PerformanceMaterial*>(sceneObject.material.get());
-            const leoscene::Shape* sceneShape = sceneObject.shape.get();
-            Material* loadedMaterial = nullptr;
-            ShapeData* loadedShape = nullptr;
-
-            // Load material data on the device
-
-            if (loadedMaterialsCache.find(sceneMaterial) == loadedMaterialsCache.end()) {
-                loadedMaterial = _materialBuilder.createMaterial(MaterialType::BASIC);
-
-                static const size_t nbTexturesInMaterial = 5;
-                std::array<const leoscene::ImageTexture*, nbTexturesInMaterial> materialTextures = {
-                    sceneMaterial->diffuseTexture.get(), sceneMaterial->specularTexture.get(), sceneMaterial->ambientTexture.get(), sceneMaterial->normalsTexture.get(), sceneMaterial->heightTexture.get()
-                };
-
-                for (size_t i = 0; i < nbTexturesInMaterial; ++i) {
-                    const leoscene::ImageTexture* sceneTexture = materialTextures[i];
-                    AllocatedImage* loadedImage = nullptr;
-                    VkSampler loadedImageSampler = VK_NULL_HANDLE;
-                    if (loadedImagesCache.find(sceneTexture) == loadedImagesCache.end()) {
-                        _materialImagesData.push_back(std::make_unique<AllocatedImage>());
-                        loadedImage = _materialImagesData.back().get();
-
-                        uint32_t texWidth = static_cast<uint32_t>(sceneTexture->width);
-                        uint32_t texHeight = static_cast<uint32_t>(sceneTexture->height);
-
-                        uint32_t imageMipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(texWidth, texHeight)))) + 1;
-
-                        uint32_t nbChannels = 0;
-                        VkFormat imageFormat = VkFormat::VK_FORMAT_UNDEFINED;
+            const leoscene::PerformanceMaterial* sceneMaterial = static_cast<const leoscene::PerformanceMaterial*>(material.get());
+            Material* loadedMaterial = _materialBuilder.createMaterial(MaterialType::BASIC);
+
+            // Every material has a slot in the texture feedback buffer, written by shader.frag
+            uint32_t feedbackSlot = static_cast<uint32_t>(_streamedMaterials.size());
+            _streamedMaterials.push_back({ loadedMaterial });
+            _feedbackSlots[loadedMaterial] = feedbackSlot;
+
+            static const size_t nbTexturesInMaterial = 5;
+            std::array<const std::shared_ptr<const leoscene::ImageTexture>*, nbTexturesInMaterial> materialTextures = {
+                &sceneMaterial->diffuseTexture, &sceneMaterial->specularTexture, &sceneMaterial->ambientTexture, &sceneMaterial->normalsTexture, &sceneMaterial->heightTexture
+            };
+
+            for (size_t i = 0; i < nbTexturesInMaterial; ++i) {
+                const leoscene::ImageTexture* sceneTexture = materialTextures[i]->get();
+                AllocatedImage* loadedImage = nullptr;
+                auto loadedImageIt = _loadedImages.find(sceneTexture);
+                if (loadedImageIt == _loadedImages.end() || loadedImageIt->second.source.expired()) {
+                    _materialImagesData.push_back(std::make_unique<AllocatedImage>());
+                    loadedImage = _materialImagesData.back().get();
+
+                    // Textures come with their mip levels, already in the format of the image, and are uploaded as they are.
+                    // Textures without mip levels (the default ones) only have their first level.
+                    bool compressed = sceneTexture->compression != leoscene::ImageTexture::Compression::NONE;
+                    std::vector<leoscene::ImageTexture::MipLevel> textureMipLevels = sceneTexture->mipLevels;
+                    if (textureMipLevels.empty()) {
+                        textureMipLevels.push_back({ sceneTexture->width, sceneTexture->height, 0, sceneTexture->getDataSize() });
+                    }
+                    uint32_t nbTextureMipLevels = static_cast<uint32_t>(textureMipLevels.size());
+
+                    // Streamed textures start with their coarse levels only. The image holds the resident levels, from its level 0.
+                    bool streamed = _options.textureStreaming && nbTextureMipLevels > 1;
+                    uint32_t firstLevel = 0;
+                    if (streamed) {
+                        uint32_t streamedTextureId = _textureResidency.addTexture(*sceneTexture);
+                        firstLevel = _textureResidency.getFirstResidentLevel(streamedTextureId);
+                        _streamedTextures.push_back({ *materialTextures[i], loadedImage });
+                        _streamedTextureIds[loadedImage] = streamedTextureId;
+                    }
+                    uint32_t imageMipLevels = nbTextureMipLevels - firstLevel;
+                    size_t firstLevelOffset = textureMipLevels[firstLevel].offset;
+
+                    VkFormat imageFormat = VkFormat::VK_FORMAT_UNDEFINED;
+                    if (compressed) {
+                        switch (sceneTexture->compression) {
+                        case leoscene::ImageTexture::Compression::BC1:
+                            imageFormat = VK_FORMAT_BC1_RGB_SRGB_BLOCK;
+                            break;
+                        case leoscene::ImageTexture::Compression::BC4:
+                            imageFormat = VK_FORMAT_BC4_UNORM_BLOCK;
+                            break;
+                        case leoscene::ImageTexture::Compression::BC5:
+                            imageFormat = VK_FORMAT_BC5_UNORM_BLOCK;
+                            break;
+                        case leoscene::ImageTexture::Compression::BC7:
+                            imageFormat = VK_FORMAT_BC7_SRGB_BLOCK;
+                            break;
+                        default:
+                            break;
+                        }
+                    }
+                    else {
                         switch (sceneTexture->layout) {
                         case leoscene::ImageTexture::Layout::R:
                             imageFormat = VK_FORMAT_R8_UNORM;
-                            nbChannels = 1;
                             break;
                         case leoscene::ImageTexture::Layout::RGBA:
                             if (i == 3) { // Normals texture
@@ -859,146 +1065,244 @@ void VulkanRenderer::loadSceneToDevice(const leoscene::Scene* scene)
                             else {
                                 imageFormat = VK_FORMAT_R8G8B8A8_SRGB;
                             }
-                            nbChannels = 4;
                             break;
                         default:
                             break;
                         }
+                    }
 
-                        if (!nbChannels || imageFormat == VkFormat::VK_FORMAT_UNDEFINED) {
-                            throw VulkanRendererException("A texture on a sceneMaterial has a format that is not expected. Something is very very wrong.");
-                        }
-
-                        // Image handle and memory
-
-                        _vulkan->createImage(texWidth, texHeight, imageMipLevels, VK_SAMPLE_COUNT_1_BIT, imageFormat, VK_IMAGE_TILING_OPTIMAL,
-                            VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-                            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, *loadedImage);
-
-                        VkCommandBuffer cmd = _vulkan->beginSingleTimeCommands(_mainCommandPool);
-                        VkImageMemoryBarrier textureCopyDstBarrier = VulkanUtils::createImageBarrier(
-                            VK_IMAGE_LAYOUT_UNDEFINED,
-                            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                            loadedImage->image,
-                            VK_IMAGE_ASPECT_COLOR_BIT, 0, VK_ACCESS_TRANSFER_WRITE_BIT,
-                            0, loadedImage->mipLevels
-                        );
-                        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &textureCopyDstBarrier);
-                        _vulkan->endSingleTimeCommands(cmd, _mainCommandPool);
+                    if (imageFormat == VkFormat::VK_FORMAT_UNDEFINED) {
+                        throw VulkanRendererException("A texture on a sceneMaterial has a format that is not expected. Something is very very wrong.");
+                    }
+                    if (streamed) {
+                        _streamedTextures.back().format = imageFormat;
+                    }
 
-                        _vulkan->copyDataToImage(_mainCommandPool, texWidth, texHeight, nbChannels, *loadedImage, sceneTexture->data);
+                    // Image handle and memory. Streamed images are also copied to the images replacing them.
+
+                    _vulkan->createImage(static_cast<uint32_t>(textureMipLevels[firstLevel].width), static_cast<uint32_t>(textureMipLevels[firstLevel].height),
+                        imageMipLevels, VK_SAMPLE_COUNT_1_BIT, imageFormat, VK_IMAGE_TILING_OPTIMAL,
+                        VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | (streamed ? VK_IMAGE_USAGE_TRANSFER_SRC_BIT : 0),
+                        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, *loadedImage);
+
+                    std::vector<VkBufferImageCopy> copyRegions(imageMipLevels);
+                    for (size_t level = 0; level < copyRegions.size(); ++level) {
+                        const leoscene::ImageTexture::MipLevel& mipLevel = textureMipLevels[firstLevel + level];
+                        copyRegions[level].bufferOffset = mipLevel.offset - firstLevelOffset;
+                        copyRegions[level].imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+                        copyRegions[level].imageSubresource.mipLevel = static_cast<uint32_t>(level);
+                        copyRegions[level].imageSubresource.layerCount = 1;
+                        copyRegions[level].imageExtent = { static_cast<uint32_t>(mipLevel.width), static_cast<uint32_t>(mipLevel.height), 1 };
+                    }
+                    _uploadToImage(*loadedImage, sceneTexture->data + firstLevelOffset, sceneTexture->getDataSize() - firstLevelOffset, copyRegions);
 
-                        _vulkan->generateMipmaps(_mainCommandPool, *loadedImage, imageFormat, texWidth, texHeight);
+                    _vulkan->createImageView(loadedImage->image, imageFormat, VK_IMAGE_ASPECT_COLOR_BIT, loadedImage->mipLevels, loadedImage->view);
 
-                        _vulkan->createImageView(loadedImage->image, imageFormat, VK_IMAGE_ASPECT_COLOR_BIT, loadedImage->mipLevels, loadedImage->view);
+                    _loadedImages[sceneTexture] = { *materialTextures[i], loadedImage };
+                }
+                else {
+                    loadedImage = loadedImageIt->second.data;
+                }
 
-                        VkSamplerCreateInfo samplerInfo = {};
-                        samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-                        samplerInfo.magFilter = VK_FILTER_LINEAR;
-                        samplerInfo.minFilter = VK_FILTER_LINEAR;
-                        samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-                        samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-                        samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-                        samplerInfo.anisotropyEnable = VK_TRUE;
+                loadedMaterial->textures[i].view = loadedImage->view;
 
-                        samplerInfo.maxAnisotropy = _vulkan->getProperties().maxSamplerAnisotropy;
+                auto streamedTextureIdIt = _streamedTextureIds.find(loadedImage);
+                if (streamedTextureIdIt != _streamedTextureIds.end()) {
+                    StreamedTexture& streamedTexture = _streamedTextures[streamedTextureIdIt->second];
+                    _streamedMaterials[feedbackSlot].textures[i] = streamedTextureIdIt->second;
+                    if (streamedTexture.materials.empty() || streamedTexture.materials.back() != feedbackSlot) {
+                        streamedTexture.materials.push_back(feedbackSlot);
+                    }
+                }
+            }
 
-                        samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
-                        samplerInfo.unnormalizedCoordinates = VK_FALSE;
-                        samplerInfo.compareEnable = VK_FALSE;
-                        samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
+            _materialBuilder.setupMaterialDescriptorSets(*loadedMaterial);
+            const std::array<uint32_t, nbTexturesInMaterial>& streamedTextures = _streamedMaterials[feedbackSlot].textures;
+            if (std::any_of(streamedTextures.begin(), streamedTextures.end(), [](uint32_t texture) { return texture != _NOT_STREAMED; })) {
+                for (VkDescriptorSet& spareDescriptorSet : _streamedMaterials[feedbackSlot].spareDescriptorSets) {
+                    spareDescriptorSet = _materialBuilder.createMaterialDescriptorSet(*loadedMaterial);
+                }
+            }
 
-                        samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-                        samplerInfo.minLod = 0.0f;
-                        samplerInfo.maxLod = static_cast<float>(loadedImage->mipLevels);
-                        samplerInfo.mipLodBias = 0.0f;
+            _loadedMaterials[material.get()] = { material, loadedMaterial };
+            loadedMaterials[materialIdx] = loadedMaterial;
+            _nbMaterials++;
+        }
 
-                        _materialImagesSamplers.emplace_back();
-                        VK_CHECK(vkCreateSampler(_device, &samplerInfo, nullptr, &_materialImagesSamplers.back()));
-                        loadedImageSampler = _materialImagesSamplers.back();
 
-                        loadedImagesCache[sceneTexture] = loadedImage;
-                        loadedImageSamplersCache[sceneTexture] = loadedImageSampler;
-                    }
-                    else {
-                        loadedImage = loadedImagesCache[sceneTexture];
-                        loadedImageSampler = loadedImageSamplersCache[sceneTexture];
-                    }
+        /*
+        * Load shape data on the device. Shapes already loaded by a previous call are reused.
+        * The vertices and indices of the new shapes are appended to the global vertex and index buffers.
+        */
 
-                    loadedMaterial->textures[i].sampler = loadedImageSampler;
-                    loadedMaterial->textures[i].view = loadedImage->view;
-                }
+        std::vector<const ShapeData*> loadedShapes(scene->shapes.size(), nullptr);
 
-                _materialBuilder.setupMaterialDescriptorSets(*loadedMaterial);
+        for (size_t shapeIdx = 0; shapeIdx < scene->shapes.size(); ++shapeIdx) {
+            const std::shared_ptr<const leoscene::Shape>& shape = scene->shapes[shapeIdx];
+            auto loadedShapeIt = _loadedShapes.find(shape.get());
+            if (loadedShapeIt != _loadedShapes.end() && !loadedShapeIt->second.source.expired()) {
+                loadedShapes[shapeIdx] = loadedShapeIt->second.data;
+                continue;
+            }
 
-                loadedMaterialsCache[sceneMaterial] = loadedMaterial;
+            _shapeData.push_back(std::make_unique<ShapeData>());
+            ShapeData* loadedShape = _shapeData.back().get();
+
+            const leoscene::Mesh* mesh = static_cast<const leoscene::Mesh*>(shape.get());  // TODO: assuming the shape is a mesh for now
+
+            // Vertices, in the packed layout decoded by the vertex shaders. Positions and other attributes are separate streams.
+            // Positions are quantized in the bounding box of the mesh, which the vertex shaders read from the data of each object.
+            leoscene::VertexQuantization quantization;
+            quantization.positionOffset = mesh->boundingBoxMin;
+            quantization.positionScale = mesh->boundingBoxMax - mesh->boundingBoxMin;
+            loadedShape->localBox.center = glm::vec4((mesh->boundingBoxMin + mesh->boundingBoxMax) * 0.5f, 0);
+            loadedShape->localBox.extents = glm::vec4(quantization.positionScale * 0.5f, 0);
+
+            loadedShape->vertexOffset = _nbVertices + static_cast<uint32_t>(newPositions.size());
+            newPositions.resize(newPositions.size() + mesh->vertices.size());
+            newAttributes.resize(newAttributes.size() + mesh->vertices.size());
+            leoscene::packVertices(mesh->vertices.data(), mesh->vertices.size(), quantization,
+                newPositions.data() + newPositions.size() - mesh->vertices.size(), newAttributes.data() + newAttributes.size() - mesh->vertices.size());
+
+            // Indices, 16 bits wide when the mesh has few enough vertices. Each shape starts on 4 bytes, so that firstIndex counts whole indices
+            // of its type from the start of the index buffer.
+            VkDeviceSize indexDataOffset = _indexDataSize + newIndexData.size();
+            size_t indexSize = leoscene::getIndexSize(mesh->indexType);
+            loadedShape->indexType = mesh->indexType == leoscene::IndexType::UINT16 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+            loadedShape->firstIndex = static_cast<uint32_t>(indexDataOffset / indexSize);
+            newIndexData.resize(newIndexData.size() + (mesh->indices.size() * indexSize + 3) / 4 * 4);
+            if (mesh->indexType == leoscene::IndexType::UINT16) {
+                uint16_t* shortIndices = reinterpret_cast<uint16_t*>(newIndexData.data() + (indexDataOffset - _indexDataSize));
+                std::copy(mesh->indices.begin(), mesh->indices.end(), shortIndices);
             }
             else {
-                loadedMaterial = loadedMaterialsCache[sceneMaterial];
+                memcpy(newIndexData.data() + (indexDataOffset - _indexDataSize), mesh->indices.data(), mesh->indices.size() * sizeof(uint32_t));
+            }
+
+            // Levels of detail, as ranges of the index buffer. A mesh without LODs is its own LOD 0.
+            loadedShape->lods = mesh->lods;
+            if (loadedShape->lods.empty()) {
+                loadedShape->lods.push_back({ 0, static_cast<uint32_t>(mesh->indices.size()), 0.f });
+            }
+
+            // Clusters of LOD 0, each with a command of its own, before the commands of the LODs
+            loadedShape->clusters = mesh->clusters;
+            loadedShape->firstCluster = static_cast<uint32_t>(_clusters.size());
+            loadedShape->nbCommands = static_cast<uint32_t>(loadedShape->clusters.size() + loadedShape->lods.size());
+            for (const leoscene::MeshCluster& cluster : loadedShape->clusters) {
+                _clusters.push_back({ cluster.boundingSphere, glm::vec4(cluster.coneAxis, cluster.coneCutoff) });
             }
 
+            _loadedShapes[shape.get()] = { shape, loadedShape };
+            loadedShapes[shapeIdx] = loadedShape;
+        }
+
 
-            /*
-            * Load shape data on the device
-            */
+        /*
+        * Finding the batch of each object. Each pair of material and shape is one object batch, used to compute an indirect draw command.
+        * Batches are only ever appended, so that the objects already on the device keep their batch id.
+        */
 
-            if (shapeDataCache.find(sceneShape) == shapeDataCache.end()) {
-                _shapeData.push_back(std::make_unique<ShapeData>());
-                loadedShape = _shapeData.back().get();
+        std::map<std::pair<uint32_t, uint32_t>, uint32_t> sceneBatches;  // Material and shape indices in the scene, to batch id
+        for (size_t i = 0; i < nbSceneObjects; ++i) {
+            sceneBatches.emplace(std::make_pair(scene->materialIndices[i], scene->shapeIndices[i]), 0);
+        }
+        for (auto& sceneBatch : sceneBatches) {
+            const Material* material = loadedMaterials[sceneBatch.first.first];
+            const ShapeData* shape = loadedShapes[sceneBatch.first.second];
+            auto drawCallIt = _drawCallIndices.find({ material, shape });
+            if (drawCallIt == _drawCallIndices.end()) {
+                drawCallIt = _drawCallIndices.emplace(std::make_pair(material, shape), static_cast<uint32_t>(_drawCalls.size())).first;
+                _drawCalls.push_back({ material, shape,
+                    0,  // nbObjects
+                    0, // firstCommand, set below
+                    });
+                _nbDrawCommands += shape->nbCommands;
+            }
+            sceneBatch.second = drawCallIt->second;
+        }
 
-                const leoscene::Mesh* mesh = static_cast<const leoscene::Mesh*>(sceneShape);  // TODO: assuming the shape is a mesh for now
+        for (size_t i = 0; i < nbSceneObjects; ++i) {
+            uint32_t batchIdx = sceneBatches[std::make_pair(scene->materialIndices[i], scene->shapeIndices[i])];
+            _objectsBatch[sceneFirstObject + i] = batchIdx;
+            _drawCalls[batchIdx].nbObjects++;
+        }
 
-                // Vertex buffer
-                _vulkan->createGPUBufferFromCPUData(_mainCommandPool, sizeof(leoscene::Vertex) * mesh->vertices.size(),
-                    VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, mesh->vertices.data(),
-                    loadedShape->vertexBuffer);
 
-                // Index buffer
-                _vulkan->createGPUBufferFromCPUData(_mainCommandPool, sizeof(mesh->indices[0]) * mesh->indices.size(),
-                    VK_BUFFER_USAGE_INDEX_BUFFER_BIT, mesh->indices.data(),
-                    loadedShape->indexBuffer);
+        /*
+        * Per-object data, appended after the objects already on the device
+        */
 
-                loadedShape->nbElements = static_cast<uint32_t>(mesh->indices.size());
+        for (size_t i = 0; i < nbSceneObjects; ++i) {
+            const leoscene::Mesh* mesh = static_cast<const leoscene::Mesh*>(scene->shapes[scene->shapeIndices[i]].get());
+            _objectsLocalBounds[sceneFirstObject + i] = mesh->boundingSphere;
+            _objectsLocalBoxes[sceneFirstObject + i] = loadedShapes[scene->shapeIndices[i]]->localBox;
+        }
 
-                shapeDataCache[sceneShape] = loadedShape;
-            }
-            else {
-                loadedShape = shapeDataCache[sceneShape];
-            }
+        // Computing sphere bounds of the objects in world space
+        std::vector<glm::vec4> worldBounds(nbSceneObjects);
+        leoscene::transformBoundingSpheres(scene->worldMatrices.data(), _objectsLocalBounds.data() + sceneFirstObject, worldBounds.data(), nbSceneObjects);
 
+        for (size_t i = 0; i < nbSceneObjects; ++i) {
+            GPUObjectData objectData;
+            objectData.modelMatrix = scene->worldMatrices[i];
+            objectData.sphereBounds = worldBounds[i];
+            objectData.localBox = _objectsLocalBoxes[sceneFirstObject + i];
+            newObjectsData.push_back(objectData);
+        }
 
-            /*
-            * Incrementing the counter for the given pair of material and shape data.
-            */
 
-            if (objectInstances.find(loadedMaterial) == objectInstances.end()) {
-                objectInstances[loadedMaterial] = {};
-            }
-            if (objectInstances[loadedMaterial].find(loadedShape) == objectInstances[loadedMaterial].end()) {
-                objectInstances[loadedMaterial][loadedShape] = {};
+        /*
+        * HLOD clusters of the new objects, appended after the clusters already loaded. The objects of the scene are numbered from sceneFirstObject.
+        */
+
+        size_t sceneFirstHlod = newObjectsHlod.size();
+        newObjectsHlod.resize(sceneFirstHlod + nbSceneObjects, _NO_HLOD);
+        for (size_t i = 0; i < scene->hlodClusters.size(); ++i) {
+            const leoscene::HlodCluster& cluster = scene->hlodClusters[i];
+            uint32_t hlodIndex = static_cast<uint32_t>(_hlodClusters.size());
+            newObjectsHlod[sceneFirstHlod + cluster.proxyObject] = (hlodIndex << 1) | 1;
+            for (uint32_t j = 0; j < cluster.nbMembers; ++j) {
+                newObjectsHlod[sceneFirstHlod + scene->hlodMembers[cluster.firstMember + j]] = hlodIndex << 1;
             }
-            objectInstances[loadedMaterial][loadedShape].push_back({ sceneShape, sceneObject.transform.get() });
+            GPUHlodCluster gpuCluster;
+            gpuCluster.sphereBounds = cluster.boundingSphere;
+            gpuCluster.error = cluster.error;
+            _hlodClusters.push_back(gpuCluster);
         }
-
     }
 
-    _nbMaterials = objectInstances.size();
+    _totalInstancesNb += static_cast<uint32_t>(nbObjects);
 
 
     /*
-    * Initializing the object batches used to compute draw indirect commands
+    * Vertices and indices of the new shapes, appended to the global vertex and index buffers.
+    * The capacities are doubled to keep the number of reallocations low when the scene is loaded in many small parts.
     */
 
-    for (const auto& materialShapesPair : objectInstances) {
-        const Material* material = materialShapesPair.first;  // TODO: assuming material is Performance for now
-        for (const auto& shapeNbPair : materialShapesPair.second) {
-            const ShapeData* shape = shapeNbPair.first;  // TODO: assuming the shape is a mesh for now
-
-            _drawCalls.push_back({ material, shape,
-                static_cast<uint32_t>(shapeNbPair.second.size()),  // nbObjects
-                shape->nbElements, // primitivesPerObject
-                });
+    if (newPositions.size()) {
+        uint32_t nbVertices = _nbVertices + static_cast<uint32_t>(newPositions.size());
+        if (nbVertices > _verticesCapacity) {
+            _verticesCapacity = std::max(_verticesCapacity * 2, nbVertices);
+            _growSceneBuffer(_positionBuffer, _nbVertices * sizeof(leoscene::PackedVertexPosition),
+                _verticesCapacity * sizeof(leoscene::PackedVertexPosition), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+            _growSceneBuffer(_attributeBuffer, _nbVertices * sizeof(leoscene::PackedVertexAttributes),
+                _verticesCapacity * sizeof(leoscene::PackedVertexAttributes), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+        }
+        _uploadToSceneBuffer(_positionBuffer, _nbVertices * sizeof(leoscene::PackedVertexPosition),
+            newPositions.data(), newPositions.size() * sizeof(leoscene::PackedVertexPosition));
+        _uploadToSceneBuffer(_attributeBuffer, _nbVertices * sizeof(leoscene::PackedVertexAttributes),
+            newAttributes.data(), newAttributes.size() * sizeof(leoscene::PackedVertexAttributes));
+        _nbVertices = nbVertices;
+    }
+    if (newIndexData.size()) {
+        VkDeviceSize indexDataSize = _indexDataSize + newIndexData.size();
+        if (indexDataSize > _indexDataCapacity) {
+            _indexDataCapacity = std::max(_indexDataCapacity * 2, indexDataSize);
+            _growSceneBuffer(_indexBuffer, _indexDataSize, _indexDataCapacity, VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
         }
+        _uploadToSceneBuffer(_indexBuffer, _indexDataSize, newIndexData.data(), newIndexData.size());
+        _indexDataSize = indexDataSize;
     }
 
 
@@ -1006,115 +1310,173 @@ void VulkanRenderer::loadSceneToDevice(const leoscene::Scene* scene)
     * Filling global scene data
     */
 
-    // TODO: Put actual values (maybe from options and/or leoscene::Scene)
-    GPUSceneData sceneData;
-    sceneData.ambientColor = { 1, 0, 0, 0 };
-    sceneData.sunlightColor = { 0, 1, 0, 0 };
-    sceneData.sunlightDirection = { 0, 0, 0, 1 };
-    _vulkan->copyDataToBuffer(sizeof(GPUSceneData), _sceneDataBuffer, &sceneData);
+    if (!_sceneLoaded) {
+        // TODO: Put actual values (maybe from options and/or leoscene::Scene)
+        GPUSceneData sceneData;
+        sceneData.ambientColor = { 1, 0, 0, 0 };
+        sceneData.sunlightColor = { 0, 1, 0, 0 };
+        sceneData.sunlightDirection = { 0, 0, 0, 1 };
+        _vulkan->copyDataToBuffer(sizeof(GPUSceneData), _sceneDataBuffer, &sceneData);
+    }
+
 
     /*
-    * Per-object data
+    * Growing the per-object buffers if the new objects do not fit, then appending the data of the new objects.
     */
 
+    if (_totalInstancesNb > _objectsCapacity) {
+        uint32_t capacity = std::max(std::max(_objectsCapacity * 2, _totalInstancesNb), _MIN_OBJECTS_CAPACITY);
+        _growSceneBuffer(_objectsDataBuffer, firstObject * sizeof(GPUObjectData), capacity * sizeof(GPUObjectData), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+        _growSceneBuffer(_gpuObjectInstances, firstObject * sizeof(GPUObjectInstance), capacity * sizeof(GPUObjectInstance), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+        _growSceneBuffer(_gpuClusteredInstances, 0, capacity * sizeof(GPUObjectInstance), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);  // Written by the culling shader every frame
+        _growSceneBuffer(_gpuObjectsHlod, firstObject * sizeof(uint32_t), capacity * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+        _objectsCapacity = capacity;
+    }
+
+    _uploadToSceneBuffer(_objectsDataBuffer, firstObject * sizeof(GPUObjectData), newObjectsData.data(), nbObjects * sizeof(GPUObjectData));
+    _uploadToSceneBuffer(_gpuObjectsHlod, firstObject * sizeof(uint32_t), newObjectsHlod.data(), nbObjects * sizeof(uint32_t));
+
+
+    /*
+    * Layout of the indirect draw commands. The commands are sorted by index type, then by material, so that each material
+    * is drawn with a single call per index type. Materials keep the order in which they were first loaded.
+    */
+
+    std::vector<uint32_t> batchesOrder;
     {
-        size_t objectsDataBufferSize = scene->objects.size() * sizeof(GPUObjectData);
-        if (!objectsDataBufferSize) {
-            throw VulkanRendererException("The scene does not contain any objects!");
+        std::unordered_map<const Material*, uint32_t> materialsOrder;
+        for (const DrawCallInfo& drawCall : _drawCalls) {
+            materialsOrder.emplace(drawCall.material, static_cast<uint32_t>(materialsOrder.size()));
         }
-
-        AllocatedBuffer stagingBuffer;
-        _vulkan->createBuffer(objectsDataBufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY, stagingBuffer);
-
-        GPUObjectData* objectDataPtr = static_cast<GPUObjectData*>(_vulkan->mapBuffer(stagingBuffer));
-        int i = 0;
-        for (const auto& materialShapesPair : objectInstances) {
-            const Material* material = materialShapesPair.first;  // TODO: assuming material is Performance for now
-            for (const auto& shapeNbPair : materialShapesPair.second) {
-                const ShapeData* shape = shapeNbPair.first;  // TODO: assuming the shape is a mesh for now
-                for (const _ObjectInstanceData& instanceData : shapeNbPair.second) {
-                    const glm::mat4& modelMatrix = instanceData.transform->getMatrix();
-                    objectDataPtr[i].modelMatrix = modelMatrix;
-
-                    // Computing sphere bounds of the object in world space
-                    const glm::vec4& sphereBounds = static_cast<const leoscene::Mesh*>(instanceData.shape)->boundingSphere;
-                    glm::vec4 transformedSphere = modelMatrix * glm::vec4(sphereBounds.x, sphereBounds.y, sphereBounds.z, 1);
-                    float maxScale = glm::max(glm::max(glm::length(modelMatrix[0]), glm::length(modelMatrix[1])), glm::length(modelMatrix[2]));
-                    transformedSphere.w = maxScale * sphereBounds.w;
-                    objectDataPtr[i].sphereBounds = transformedSphere;
-
-                    i++;
-                }
+        batchesOrder.resize(_drawCalls.size());
+        for (uint32_t i = 0; i < batchesOrder.size(); ++i) {
+            batchesOrder[i] = i;
+        }
+        std::stable_sort(batchesOrder.begin(), batchesOrder.end(), [this, &materialsOrder](uint32_t a, uint32_t b) {
+            if (_drawCalls[a].shape->indexType != _drawCalls[b].shape->indexType) {
+                return _drawCalls[a].shape->indexType < _drawCalls[b].shape->indexType;
             }
+            return materialsOrder[_drawCalls[a].material] < materialsOrder[_drawCalls[b].material];
+        });
+    }
+
+    // The instances store the first command of their batch: when the commands of a batch already on the device move,
+    // all the instances are written again.
+    bool commandsMoved = false;
+    _materialDraws.clear();
+    _indexTypeDraws.clear();
+    uint32_t nbCommands = 0;
+    for (uint32_t batchIdx : batchesOrder) {
+        DrawCallInfo& drawCall = _drawCalls[batchIdx];
+        VkIndexType indexType = drawCall.shape->indexType;
+        if (_materialDraws.empty() || _materialDraws.back().material != drawCall.material || _materialDraws.back().indexType != indexType) {
+            _materialDraws.push_back({ drawCall.material, indexType, nbCommands, 0, _feedbackSlots[drawCall.material] });
         }
-        _vulkan->unmapBuffer(stagingBuffer);
+        if (_indexTypeDraws.empty() || _indexTypeDraws.back().indexType != indexType) {
+            _indexTypeDraws.push_back({ nullptr, indexType, nbCommands, 0 });
+        }
+        commandsMoved = commandsMoved || (batchIdx < nbPreviousBatches && drawCall.firstCommand != nbCommands);
+        drawCall.firstCommand = nbCommands;
+        nbCommands += drawCall.shape->nbCommands;
+        _materialDraws.back().nbCommands += drawCall.shape->nbCommands;
+        _indexTypeDraws.back().nbCommands += drawCall.shape->nbCommands;
+    }
 
-        _vulkan->createBuffer(objectsDataBufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY, _objectsDataBuffer);
-        _vulkan->copyBufferToBuffer(_mainCommandPool, stagingBuffer.buffer, _objectsDataBuffer.buffer, objectsDataBufferSize);
-        _vulkan->destroyBuffer(stagingBuffer);
+
+    /*
+    * Instances buffer. Each new object is one instance pointing to its batch and to its data.
+    */
+
+    {
+        uint32_t firstWrittenObject = commandsMoved ? 0 : firstObject;
+        std::vector<GPUObjectInstance> instances(_totalInstancesNb - firstWrittenObject);
+        for (size_t i = 0; i < instances.size(); ++i) {
+            uint32_t objectIdx = firstWrittenObject + static_cast<uint32_t>(i);
+            instances[i].batchId = _drawCalls[_objectsBatch[objectIdx]].firstCommand;
+            instances[i].dataId = objectIdx;
+        }
+        _uploadToSceneBuffer(_gpuObjectInstances, firstWrittenObject * sizeof(GPUObjectInstance), instances.data(), instances.size() * sizeof(GPUObjectInstance));
     }
 
+
     /*
-    * Indirect Command buffer
+    * Indirect Command buffer. Rebuilt from scratch since the instances of each batch moved in the index map.
     */
 
-    std::vector<GPUIndirectDrawCommand> commandBufferData(_drawCalls.size(), GPUIndirectDrawCommand{});
+    std::vector<GPUIndirectDrawCommand> commandBufferData(_nbDrawCommands, GPUIndirectDrawCommand{});
     uint32_t offset = 0;
+    _nbInstances = 0;
     for (int i = 0; i < _drawCalls.size(); ++i) {
-        GPUIndirectDrawCommand& gpuBatch = commandBufferData[i];
-        gpuBatch.command.firstInstance = offset;  // Used to access i in the model matrix since we dont use instancing.
-        gpuBatch.command.instanceCount = 0;
-        gpuBatch.command.indexCount = _drawCalls[i].primitivesPerObject;
+        const ShapeData* shape = _drawCalls[i].shape;
+        const std::vector<leoscene::MeshLod>& lods = shape->lods;
+        const std::vector<leoscene::MeshCluster>& clusters = shape->clusters;
+        uint32_t nbClusters = static_cast<uint32_t>(clusters.size());
+        uint32_t maxClusteredInstances = std::min(_drawCalls[i].nbObjects, _MAX_CLUSTERED_INSTANCES_PER_BATCH);
+        for (uint32_t c = 0; c < shape->nbCommands; ++c) {
+            GPUIndirectDrawCommand& gpuBatch = commandBufferData[_drawCalls[i].firstCommand + c];
+            bool isCluster = c < nbClusters;
+            size_t lod = isCluster ? 0 : c - nbClusters;
+            gpuBatch.command.firstInstance = offset;  // Used to access i in the model matrix since we dont use instancing.
+            gpuBatch.command.instanceCount = 0;
+            gpuBatch.command.indexCount = isCluster ? clusters[c].nbIndices : lods[lod].nbIndices;
+            gpuBatch.command.firstIndex = shape->firstIndex + (isCluster ? clusters[c].firstIndex : lods[lod].firstIndex);
+            gpuBatch.command.vertexOffset = static_cast<int32_t>(shape->vertexOffset);
+            gpuBatch.lodError = lods[lod].error;
+            gpuBatch.nbLods = static_cast<uint32_t>(lods.size());
+            gpuBatch.nbClusters = nbClusters;
+            gpuBatch.firstCluster = shape->firstCluster;
+            gpuBatch.maxClusteredInstances = maxClusteredInstances;
+            offset += isCluster ? maxClusteredInstances : _drawCalls[i].nbObjects;  // Every object of the batch may use this LOD
+        }
         _nbInstances += _drawCalls[i].nbObjects;
-        offset += _drawCalls[i].nbObjects;
     }
 
-    _vulkan->createGPUBufferFromCPUData(_mainCommandPool, commandBufferData.size() * sizeof(GPUIndirectDrawCommand),
-        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
-        commandBufferData.data(),
-        _gpuBatches
-    );
-
-
-    /*
-    * Indirect Command buffer reset
-    */
+    // Written by the culling shaders every frame, nothing to keep
+    if (offset > _indexMapCapacity) {
+        _indexMapCapacity = std::max(_indexMapCapacity * 2, offset);
+        _growSceneBuffer(_gpuIndexToObjectId, 0, _indexMapCapacity * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+    }
 
-    _vulkan->createGPUBufferFromCPUData(_mainCommandPool, commandBufferData.size() * sizeof(GPUIndirectDrawCommand),
-        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        commandBufferData.data(),
-        _gpuResetBatches
-    );
+    // The batches are reset from _gpuResetBatches each frame, so only the reset data is uploaded
+    if (_nbDrawCommands > _commandsCapacity) {
+        _commandsCapacity = std::max(_commandsCapacity * 2, _nbDrawCommands);
+        _growSceneBuffer(_gpuBatches, 0, _commandsCapacity * sizeof(GPUIndirectDrawCommand), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT);
+        _growSceneBuffer(_gpuResetBatches, 0, _commandsCapacity * sizeof(GPUIndirectDrawCommand), 0);
+    }
+    _uploadToSceneBuffer(_gpuResetBatches, 0, commandBufferData.data(), commandBufferData.size() * sizeof(GPUIndirectDrawCommand));
 
 
     /*
-    * Instances buffer
+    * Clusters of all the loaded shapes, and HLOD clusters of all the loaded objects. Only the new ones are uploaded.
+    * The buffers are never empty, so that they can be bound.
     */
 
-    _totalInstancesNb = static_cast<uint32_t>(scene->objects.size());
+    if (_clusters.size() > _clustersCapacity || !_clustersCapacity) {
+        size_t capacity = std::max<size_t>(std::max<size_t>(_clustersCapacity * 2, _clusters.size()), 1);
+        _growSceneBuffer(_gpuClusters, nbPreviousClusters * sizeof(GPUCluster), capacity * sizeof(GPUCluster), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+        _clustersCapacity = static_cast<uint32_t>(capacity);
+    }
+    if (_clusters.size() > nbPreviousClusters) {
+        _uploadToSceneBuffer(_gpuClusters, nbPreviousClusters * sizeof(GPUCluster),
+            _clusters.data() + nbPreviousClusters, (_clusters.size() - nbPreviousClusters) * sizeof(GPUCluster));
+    }
 
-    std::vector<GPUObjectInstance> objects(_totalInstancesNb);
-    {
-        uint32_t entryIdx = 0;
-        for (uint32_t batchIdx = 0; batchIdx < _drawCalls.size(); ++batchIdx) {
-            for (uint32_t i = 0; i < _drawCalls[batchIdx].nbObjects; ++i) {
-                objects[entryIdx].batchId = batchIdx;
-                objects[entryIdx].dataId = entryIdx;
-                entryIdx++;
-            }
-        }
+    if (_hlodClusters.size() > _hlodClustersCapacity || !_hlodClustersCapacity) {
+        size_t capacity = std::max<size_t>(std::max<size_t>(_hlodClustersCapacity * 2, _hlodClusters.size()), 1);
+        _growSceneBuffer(_gpuHlodClusters, nbPreviousHlodClusters * sizeof(GPUHlodCluster), capacity * sizeof(GPUHlodCluster), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+        _hlodClustersCapacity = static_cast<uint32_t>(capacity);
+    }
+    if (_hlodClusters.size() > nbPreviousHlodClusters) {
+        _uploadToSceneBuffer(_gpuHlodClusters, nbPreviousHlodClusters * sizeof(GPUHlodCluster),
+            _hlodClusters.data() + nbPreviousHlodClusters, (_hlodClusters.size() - nbPreviousHlodClusters) * sizeof(GPUHlodCluster));
     }
-    _vulkan->createGPUBufferFromCPUData(_mainCommandPool, _totalInstancesNb * sizeof(GPUObjectInstance),
-        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
-        objects.data(),
-        _gpuObjectInstances
-    );
 
-    _vulkan->createGPUBufferFromCPUData(_mainCommandPool, _totalInstancesNb * sizeof(uint32_t),
-        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
-        objects.data(),
-        _gpuIndexToObjectId
-    );
+    // Number of clustered instances, then the indirect dispatch (x, y, z). The number and x are reset each frame.
+    if (!_sceneLoaded) {
+        uint32_t dispatch[4] = { 0, 0, 1, 1 };
+        _growSceneBuffer(_gpuClusterDispatch, 0, sizeof(dispatch), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT);
+        _uploadToSceneBuffer(_gpuClusterDispatch, 0, dispatch, sizeof(dispatch));
+    }
 
 
     /*
@@ -1135,19 +1497,24 @@ void VulkanRenderer::loadSceneToDevice(const leoscene::Scene* scene)
     globalData.pyramidHeight = _depthPyramidHeight;
     globalData.nbInstances = _totalInstancesNb;
 
-    _vulkan->createGPUBufferFromCPUData(_mainCommandPool, sizeof(GPUCullingGlobalData),
-        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-        &globalData,
-        _gpuCullingGlobalData
-    );
+    if (!_sceneLoaded) {
+        _growSceneBuffer(_gpuCullingGlobalData, 0, sizeof(GPUCullingGlobalData), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+    }
+    _uploadToSceneBuffer(_gpuCullingGlobalData, 0, &globalData, sizeof(GPUCullingGlobalData));
 
 
     /*
     * Setup descriptors. Global descriptors depend partially on the scene being loaded, so we create them here.
+    * They are only created again when a buffer they point to was replaced. The sets they replace may still be bound by the
+    * frames in flight, so they stay in their pools until cleanup: the buffers grow geometrically, so there are few of them.
     */
 
-    _createGlobalDescriptors(_totalInstancesNb);
-    _createCullingDescriptors(_totalInstancesNb);
+    _createTextureFeedbackBuffers(static_cast<uint32_t>(_streamedMaterials.size()));
+    if (_sceneDescriptorsOutdated) {
+        _createGlobalDescriptors(_objectsCapacity);
+        _createCullingDescriptors(_objectsCapacity);
+        _sceneDescriptorsOutdated = false;
+    }
 
 
     /*
@@ -1178,9 +1545,432 @@ void VulkanRenderer::loadSceneToDevice(const leoscene::Scene* scene)
     _gpuBatchesResetBarrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT;
     _gpuBatchesResetBarrier.srcQueueFamilyIndex = static_cast<uint32_t>(_vulkan->getQueueFamilyIndices().graphicsFamily.value());
 
+    _gpuClusterDispatchResetBarrier = _gpuBatchesResetBarrier;
+    _gpuClusterDispatchResetBarrier.buffer = _gpuClusterDispatch.buffer;
+
+    // The cluster culling shader reads the clustered instances and the commands, and adds instances to the commands of the clusters
+    _clusterCullingBarriers = { _gpuBatchesBarrier, _gpuIndexToObjectIdBarrier, _gpuBatchesBarrier, _gpuBatchesBarrier };
+    _clusterCullingBarriers[1].buffer = _gpuIndexToObjectId.buffer;
+    _clusterCullingBarriers[2].buffer = _gpuClusteredInstances.buffer;
+    _clusterCullingBarriers[3].buffer = _gpuClusterDispatch.buffer;
+    for (VkBufferMemoryBarrier& barrier : _clusterCullingBarriers) {
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+    }
+
     _updateDynamicData();
 
     _sceneLoaded = true;
+
+    return firstObject;
+}
+
+void VulkanRenderer::updateObjectMatrices(const uint32_t* objectIndices, const glm::mat4* worldMatrices, size_t nbObjects)
+{
+    _updatedObjectsBounds.resize(nbObjects);
+    for (size_t i = 0; i < nbObjects; ++i) {
+        if (objectIndices[i] >= _totalInstancesNb) {
+            throw VulkanRendererException("Trying to move an object that is not loaded.");
+        }
+        _updatedObjectsBounds[i] = _objectsLocalBounds[objectIndices[i]];
+    }
+    leoscene::transformBoundingSpheres(worldMatrices, _updatedObjectsBounds.data(), _updatedObjectsBounds.data(), nbObjects);
+
+    for (size_t i = 0; i < nbObjects; ++i) {
+        uint32_t dataId = objectIndices[i];
+
+        // An object moved several times before being uploaded is only uploaded once, with its last matrix.
+        uint32_t& slot = _pendingObjectUpdateSlots[dataId];
+        if (slot == UINT32_MAX) {
+            slot = static_cast<uint32_t>(_pendingObjectUpdates.size());
+            _pendingObjectUpdates.push_back({ dataId });
+        }
+        _pendingObjectUpdates[slot].data.modelMatrix = worldMatrices[i];
+        _pendingObjectUpdates[slot].data.sphereBounds = _updatedObjectsBounds[i];
+        _pendingObjectUpdates[slot].data.localBox = _objectsLocalBoxes[dataId];
+    }
+}
+
+void VulkanRenderer::_createObjectUpdatesStagingRing()
+{
+    VkDeviceSize ringSize = static_cast<VkDeviceSize>(_MAX_FRAMES_IN_FLIGHT) * _MAX_OBJECT_UPDATES_PER_FRAME * sizeof(GPUObjectData);
+    _vulkan->createBuffer(ringSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY, _objectUpdatesStagingRing);
+    _objectUpdatesStagingData = static_cast<GPUObjectData*>(_vulkan->mapBuffer(_objectUpdatesStagingRing));  // Mapped until cleanup
+}
+
+void VulkanRenderer::_recordObjectUpdates(VkCommandBuffer commandBuffer)
+{
+    if (_pendingObjectUpdates.empty()) {
+        return;
+    }
+
+    // Sorted so that objects next to each other in the objects data buffer are copied with a single region.
+    std::sort(_pendingObjectUpdates.begin(), _pendingObjectUpdates.end(),
+        [](const PendingObjectUpdate& a, const PendingObjectUpdate& b) { return a.dataId < b.dataId; });
+
+    // The fence of the current frame was waited for, so its segment of the ring is not read by the device anymore.
+    size_t nbUpdates = std::min<size_t>(_pendingObjectUpdates.size(), _MAX_OBJECT_UPDATES_PER_FRAME);
+    size_t segmentStart = _currentFrame * _MAX_OBJECT_UPDATES_PER_FRAME;
+    GPUObjectData* segment = _objectUpdatesStagingData + segmentStart;
+
+    _objectUpdatesCopies.clear();
+    for (size_t i = 0; i < nbUpdates; ++i) {
+        const PendingObjectUpdate& update = _pendingObjectUpdates[i];
+        segment[i] = update.data;
+        if (i && _pendingObjectUpdates[i - 1].dataId + 1 == update.dataId) {
+            _objectUpdatesCopies.back().size += sizeof(GPUObjectData);
+        }
+        else {
+            VkBufferCopy copy = {};
+            copy.srcOffset = (segmentStart + i) * sizeof(GPUObjectData);
+            copy.dstOffset = static_cast<VkDeviceSize>(update.dataId) * sizeof(GPUObjectData);
+            copy.size = sizeof(GPUObjectData);
+            _objectUpdatesCopies.push_back(copy);
+        }
+    }
+    _vulkan->flushBuffer(_objectUpdatesStagingRing, segmentStart * sizeof(GPUObjectData), nbUpdates * sizeof(GPUObjectData));
+
+    // The previous frame may still be reading the objects data.
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0, 0, nullptr, 0, nullptr, 0, nullptr);
+
+    vkCmdCopyBuffer(commandBuffer, _objectUpdatesStagingRing.buffer, _objectsDataBuffer.buffer, static_cast<uint32_t>(_objectUpdatesCopies.size()), _objectUpdatesCopies.data());
+
+    VkBufferMemoryBarrier objectsDataBarrier = {};
+    objectsDataBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    objectsDataBarrier.buffer = _objectsDataBuffer.buffer;
+    objectsDataBarrier.size = VK_WHOLE_SIZE;
+    objectsDataBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    objectsDataBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    objectsDataBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    objectsDataBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+        0, 0, nullptr, 1, &objectsDataBarrier, 0, nullptr);
+
+    // Updates that did not fit in the segment are uploaded with the next frames.
+    for (size_t i = 0; i < nbUpdates; ++i) {
+        _pendingObjectUpdateSlots[_pendingObjectUpdates[i].dataId] = UINT32_MAX;
+    }
+    _pendingObjectUpdates.erase(_pendingObjectUpdates.begin(), _pendingObjectUpdates.begin() + nbUpdates);
+    for (size_t i = 0; i < _pendingObjectUpdates.size(); ++i) {
+        _pendingObjectUpdateSlots[_pendingObjectUpdates[i].dataId] = static_cast<uint32_t>(i);
+    }
+}
+
+void VulkanRenderer::_createTextureFeedbackBuffers(uint32_t nbSlots)
+{
+    if (nbSlots <= _textureFeedbackCapacity) {
+        return;
+    }
+
+    // The buffers replaced may still be used by the frames in flight, and are retired like the scene buffers.
+    // The feedback of the frames in flight is dropped.
+    if (_textureFeedbackCapacity) {
+        _vulkan->unmapBuffer(_textureFeedbackReadback);
+        _retireBuffer(_textureFeedbackReadback);
+    }
+    _textureFeedbackCapacity = std::max(nbSlots, 2 * _textureFeedbackCapacity);
+
+    std::vector<uint32_t> noFeedback(_textureFeedbackCapacity, leoscene::TextureResidency::NO_FEEDBACK);
+    _growSceneBuffer(_textureFeedbackBuffer, 0, _textureFeedbackCapacity * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+    _uploadToSceneBuffer(_textureFeedbackBuffer, 0, noFeedback.data(), _textureFeedbackCapacity * sizeof(uint32_t));
+
+    VkDeviceSize readbackSize = static_cast<VkDeviceSize>(_MAX_FRAMES_IN_FLIGHT) * _textureFeedbackCapacity * sizeof(uint32_t);
+    _vulkan->createBuffer(readbackSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_TO_CPU, _textureFeedbackReadback);
+    _textureFeedbackReadbackData = static_cast<uint32_t*>(_vulkan->mapBuffer(_textureFeedbackReadback));  // Mapped until cleanup
+    std::fill(_textureFeedbackReadbackData, _textureFeedbackReadbackData + readbackSize / sizeof(uint32_t), leoscene::TextureResidency::NO_FEEDBACK);
+    _vulkan->flushBuffer(_textureFeedbackReadback);
+}
+
+void VulkanRenderer::_updateTextureStreaming(VkCommandBuffer commandBuffer)
+{
+    _freeRetiredTextureData(false);
+
+    // The fence of the current frame was waited for, so its segment of the readback buffer holds the feedback of the last frame
+    // that used it, _MAX_FRAMES_IN_FLIGHT frames ago. The level sampled in the diffuse texture stands for all the textures of the material.
+    size_t segmentStart = _currentFrame * _textureFeedbackCapacity;
+    _vulkan->invalidateBuffer(_textureFeedbackReadback, segmentStart * sizeof(uint32_t), _streamedMaterials.size() * sizeof(uint32_t));
+    const uint32_t* feedback = _textureFeedbackReadbackData + segmentStart;
+    for (uint32_t slot = 0; slot < _streamedMaterials.size(); ++slot) {
+        if (feedback[slot] == leoscene::TextureResidency::NO_FEEDBACK) {
+            continue;
+        }
+        for (uint32_t texture : _streamedMaterials[slot].textures) {
+            if (texture != _NOT_STREAMED) {
+                _textureResidency.requestFeedbackLevel(texture, feedback[slot], _frameNumber);
+            }
+        }
+    }
+
+    _textureResidency.update(_frameNumber, _textureResidencyChanges);
+    for (const leoscene::TextureResidency::Change& change : _textureResidencyChanges) {
+        _recordTextureLevelsChange(commandBuffer, change.texture, change.firstLevel);
+    }
+
+    // A material swaps its set at most once per frame, and the spare sets are written in the order they were swapped out.
+    // The next spare set was swapped out _MAX_FRAMES_IN_FLIGHT swaps ago, so it was last bound more than _MAX_FRAMES_IN_FLIGHT
+    // frames ago, by a frame whose fence was waited for. It can be written.
+    for (StreamedMaterial& streamedMaterial : _streamedMaterials) {
+        if (streamedMaterial.changed) {
+            VkDescriptorSet& descriptorSet = streamedMaterial.material->getDescriptorSet(ShaderPass::Type::FORWARD);
+            VkDescriptorSet& spareDescriptorSet = streamedMaterial.spareDescriptorSets[streamedMaterial.nextSpareDescriptorSet];
+            _materialBuilder.writeMaterialDescriptorSet(*streamedMaterial.material, spareDescriptorSet);
+            std::swap(descriptorSet, spareDescriptorSet);
+            streamedMaterial.nextSpareDescriptorSet = (streamedMaterial.nextSpareDescriptorSet + 1) % _MAX_FRAMES_IN_FLIGHT;
+            streamedMaterial.changed = false;
+        }
+    }
+}
+
+void VulkanRenderer::_recordTextureLevelsChange(VkCommandBuffer commandBuffer, uint32_t textureId, uint32_t firstLevel)
+{
+    StreamedTexture& texture = _streamedTextures[textureId];
+    const std::vector<leoscene::ImageTexture::MipLevel>& mipLevels = texture.source->mipLevels;
+    uint32_t nbLevels = static_cast<uint32_t>(mipLevels.size());
+    uint32_t previousFirstLevel = nbLevels - texture.image->mipLevels;
+
+    RetiredTextureData retiredData;
+    retiredData.image = *texture.image;
+    retiredData.frame = _frameNumber;
+
+    AllocatedImage newImage;
+    _vulkan->createImage(static_cast<uint32_t>(mipLevels[firstLevel].width), static_cast<uint32_t>(mipLevels[firstLevel].height),
+        nbLevels - firstLevel, VK_SAMPLE_COUNT_1_BIT, texture.format, VK_IMAGE_TILING_OPTIMAL,
+        VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, newImage);
+
+    // The previous frame may still be sampling the previous image.
+    std::array<VkImageMemoryBarrier, 2> copyBarriers = {
+        VulkanUtils::createImageBarrier(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, retiredData.image.image,
+            VK_IMAGE_ASPECT_COLOR_BIT, 0, VK_ACCESS_TRANSFER_READ_BIT, 0, retiredData.image.mipLevels),
+        VulkanUtils::createImageBarrier(VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, newImage.image,
+            VK_IMAGE_ASPECT_COLOR_BIT, 0, VK_ACCESS_TRANSFER_WRITE_BIT, 0, newImage.mipLevels)
+    };
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr,
+        static_cast<uint32_t>(copyBarriers.size()), copyBarriers.data());
+
+    // Levels resident in both images are copied from the previous one. Without sparse images, clamping the minLod of the view
+    // would not free the evicted levels. The copied levels are coarser than the uploaded ones, so they take at most a third of
+    // the upload budget of the frame.
+    std::vector<VkImageCopy> imageCopies;
+    for (uint32_t level = std::max(firstLevel, previousFirstLevel); level < nbLevels; ++level) {
+        VkImageCopy imageCopy = {};
+        imageCopy.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level - previousFirstLevel, 0, 1 };
+        imageCopy.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level - firstLevel, 0, 1 };
+        imageCopy.extent = { static_cast<uint32_t>(mipLevels[level].width), static_cast<uint32_t>(mipLevels[level].height), 1 };
+        imageCopies.push_back(imageCopy);
+    }
+    vkCmdCopyImage(commandBuffer, retiredData.image.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, newImage.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        static_cast<uint32_t>(imageCopies.size()), imageCopies.data());
+
+    // Finer levels are uploaded from the texture, which holds them one after another
+    if (firstLevel < previousFirstLevel) {
+        size_t uploadOffset = mipLevels[firstLevel].offset;
+        size_t uploadSize = mipLevels[previousFirstLevel - 1].offset + mipLevels[previousFirstLevel - 1].size - uploadOffset;
+        _vulkan->createBuffer(uploadSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY, retiredData.stagingBuffer);
+        memcpy(_vulkan->mapBuffer(retiredData.stagingBuffer), texture.source->data + uploadOffset, uploadSize);
+        _vulkan->unmapBuffer(retiredData.stagingBuffer);
+
+        std::vector<VkBufferImageCopy> uploadRegions(previousFirstLevel - firstLevel);
+        for (uint32_t level = firstLevel; level < previousFirstLevel; ++level) {
+            VkBufferImageCopy& region = uploadRegions[level - firstLevel];
+            region.bufferOffset = mipLevels[level].offset - uploadOffset;
+            region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level - firstLevel, 0, 1 };
+            region.imageExtent = { static_cast<uint32_t>(mipLevels[level].width), static_cast<uint32_t>(mipLevels[level].height), 1 };
+        }
+        vkCmdCopyBufferToImage(commandBuffer, retiredData.stagingBuffer.buffer, newImage.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            static_cast<uint32_t>(uploadRegions.size()), uploadRegions.data());
+    }
+
+    VkImageMemoryBarrier shaderReadBarrier = VulkanUtils::createImageBarrier(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        newImage.image, VK_IMAGE_ASPECT_COLOR_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT, 0, newImage.mipLevels);
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &shaderReadBarrier);
+
+    _vulkan->createImageView(newImage.image, texture.format, VK_IMAGE_ASPECT_COLOR_BIT, newImage.mipLevels, newImage.view);
+
+    // The image keeps its address, which the loaded images and the streamed textures point to. The previous one is freed
+    // once the frames that may use it are done.
+    *texture.image = newImage;
+    _retiredTextureData.push_back(retiredData);
+
+    for (uint32_t slot : texture.materials) {
+        StreamedMaterial& streamedMaterial = _streamedMaterials[slot];
+        for (size_t i = 0; i < streamedMaterial.textures.size(); ++i) {
+            if (streamedMaterial.textures[i] == textureId) {
+                streamedMaterial.material->textures[i].view = newImage.view;
+                streamedMaterial.changed = true;
+            }
+        }
+    }
+}
+
+void VulkanRenderer::_recordTextureFeedbackReadback(VkCommandBuffer commandBuffer)
+{
+    VkBufferMemoryBarrier feedbackBarrier = {};
+    feedbackBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    feedbackBarrier.buffer = _textureFeedbackBuffer.buffer;
+    feedbackBarrier.size = VK_WHOLE_SIZE;
+    feedbackBarrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    feedbackBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    feedbackBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    feedbackBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 1, &feedbackBarrier, 0, nullptr);
+
+    VkBufferCopy feedbackCopy = {};
+    feedbackCopy.srcOffset = 0;
+    feedbackCopy.dstOffset = static_cast<VkDeviceSize>(_currentFrame) * _textureFeedbackCapacity * sizeof(uint32_t);
+    feedbackCopy.size = _streamedMaterials.size() * sizeof(uint32_t);
+    vkCmdCopyBuffer(commandBuffer, _textureFeedbackBuffer.buffer, _textureFeedbackReadback.buffer, 1, &feedbackCopy);
+
+    // Reset for the next frame, once copied
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 0, nullptr);
+    vkCmdFillBuffer(commandBuffer, _textureFeedbackBuffer.buffer, 0, VK_WHOLE_SIZE, leoscene::TextureResidency::NO_FEEDBACK);
+
+    // The fence alone does not make the copy visible to the host
+    std::array<VkBufferMemoryBarrier, 2> readbackBarriers = { feedbackBarrier, feedbackBarrier };
+    readbackBarriers[0].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    readbackBarriers[0].dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    readbackBarriers[1].buffer = _textureFeedbackReadback.buffer;
+    readbackBarriers[1].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    readbackBarriers[1].dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_HOST_BIT,
+        0, 0, nullptr, static_cast<uint32_t>(readbackBarriers.size()), readbackBarriers.data(), 0, nullptr);
+}
+
+void VulkanRenderer::_freeRetiredTextureData(bool all)
+{
+    // Data retired during a frame may be used by the frames recorded until then, which are done _MAX_FRAMES_IN_FLIGHT frames later
+    size_t nbKept = 0;
+    for (RetiredTextureData& retiredData : _retiredTextureData) {
+        if (!all && retiredData.frame + _MAX_FRAMES_IN_FLIGHT > _frameNumber) {
+            _retiredTextureData[nbKept++] = retiredData;
+            continue;
+        }
+        vkDestroyImageView(_device, retiredData.image.view, nullptr);
+        _vulkan->destroyImage(retiredData.image);
+        if (retiredData.stagingBuffer.buffer != VK_NULL_HANDLE) {
+            _vulkan->destroyBuffer(retiredData.stagingBuffer);
+        }
+    }
+    _retiredTextureData.resize(nbKept);
+}
+
+void VulkanRenderer::_growSceneBuffer(AllocatedBuffer& buffer, VkDeviceSize keptSize, VkDeviceSize newSize, VkBufferUsageFlags usage)
+{
+    AllocatedBuffer newBuffer;
+    _vulkan->createBuffer(newSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | usage, VMA_MEMORY_USAGE_GPU_ONLY, newBuffer);
+    if (keptSize) {
+        _pendingSceneCopies.push_back({ buffer.buffer, newBuffer.buffer, { 0, 0, keptSize } });
+    }
+    if (buffer.buffer != VK_NULL_HANDLE) {
+        _retireBuffer(buffer);
+    }
+    buffer = newBuffer;
+    _sceneDescriptorsOutdated = true;
+}
+
+void VulkanRenderer::_uploadToSceneBuffer(AllocatedBuffer& buffer, VkDeviceSize offset, const void* data, VkDeviceSize size)
+{
+    AllocatedBuffer stagingBuffer;
+    _vulkan->createBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY, stagingBuffer);
+    memcpy(_vulkan->mapBuffer(stagingBuffer), data, size);
+    _vulkan->unmapBuffer(stagingBuffer);
+    _pendingSceneCopies.push_back({ stagingBuffer.buffer, buffer.buffer, { 0, offset, size } });
+    _retireBuffer(stagingBuffer);
+}
+
+void VulkanRenderer::_recordSceneCopies(VkCommandBuffer commandBuffer)
+{
+    if (_pendingSceneCopies.empty()) {
+        return;
+    }
+
+    // The previous frames may still be reading the regions about to be written
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 0, nullptr);
+
+    // In the order they were queued: a buffer grown after data was uploaded to it copies that data to its replacement
+    VkMemoryBarrier copyBarrier = {};
+    copyBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    copyBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    copyBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+    for (const PendingSceneCopy& copy : _pendingSceneCopies) {
+        vkCmdCopyBuffer(commandBuffer, copy.srcBuffer, copy.dstBuffer, 1, &copy.region);
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &copyBarrier, 0, nullptr, 0, nullptr);
+    }
+
+    VkMemoryBarrier sceneDataBarrier = {};
+    sceneDataBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    sceneDataBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    sceneDataBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT
+        | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT
+        | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0, 1, &sceneDataBarrier, 0, nullptr, 0, nullptr);
+
+    _pendingSceneCopies.clear();
+}
+
+// The previous content of the image is discarded
+void VulkanRenderer::_uploadToImage(const AllocatedImage& image, const void* data, VkDeviceSize size, const std::vector<VkBufferImageCopy>& regions)
+{
+    AllocatedBuffer stagingBuffer;
+    _vulkan->createBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY, stagingBuffer);
+    memcpy(_vulkan->mapBuffer(stagingBuffer), data, size);
+    _vulkan->unmapBuffer(stagingBuffer);
+    _pendingImageUploads.push_back({ stagingBuffer.buffer, image.image, image.mipLevels, regions });
+    _retireBuffer(stagingBuffer);
+}
+
+void VulkanRenderer::_recordImageUploads(VkCommandBuffer commandBuffer)
+{
+    if (_pendingImageUploads.empty()) {
+        return;
+    }
+
+    // The images are new: nothing uses them yet, and all their levels are written
+    std::vector<VkImageMemoryBarrier> imageBarriers;
+    imageBarriers.reserve(_pendingImageUploads.size());
+    for (const PendingImageUpload& upload : _pendingImageUploads) {
+        imageBarriers.push_back(VulkanUtils::createImageBarrier(VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, upload.image,
+            VK_IMAGE_ASPECT_COLOR_BIT, 0, VK_ACCESS_TRANSFER_WRITE_BIT, 0, upload.mipLevels));
+    }
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr,
+        static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+
+    for (const PendingImageUpload& upload : _pendingImageUploads) {
+        vkCmdCopyBufferToImage(commandBuffer, upload.stagingBuffer, upload.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            static_cast<uint32_t>(upload.regions.size()), upload.regions.data());
+    }
+
+    imageBarriers.clear();
+    for (const PendingImageUpload& upload : _pendingImageUploads) {
+        imageBarriers.push_back(VulkanUtils::createImageBarrier(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, upload.image,
+            VK_IMAGE_ASPECT_COLOR_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT, 0, upload.mipLevels));
+    }
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr,
+        static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+
+    _pendingImageUploads.clear();
+}
+
+void VulkanRenderer::_retireBuffer(AllocatedBuffer& buffer)
+{
+    _retiredBuffers.push_back({ buffer, _frameNumber });
+    buffer = {};
+}
+
+void VulkanRenderer::_freeRetiredBuffers(bool all)
+{
+    // Buffers retired between two frames may be used by the frames recorded until the next one, done _MAX_FRAMES_IN_FLIGHT frames later
+    size_t nbKept = 0;
+    for (RetiredBuffer& retiredBuffer : _retiredBuffers) {
+        if (!all && retiredBuffer.frame + _MAX_FRAMES_IN_FLIGHT > _frameNumber) {
+            _retiredBuffers[nbKept++] = retiredBuffer;
+            continue;
+        }
+        _vulkan->destroyBuffer(retiredBuffer.buffer);
+    }
+    _retiredBuffers.resize(nbKept);
 }
 
 void VulkanRenderer::_createGlobalDescriptors(uint32_t _totalInstancesNb)
@@ -1189,7 +1979,7 @@ void VulkanRenderer::_createGlobalDescriptors(uint32_t _totalInstancesNb)
     globalDescriptorAllocatorOptions.poolBaseSize = 10;
     globalDescriptorAllocatorOptions.poolSizes = {
         { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 3.f },
-        { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1.f },
+        { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2.f },
     };
     _globalDescriptorAllocator.init(globalDescriptorAllocatorOptions);
 
@@ -1219,11 +2009,17 @@ void VulkanRenderer::_createGlobalDescriptors(uint32_t _totalInstancesNb)
     miscBufferInfo.offset = 0;
     miscBufferInfo.range = VK_WHOLE_SIZE;
 
+    VkDescriptorBufferInfo textureFeedbackInfo = {};
+    textureFeedbackInfo.buffer = _textureFeedbackBuffer.buffer;
+    textureFeedbackInfo.offset = 0;
+    textureFeedbackInfo.range = VK_WHOLE_SIZE;
+
     DescriptorBuilder::begin(_device, _globalDescriptorLayoutCache, _globalDescriptorAllocator)
         .bindBuffer(0, cameraBufferInfo, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT)
         .bindBuffer(1, sceneBufferInfo, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT)
         .bindBuffer(2, indexMapInfo, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT)
         .bindBuffer(3, miscBufferInfo, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT)
+        .bindBuffer(4, textureFeedbackInfo, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT)
         .build(_globalDataDescriptorSet, _globalDataDescriptorSetLayout);
 
     /*
@@ -1245,8 +2041,8 @@ void VulkanRenderer::_createCullingDescriptors(uint32_t nbObjects)
     DescriptorAllocator::Options cullingDescriptorAllocatorOptions = {};
     cullingDescriptorAllocatorOptions.poolBaseSize = 10;
     cullingDescriptorAllocatorOptions.poolSizes = {
-        { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2.f },
-        { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 5.f },
+        { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 4.f },
+        { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 14.f },
     };
     _cullingDescriptorAllocator.init(cullingDescriptorAllocatorOptions);
 
@@ -1285,6 +2081,31 @@ void VulkanRenderer::_createCullingDescriptors(uint32_t nbObjects)
     miscBufferInfo.offset = 0;
     miscBufferInfo.range = VK_WHOLE_SIZE;
 
+    VkDescriptorBufferInfo clusteredInstancesInfo = {};
+    clusteredInstancesInfo.buffer = _gpuClusteredInstances.buffer;
+    clusteredInstancesInfo.offset = 0;
+    clusteredInstancesInfo.range = VK_WHOLE_SIZE;
+
+    VkDescriptorBufferInfo clusterDispatchInfo = {};
+    clusterDispatchInfo.buffer = _gpuClusterDispatch.buffer;
+    clusterDispatchInfo.offset = 0;
+    clusterDispatchInfo.range = VK_WHOLE_SIZE;
+
+    VkDescriptorBufferInfo clustersInfo = {};
+    clustersInfo.buffer = _gpuClusters.buffer;
+    clustersInfo.offset = 0;
+    clustersInfo.range = VK_WHOLE_SIZE;
+
+    VkDescriptorBufferInfo hlodClustersInfo = {};
+    hlodClustersInfo.buffer = _gpuHlodClusters.buffer;
+    hlodClustersInfo.offset = 0;
+    hlodClustersInfo.range = VK_WHOLE_SIZE;
+
+    VkDescriptorBufferInfo objectsHlodInfo = {};
+    objectsHlodInfo.buffer = _gpuObjectsHlod.buffer;
+    objectsHlodInfo.offset = 0;
+    objectsHlodInfo.range = VK_WHOLE_SIZE;
+
     VkDescriptorImageInfo depthPyramidInfo = {};
     depthPyramidInfo.sampler = _depthImageSampler;
     depthPyramidInfo.imageView = _depthPyramid.view;
@@ -1299,7 +2120,25 @@ void VulkanRenderer::_createCullingDescriptors(uint32_t nbObjects)
         .bindBuffer(5, indexMapInfo, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
         .bindImage(6, depthPyramidInfo, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT)
         .bindBuffer(7, miscBufferInfo, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+        .bindBuffer(8, clusteredInstancesInfo, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+        .bindBuffer(9, clusterDispatchInfo, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+        .bindBuffer(10, hlodClustersInfo, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+        .bindBuffer(11, objectsHlodInfo, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
         .build(_cullingDescriptorSet, _cullingDescriptorSetLayout);
+
+    // Cluster culling: same data, but reads the clustered instances instead of all the instances
+    DescriptorBuilder::begin(_device, _globalDescriptorLayoutCache, _cullingDescriptorAllocator)
+        .bindBuffer(0, globalDataBufferInfo, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+        .bindBuffer(1, cameraBufferInfo, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+        .bindBuffer(2, objectsDataBufferInfo, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+        .bindBuffer(3, drawBufferInfo, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+        .bindBuffer(4, clusteredInstancesInfo, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+        .bindBuffer(5, indexMapInfo, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+        .bindImage(6, depthPyramidInfo, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT)
+        .bindBuffer(7, miscBufferInfo, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+        .bindBuffer(8, clustersInfo, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+        .bindBuffer(9, clusterDispatchInfo, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+        .build(_clusterCullingDescriptorSet, _clusterCullingDescriptorSetLayout);
 }
 
 void VulkanRenderer::_createDepthPyramidDescriptors()
@@ -1478,7 +2317,7 @@ void VulkanRenderer::_createDepthSampler()
     reductionCreateInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_REDUCTION_MODE_CREATE_INFO;
     reductionCreateInfo.reductionMode = VK_SAMPLER_REDUCTION_MODE_MAX;
     samplerCreateInfo.pNext = &reductionCreateInfo;
-    VK_CHECK(vkCreateSampler(_device, &samplerCreateInfo, 0, &_depthImageSampler));
+    _depthImageSampler = _samplerCache.getSampler(samplerCreateInfo);
 }
 
 void VulkanRenderer::_createBarriers()
@@ -1560,4 +2399,10 @@ namespace {
         while (result * 2 < v) result *= 2;
         return result;
     }
+
+    leoscene::TextureResidencyOptions getTextureResidencyOptions(const VulkanRenderer::Options& options) {
+        leoscene::TextureResidencyOptions residencyOptions;
+        residencyOptions.memoryBudget = static_cast<size_t>(options.textureMemoryBudget);
+        return residencyOptions;
+    }
 }
@@ -5,17 +5,19 @@
 #include "DescriptorUtils.h"
 #include "MaterialBuilder.h"
 
+#include <array>
 #include <memory>
 #include <unordered_map>
 #include <map>
 
 #include <scene/GeometryIncludes.h>
+#include <scene/Mesh.h>
+#include <scene/TextureResidency.h>
 
 namespace leoscene {
 	class Scene;
 	class Material;
 	class PerformanceMaterial;
-	class Mesh;
 	class Shape;
 	class Transform;
 	class ImageTexture;
@@ -42,6 +44,9 @@ struct GPUDynamicData {
 	glm::vec4 forcedColoring;
 	int frustumCulling;
 	int occlusionCulling;
+	float lodErrorThreshold;  // Largest LOD error allowed on screen, as a fraction of the screen height. 0 draws the full meshes.
+	int clusterCulling;  // When 0, all the clusters of the visible objects are drawn
+	float hlodErrorThreshold;  // Largest HLOD proxy error allowed on screen, as a fraction of the screen height. 0 always draws the members.
 };
 
 // For an instance of a mesh, stores the batch in witch the instance is located and the index of the instance's data (see GPUObjectData)
@@ -50,9 +55,29 @@ struct GPUObjectInstance {
 	uint32_t dataId = 0;
 };
 
-// Stores the draw command parameters for a batch
+// Stores the draw command parameters for one LOD, or one cluster of LOD 0, of a batch. The commands of a batch follow each other:
+// one per cluster of LOD 0, then one per LOD, including LOD 0 for the instances whose clusters are not culled.
 struct GPUIndirectDrawCommand {
 	VkDrawIndexedIndirectCommand command = {};
+	float lodError = 0;  // See leoscene::MeshLod
+	uint32_t nbLods = 1;  // Read on the first command of the batch
+	uint32_t nbClusters = 0;  // Read on the first command of the batch
+	uint32_t firstCluster = 0;  // Index of the first cluster of the batch in the clusters buffer. Read on the first command of the batch.
+	uint32_t nbClusteredInstances = 0;  // Instances of the batch queued for cluster culling. Counted on the first command of the batch.
+	uint32_t maxClusteredInstances = 0;  // Room of each cluster command. Read on the first command of the batch.
+};
+
+// Bounds of a cluster, culled by the cluster culling shader (see leoscene::MeshCluster)
+struct GPUCluster {
+	glm::vec4 sphereBounds = glm::vec4(0);  // Object space
+	glm::vec4 cone = glm::vec4(0, 0, 0, 1);  // Axis and cutoff
+};
+
+// Bounds and error of an HLOD cluster (see leoscene::HlodCluster). The culling shader draws either its proxy or its members.
+struct GPUHlodCluster {
+	glm::vec4 sphereBounds = glm::vec4(0);  // World space
+	float error = 0;
+	uint32_t padding[3] = {};
 };
 
 // Global data used for culling compute shaders
@@ -67,20 +92,42 @@ struct GPUCullingGlobalData {
 	uint32_t nbInstances = 0;
 };
 
+// Axis aligned bounding box of the shape of an object, in object space. w is unused.
+// The packed vertex positions of the shape are normalized in this box (see leoscene::PackedVertexPosition).
+struct GPUBoundingBox {
+	glm::vec4 center;
+	glm::vec4 extents;  // Half of the size of the box along each axis
+};
+
 // Data relative to each object instance. Instances will differ only by these data.
 struct GPUObjectData {
 	glm::mat4 modelMatrix;
-	glm::vec4 sphereBounds;
+	glm::vec4 sphereBounds;  // World space
+	GPUBoundingBox localBox;  // Projected by the culling shader for the occlusion test, and used by the vertex shaders to decode the positions
 };
 
-// Buffers for each mesh
+// Range of each mesh in the global vertex and index buffers
 struct ShapeData {
-	AllocatedBuffer vertexBuffer;
-	AllocatedBuffer indexBuffer;
-	uint32_t nbElements = 0;
+	uint32_t vertexOffset = 0;  // First vertex of the mesh in the position and attribute buffers. Its indices are relative to it.
+	uint32_t firstIndex = 0;  // First index of the mesh in the index buffer, counted in indices of its type
+	VkIndexType indexType = VK_INDEX_TYPE_UINT32;  // 16 bits for the meshes with few vertices (see leoscene::selectIndexType)
+	std::vector<leoscene::MeshLod> lods;  // Index ranges relative to firstIndex, from the full mesh to the coarsest. At least one.
+	std::vector<leoscene::MeshCluster> clusters;  // Index ranges of the clusters of the full mesh. Empty if it is culled as a whole.
+	uint32_t firstCluster = 0;  // In the clusters buffer
+	uint32_t nbCommands = 1;  // Indirect draw commands of each batch of the shape (see GPUIndirectDrawCommand)
+	GPUBoundingBox localBox;  // Bounding box of the mesh, in which its positions are quantized
+};
+
+// Device data created for a resource of the scene (material, shape, texture).
+// The weak pointer tells a resource that was freed apart from a new one allocated at the same address.
+template<typename SceneResource, typename DeviceData>
+struct LoadedSceneResource {
+	std::weak_ptr<const SceneResource> source;
+	DeviceData data = {};
 };
 
-// Data tied to a frame
+// Data tied to a frame. The framebuffer is used by the frame presenting the swap chain image of the same index,
+// the rest by the frame in flight of the same index.
 struct FrameData {
 	VkSemaphore presentSemaphore = VK_NULL_HANDLE;
 	VkSemaphore renderSemaphore = VK_NULL_HANDLE;
@@ -91,26 +138,52 @@ struct FrameData {
 	VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
 };
 
-// Data of each separate draw call (mainly the vertex/index buffers and the material to bind)
+// Data of each batch of objects sharing a material and a shape
 struct DrawCallInfo {
 	const Material* material = nullptr;
 	const ShapeData* shape = nullptr;
 	uint32_t nbObjects = 0;
-	uint32_t primitivesPerObject = 0;
+	uint32_t firstCommand = 0;  // First indirect draw command of the batch, see GPUIndirectDrawCommand.
+};
+
+// The commands of the batches of a material whose shapes have the same index type follow each other,
+// and are drawn with a single indirect draw call
+struct MaterialDrawInfo {
+	const Material* material = nullptr;
+	VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+	uint32_t firstCommand = 0;
+	uint32_t nbCommands = 0;
+	uint32_t feedbackSlot = 0;  // Entry of the material in the texture feedback buffer, pushed to shader.frag
 };
 
 class VulkanRenderer
 {
 public:
-	VulkanRenderer(VulkanInstance* vulkan, const ApplicationState* applicationState, const leoscene::Camera* camera);
+	struct Options {
+		// Textures start with their coarse mip levels, and their finer levels are uploaded when shader.frag samples them.
+		// When false, all the levels are uploaded when the textures are loaded.
+		bool textureStreaming = true;
+
+		// Bytes of the mip levels of the streamed textures on the device (see leoscene::TextureResidency)
+		VkDeviceSize textureMemoryBudget = 256 * 1024 * 1024;
+	};
+
+public:
+	VulkanRenderer(VulkanInstance* vulkan, const ApplicationState* applicationState, const leoscene::Camera* camera, const Options& options = {});
 
 public:
 	void init();
 	void cleanup();
 	void drawFrame();
 
-	// Allocate and fill all the scene-related data from the given scene
-	void loadSceneToDevice(const leoscene::Scene* scene);
+	// Allocate and fill all the scene-related data from the given scenes, loaded together.
+	// Can be called again between frames to add more objects: the scene buffers grow and the shapes, materials and textures
+	// already on the device are reused. The new data is uploaded at the start of the next frame, without waiting for the device.
+	// Returns the index of the first object added. Objects are indexed in the order they are loaded.
+	uint32_t loadSceneToDevice(const std::vector<const leoscene::Scene*>& scenes);
+
+	// Sets new world matrices for already loaded objects (see leoscene::SceneGraph). Their data is uploaded at the start of the next frames.
+	void updateObjectMatrices(const uint32_t* objectIndices, const glm::mat4* worldMatrices, size_t nbObjects);
 
 	// Reset data that is dependent on the window's dimensions.
 	void cleanupSwapChainDependentObjects();
@@ -118,7 +191,8 @@ public:
 
 private:
 	void _updateDynamicData();
-	void _drawObjectsCommands(VkCommandBuffer cmd, VkFramebuffer framebuffer);
+	void _drawObjectsCommands(VkCommandBuffer cmd, VkFramebuffer framebuffer, ShaderPass::Type passType);
+	void _drawIndirectCommands(VkCommandBuffer cmd, uint32_t firstCommand, uint32_t nbCommands);
 	void _createMainRenderPass();
 	void _fillConstantGlobalBuffers(const leoscene::Scene* scene);
 	void _createComputePipeline(const char* shaderPath, VkPipeline& pipeline, VkPipelineLayout& layout, ShaderPass& shaderPass);
@@ -130,17 +204,33 @@ private:
 	void _createBarriers();
 	void _computeDepthPyramid(VkCommandBuffer commandBuffer);
 	void _createGlobalDescriptors(uint32_t nbObjects);
+	void _growSceneBuffer(AllocatedBuffer& buffer, VkDeviceSize keptSize, VkDeviceSize newSize, VkBufferUsageFlags usage);
+	void _uploadToSceneBuffer(AllocatedBuffer& buffer, VkDeviceSize offset, const void* data, VkDeviceSize size);
+	void _recordSceneCopies(VkCommandBuffer commandBuffer);
+	void _uploadToImage(const AllocatedImage& image, const void* data, VkDeviceSize size, const std::vector<VkBufferImageCopy>& regions);
+	void _recordImageUploads(VkCommandBuffer commandBuffer);
+	void _retireBuffer(AllocatedBuffer& buffer);
+	void _freeRetiredBuffers(bool all);
+	void _createObjectUpdatesStagingRing();
+	void _recordObjectUpdates(VkCommandBuffer commandBuffer);
+	void _createTextureFeedbackBuffers(uint32_t nbSlots);
+	void _updateTextureStreaming(VkCommandBuffer commandBuffer);
+	void _recordTextureLevelsChange(VkCommandBuffer commandBuffer, uint32_t texture, uint32_t firstLevel);
+	void _recordTextureFeedbackReadback(VkCommandBuffer commandBuffer);
+	void _freeRetiredTextureData(bool all);
 
 private:
 	// Data owned by other objects referenced here for easy access.
 	const leoscene::Camera* _camera = nullptr;  // Application camera
 	const ApplicationState* _applicationState = nullptr;  // Application state
+	Options _options;
 	VulkanInstance* _vulkan = nullptr;  // Vulkan instance (constains swap chain, VkInstance and general properties)
 	VkDevice _device = VK_NULL_HANDLE;  // Logical device owned by the VulkanInstance
 
 	// Builders and helpers
 	MaterialBuilder _materialBuilder;
 	ShaderBuilder _shaderBuilder;
+	SamplerCache _samplerCache;  // All the samplers of the renderer and of the materials
 
 	// Command pool used mainly for single time transfer operations. Each frame has its own command pool.
 	VkCommandPool _mainCommandPool = VK_NULL_HANDLE;
@@ -150,7 +240,7 @@ private:
 	AllocatedImage _framebufferColor;  // Multisampled color attachment
 	AllocatedImage _framebufferDepth;  // Multisampled depth attachment
 	AllocatedImage _depthImage;  // Singlesampled depth resolve attachment
-	VkSampler _depthImageSampler = VK_NULL_HANDLE;  // This sampler is used when we need to sample the depth buffer (ex. computing the depth pyramid)
+	VkSampler _depthImageSampler = VK_NULL_HANDLE;  // This sampler is used when we need to sample the depth buffer (ex. computing the depth pyramid). In _samplerCache.
 	VkFormat _depthBufferFormat = VK_FORMAT_UNDEFINED;
 
 	// Per-frame data
@@ -186,21 +276,141 @@ private:
 	VkDescriptorSetLayout _materialDescriptorSetLayout = VK_NULL_HANDLE;
 	std::unordered_map<const leoscene::Material*, VkDescriptorSet> _materialDescriptorSets;
 	std::vector<std::unique_ptr<AllocatedImage>> _materialImagesData;
-	std::vector<VkSampler> _materialImagesSamplers;
 
 	// Some data needed for the drawFrame function.
 	static const int _MAX_FRAMES_IN_FLIGHT = 2;
 	size_t _currentFrame = 0;
+	uint64_t _frameNumber = 0;  // Frames drawn so far
 
-	// Vertex and index buffers
+	// Range of each loaded shape in the vertex and index buffers
 	std::vector<std::unique_ptr<ShapeData>> _shapeData;
 
+	// Vertices and indices of all the loaded shapes, one after another. Grown when shapes are added.
+	AllocatedBuffer _positionBuffer;  // leoscene::PackedVertexPosition, vertex binding 0
+	AllocatedBuffer _attributeBuffer;  // leoscene::PackedVertexAttributes, vertex binding 1
+	AllocatedBuffer _indexBuffer;  // 16 and 32 bits indices. The indices of each shape start on 4 bytes, so that both types can be bound.
+	uint32_t _nbVertices = 0;
+	uint32_t _verticesCapacity = 0;
+	VkDeviceSize _indexDataSize = 0;  // In bytes
+	VkDeviceSize _indexDataCapacity = 0;
+
+	// Copies to the scene buffers queued by loadSceneToDevice, recorded in order at the start of the next frame.
+	// Growing a buffer queues the copy of its content to the new buffer.
+	struct PendingSceneCopy {
+		VkBuffer srcBuffer = VK_NULL_HANDLE;
+		VkBuffer dstBuffer = VK_NULL_HANDLE;
+		VkBufferCopy region = {};
+	};
+	std::vector<PendingSceneCopy> _pendingSceneCopies;
+
+	// Uploads of all the levels of the images created by loadSceneToDevice, recorded after the scene copies
+	struct PendingImageUpload {
+		VkBuffer stagingBuffer = VK_NULL_HANDLE;
+		VkImage image = VK_NULL_HANDLE;
+		uint32_t mipLevels = 0;
+		std::vector<VkBufferImageCopy> regions;  // Offsets relative to the staging buffer
+	};
+	std::vector<PendingImageUpload> _pendingImageUploads;
+
+	// Scene buffers replaced when growing, and staging buffers, freed once the frames that may use them are done
+	struct RetiredBuffer {
+		AllocatedBuffer buffer = {};
+		uint64_t frame = 0;
+	};
+	std::vector<RetiredBuffer> _retiredBuffers;
+	bool _sceneDescriptorsOutdated = false;  // A buffer of the global or culling descriptor sets was replaced
+
+	// Scene resources already on the device, so that objects added later reuse them.
+	std::unordered_map<const leoscene::Material*, LoadedSceneResource<leoscene::Material, const Material*>> _loadedMaterials;
+	std::unordered_map<const leoscene::Shape*, LoadedSceneResource<leoscene::Shape, const ShapeData*>> _loadedShapes;
+	std::unordered_map<const leoscene::ImageTexture*, LoadedSceneResource<leoscene::ImageTexture, AllocatedImage*>> _loadedImages;
+
+	// Number of objects the per-object buffers can hold. Grows when objects are added to the scene.
+	static const uint32_t _MIN_OBJECTS_CAPACITY = 1024;
+	uint32_t _objectsCapacity = 0;
+
 	uint32_t _totalInstancesNb = 0;
 	size_t _nbMaterials = 0;
 	uint32_t _nbInstances = 0;
 
+	/*
+	* Data for the objects moved after loading
+	*/
+
+	// Bounding sphere of each object's shape, in object space. Needed to compute the world space bounds of the objects that moved.
+	std::vector<glm::vec4> _objectsLocalBounds;
+	std::vector<GPUBoundingBox> _objectsLocalBoxes;  // Uploaded again with the matrices of the objects that moved
+	std::vector<glm::vec4> _updatedObjectsBounds;  // Reused by updateObjectMatrices
+
+	// Objects data waiting to be uploaded, one entry per object. _pendingObjectUpdateSlots gives the entry of each object, if any.
+	struct PendingObjectUpdate {
+		uint32_t dataId = 0;
+		GPUObjectData data = {};
+	};
+	std::vector<PendingObjectUpdate> _pendingObjectUpdates;
+	std::vector<uint32_t> _pendingObjectUpdateSlots;
+
+	// Persistently mapped staging ring, with one segment per frame in flight. A segment is written once the fence
+	// of its frame is signaled. Updates that do not fit in a segment wait for the next frame.
+	static const uint32_t _MAX_OBJECT_UPDATES_PER_FRAME = 16384;
+	AllocatedBuffer _objectUpdatesStagingRing = {};
+	GPUObjectData* _objectUpdatesStagingData = nullptr;
+	std::vector<VkBufferCopy> _objectUpdatesCopies;
+
 	// Data related to each draw call (material, instance number etc.)
 	std::vector<DrawCallInfo> _drawCalls;
+	std::map<std::pair<const Material*, const ShapeData*>, uint32_t> _drawCallIndices;  // Batch id of each pair of material and shape
+	std::vector<MaterialDrawInfo> _materialDraws;  // Draw calls of each material, in the order of the indirect draw commands
+	std::vector<MaterialDrawInfo> _indexTypeDraws;  // Draw call of each index type for the depth-only pass. The material is null.
+	std::vector<uint32_t> _objectsBatch;  // Batch id of each object, to write the instances again when the commands move
+	uint32_t _nbDrawCommands = 0;  // Indirect draw commands of all the batches
+
+	/*
+	* Data for texture streaming (see leoscene::TextureResidency)
+	*/
+
+	// Texture with mip levels whose resident levels change. Its image only holds the resident levels: level 0 of the image is the
+	// first resident level of the texture, so that the evicted levels take no memory. The image is replaced when they change.
+	struct StreamedTexture {
+		std::shared_ptr<const leoscene::ImageTexture> source;  // Kept for the levels uploaded later, since the scene is freed after loading
+		AllocatedImage* image = nullptr;  // In _materialImagesData
+		VkFormat format = VK_FORMAT_UNDEFINED;
+		std::vector<uint32_t> materials;  // Feedback slots of the materials sampling the texture
+	};
+
+	// Material with a slot in the feedback buffer. Its descriptor set is written again when the images of its textures are replaced.
+	static const uint32_t _NOT_STREAMED = 0xFFFFFFFF;
+	struct StreamedMaterial {
+		Material* material = nullptr;
+		std::array<uint32_t, 5> textures = { _NOT_STREAMED, _NOT_STREAMED, _NOT_STREAMED, _NOT_STREAMED, _NOT_STREAMED };  // Streamed texture of each binding
+		// Written in turn with the new images, then swapped with the set of the material. A spare set is written again
+		// _MAX_FRAMES_IN_FLIGHT swaps after it was swapped out, so its last frame is done even if the material changes every frame.
+		std::array<VkDescriptorSet, _MAX_FRAMES_IN_FLIGHT> spareDescriptorSets = {};
+		uint32_t nextSpareDescriptorSet = 0;
+		bool changed = false;  // Reset once its set is swapped
+	};
+
+	// Device objects replaced by the streaming, freed once the frames that may use them are done
+	struct RetiredTextureData {
+		AllocatedImage image = {};
+		AllocatedBuffer stagingBuffer = {};
+		uint64_t frame = 0;
+	};
+
+	leoscene::TextureResidency _textureResidency;
+	std::vector<StreamedTexture> _streamedTextures;  // In the order of the ids of _textureResidency
+	std::unordered_map<const AllocatedImage*, uint32_t> _streamedTextureIds;  // For the textures already loaded, reused by new materials
+	std::vector<StreamedMaterial> _streamedMaterials;  // Indexed by feedback slot
+	std::unordered_map<const Material*, uint32_t> _feedbackSlots;
+	std::vector<RetiredTextureData> _retiredTextureData;
+	std::vector<leoscene::TextureResidency::Change> _textureResidencyChanges;  // Reused by _updateTextureStreaming
+
+	// Finest level sampled in the textures of each material, written by shader.frag (see leoscene::TextureResidency::FEEDBACK_LOD_BIAS).
+	// Copied each frame to the segment of the frame in the readback buffer, then reset. The segment is read once the fence of its frame is signaled.
+	AllocatedBuffer _textureFeedbackBuffer = {};
+	AllocatedBuffer _textureFeedbackReadback = {};
+	uint32_t* _textureFeedbackReadbackData = nullptr;
+	uint32_t _textureFeedbackCapacity = 0;  // Slots of each segment
 
 	/*
 	* Data for indirect compute based culling
@@ -211,10 +421,17 @@ private:
 	VkPipelineLayout _cullingPipelineLayout = VK_NULL_HANDLE;
 	ShaderPass _cullShaderPass;
 
-	// Data for used by the culling compute pipeline
+	// Cluster culling compute pipeline (frustum, occlusion and back-face culling of the clusters of the objects drawn with their LOD 0)
+	VkPipeline _clusterCullingPipeline = VK_NULL_HANDLE;
+	VkPipelineLayout _clusterCullingPipelineLayout = VK_NULL_HANDLE;
+	ShaderPass _clusterCullShaderPass;
+
+	// Data for used by the culling compute pipelines
 	DescriptorAllocator _cullingDescriptorAllocator;
 	VkDescriptorSetLayout _cullingDescriptorSetLayout = VK_NULL_HANDLE;
 	VkDescriptorSet _cullingDescriptorSet = VK_NULL_HANDLE;
+	VkDescriptorSetLayout _clusterCullingDescriptorSetLayout = VK_NULL_HANDLE;
+	VkDescriptorSet _clusterCullingDescriptorSet = VK_NULL_HANDLE;
 	glm::mat4 _cullingViewMatrix = glm::mat4(1);  // All culling happens from this view. Usually set to be the camera's view matrix, but can be (un)locked by presing "L".
 	// Projection matrix of the camera.
 	glm::mat4 _projectionMatrix = glm::mat4(1);
@@ -222,16 +439,47 @@ private:
 	float _zNear = 0.1f;
 	float _zFar = 300.f;
 
+	// Largest error, in pixels, of the LOD picked for each object by the culling shader.
+	static constexpr float _LOD_PIXEL_ERROR = 1.f;
+
+	// Largest error, in pixels, of the HLOD proxies drawn instead of their members. Higher than for the LODs: a proxy replaces
+	// hundreds of draws, and the merged geometry hides the error better than a single simplified mesh.
+	static constexpr float _HLOD_PIXEL_ERROR = 4.f;
+
 	AllocatedBuffer _gpuObjectInstances = {};  // For each instance, the batch it belongs to and an index to retrieve the instance's data (transform matrix, bounds)
 	AllocatedBuffer _gpuBatches = {};  // Set by the culling shader. For each draw call, the corresponding indirect draw command
 	AllocatedBuffer _gpuCullingGlobalData = {};  // Global data used by the culling algorithms: The frustum's representation, among other things.
 	AllocatedBuffer _gpuResetBatches = {};  // Constant buffer used to reset the batches buffer each frame.
-	AllocatedBuffer _gpuIndexToObjectId = {};  // A map from instance index to the instance's data. Set by the culling shader.
+	uint32_t _commandsCapacity = 0;  // Commands of _gpuBatches and _gpuResetBatches
+	AllocatedBuffer _gpuIndexToObjectId = {};  // A map from instance index to the instance's data. Set by the culling shaders. See _MAX_CLUSTERED_INSTANCES_PER_BATCH for its size.
+	uint32_t _indexMapCapacity = 0;  // Entries of _gpuIndexToObjectId
+
+	// Clusters of all the shapes, appended when shapes are loaded. Only the new clusters are uploaded.
+	std::vector<GPUCluster> _clusters;
+	AllocatedBuffer _gpuClusters = {};
+	uint32_t _clustersCapacity = 0;
+	AllocatedBuffer _gpuClusteredInstances = {};  // Set by the culling shader. Visible instances drawn with their LOD 0 split into clusters.
+
+	// The commands of the LODs have room for all the objects of their batch in the index map, and the commands of the clusters
+	// for this many objects only. The index map then holds at most nbObjects * nbLods + nbClusters * min(nbObjects, this) entries
+	// per batch, instead of nbObjects * (nbClusters + nbLods - 1). The instances of a batch drawn with their LOD 0 beyond this
+	// number are drawn with the full LOD 0 instead, without culling their clusters.
+	static const uint32_t _MAX_CLUSTERED_INSTANCES_PER_BATCH = 256;
+	AllocatedBuffer _gpuClusterDispatch = {};  // Number of clustered instances, then the indirect dispatch of the cluster culling shader. Reset each frame.
+
+	// HLOD clusters of all the loaded objects. Only the new clusters are uploaded.
+	static const uint32_t _NO_HLOD = 0xFFFFFFFF;
+	std::vector<GPUHlodCluster> _hlodClusters;
+	AllocatedBuffer _gpuHlodClusters = {};
+	uint32_t _hlodClustersCapacity = 0;
+	AllocatedBuffer _gpuObjectsHlod = {};  // For each object, _NO_HLOD, or its cluster shifted left by one with the lowest bit set on proxies
 
 	// Barriers to synchronize access of resources written by the culling algorithm and then read by the render pass.
 	VkBufferMemoryBarrier _gpuBatchesBarrier = {};
 	VkBufferMemoryBarrier _gpuBatchesResetBarrier = {};
 	VkBufferMemoryBarrier _gpuIndexToObjectIdBarrier = {};
+	VkBufferMemoryBarrier _gpuClusterDispatchResetBarrier = {};
+	std::array<VkBufferMemoryBarrier, 4> _clusterCullingBarriers = {};  // From the culling shader to the cluster culling shader
 
 	/*
 	* Data for computing the depth pyramid used by compute based culling
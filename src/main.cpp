@@ -11,20 +11,68 @@ namespace {
 }
 
 int main(int argc, const char** argv) {
-	if (argc > 2) {
-		std::cerr << "Error: too many arguments." << std::endl;
-		printUsage();
-		return 1;
-	}
-
 	const char* scenePath = "resources/models/Sponza/super_sponza.scene";
-	if (argc == 2) {
-		if (!strcmp(argv[1], "--help")) {
+	leoscene::SceneLoader::LoadingOptions loadingOptions;
+	VulkanRenderer::Options rendererOptions;
+	bool hasScenePath = false;
+	bool streamScene = true;
+	for (int i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "--help")) {
 			printUsage();
 			return 0;
 		}
+		else if (!strcmp(argv[i], "--load-threads")) {
+			int value = i + 1 < argc ? atoi(argv[i + 1]) : 0;
+			if (value <= 0) {
+				std::cerr << "Error: --load-threads expects a positive number of threads." << std::endl;
+				printUsage();
+				return 1;
+			}
+			loadingOptions.nbThreads = static_cast<uint32_t>(value);
+			++i;
+		}
+		else if (!strcmp(argv[i], "--no-asset-cache")) {
+			loadingOptions.assetCacheDirectoryPath.clear();
+		}
+		else if (!strcmp(argv[i], "--no-streaming")) {
+			streamScene = false;
+		}
+		else if (!strcmp(argv[i], "--no-mesh-optimization")) {
+			loadingOptions.optimizeMeshes = false;
+		}
+		else if (!strcmp(argv[i], "--no-lods")) {
+			loadingOptions.generateLods = false;
+		}
+		else if (!strcmp(argv[i], "--no-clusters")) {
+			loadingOptions.buildClusters = false;
+		}
+		else if (!strcmp(argv[i], "--no-hlods")) {
+			loadingOptions.buildHlods = false;
+		}
+		else if (!strcmp(argv[i], "--no-texture-compression")) {
+			loadingOptions.compressTextures = false;
+		}
+		else if (!strcmp(argv[i], "--texture-budget")) {
+			int value = i + 1 < argc ? atoi(argv[i + 1]) : 0;
+			if (value <= 0) {
+				std::cerr << "Error: --texture-budget expects a positive number of megabytes." << std::endl;
+				printUsage();
+				return 1;
+			}
+			rendererOptions.textureMemoryBudget = static_cast<VkDeviceSize>(value) * 1024 * 1024;
+			++i;
+		}
+		else if (!strcmp(argv[i], "--no-texture-streaming")) {
+			rendererOptions.textureStreaming = false;
+		}
+		else if (!hasScenePath) {
+			scenePath = argv[i];
+			hasScenePath = true;
+		}
 		else {
-			scenePath = argv[1];
+			std::cerr << "Error: too many arguments." << std::endl;
+			printUsage();
+			return 1;
 		}
 	}
 
@@ -32,13 +80,13 @@ int main(int argc, const char** argv) {
 		Application application;
 
 		std::cout << "Initializing application" << std::endl;
-		if (application.init()) {
+		if (application.init(rendererOptions)) {
 			std::cerr << "Error. Application failed to initialize. Exiting." << std::endl;
 			return 2;
 		}
 
 		std::cout << "Loading scene" << std::endl;
-		if (application.loadScene(scenePath)) {
+		if (streamScene ? application.streamScene(scenePath, loadingOptions) : application.loadScene(scenePath, loadingOptions)) {
 			std::cerr << "Error: Scene loading failed. Exiting." << std::endl;
 			return 2;
 		}
@@ -58,9 +106,19 @@ int main(int argc, const char** argv) {
 namespace {
 	void printUsage() {
 		std::cout << "Usage:" << std::endl
-			<< "\t" << "LeoEngine.exe [my_file.scene]" << "\t" << "Open the scene file with the renderer." << std::endl
+			<< "\t" << "LeoEngine.exe [my_file.scene] [--load-threads N] [--no-asset-cache] [--no-streaming] [--no-mesh-optimization] [--no-lods] [--no-clusters] [--no-hlods] [--no-texture-compression] [--texture-budget MB] [--no-texture-streaming]" << "\t" << "Open the scene file with the renderer." << std::endl
 			<< "\t" << "LeoEngine.exe --help [...]" << "\t" << "Print this help." << std::endl;
 		std::cout << "Notes:" << std::endl
-			<< "\t" << "If no scene file is provided, will open \"resources/models/Sponza/super_sponza.scene\"." << std::endl << std::endl;
+			<< "\t" << "If no scene file is provided, will open \"resources/models/Sponza/super_sponza.scene\"." << std::endl
+			<< "\t" << "--load-threads N sets the number of threads loading the scene, which import the models, process their meshes and textures, and build the HLODs. Defaults to one per hardware thread." << std::endl
+			<< "\t" << "--no-asset-cache disables the cache of processed models and textures (\"cache\" directory)." << std::endl
+			<< "\t" << "--no-streaming loads the whole scene before the first frame, instead of showing objects as soon as they are loaded." << std::endl
+			<< "\t" << "--no-mesh-optimization keeps the triangles and vertices of the imported meshes in the order of the model files." << std::endl
+			<< "\t" << "--no-lods draws every object with its full mesh, instead of simplified versions when they are far enough." << std::endl
+			<< "\t" << "--no-clusters culls the full meshes as a whole, instead of culling each of their clusters of triangles." << std::endl
+			<< "\t" << "--no-hlods draws every object on its own, instead of merging the far groups of objects into single proxy meshes." << std::endl
+			<< "\t" << "--no-texture-compression uploads the textures uncompressed (RGBA or R), instead of in BC1/BC4/BC5/BC7 with precomputed mip levels." << std::endl
+			<< "\t" << "--texture-budget MB sets the device memory of the mip levels of the streamed textures. Defaults to 256." << std::endl
+			<< "\t" << "--no-texture-streaming uploads all the mip levels of the textures when they are loaded, instead of the ones sampled on screen." << std::endl << std::endl;
 	}
 }
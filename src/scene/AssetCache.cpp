@@ -0,0 +1,300 @@
+#include "AssetCache.h"
+
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <utility>
+
+namespace leoscene {
+	namespace {
+		const char ENTRY_MAGIC[4] = { 'L', 'E', 'O', 'C' };
+		const uint32_t ENTRY_VERSION = 4;
+		const uint64_t PAYLOAD_ALIGNMENT = 16;
+
+		struct AssetCacheEntryHeader {
+			char magic[4];
+			uint32_t version;
+			uint32_t keySize;  // The key is stored right after the header, to detect collisions on entry file names.
+			uint32_t nbDependencies;  // The dependencies are stored after the key
+			int64_t sourceModificationTime;
+			uint64_t sourceSize;
+			uint64_t sourceContentHash;
+			uint64_t payloadOffset;
+			uint64_t payloadSize;
+		};
+
+		// Followed by the path of the file
+		struct AssetCacheDependency {
+			int64_t modificationTime;
+			uint64_t size;
+			uint64_t contentHash;
+			uint32_t isMissing;
+			uint32_t pathSize;
+		};
+
+		bool isFileUnchanged(const char* filePath, bool wasMissing, int64_t recordedModificationTime, uint64_t recordedSize, uint64_t recordedContentHash, int64_t& modificationTime);
+		bool getSourceFileInfo(const char* filePath, int64_t& modificationTime, uint64_t& size);
+		bool hashFile(const char* filePath, uint64_t& hash);
+		uint64_t hashData(const void* data, size_t size);
+	}
+
+	AssetCache::AssetCache(const std::string& directoryPath) : _directoryPath(directoryPath)
+	{
+	}
+
+	bool AssetCache::find(const std::string& key, const char* sourceFilePath, MappedFile& file, const unsigned char*& payload, size_t& payloadSize) const
+	{
+		if (!file.open(_getEntryPath(key).c_str())) {
+			return false;
+		}
+
+		const unsigned char* data = file.getData();
+		size_t size = file.getSize();
+		AssetCacheEntryHeader header = {};
+		if (size >= sizeof(AssetCacheEntryHeader)) {
+			memcpy(&header, data, sizeof(AssetCacheEntryHeader));
+		}
+		uint64_t keyEnd = sizeof(AssetCacheEntryHeader) + key.size();
+		bool isValid = size >= sizeof(AssetCacheEntryHeader) &&
+			!memcmp(header.magic, ENTRY_MAGIC, sizeof(ENTRY_MAGIC)) &&
+			header.version == ENTRY_VERSION &&
+			header.keySize == key.size() && key.size() <= size - sizeof(AssetCacheEntryHeader) &&
+			!memcmp(data + sizeof(AssetCacheEntryHeader), key.data(), key.size()) &&
+			header.payloadOffset >= keyEnd && header.payloadOffset <= size && header.payloadSize <= size - header.payloadOffset;
+
+		// Files touched since the entry was written may still have the same content, in which case the entry is updated
+		// with their new modification time so that they are not hashed again next time. Offsets in the entry and times.
+		std::vector<std::pair<uint64_t, int64_t>> modificationTimeUpdates;
+		int64_t modificationTime = 0;
+		if (isValid) {
+			isValid = isFileUnchanged(sourceFilePath, false, header.sourceModificationTime, header.sourceSize, header.sourceContentHash, modificationTime);
+			if (modificationTime != header.sourceModificationTime) {
+				modificationTimeUpdates.push_back({ offsetof(AssetCacheEntryHeader, sourceModificationTime), modificationTime });
+			}
+		}
+		uint64_t dependencyOffset = keyEnd;
+		for (uint32_t i = 0; isValid && i < header.nbDependencies; ++i) {
+			AssetCacheDependency dependency = {};
+			if (sizeof(AssetCacheDependency) > header.payloadOffset - dependencyOffset) {
+				isValid = false;
+				break;
+			}
+			memcpy(&dependency, data + dependencyOffset, sizeof(AssetCacheDependency));
+			uint64_t pathOffset = dependencyOffset + sizeof(AssetCacheDependency);
+			if (dependency.pathSize > header.payloadOffset - pathOffset) {
+				isValid = false;
+				break;
+			}
+			std::string dependencyFilePath(reinterpret_cast<const char*>(data + pathOffset), dependency.pathSize);
+			isValid = isFileUnchanged(dependencyFilePath.c_str(), dependency.isMissing, dependency.modificationTime, dependency.size, dependency.contentHash, modificationTime);
+			if (modificationTime != dependency.modificationTime) {
+				modificationTimeUpdates.push_back({ dependencyOffset + offsetof(AssetCacheDependency, modificationTime), modificationTime });
+			}
+			dependencyOffset = pathOffset + dependency.pathSize;
+		}
+
+		if (!isValid) {
+			file.close();
+			return false;
+		}
+
+		if (modificationTimeUpdates.size()) {
+			file.close();
+			{
+				std::fstream entry(_getEntryPath(key), std::ios::in | std::ios::out | std::ios::binary);
+				for (const std::pair<uint64_t, int64_t>& update : modificationTimeUpdates) {
+					entry.seekp(update.first);
+					entry.write(reinterpret_cast<const char*>(&update.second), sizeof(int64_t));
+				}
+			}
+			if (!file.open(_getEntryPath(key).c_str()) || file.getSize() != size) {
+				file.close();
+				return false;
+			}
+		}
+
+		payload = file.getData() + header.payloadOffset;
+		payloadSize = static_cast<size_t>(header.payloadSize);
+		return true;
+	}
+
+	void AssetCache::store(const std::string& key, const char* sourceFilePath, const std::vector<unsigned char>& payload,
+		const std::vector<std::string>& dependencyFilePaths) const
+	{
+		AssetCacheEntryHeader header = {};
+		memcpy(header.magic, ENTRY_MAGIC, sizeof(ENTRY_MAGIC));
+		header.version = ENTRY_VERSION;
+		header.keySize = static_cast<uint32_t>(key.size());
+		header.nbDependencies = static_cast<uint32_t>(dependencyFilePaths.size());
+		if (!getSourceFileInfo(sourceFilePath, header.sourceModificationTime, header.sourceSize) || !hashFile(sourceFilePath, header.sourceContentHash)) {
+			return;
+		}
+
+		std::vector<unsigned char> dependencies;
+		AssetCacheWriter dependenciesWriter(dependencies);
+		for (const std::string& dependencyFilePath : dependencyFilePaths) {
+			AssetCacheDependency dependency = {};
+			if (!getSourceFileInfo(dependencyFilePath.c_str(), dependency.modificationTime, dependency.size)) {
+				dependency.isMissing = 1;
+			}
+			else if (!hashFile(dependencyFilePath.c_str(), dependency.contentHash)) {
+				return;
+			}
+			dependency.pathSize = static_cast<uint32_t>(dependencyFilePath.size());
+			dependenciesWriter.write(&dependency, sizeof(AssetCacheDependency));
+			dependenciesWriter.write(dependencyFilePath.data(), dependencyFilePath.size());
+		}
+
+		uint64_t dependenciesEnd = sizeof(AssetCacheEntryHeader) + key.size() + dependencies.size();
+		header.payloadOffset = (dependenciesEnd + PAYLOAD_ALIGNMENT - 1) & ~(PAYLOAD_ALIGNMENT - 1);
+		header.payloadSize = payload.size();
+
+		std::error_code error;
+		std::filesystem::create_directories(_directoryPath, error);
+
+		// The entry is written to a temporary file first, so that readers never see a partially written entry.
+		std::string entryPath = _getEntryPath(key);
+		std::stringstream temporaryPath;
+		temporaryPath << entryPath << "." << std::this_thread::get_id() << ".tmp";
+		{
+			std::ofstream ofs(temporaryPath.str(), std::ios::binary);
+			static const char zeros[PAYLOAD_ALIGNMENT] = {};
+			ofs.write(reinterpret_cast<const char*>(&header), sizeof(AssetCacheEntryHeader));
+			ofs.write(key.data(), key.size());
+			ofs.write(reinterpret_cast<const char*>(dependencies.data()), dependencies.size());
+			ofs.write(zeros, header.payloadOffset - dependenciesEnd);
+			ofs.write(reinterpret_cast<const char*>(payload.data()), payload.size());
+			if (!ofs) {
+				ofs.close();
+				std::filesystem::remove(temporaryPath.str(), error);
+				return;
+			}
+		}
+
+		std::filesystem::rename(temporaryPath.str(), entryPath, error);
+		if (error) {  // For example if the previous entry is still mapped by a reader on Windows. The entry will be written next time.
+			std::filesystem::remove(temporaryPath.str(), error);
+		}
+	}
+
+	const std::string& AssetCache::getDirectoryPath() const
+	{
+		return _directoryPath;
+	}
+
+	std::string AssetCache::_getEntryPath(const std::string& key) const
+	{
+		std::stringstream entryPath;
+		entryPath << _directoryPath << "/" << std::hex << hashData(key.data(), key.size()) << ".leocache";
+		return entryPath.str();
+	}
+
+	AssetCacheWriter::AssetCacheWriter(std::vector<unsigned char>& payload) : _payload(payload)
+	{
+	}
+
+	void AssetCacheWriter::write(const void* data, size_t size)
+	{
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		_payload.insert(_payload.end(), bytes, bytes + size);
+	}
+
+	void AssetCacheWriter::writeUint32(uint32_t value)
+	{
+		write(&value, sizeof(uint32_t));
+	}
+
+	void AssetCacheWriter::writeString(const std::string& value)
+	{
+		writeUint32(static_cast<uint32_t>(value.size()));
+		write(value.data(), value.size());
+	}
+
+	AssetCacheReader::AssetCacheReader(const unsigned char* payload, size_t payloadSize) : _payload(payload), _payloadSize(payloadSize)
+	{
+	}
+
+	bool AssetCacheReader::read(void* data, size_t size)
+	{
+		if (size > _payloadSize - _offset) {
+			return false;
+		}
+		memcpy(data, _payload + _offset, size);
+		_offset += size;
+		return true;
+	}
+
+	bool AssetCacheReader::readUint32(uint32_t& value)
+	{
+		return read(&value, sizeof(uint32_t));
+	}
+
+	bool AssetCacheReader::readString(std::string& value)
+	{
+		uint32_t size = 0;
+		if (!readUint32(size) || size > _payloadSize - _offset) {
+			return false;
+		}
+		value.assign(reinterpret_cast<const char*>(_payload + _offset), size);
+		_offset += size;
+		return true;
+	}
+
+	namespace {
+		// Checks that a file has the recorded modification time and size, or else the recorded content. modificationTime
+		// receives its current modification time. A missing file is unchanged if it was already missing.
+		bool isFileUnchanged(const char* filePath, bool wasMissing, int64_t recordedModificationTime, uint64_t recordedSize, uint64_t recordedContentHash, int64_t& modificationTime)
+		{
+			modificationTime = recordedModificationTime;
+			uint64_t size = 0;
+			if (!getSourceFileInfo(filePath, modificationTime, size)) {
+				return wasMissing;
+			}
+			if (wasMissing || size != recordedSize) {
+				return false;
+			}
+			uint64_t contentHash = 0;
+			return modificationTime == recordedModificationTime || (hashFile(filePath, contentHash) && contentHash == recordedContentHash);
+		}
+
+		bool getSourceFileInfo(const char* filePath, int64_t& modificationTime, uint64_t& size)
+		{
+			std::error_code error;
+			std::filesystem::file_time_type fileTime = std::filesystem::last_write_time(filePath, error);
+			if (error) {
+				return false;
+			}
+			size = std::filesystem::file_size(filePath, error);
+			if (error) {
+				return false;
+			}
+			modificationTime = static_cast<int64_t>(fileTime.time_since_epoch().count());
+			return true;
+		}
+
+		bool hashFile(const char* filePath, uint64_t& hash)
+		{
+			MappedFile file;
+			if (!file.open(filePath)) {
+				return false;
+			}
+			hash = hashData(file.getData(), file.getSize());
+			return true;
+		}
+
+		// 64 bits FNV-1a
+		uint64_t hashData(const void* data, size_t size)
+		{
+			const unsigned char* bytes = static_cast<const unsigned char*>(data);
+			uint64_t hash = 14695981039346656037ull;
+			for (size_t i = 0; i < size; ++i) {
+				hash ^= bytes[i];
+				hash *= 1099511628211ull;
+			}
+			return hash;
+		}
+	}
+}
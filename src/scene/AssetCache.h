@@ -0,0 +1,71 @@
+#pragma once
+
+#include "MappedFile.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace leoscene {
+	/*
+	* Persistent on-disk cache of preprocessed assets (processed meshes, decoded textures).
+	*
+	* Each entry is one file in the cache directory, named after a hash of its key. The key identifies the source file
+	* and the way it was processed. An entry is valid as long as the source file has the same modification time and size
+	* as when the entry was written, or else the same content hash. The same goes for the other files the entry was made
+	* from (dependencies), which may also be missing files: their entry is valid as long as they are still missing.
+	* Entries can be read and written from several threads at the same time, as long as their keys differ.
+	*/
+	class AssetCache {
+	public:
+		AssetCache(const std::string& directoryPath);
+
+	public:
+		// Maps the cache entry for the given key. On success, payload points to the entry's data inside the mapped file.
+		bool find(const std::string& key, const char* sourceFilePath, MappedFile& file, const unsigned char*& payload, size_t& payloadSize) const;
+
+		// Writes the cache entry for the given key, replacing any previous one. Fails silently: the cache is optional.
+		void store(const std::string& key, const char* sourceFilePath, const std::vector<unsigned char>& payload,
+			const std::vector<std::string>& dependencyFilePaths = {}) const;
+
+		const std::string& getDirectoryPath() const;
+
+	private:
+		std::string _getEntryPath(const std::string& key) const;
+
+	private:
+		std::string _directoryPath;
+	};
+
+	/*
+	* Helpers to write and read the payload of cache entries.
+	*/
+	class AssetCacheWriter {
+	public:
+		AssetCacheWriter(std::vector<unsigned char>& payload);
+
+	public:
+		void write(const void* data, size_t size);
+		void writeUint32(uint32_t value);
+		void writeString(const std::string& value);
+
+	private:
+		std::vector<unsigned char>& _payload;
+	};
+
+	class AssetCacheReader {
+	public:
+		AssetCacheReader(const unsigned char* payload, size_t payloadSize);
+
+	public:
+		// Return false if the payload is too small. Nothing is read in that case.
+		bool read(void* data, size_t size);
+		bool readUint32(uint32_t& value);
+		bool readString(std::string& value);
+
+	private:
+		const unsigned char* _payload = nullptr;
+		size_t _payloadSize = 0;
+		size_t _offset = 0;
+	};
+}
@@ -0,0 +1,206 @@
+#include "BatchTransforms.h"
+
+// Define LEO_DISABLE_SIMD to build the plain C++ version, for example to compare it with the vectorized ones.
+#if defined(LEO_DISABLE_SIMD)
+#elif defined(__AVX2__)
+#define LEO_BATCH_TRANSFORMS_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LEO_BATCH_TRANSFORMS_SSE
+#include <emmintrin.h>
+#endif
+
+namespace leoscene {
+	namespace {
+#if defined(LEO_BATCH_TRANSFORMS_AVX2) || defined(LEO_BATCH_TRANSFORMS_SSE)
+		template<int lane>
+		__m128 splat(__m128 v);
+
+		__m128 multiplyAdd(__m128 a, __m128 b, __m128 c);
+		void transformSphere(const float* matrix, const float* sphere, float* result);
+#endif
+#if defined(LEO_BATCH_TRANSFORMS_AVX2)
+		void multiplyAffine(__m256 lhs0, __m256 lhs1, __m256 lhs2, __m256 lhs3, const float* rhs, float* result);
+#elif defined(LEO_BATCH_TRANSFORMS_SSE)
+		void multiplyAffine(__m128 lhs0, __m128 lhs1, __m128 lhs2, __m128 lhs3, const float* rhs, float* result);
+#else
+		void multiplyAffine(const glm::mat4& lhs, const glm::mat4& rhs, glm::mat4& result);
+		void transformSphere(const glm::mat4& matrix, const glm::vec4& sphere, glm::vec4& result);
+#endif
+	}
+
+	void multiplyAffineMatrices(const glm::mat4& lhs, const glm::mat4* rhs, glm::mat4* results, size_t count)
+	{
+		// The columns of lhs are loaded once for the whole batch.
+#if defined(LEO_BATCH_TRANSFORMS_AVX2)
+		__m256 lhs0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&lhs[0][0]));
+		__m256 lhs1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&lhs[1][0]));
+		__m256 lhs2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&lhs[2][0]));
+		__m256 lhs3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&lhs[3][0]));
+		for (size_t i = 0; i < count; ++i) {
+			multiplyAffine(lhs0, lhs1, lhs2, lhs3, &rhs[i][0][0], &results[i][0][0]);
+		}
+#elif defined(LEO_BATCH_TRANSFORMS_SSE)
+		__m128 lhs0 = _mm_loadu_ps(&lhs[0][0]);
+		__m128 lhs1 = _mm_loadu_ps(&lhs[1][0]);
+		__m128 lhs2 = _mm_loadu_ps(&lhs[2][0]);
+		__m128 lhs3 = _mm_loadu_ps(&lhs[3][0]);
+		for (size_t i = 0; i < count; ++i) {
+			multiplyAffine(lhs0, lhs1, lhs2, lhs3, &rhs[i][0][0], &results[i][0][0]);
+		}
+#else
+		for (size_t i = 0; i < count; ++i) {
+			multiplyAffine(lhs, rhs[i], results[i]);
+		}
+#endif
+	}
+
+	void multiplyAffineMatrices(const glm::mat4* lhs, const glm::mat4* rhs, glm::mat4* results, size_t count)
+	{
+		for (size_t i = 0; i < count; ++i) {
+#if defined(LEO_BATCH_TRANSFORMS_AVX2)
+			multiplyAffine(
+				_mm256_broadcast_ps(reinterpret_cast<const __m128*>(&lhs[i][0][0])),
+				_mm256_broadcast_ps(reinterpret_cast<const __m128*>(&lhs[i][1][0])),
+				_mm256_broadcast_ps(reinterpret_cast<const __m128*>(&lhs[i][2][0])),
+				_mm256_broadcast_ps(reinterpret_cast<const __m128*>(&lhs[i][3][0])),
+				&rhs[i][0][0], &results[i][0][0]);
+#elif defined(LEO_BATCH_TRANSFORMS_SSE)
+			multiplyAffine(_mm_loadu_ps(&lhs[i][0][0]), _mm_loadu_ps(&lhs[i][1][0]), _mm_loadu_ps(&lhs[i][2][0]), _mm_loadu_ps(&lhs[i][3][0]),
+				&rhs[i][0][0], &results[i][0][0]);
+#else
+			multiplyAffine(lhs[i], rhs[i], results[i]);
+#endif
+		}
+	}
+
+	void transformBoundingSpheres(const glm::mat4* matrices, const glm::vec4* spheres, glm::vec4* results, size_t count)
+	{
+		for (size_t i = 0; i < count; ++i) {
+#if defined(LEO_BATCH_TRANSFORMS_AVX2) || defined(LEO_BATCH_TRANSFORMS_SSE)
+			transformSphere(&matrices[i][0][0], &spheres[i][0], &results[i][0]);
+#else
+			transformSphere(matrices[i], spheres[i], results[i]);
+#endif
+		}
+	}
+
+	const char* getBatchTransformsInstructionSet()
+	{
+#if defined(LEO_BATCH_TRANSFORMS_AVX2)
+		return "AVX2";
+#elif defined(LEO_BATCH_TRANSFORMS_SSE)
+		return "SSE";
+#else
+		return "Scalar";
+#endif
+	}
+
+	namespace {
+#if defined(LEO_BATCH_TRANSFORMS_AVX2) || defined(LEO_BATCH_TRANSFORMS_SSE)
+		template<int lane>
+		__m128 splat(__m128 v)
+		{
+			return _mm_shuffle_ps(v, v, _MM_SHUFFLE(lane, lane, lane, lane));
+		}
+
+		// a * b + c
+		__m128 multiplyAdd(__m128 a, __m128 b, __m128 c)
+		{
+#if defined(LEO_BATCH_TRANSFORMS_AVX2)
+			return _mm_fmadd_ps(a, b, c);
+#else
+			return _mm_add_ps(_mm_mul_ps(a, b), c);
+#endif
+		}
+
+		void transformSphere(const float* matrix, const float* sphere, float* result)
+		{
+			__m128 column0 = _mm_loadu_ps(matrix);
+			__m128 column1 = _mm_loadu_ps(matrix + 4);
+			__m128 column2 = _mm_loadu_ps(matrix + 8);
+			__m128 column3 = _mm_loadu_ps(matrix + 12);
+			__m128 localSphere = _mm_loadu_ps(sphere);
+			float localRadius = sphere[3];  // Read before result is written, in case they are the same
+
+			__m128 center = multiplyAdd(column0, splat<0>(localSphere),
+				multiplyAdd(column1, splat<1>(localSphere),
+					multiplyAdd(column2, splat<2>(localSphere), column3)));
+
+			// Squared lengths of the three axes. Once transposed, the squared columns add up to the three lengths in one register.
+			__m128 squares0 = _mm_mul_ps(column0, column0);
+			__m128 squares1 = _mm_mul_ps(column1, column1);
+			__m128 squares2 = _mm_mul_ps(column2, column2);
+			__m128 squares3 = _mm_setzero_ps();
+			_MM_TRANSPOSE4_PS(squares0, squares1, squares2, squares3);
+			__m128 squaredLengths = _mm_add_ps(_mm_add_ps(squares0, squares1), squares2);
+
+			// One square root for the largest axis instead of one per axis
+			__m128 maxSquaredLength = _mm_max_ps(squaredLengths, _mm_shuffle_ps(squaredLengths, squaredLengths, _MM_SHUFFLE(3, 0, 2, 1)));
+			maxSquaredLength = _mm_max_ps(maxSquaredLength, _mm_shuffle_ps(squaredLengths, squaredLengths, _MM_SHUFFLE(3, 1, 0, 2)));
+			float radius = _mm_cvtss_f32(_mm_sqrt_ss(maxSquaredLength)) * localRadius;
+
+			_mm_storeu_ps(result, center);
+			result[3] = radius;
+		}
+#endif
+
+#if defined(LEO_BATCH_TRANSFORMS_AVX2)
+		// Two columns of the result per register. Each lane holds a copy of the lhs column.
+		void multiplyAffine(__m256 lhs0, __m256 lhs1, __m256 lhs2, __m256 lhs3, const float* rhs, float* result)
+		{
+			__m256 rhs01 = _mm256_loadu_ps(rhs);
+			__m256 rhs23 = _mm256_loadu_ps(rhs + 8);
+
+			// The w of the columns 0 and 1 is 0, so the translation of lhs is not added to them.
+			__m256 result01 = _mm256_mul_ps(lhs0, _mm256_permute_ps(rhs01, _MM_SHUFFLE(0, 0, 0, 0)));
+			result01 = _mm256_fmadd_ps(lhs1, _mm256_permute_ps(rhs01, _MM_SHUFFLE(1, 1, 1, 1)), result01);
+			result01 = _mm256_fmadd_ps(lhs2, _mm256_permute_ps(rhs01, _MM_SHUFFLE(2, 2, 2, 2)), result01);
+
+			__m256 result23 = _mm256_mul_ps(lhs0, _mm256_permute_ps(rhs23, _MM_SHUFFLE(0, 0, 0, 0)));
+			result23 = _mm256_fmadd_ps(lhs1, _mm256_permute_ps(rhs23, _MM_SHUFFLE(1, 1, 1, 1)), result23);
+			result23 = _mm256_fmadd_ps(lhs2, _mm256_permute_ps(rhs23, _MM_SHUFFLE(2, 2, 2, 2)), result23);
+			result23 = _mm256_fmadd_ps(lhs3, _mm256_permute_ps(rhs23, _MM_SHUFFLE(3, 3, 3, 3)), result23);
+
+			_mm256_storeu_ps(result, result01);
+			_mm256_storeu_ps(result + 8, result23);
+		}
+#elif defined(LEO_BATCH_TRANSFORMS_SSE)
+		void multiplyAffine(__m128 lhs0, __m128 lhs1, __m128 lhs2, __m128 lhs3, const float* rhs, float* result)
+		{
+			__m128 rhs0 = _mm_loadu_ps(rhs);
+			__m128 rhs1 = _mm_loadu_ps(rhs + 4);
+			__m128 rhs2 = _mm_loadu_ps(rhs + 8);
+			__m128 rhs3 = _mm_loadu_ps(rhs + 12);
+
+			// The w of the first three columns is 0, and the w of the last one is 1.
+			__m128 result0 = multiplyAdd(lhs0, splat<0>(rhs0), multiplyAdd(lhs1, splat<1>(rhs0), _mm_mul_ps(lhs2, splat<2>(rhs0))));
+			__m128 result1 = multiplyAdd(lhs0, splat<0>(rhs1), multiplyAdd(lhs1, splat<1>(rhs1), _mm_mul_ps(lhs2, splat<2>(rhs1))));
+			__m128 result2 = multiplyAdd(lhs0, splat<0>(rhs2), multiplyAdd(lhs1, splat<1>(rhs2), _mm_mul_ps(lhs2, splat<2>(rhs2))));
+			__m128 result3 = multiplyAdd(lhs0, splat<0>(rhs3), multiplyAdd(lhs1, splat<1>(rhs3), multiplyAdd(lhs2, splat<2>(rhs3), lhs3)));
+
+			_mm_storeu_ps(result, result0);
+			_mm_storeu_ps(result + 4, result1);
+			_mm_storeu_ps(result + 8, result2);
+			_mm_storeu_ps(result + 12, result3);
+		}
+#else
+		void multiplyAffine(const glm::mat4& lhs, const glm::mat4& rhs, glm::mat4& result)
+		{
+			glm::mat4 product(0.f);  // In case result is lhs or rhs
+			for (int column = 0; column < 3; ++column) {
+				product[column] = lhs[0] * rhs[column].x + lhs[1] * rhs[column].y + lhs[2] * rhs[column].z;
+			}
+			product[3] = lhs[0] * rhs[3].x + lhs[1] * rhs[3].y + lhs[2] * rhs[3].z + lhs[3];
+			result = product;
+		}
+
+		void transformSphere(const glm::mat4& matrix, const glm::vec4& sphere, glm::vec4& result)
+		{
+			glm::vec3 center = glm::vec3(matrix[0]) * sphere.x + glm::vec3(matrix[1]) * sphere.y + glm::vec3(matrix[2]) * sphere.z + glm::vec3(matrix[3]);
+			float maxSquaredLength = glm::max(glm::max(glm::dot(matrix[0], matrix[0]), glm::dot(matrix[1], matrix[1])), glm::dot(matrix[2], matrix[2]));
+			result = glm::vec4(center, glm::sqrt(maxSquaredLength) * sphere.w);
+		}
+#endif
+	}
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "GeometryIncludes.h"
+
+#include <cstddef>
+
+/*
+* Kernels transforming many matrices or bounding spheres in one call. They use AVX2 when the code is built with it
+* (LEO_ENABLE_AVX2 in CMake), SSE otherwise, and plain C++ on platforms without SSE or when LEO_DISABLE_SIMD is defined.
+* All matrices are expected to be affine: their last row is (0, 0, 0, 1).
+*/
+namespace leoscene {
+	// results[i] = lhs * rhs[i]. results can be rhs itself.
+	void multiplyAffineMatrices(const glm::mat4& lhs, const glm::mat4* rhs, glm::mat4* results, size_t count);
+
+	// results[i] = lhs[i] * rhs[i]. results can be lhs or rhs itself.
+	void multiplyAffineMatrices(const glm::mat4* lhs, const glm::mat4* rhs, glm::mat4* results, size_t count);
+
+	// World space bounding spheres (center, radius) of objects given their object space spheres and their matrices.
+	// The radius is scaled by the largest scale of the matrix axes. results can be spheres itself.
+	void transformBoundingSpheres(const glm::mat4* matrices, const glm::vec4* spheres, glm::vec4* results, size_t count);
+
+	// "AVX2", "SSE" or "Scalar"
+	const char* getBatchTransformsInstructionSet();
+}
@@ -0,0 +1,120 @@
+#include "BoundingVolumes.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace leoscene {
+	namespace {
+		// Each refinement pass shrinks the best sphere by this ratio, then grows it again starting from another position.
+		const uint32_t NB_REFINEMENT_PASSES = 8;
+		const float REFINEMENT_SHRINK_RATIO = 0.95f;
+
+		// Directions along which the extreme positions are looked for: the axes, the diagonals of a cube and the diagonals of its faces.
+		// More directions than the three axes of Ritter's sphere make the initial sphere much closer to the minimal one.
+		const int NB_EXTREME_DIRECTIONS = 13;
+		const glm::vec3 EXTREME_DIRECTIONS[NB_EXTREME_DIRECTIONS] = {
+			{ 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 },
+			{ 1, 1, 1 }, { 1, 1, -1 }, { 1, -1, 1 }, { 1, -1, -1 },
+			{ 1, 1, 0 }, { 1, -1, 0 }, { 1, 0, 1 }, { 1, 0, -1 }, { 0, 1, 1 }, { 0, 1, -1 },
+		};
+
+		const glm::vec3& getPosition(const glm::vec3* positions, size_t i, size_t stride);
+
+		// Grows the sphere just enough to contain each position outside of it, starting at position first and wrapping around.
+		void growSphere(glm::vec3& center, float& radius, const glm::vec3* positions, size_t nbPositions, size_t stride, size_t first);
+	}
+
+	glm::vec4 computeBoundingSphere(const glm::vec3* positions, size_t nbPositions, size_t stride)
+	{
+		if (!nbPositions) {
+			return glm::vec4(0);
+		}
+
+		// Initial sphere: the pair of extreme positions along a direction that are the farthest apart
+		size_t minIndices[NB_EXTREME_DIRECTIONS] = {};
+		size_t maxIndices[NB_EXTREME_DIRECTIONS] = {};
+		float minProjections[NB_EXTREME_DIRECTIONS];
+		float maxProjections[NB_EXTREME_DIRECTIONS];
+		for (int k = 0; k < NB_EXTREME_DIRECTIONS; ++k) {
+			minProjections[k] = maxProjections[k] = glm::dot(getPosition(positions, 0, stride), EXTREME_DIRECTIONS[k]);
+		}
+		for (size_t i = 1; i < nbPositions; ++i) {
+			const glm::vec3& position = getPosition(positions, i, stride);
+			for (int k = 0; k < NB_EXTREME_DIRECTIONS; ++k) {
+				float projection = glm::dot(position, EXTREME_DIRECTIONS[k]);
+				if (projection < minProjections[k]) { minProjections[k] = projection; minIndices[k] = i; }
+				if (projection > maxProjections[k]) { maxProjections[k] = projection; maxIndices[k] = i; }
+			}
+		}
+		int axis = 0;
+		float largestSquaredDistance = -1.f;
+		for (int k = 0; k < NB_EXTREME_DIRECTIONS; ++k) {
+			glm::vec3 span = getPosition(positions, maxIndices[k], stride) - getPosition(positions, minIndices[k], stride);
+			float squaredDistance = glm::dot(span, span);
+			if (squaredDistance > largestSquaredDistance) {
+				largestSquaredDistance = squaredDistance;
+				axis = k;
+			}
+		}
+		const glm::vec3& a = getPosition(positions, minIndices[axis], stride);
+		const glm::vec3& b = getPosition(positions, maxIndices[axis], stride);
+		glm::vec3 center = (a + b) * 0.5f;
+		float radius = glm::length(b - a) * 0.5f;
+		growSphere(center, radius, positions, nbPositions, stride, 0);
+
+		glm::vec4 best(center, radius);
+		for (uint32_t pass = 0; pass < NB_REFINEMENT_PASSES; ++pass) {
+			center = glm::vec3(best);
+			radius = best.w * REFINEMENT_SHRINK_RATIO;
+			growSphere(center, radius, positions, nbPositions, stride, (pass + 1) * nbPositions / (NB_REFINEMENT_PASSES + 1));
+			if (radius < best.w) {
+				best = glm::vec4(center, radius);
+			}
+		}
+
+		// Growing keeps the previous positions inside up to rounding errors, so the radius is measured again from the final center
+		float maxSquaredDistance = 0;
+		for (size_t i = 0; i < nbPositions; ++i) {
+			glm::vec3 offset = getPosition(positions, i, stride) - glm::vec3(best);
+			maxSquaredDistance = std::max(maxSquaredDistance, glm::dot(offset, offset));
+		}
+		best.w = std::sqrt(maxSquaredDistance);
+		return best;
+	}
+
+	void computeBoundingBox(const glm::vec3* positions, size_t nbPositions, glm::vec3& boxMin, glm::vec3& boxMax, size_t stride)
+	{
+		if (!nbPositions) {
+			boxMin = boxMax = glm::vec3(0);
+			return;
+		}
+		boxMin = boxMax = getPosition(positions, 0, stride);
+		for (size_t i = 1; i < nbPositions; ++i) {
+			boxMin = glm::min(boxMin, getPosition(positions, i, stride));
+			boxMax = glm::max(boxMax, getPosition(positions, i, stride));
+		}
+	}
+
+	namespace {
+		const glm::vec3& getPosition(const glm::vec3* positions, size_t i, size_t stride)
+		{
+			return *reinterpret_cast<const glm::vec3*>(reinterpret_cast<const unsigned char*>(positions) + i * stride);
+		}
+
+		void growSphere(glm::vec3& center, float& radius, const glm::vec3* positions, size_t nbPositions, size_t stride, size_t first)
+		{
+			for (size_t n = 0; n < nbPositions; ++n) {
+				const glm::vec3& position = getPosition(positions, (first + n) % nbPositions, stride);
+				glm::vec3 offset = position - center;
+				float squaredDistance = glm::dot(offset, offset);
+				if (squaredDistance > radius * radius) {
+					// New sphere touching the position and the opposite side of the previous sphere
+					float distance = std::sqrt(squaredDistance);
+					float newRadius = (radius + distance) * 0.5f;
+					center += offset * ((newRadius - radius) / distance);
+					radius = newRadius;
+				}
+			}
+		}
+	}
+}
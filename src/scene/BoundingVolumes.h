@@ -0,0 +1,19 @@
+#pragma once
+
+#include "GeometryIncludes.h"
+
+#include <cstddef>
+
+/*
+* Bounding volumes of point sets, used by the culling of the renderer.
+* Positions are read every stride bytes, so that they can be read in place from an array of vertices.
+*/
+namespace leoscene {
+	// Sphere (center, radius) containing all the positions. Ritter's sphere (Graphics Gems, 1990) started from the extreme positions along
+	// 13 directions instead of 3, then shrunk and grown again a few times from different starting points to keep the smallest one.
+	// Usually within a few percents of the minimal sphere.
+	glm::vec4 computeBoundingSphere(const glm::vec3* positions, size_t nbPositions, size_t stride = sizeof(glm::vec3));
+
+	// Axis aligned bounding box of the positions. Both corners are 0 when there is no position.
+	void computeBoundingBox(const glm::vec3* positions, size_t nbPositions, glm::vec3& boxMin, glm::vec3& boxMax, size_t stride = sizeof(glm::vec3));
+}
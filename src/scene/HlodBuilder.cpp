@@ -0,0 +1,583 @@
+#include "HlodBuilder.h"
+
+#include "BatchTransforms.h"
+#include "BoundingVolumes.h"
+#include "ImageTexture.h"
+#include "Mesh.h"
+#include "PerformanceMaterial.h"
+#include "Scene.h"
+#include "TextureCompression.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <exception>
+#include <future>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace leoscene {
+	namespace {
+		// Cells along each axis of the grids are counted on 21 bits, so that a cell is a 64 bits key.
+		const uint32_t MAX_CELLS_PER_AXIS = 1 << 21;
+
+		// Merged and simplified geometry of a cluster, before it is given its texture coordinates in the atlas
+		struct ProxyGeometry {
+			glm::vec3 center = glm::vec3(0);  // World space. The positions are relative to it.
+			std::vector<glm::vec3> positions;  // Three per triangle
+			std::vector<glm::vec3> colors;  // Of each position, in [0, 255]
+			float error = 0;
+			size_t nbMemberTriangles = 0;
+		};
+
+		// Size of the cells giving about targetNbObjects objects per non-empty cell
+		float pickCellSize(const std::vector<glm::vec3>& centers, uint32_t targetNbObjects);
+
+		// Cell of each center, as a key sorting the cells along z, then y, then x
+		void computeCellKeys(const std::vector<glm::vec3>& centers, float cellSize, std::vector<uint64_t>& keys);
+
+		// Average color of the diffuse texture of a material, in [0, 255]. White for materials that are not performance materials.
+		glm::vec3 computeAverageColor(const Material* material);
+
+		// Merges the members with the coarsest level of detail of their meshes, then simplifies the result down to maxNbTriangles.
+		void buildProxyGeometry(
+			const Scene& scene,
+			const uint32_t* members,
+			size_t nbMembers,
+			const glm::vec4& boundingSphere,
+			const std::vector<glm::vec3>& materialColors,
+			uint32_t maxNbTriangles,
+			ProxyGeometry& proxy);
+
+		// Vertex clustering: the vertices in each cell of a grid of resolution^3 cells over the bounding box are merged into their average.
+		// Triangles that become degenerate or duplicated are removed. Returns the number of triangles left, and fills the result if asked.
+		size_t clusterVertices(
+			const std::vector<glm::vec3>& positions,
+			const std::vector<glm::vec3>& colors,
+			const std::vector<uint32_t>& indices,
+			uint32_t resolution,
+			ProxyGeometry* result);
+
+		float getLargestScale(const glm::mat4& matrix);
+
+		uint32_t getNextPowerOfTwo(uint32_t value);
+	}
+
+	HlodStatistics buildHlods(Scene& scene, const HlodOptions& options)
+	{
+		HlodStatistics statistics;
+		size_t nbObjects = scene.getNbObjects();
+
+		/*
+		* Objects that can join a cluster: meshes that are not a member or a proxy of a previous call
+		*/
+
+		std::vector<uint8_t> isAvailable(nbObjects, 1);
+		for (const HlodCluster& cluster : scene.hlodClusters) {
+			isAvailable[cluster.proxyObject] = 0;
+			for (uint32_t i = 0; i < cluster.nbMembers; ++i) {
+				isAvailable[scene.hlodMembers[cluster.firstMember + i]] = 0;
+			}
+		}
+		std::vector<uint32_t> objects;
+		std::vector<glm::vec4> spheres;
+		for (uint32_t i = 0; i < nbObjects; ++i) {
+			const Shape* shape = scene.shapes[scene.shapeIndices[i]].get();
+			if (isAvailable[i] && shape && shape->getType() == Shape::Type::MESH) {
+				objects.push_back(i);
+				spheres.push_back(static_cast<const Mesh*>(shape)->boundingSphere);
+			}
+		}
+		if (objects.size() < std::max<size_t>(options.minNbObjects, 1)) {
+			return statistics;
+		}
+
+		// World space bounding spheres. The matrices of the objects are gathered to transform the spheres in a single batch.
+		{
+			std::vector<glm::mat4> matrices(objects.size());
+			for (size_t i = 0; i < objects.size(); ++i) {
+				matrices[i] = scene.worldMatrices[objects[i]];
+			}
+			transformBoundingSpheres(matrices.data(), spheres.data(), spheres.data(), spheres.size());
+		}
+
+		/*
+		* Grouping the objects by cell. Sorting them by cell makes each group a range of objects, in a deterministic order.
+		*/
+
+		std::vector<glm::vec3> centers(objects.size());
+		for (size_t i = 0; i < objects.size(); ++i) {
+			centers[i] = glm::vec3(spheres[i]);
+		}
+		float cellSize = options.cellSize > 0 ? options.cellSize : pickCellSize(centers, std::max(options.targetNbObjects, 1u));
+		std::vector<uint64_t> keys;
+		computeCellKeys(centers, cellSize, keys);
+		std::vector<uint32_t> order(objects.size());
+		for (uint32_t i = 0; i < order.size(); ++i) {
+			order[i] = i;
+		}
+		std::stable_sort(order.begin(), order.end(), [&keys](uint32_t a, uint32_t b) { return keys[a] < keys[b]; });
+
+		struct Group {
+			uint32_t firstMember = 0;  // In members
+			uint32_t nbMembers = 0;
+			glm::vec4 boundingSphere = glm::vec4(0);
+		};
+		std::vector<Group> groups;
+		std::vector<uint32_t> members;
+		for (size_t first = 0; first < order.size();) {
+			size_t last = first + 1;
+			while (last < order.size() && keys[order[last]] == keys[order[first]]) {
+				++last;
+			}
+			if (last - first >= std::max(options.minNbObjects, 1u)) {
+				Group group;
+				group.firstMember = static_cast<uint32_t>(members.size());
+				group.nbMembers = static_cast<uint32_t>(last - first);
+
+				// Sphere centered on the box of the spheres of the members, large enough to contain them
+				glm::vec3 boxMin = glm::vec3(spheres[order[first]]) - spheres[order[first]].w;
+				glm::vec3 boxMax = glm::vec3(spheres[order[first]]) + spheres[order[first]].w;
+				for (size_t i = first; i < last; ++i) {
+					const glm::vec4& sphere = spheres[order[i]];
+					boxMin = glm::min(boxMin, glm::vec3(sphere) - sphere.w);
+					boxMax = glm::max(boxMax, glm::vec3(sphere) + sphere.w);
+					members.push_back(objects[order[i]]);
+				}
+				glm::vec3 center = (boxMin + boxMax) * 0.5f;
+				float radius = 0;
+				for (size_t i = first; i < last; ++i) {
+					const glm::vec4& sphere = spheres[order[i]];
+					radius = std::max(radius, glm::length(glm::vec3(sphere) - center) + sphere.w);
+				}
+				group.boundingSphere = glm::vec4(center, radius);
+				groups.push_back(group);
+			}
+			first = last;
+		}
+		if (groups.empty()) {
+			return statistics;
+		}
+
+		/*
+		* Proxy geometry of each group, built in parallel. The calling thread and the helper threads take the next group until there is none left.
+		*/
+
+		std::vector<glm::vec3> materialColors(scene.materials.size(), glm::vec3(255));
+		{
+			std::vector<uint8_t> isUsed(scene.materials.size(), 0);
+			for (uint32_t member : members) {
+				isUsed[scene.materialIndices[member]] = 1;
+			}
+			for (size_t i = 0; i < scene.materials.size(); ++i) {
+				if (isUsed[i]) {
+					materialColors[i] = computeAverageColor(scene.materials[i].get());
+				}
+			}
+		}
+
+		std::vector<ProxyGeometry> proxies(groups.size());
+		{
+			std::atomic<size_t> nextGroup(0);
+			auto buildProxies = [&]() {
+				for (size_t i = nextGroup++; i < groups.size(); i = nextGroup++) {
+					buildProxyGeometry(scene, members.data() + groups[i].firstMember, groups[i].nbMembers, groups[i].boundingSphere,
+						materialColors, std::max(options.maxNbTriangles, 1u), proxies[i]);
+				}
+			};
+			std::unique_ptr<ThreadPool> ownThreadPool;
+			ThreadPool* threadPool = options.threadPool;
+			if (!threadPool) {
+				size_t nbThreads = options.nbThreads ? options.nbThreads : ThreadPool::getDefaultNbThreads();
+				ownThreadPool = std::make_unique<ThreadPool>(std::min(nbThreads, groups.size()) - 1);
+				threadPool = ownThreadPool.get();
+			}
+			std::vector<std::future<void>> helpers;
+			for (size_t i = 0; i < std::min(threadPool->getNbThreads(), groups.size() - 1); ++i) {
+				helpers.push_back(threadPool->submitHelper(buildProxies));
+			}
+
+			// The helpers use the local variables of this function: they are waited for even if a group fails on this thread.
+			std::exception_ptr error;
+			try {
+				buildProxies();
+			}
+			catch (...) {
+				error = std::current_exception();
+				nextGroup = groups.size();
+			}
+			for (std::future<void>& helper : helpers) {
+				threadPool->wait(helper);
+			}
+			if (error) {
+				std::rethrow_exception(error);
+			}
+			for (std::future<void>& helper : helpers) {
+				helper.get();
+			}
+		}
+
+		/*
+		* Atlas. Each triangle of the proxies gets a square of texels filled with the colors of its vertices, interpolated.
+		* The corners of the triangle are on the centers of three corner texels of the square, so that the bilinear filtering
+		* of the texels of a triangle stays inside its square.
+		*/
+
+		size_t nbTriangles = 0;
+		for (const ProxyGeometry& proxy : proxies) {
+			nbTriangles += proxy.positions.size() / 3;
+		}
+		// The squares are lowered until their rows fit in the largest atlas. Rows that still do not fit with one texel per
+		// triangle wrap around.
+		uint32_t maxAtlasSize = std::max(options.maxAtlasSize, 1u);
+		uint32_t texelsPerTriangle = std::min(std::max(options.atlasTexelsPerTriangle, 1u), maxAtlasSize);
+		uint32_t atlasWidth = 0;
+		uint32_t squaresPerRow = 0;
+		uint64_t nbRows = 0;
+		while (true) {
+			uint64_t squaresSide = static_cast<uint64_t>(std::ceil(std::sqrt(double(nbTriangles))));
+			atlasWidth = getNextPowerOfTwo(static_cast<uint32_t>(std::min<uint64_t>(squaresSide * texelsPerTriangle, maxAtlasSize)));
+			atlasWidth = std::max(std::min(atlasWidth, maxAtlasSize), texelsPerTriangle);
+			squaresPerRow = atlasWidth / texelsPerTriangle;
+			nbRows = (nbTriangles + squaresPerRow - 1) / squaresPerRow;
+			if (texelsPerTriangle == 1 || nbRows * texelsPerTriangle <= maxAtlasSize) {
+				break;
+			}
+			--texelsPerTriangle;
+		}
+		uint32_t atlasHeight = std::max(getNextPowerOfTwo(static_cast<uint32_t>(std::min<uint64_t>(nbRows * texelsPerTriangle, maxAtlasSize))), 1u);
+		atlasHeight = std::min(atlasHeight, maxAtlasSize);
+		size_t nbSquares = size_t(squaresPerRow) * (atlasHeight / texelsPerTriangle);
+
+		unsigned char* atlasData = new unsigned char[size_t(atlasWidth) * atlasHeight * 4]();
+		std::shared_ptr<ImageTexture> atlas = std::make_shared<ImageTexture>(atlasWidth, atlasHeight, ImageTexture::Type::FLOAT, ImageTexture::Layout::RGBA, atlasData);
+		std::shared_ptr<PerformanceMaterial> material = std::make_shared<PerformanceMaterial>();
+		material->diffuseTexture = atlas;
+		uint32_t materialIndex = static_cast<uint32_t>(scene.materials.size());
+		scene.materials.push_back(material);
+
+		/*
+		* Proxies, added to the scene as objects of their own
+		*/
+
+		size_t triangle = 0;
+		for (size_t i = 0; i < groups.size(); ++i) {
+			const ProxyGeometry& proxy = proxies[i];
+			std::shared_ptr<Mesh> mesh = std::make_shared<Mesh>();
+			mesh->vertices.resize(proxy.positions.size());
+			mesh->indices.resize(proxy.positions.size());
+			for (size_t v = 0; v < proxy.positions.size(); v += 3, ++triangle) {
+				size_t square = triangle % nbSquares;
+				uint32_t squareX = static_cast<uint32_t>(square % squaresPerRow) * texelsPerTriangle;
+				uint32_t squareY = static_cast<uint32_t>(square / squaresPerRow) * texelsPerTriangle;
+				const glm::vec3* colors = &proxy.colors[v];
+				for (uint32_t y = 0; y < texelsPerTriangle; ++y) {
+					for (uint32_t x = 0; x < texelsPerTriangle; ++x) {
+						// Barycentric coordinates of the texel center. Texels past the hypotenuse take the color of the nearest point of the hypotenuse.
+						float s = texelsPerTriangle > 1 ? float(x) / (texelsPerTriangle - 1) : 1.f / 3;
+						float t = texelsPerTriangle > 1 ? float(y) / (texelsPerTriangle - 1) : 1.f / 3;
+						if (s + t > 1) {
+							s /= s + t;
+							t = 1 - s;
+						}
+						glm::vec3 color = colors[0] * (1 - s - t) + colors[1] * s + colors[2] * t;
+						unsigned char* texel = atlasData + (size_t(squareY + y) * atlasWidth + squareX + x) * 4;
+						for (int c = 0; c < 3; ++c) {
+							texel[c] = static_cast<unsigned char>(glm::clamp(color[c] + 0.5f, 0.f, 255.f));
+						}
+						texel[3] = 255;
+					}
+				}
+
+				// Rows of the texture are stored from v = 1 to v = 0 (see ImageTexture::getTexel)
+				glm::vec2 corners[3] = {
+					glm::vec2(squareX + 0.5f, squareY + 0.5f),
+					glm::vec2(squareX + texelsPerTriangle - 0.5f, squareY + 0.5f),
+					glm::vec2(squareX + 0.5f, squareY + texelsPerTriangle - 0.5f)
+				};
+				glm::vec3 normal = glm::cross(proxy.positions[v + 1] - proxy.positions[v], proxy.positions[v + 2] - proxy.positions[v]);
+				float normalLength = glm::length(normal);
+				for (size_t k = 0; k < 3; ++k) {
+					Vertex& vertex = mesh->vertices[v + k];
+					vertex.position = proxy.positions[v + k];
+					vertex.normal = normalLength > 0 ? normal / normalLength : glm::vec3(0, 0, 1);
+					vertex.uv = glm::vec2(corners[k].x / atlasWidth, 1.f - corners[k].y / atlasHeight);
+					mesh->indices[v + k] = static_cast<uint32_t>(v + k);
+				}
+			}
+			if (mesh->vertices.size()) {
+				mesh->boundingSphere = computeBoundingSphere(&mesh->vertices[0].position, mesh->vertices.size(), sizeof(Vertex));
+				computeBoundingBox(&mesh->vertices[0].position, mesh->vertices.size(), mesh->boundingBoxMin, mesh->boundingBoxMax, sizeof(Vertex));
+			}
+			mesh->indexType = selectIndexType(mesh->vertices.size());
+
+			HlodCluster cluster;
+			cluster.boundingSphere = groups[i].boundingSphere;
+			cluster.error = proxy.error;
+			cluster.proxyObject = static_cast<uint32_t>(scene.getNbObjects());
+			cluster.firstMember = static_cast<uint32_t>(scene.hlodMembers.size());
+			cluster.nbMembers = groups[i].nbMembers;
+			scene.hlodMembers.insert(scene.hlodMembers.end(), members.begin() + groups[i].firstMember, members.begin() + groups[i].firstMember + groups[i].nbMembers);
+			scene.hlodClusters.push_back(cluster);
+
+			scene.worldMatrices.push_back(glm::translate(glm::mat4(1), proxy.center));
+			scene.shapeIndices.push_back(static_cast<uint32_t>(scene.shapes.size()));
+			scene.materialIndices.push_back(materialIndex);
+			scene.shapes.push_back(mesh);
+
+			statistics.nbMemberTriangles += proxy.nbMemberTriangles;
+			statistics.nbProxyTriangles += mesh->indices.size() / 3;
+		}
+
+		// The atlas is uploaded with its mip levels, like the textures of the models
+		std::shared_ptr<ImageTexture> mipmappedAtlas = generateMipLevels(*atlas, true);
+		if (mipmappedAtlas) {
+			material->diffuseTexture = mipmappedAtlas;
+		}
+
+		statistics.nbClusters = static_cast<uint32_t>(groups.size());
+		statistics.nbMembers = static_cast<uint32_t>(members.size());
+		statistics.atlasWidth = atlasWidth;
+		statistics.atlasHeight = atlasHeight;
+		statistics.atlasTexelsPerTriangle = texelsPerTriangle;
+		return statistics;
+	}
+
+	bool isHlodProxyVisible(const glm::vec4& boundingSphere, float error, const glm::vec3& eye, float projectionScale, float errorThreshold)
+	{
+		// The error is seen from the nearest point of the sphere. Inside the sphere, the members are always drawn.
+		float distance = glm::length(glm::vec3(boundingSphere) - eye) - boundingSphere.w;
+		return errorThreshold > 0 && distance > 0 && error * projectionScale * 0.5f <= errorThreshold * distance;
+	}
+
+	namespace {
+		float pickCellSize(const std::vector<glm::vec3>& centers, uint32_t targetNbObjects)
+		{
+			glm::vec3 boundsMin = centers[0];
+			glm::vec3 boundsMax = centers[0];
+			for (const glm::vec3& center : centers) {
+				boundsMin = glm::min(boundsMin, center);
+				boundsMax = glm::max(boundsMax, center);
+			}
+			glm::vec3 size = boundsMax - boundsMin;
+			float cellSize = std::max(std::max(size.x, std::max(size.y, size.z)), 1e-6f) * 1.001f;
+
+			// Halved until the non-empty cells hold about the target number of objects on average
+			std::vector<uint64_t> keys;
+			for (int i = 0; i < 20; ++i) {
+				computeCellKeys(centers, cellSize, keys);
+				std::sort(keys.begin(), keys.end());
+				size_t nbCells = std::unique(keys.begin(), keys.end()) - keys.begin();
+				if (centers.size() <= nbCells * targetNbObjects) {
+					break;
+				}
+				cellSize *= 0.5f;
+			}
+			return cellSize;
+		}
+
+		void computeCellKeys(const std::vector<glm::vec3>& centers, float cellSize, std::vector<uint64_t>& keys)
+		{
+			glm::vec3 boundsMin = centers[0];
+			for (const glm::vec3& center : centers) {
+				boundsMin = glm::min(boundsMin, center);
+			}
+			keys.resize(centers.size());
+			for (size_t i = 0; i < centers.size(); ++i) {
+				glm::vec3 cell = glm::floor((centers[i] - boundsMin) / cellSize);
+				uint64_t x = static_cast<uint64_t>(glm::clamp(cell.x, 0.f, float(MAX_CELLS_PER_AXIS - 1)));
+				uint64_t y = static_cast<uint64_t>(glm::clamp(cell.y, 0.f, float(MAX_CELLS_PER_AXIS - 1)));
+				uint64_t z = static_cast<uint64_t>(glm::clamp(cell.z, 0.f, float(MAX_CELLS_PER_AXIS - 1)));
+				keys[i] = (z << 42) | (y << 21) | x;
+			}
+		}
+
+		glm::vec3 computeAverageColor(const Material* material)
+		{
+			if (!material || material->getType() != Material::Type::PERFORMANCE) {
+				return glm::vec3(255);
+			}
+			const ImageTexture* texture = static_cast<const PerformanceMaterial*>(material)->diffuseTexture.get();
+			if (!texture || !texture->data || !texture->nbChannels) {
+				return glm::vec3(255);
+			}
+			if (texture->compression != ImageTexture::Compression::NONE) {  // The last mip level is the average color
+				unsigned char blockTexels[16 * 4];
+				decompressBlock(texture->compression, texture->data + texture->mipLevels.back().offset, blockTexels);
+				return texture->nbChannels >= 3 ? glm::vec3(blockTexels[0], blockTexels[1], blockTexels[2]) : glm::vec3(blockTexels[0]);
+			}
+			size_t nbTexels = texture->width * texture->height;
+			if (!nbTexels) {
+				return glm::vec3(255);
+			}
+			// Gray levels for the single channel layouts. The alpha channel is ignored, like in the fragment shader.
+			glm::dvec3 sum(0);
+			for (size_t i = 0; i < nbTexels; ++i) {
+				const unsigned char* texel = texture->data + i * texture->nbChannels;
+				sum += texture->nbChannels >= 3 ? glm::dvec3(texel[0], texel[1], texel[2]) : glm::dvec3(texel[0]);
+			}
+			return glm::vec3(sum / double(nbTexels));
+		}
+
+		void buildProxyGeometry(
+			const Scene& scene,
+			const uint32_t* members,
+			size_t nbMembers,
+			const glm::vec4& boundingSphere,
+			const std::vector<glm::vec3>& materialColors,
+			uint32_t maxNbTriangles,
+			ProxyGeometry& proxy)
+		{
+			proxy.center = glm::vec3(boundingSphere);
+
+			/*
+			* Merge. Each member adds the vertices used by the coarsest level of detail of its mesh, transformed relative to the center.
+			*/
+
+			std::vector<glm::vec3> positions;
+			std::vector<glm::vec3> colors;
+			std::vector<uint32_t> indices;
+			std::vector<uint32_t> remap;
+			float sourceError = 0;
+			for (size_t m = 0; m < nbMembers; ++m) {
+				uint32_t object = members[m];
+				const Mesh* mesh = static_cast<const Mesh*>(scene.shapes[scene.shapeIndices[object]].get());
+				const glm::mat4& matrix = scene.worldMatrices[object];
+				const glm::vec3& color = materialColors[scene.materialIndices[object]];
+				MeshLod lod = mesh->lods.size() ? mesh->lods.back() : MeshLod{ 0, static_cast<uint32_t>(mesh->indices.size()), 0.f };
+				sourceError = std::max(sourceError, lod.error * mesh->boundingSphere.w * getLargestScale(matrix));
+
+				remap.assign(mesh->vertices.size(), UINT32_MAX);
+				for (uint32_t i = lod.firstIndex; i < lod.firstIndex + lod.nbIndices - lod.nbIndices % 3; ++i) {
+					uint32_t index = mesh->indices[i];
+					if (remap[index] == UINT32_MAX) {
+						remap[index] = static_cast<uint32_t>(positions.size());
+						positions.push_back(glm::vec3(matrix * glm::vec4(mesh->vertices[index].position, 1.f)) - proxy.center);
+						colors.push_back(color);
+					}
+					indices.push_back(remap[index]);
+				}
+			}
+			proxy.nbMemberTriangles = indices.size() / 3;
+
+			/*
+			* Simplification. The resolution of the grid is lowered until the proxy has few enough triangles, guessing the next resolution
+			* from the number of triangles left, which is roughly proportional to the square of the resolution for surfaces.
+			* The first resolution is the one of a surface filling the grid with maxNbTriangles triangles, to save the passes on the finest grids.
+			*/
+
+			uint32_t resolution = std::min(1024u, static_cast<uint32_t>(std::ceil(4 * std::sqrt(double(maxNbTriangles)))));
+			size_t nbTriangles = clusterVertices(positions, colors, indices, resolution, nullptr);
+			while (nbTriangles > maxNbTriangles && resolution > 1) {
+				uint32_t guess = static_cast<uint32_t>(resolution * std::sqrt(double(maxNbTriangles) / nbTriangles) * 0.95);
+				resolution = std::max(1u, std::min(guess, resolution - 1));
+				nbTriangles = clusterVertices(positions, colors, indices, resolution, nullptr);
+			}
+			clusterVertices(positions, colors, indices, resolution, &proxy);
+			proxy.error += sourceError;
+		}
+
+		size_t clusterVertices(
+			const std::vector<glm::vec3>& positions,
+			const std::vector<glm::vec3>& colors,
+			const std::vector<uint32_t>& indices,
+			uint32_t resolution,
+			ProxyGeometry* result)
+		{
+			if (positions.empty()) {
+				return 0;
+			}
+
+			glm::vec3 boundsMin = positions[0];
+			glm::vec3 boundsMax = positions[0];
+			for (const glm::vec3& position : positions) {
+				boundsMin = glm::min(boundsMin, position);
+				boundsMax = glm::max(boundsMax, position);
+			}
+			glm::vec3 size = boundsMax - boundsMin;
+			float extent = std::max(size.x, std::max(size.y, size.z));
+			float cellsPerUnit = extent > 0 ? resolution / extent : 0.f;
+
+			// Cell of each vertex
+			std::vector<uint32_t> vertexCells(positions.size());
+			std::unordered_map<uint64_t, uint32_t> cells;
+			cells.reserve(positions.size());
+			for (size_t i = 0; i < positions.size(); ++i) {
+				glm::vec3 cell = glm::min(glm::floor((positions[i] - boundsMin) * cellsPerUnit), glm::vec3(float(resolution - 1)));
+				uint64_t key = (uint64_t(cell.z) * resolution + uint64_t(cell.y)) * resolution + uint64_t(cell.x);
+				vertexCells[i] = cells.emplace(key, static_cast<uint32_t>(cells.size())).first->second;
+			}
+
+			// Triangles left, without the degenerate ones and the ones covering the same cells as a previous one (both sides are drawn)
+			struct TriangleHash {
+				size_t operator()(const std::array<uint32_t, 3>& triangle) const {
+					return (size_t(triangle[0]) * 73856093) ^ (size_t(triangle[1]) * 19349663) ^ (size_t(triangle[2]) * 83492791);
+				}
+			};
+			std::unordered_set<std::array<uint32_t, 3>, TriangleHash> triangleSet;
+			std::vector<std::array<uint32_t, 3>> triangles;
+			for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+				std::array<uint32_t, 3> triangle = { vertexCells[indices[i]], vertexCells[indices[i + 1]], vertexCells[indices[i + 2]] };
+				if (triangle[0] == triangle[1] || triangle[1] == triangle[2] || triangle[0] == triangle[2]) {
+					continue;
+				}
+				std::array<uint32_t, 3> sortedTriangle = triangle;
+				std::sort(sortedTriangle.begin(), sortedTriangle.end());
+				if (triangleSet.insert(sortedTriangle).second) {
+					triangles.push_back(triangle);
+				}
+			}
+			if (!result) {
+				return triangles.size();
+			}
+
+			// Each cell is the average of its vertices. The error is the largest distance between a vertex and the average of its cell.
+			std::vector<glm::vec3> cellPositions(cells.size(), glm::vec3(0));
+			std::vector<glm::vec3> cellColors(cells.size(), glm::vec3(0));
+			std::vector<uint32_t> cellSizes(cells.size(), 0);
+			for (size_t i = 0; i < positions.size(); ++i) {
+				cellPositions[vertexCells[i]] += positions[i];
+				cellColors[vertexCells[i]] += colors[i];
+				cellSizes[vertexCells[i]]++;
+			}
+			for (size_t c = 0; c < cells.size(); ++c) {
+				cellPositions[c] /= float(cellSizes[c]);
+				cellColors[c] /= float(cellSizes[c]);
+			}
+			result->error = 0;
+			for (size_t i = 0; i < positions.size(); ++i) {
+				result->error = std::max(result->error, glm::length(positions[i] - cellPositions[vertexCells[i]]));
+			}
+
+			result->positions.clear();
+			result->colors.clear();
+			result->positions.reserve(triangles.size() * 3);
+			result->colors.reserve(triangles.size() * 3);
+			for (const std::array<uint32_t, 3>& triangle : triangles) {
+				for (uint32_t cell : triangle) {
+					result->positions.push_back(cellPositions[cell]);
+					result->colors.push_back(cellColors[cell]);
+				}
+			}
+			return triangles.size();
+		}
+
+		float getLargestScale(const glm::mat4& matrix)
+		{
+			return std::sqrt(std::max(glm::dot(glm::vec3(matrix[0]), glm::vec3(matrix[0])),
+				std::max(glm::dot(glm::vec3(matrix[1]), glm::vec3(matrix[1])), glm::dot(glm::vec3(matrix[2]), glm::vec3(matrix[2])))));
+		}
+
+		uint32_t getNextPowerOfTwo(uint32_t value)
+		{
+			uint32_t power = 1;
+			while (power < value) {
+				power <<= 1;
+			}
+			return power;
+		}
+	}
+}
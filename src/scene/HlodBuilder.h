@@ -0,0 +1,65 @@
+#pragma once
+
+#include "GeometryIncludes.h"
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+* Hierarchical levels of detail (HLOD). The objects of a scene are grouped by the cell of a regular grid containing their center.
+* The geometry of each group is merged into a single proxy mesh, simplified by vertex clustering (Rossignac, Borrel 1993) so that
+* the merged objects can be simplified across each other, and colored with a texture atlas baked from their materials.
+* The proxies are added to the scene as objects of their own. The culling shader draws either the proxy or the members of a cluster,
+* depending on the error of the proxy on screen.
+*/
+namespace leoscene {
+	class Scene;
+	class ThreadPool;
+
+	struct HlodOptions {
+		// Side of the cubic cells grouping the objects, in world units. 0 picks the size giving about targetNbObjects objects per cluster.
+		float cellSize = 0;
+		uint32_t targetNbObjects = 2048;
+
+		// Groups with fewer objects keep their objects only: a proxy would not save much.
+		uint32_t minNbObjects = 64;
+
+		// Largest number of triangles of a proxy. The proxies are simplified until they fit, and the error grows accordingly.
+		uint32_t maxNbTriangles = 8192;
+
+		// Side of the square of the atlas in which the color of each triangle of a proxy is baked, in texels.
+		// Lowered when the atlas of all the proxies would not fit in a texture of maxAtlasSize x maxAtlasSize.
+		uint32_t atlasTexelsPerTriangle = 4;
+
+		// Largest side of the atlas, a power of two. Every Vulkan device supports 2D images of 4096x4096. With more triangles
+		// than texels, the triangles past the last texel wrap around to the first ones and share their colors.
+		uint32_t maxAtlasSize = 4096;
+
+		// Threads building the proxies. 0 uses one thread per hardware thread.
+		uint32_t nbThreads = 0;
+
+		// Pool building the proxies with helper tasks instead of a pool of nbThreads threads created for the call (see ThreadPool).
+		ThreadPool* threadPool = nullptr;
+	};
+
+	// Statistics of a call to buildHlods
+	struct HlodStatistics {
+		uint32_t nbClusters = 0;
+		uint32_t nbMembers = 0;  // Objects that are a member of a cluster
+		size_t nbMemberTriangles = 0;  // Triangles of the members, with the levels of detail used as input
+		size_t nbProxyTriangles = 0;
+		uint32_t atlasWidth = 0;
+		uint32_t atlasHeight = 0;
+		uint32_t atlasTexelsPerTriangle = 0;  // After lowering to fit the atlas
+	};
+
+	// Builds the clusters of the objects of the scene that are not a member of a cluster yet, and appends their proxies to the scene.
+	// All the proxies of a call share a single material, so they add one texture to the scene.
+	// The members are merged with the coarsest level of detail of their meshes.
+	HlodStatistics buildHlods(Scene& scene, const HlodOptions& options = {});
+
+	// Same test as the culling shader: true when the proxy of the cluster is drawn instead of its members, seen from eye.
+	// errorThreshold is the largest error allowed on screen, as a fraction of the screen height. projectionScale is the
+	// element [1][1] of the projection matrix.
+	bool isHlodProxyVisible(const glm::vec4& boundingSphere, float error, const glm::vec3& eye, float projectionScale, float errorThreshold);
+}
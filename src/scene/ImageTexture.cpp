@@ -1,10 +1,14 @@
 #include "ImageTexture.h"
 
+#include "TextureCompression.h"
+
+#include <algorithm>
+
 namespace leoscene {
 
-	const std::shared_ptr<const ImageTexture> ImageTexture::white = std::make_shared<const ImageTexture>(1, 1, Type::FLOAT, Layout::RGBA, new unsigned char[3]{255, 255, 255});
-	const std::shared_ptr<const ImageTexture> ImageTexture::black = std::make_shared<const ImageTexture>(1, 1, Type::FLOAT, Layout::RGBA, new unsigned char[3]{ 0, 0, 0 });
-	const std::shared_ptr<const ImageTexture> ImageTexture::blue = std::make_shared<const ImageTexture>(1, 1, Type::FLOAT, Layout::RGBA, new unsigned char[3]{ 0, 0, 255 });
+	const std::shared_ptr<const ImageTexture> ImageTexture::white = std::make_shared<const ImageTexture>(1, 1, Type::FLOAT, Layout::RGBA, new unsigned char[4]{ 255, 255, 255, 255 });
+	const std::shared_ptr<const ImageTexture> ImageTexture::black = std::make_shared<const ImageTexture>(1, 1, Type::FLOAT, Layout::RGBA, new unsigned char[4]{ 0, 0, 0, 255 });
+	const std::shared_ptr<const ImageTexture> ImageTexture::blue = std::make_shared<const ImageTexture>(1, 1, Type::FLOAT, Layout::RGBA, new unsigned char[4]{ 0, 0, 255, 255 });
 
 	ImageTexture::ImageTexture(size_t width, size_t height, Type type, Layout layout, unsigned char* data) :
 		Texture(Texture::Type::IMAGE),
@@ -17,6 +21,19 @@ namespace leoscene {
 	{
 	}
 
+	ImageTexture::ImageTexture(size_t width, size_t height, Type type, Layout layout, Compression compression, std::vector<MipLevel> mipLevels, unsigned char* data) :
+		Texture(Texture::Type::IMAGE),
+		width(width),
+		height(height),
+		nbChannels(getNbChannelsFromLayout(layout)),
+		type(type),
+		layout(layout),
+		compression(compression),
+		mipLevels(std::move(mipLevels)),
+		data(data)
+	{
+	}
+
 	ImageTexture::~ImageTexture()
 	{
 		if (data) {
@@ -31,16 +48,34 @@ namespace leoscene {
 		v = glm::modf(v, dummy);
 		if (u < 0) u += 1.f;
 		if (v < 0) v += 1.f;
-		size_t i = static_cast<size_t>(u * width);
-		size_t j = static_cast<size_t>((1.f - v) * height);
-		size_t index = (nbChannels * width) * j + (i * nbChannels);
+		size_t i = std::min(static_cast<size_t>(u * width), width - 1);
+		size_t j = std::min(static_cast<size_t>((1.f - v) * height), height - 1);
 		glm::vec4 texel(0);
+		if (compression != Compression::NONE) {  // Decompresses the block of the first mip level holding the texel
+			unsigned char blockTexels[16 * 4];
+			size_t blockIndex = (j / 4) * ((width + 3) / 4) + i / 4;
+			decompressBlock(compression, data + blockIndex * getCompressedBlockSize(compression), blockTexels);
+			const unsigned char* blockTexel = blockTexels + ((j % 4) * 4 + i % 4) * 4;
+			for (size_t channel = 0; channel < nbChannels; ++channel) {
+				texel[static_cast<glm::vec4::length_type>(channel)] = blockTexel[channel];
+			}
+			return texel;
+		}
+		size_t index = (nbChannels * width) * j + (i * nbChannels);
 		for (size_t channel = 0; channel < nbChannels; ++channel) {
 			texel[static_cast<glm::vec4::length_type>(channel)] = data[index + channel];
 		}
 		return texel;
 	}
 
+	size_t ImageTexture::getDataSize() const
+	{
+		if (mipLevels.size()) {
+			return mipLevels.back().offset + mipLevels.back().size;
+		}
+		return width * height * nbChannels;
+	}
+
 	size_t ImageTexture::getNbChannelsFromLayout(ImageTexture::Layout layout)
 	{
 		switch (layout) {
@@ -52,9 +87,27 @@ namespace leoscene {
 			return 4;
 		case ImageTexture::Layout::LUMINANCE:
 			return 1;
+		case ImageTexture::Layout::RG:
+			return 2;
 		default:
 			return 0;
 		}
 	}
 
+	ImageTexture::Layout ImageTexture::getLayoutFromCompression(ImageTexture::Compression compression)
+	{
+		switch (compression) {
+		case ImageTexture::Compression::BC1:
+			return ImageTexture::Layout::RGB;
+		case ImageTexture::Compression::BC4:
+			return ImageTexture::Layout::R;
+		case ImageTexture::Compression::BC5:
+			return ImageTexture::Layout::RG;
+		case ImageTexture::Compression::BC7:
+			return ImageTexture::Layout::RGBA;
+		default:
+			return ImageTexture::Layout::INVALID;
+		}
+	}
+
 }
@@ -3,6 +3,7 @@
 #include "Texture.h"
 
 #include <memory>
+#include <vector>
 
 namespace leoscene {
 	class ImageTexture : public Texture
@@ -17,25 +18,51 @@ namespace leoscene {
 			RGB,
 			RGBA,
 			LUMINANCE,
-			R
+			R,
+			RG
+		};
+		// Block compression of the texels (see TextureCompression.h). BC1 and BC7 textures are in sRGB.
+		enum class Compression {
+			NONE = 0,
+			BC1,  // RGB
+			BC4,  // R
+			BC5,  // RG
+			BC7  // RGBA
+		};
+		// Level of a precomputed mip chain, stored in data at the given offset
+		struct MipLevel {
+			size_t width = 0;
+			size_t height = 0;
+			size_t offset = 0;
+			size_t size = 0;
 		};
 
 	public:
 		ImageTexture(size_t width, size_t height, Type type, Layout layout, unsigned char* data = nullptr);
+
+		// Texture with its mip chain, whose levels are stored one after another in data (see TextureCompression.h).
+		// The layout of compressed textures must be the one of their compression (see getLayoutFromCompression).
+		ImageTexture(size_t width, size_t height, Type type, Layout layout, Compression compression, std::vector<MipLevel> mipLevels, unsigned char* data);
 		~ImageTexture();
 
 	public:
 		virtual glm::vec4 getTexel(float u, float v) const override;
 
+		// Size of data in bytes
+		size_t getDataSize() const;
+
 	public:
 		static size_t getNbChannelsFromLayout(ImageTexture::Layout layout);
+		static Layout getLayoutFromCompression(ImageTexture::Compression compression);
 
 	public:
 		const size_t width = 0;
 		const size_t height = 0;
 		const size_t nbChannels = 0;
 		const Type type = Type::INVALID;
-		const Layout layout = Layout::INVALID;
+		const Layout layout = Layout::INVALID;  // Layout of the decompressed texels for compressed textures
+		const Compression compression = Compression::NONE;
+		const std::vector<MipLevel> mipLevels;  // Empty when data only holds the first level
 		const unsigned char* data = nullptr;
 
 	public:
@@ -0,0 +1,65 @@
+#include "LoadingStats.h"
+
+namespace leoscene {
+	thread_local uint64_t LoadingStats::threadNbAllocations = 0;
+	thread_local uint64_t LoadingStats::threadAllocatedBytes = 0;
+	thread_local ScopedLoadingPhase* ScopedLoadingPhase::_current = nullptr;
+
+	const LoadingStats::PhaseStats& LoadingStats::getPhaseStats(Phase phase) const
+	{
+		return _phases[static_cast<size_t>(phase)];
+	}
+
+	const char* LoadingStats::getPhaseName(Phase phase)
+	{
+		switch (phase) {
+		case Phase::SCENE_PARSING: return "sceneParsing";
+		case Phase::MODEL_IMPORT: return "modelImport";
+		case Phase::MESH_CONVERSION: return "meshConversion";
+		case Phase::MESH_OPTIMIZATION: return "meshOptimization";
+		case Phase::MESH_SIMPLIFICATION: return "meshSimplification";
+		case Phase::MESH_CLUSTERING: return "meshClustering";
+		case Phase::TEXTURE_DECODING: return "textureDecoding";
+		case Phase::TEXTURE_PROCESSING: return "textureProcessing";
+		case Phase::ASSET_CACHE: return "assetCache";
+		case Phase::INSTANTIATION: return "instantiation";
+		case Phase::HLOD_BUILDING: return "hlodBuilding";
+		default: return "unknown";
+		}
+	}
+
+	ScopedLoadingPhase::ScopedLoadingPhase(LoadingStats* stats, LoadingStats::Phase phase) : _stats(stats), _phase(phase)
+	{
+		if (!_stats) {
+			return;
+		}
+		_parent = _current;
+		_current = this;
+		_startNbAllocations = LoadingStats::threadNbAllocations;
+		_startAllocatedBytes = LoadingStats::threadAllocatedBytes;
+		_start = std::chrono::steady_clock::now();
+	}
+
+	ScopedLoadingPhase::~ScopedLoadingPhase()
+	{
+		if (!_stats) {
+			return;
+		}
+		uint64_t nanoseconds = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _start).count());
+		uint64_t nbAllocations = LoadingStats::threadNbAllocations - _startNbAllocations;
+		uint64_t allocatedBytes = LoadingStats::threadAllocatedBytes - _startAllocatedBytes;
+
+		LoadingStats::PhaseStats& phaseStats = _stats->_phases[static_cast<size_t>(_phase)];
+		phaseStats.nanoseconds += nanoseconds - _nestedNanoseconds;
+		phaseStats.nbAllocations += nbAllocations - _nestedNbAllocations;
+		phaseStats.allocatedBytes += allocatedBytes - _nestedAllocatedBytes;
+		phaseStats.nbCalls++;
+
+		_current = _parent;
+		if (_parent) {
+			_parent->_nestedNanoseconds += nanoseconds;
+			_parent->_nestedNbAllocations += nbAllocations;
+			_parent->_nestedAllocatedBytes += allocatedBytes;
+		}
+	}
+}
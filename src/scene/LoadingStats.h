@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace leoscene {
+	/*
+	* Time and allocations spent in each phase of scene loading, summed over all the loading threads.
+	* Phases are exclusive: the time spent in a nested phase (a texture decoded while a mesh is converted) only counts for the nested phase.
+	* Allocations are only counted by programs that increment the per-thread counters (see tools/SceneLoadBench.cpp).
+	*/
+	class LoadingStats {
+	public:
+		enum class Phase {
+			SCENE_PARSING = 0,
+			MODEL_IMPORT,
+			MESH_CONVERSION,
+			MESH_OPTIMIZATION,
+			MESH_SIMPLIFICATION,
+			MESH_CLUSTERING,
+			TEXTURE_DECODING,
+			TEXTURE_PROCESSING,  // Mip levels and block compression
+			ASSET_CACHE,
+			INSTANTIATION,
+			HLOD_BUILDING,
+			NB_PHASES
+		};
+
+		struct PhaseStats {
+			std::atomic<uint64_t> nanoseconds{ 0 };
+			std::atomic<uint64_t> nbCalls{ 0 };
+			std::atomic<uint64_t> nbAllocations{ 0 };
+			std::atomic<uint64_t> allocatedBytes{ 0 };
+		};
+
+	public:
+		const PhaseStats& getPhaseStats(Phase phase) const;
+		static const char* getPhaseName(Phase phase);
+
+	public:
+		// Allocation counters of the calling thread. Never reset.
+		static thread_local uint64_t threadNbAllocations;
+		static thread_local uint64_t threadAllocatedBytes;
+
+	private:
+		friend class ScopedLoadingPhase;
+		PhaseStats _phases[static_cast<size_t>(Phase::NB_PHASES)];
+	};
+
+	/*
+	* Adds the time and allocations of its scope to a phase of the given stats. Does nothing if the stats are nullptr.
+	*/
+	class ScopedLoadingPhase {
+	public:
+		ScopedLoadingPhase(LoadingStats* stats, LoadingStats::Phase phase);
+		~ScopedLoadingPhase();
+
+		ScopedLoadingPhase(const ScopedLoadingPhase& other) = delete;
+		ScopedLoadingPhase& operator=(const ScopedLoadingPhase& other) = delete;
+
+	private:
+		LoadingStats* _stats = nullptr;
+		LoadingStats::Phase _phase = LoadingStats::Phase::SCENE_PARSING;
+		ScopedLoadingPhase* _parent = nullptr;  // Enclosing phase on the same thread
+		std::chrono::steady_clock::time_point _start;
+		uint64_t _startNbAllocations = 0;
+		uint64_t _startAllocatedBytes = 0;
+
+		// Totals of the nested phases, to remove from this one
+		uint64_t _nestedNanoseconds = 0;
+		uint64_t _nestedNbAllocations = 0;
+		uint64_t _nestedAllocatedBytes = 0;
+
+		static thread_local ScopedLoadingPhase* _current;
+	};
+}
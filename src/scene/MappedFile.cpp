@@ -0,0 +1,110 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace leoscene {
+
+	MappedFile::~MappedFile()
+	{
+		close();
+	}
+
+	bool MappedFile::open(const char* filePath)
+	{
+		close();
+
+#ifdef _WIN32
+		_fileHandle = CreateFileA(filePath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (_fileHandle == INVALID_HANDLE_VALUE) {
+			_fileHandle = nullptr;
+			return false;
+		}
+
+		LARGE_INTEGER fileSize = {};
+		if (!GetFileSizeEx(_fileHandle, &fileSize) || fileSize.QuadPart == 0) {
+			close();
+			return false;
+		}
+		_size = static_cast<size_t>(fileSize.QuadPart);
+
+		_mappingHandle = CreateFileMappingA(_fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!_mappingHandle) {
+			close();
+			return false;
+		}
+
+		_data = static_cast<const unsigned char*>(MapViewOfFile(_mappingHandle, FILE_MAP_READ, 0, 0, 0));
+		if (!_data) {
+			close();
+			return false;
+		}
+#else
+		_fileDescriptor = ::open(filePath, O_RDONLY);
+		if (_fileDescriptor < 0) {
+			return false;
+		}
+
+		struct stat fileStats = {};
+		if (fstat(_fileDescriptor, &fileStats) || fileStats.st_size == 0) {
+			close();
+			return false;
+		}
+		_size = static_cast<size_t>(fileStats.st_size);
+
+		void* data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, _fileDescriptor, 0);
+		if (data == MAP_FAILED) {
+			close();
+			return false;
+		}
+		_data = static_cast<const unsigned char*>(data);
+#endif
+
+		return true;
+	}
+
+	void MappedFile::close()
+	{
+#ifdef _WIN32
+		if (_data) {
+			UnmapViewOfFile(_data);
+		}
+		if (_mappingHandle) {
+			CloseHandle(_mappingHandle);
+		}
+		if (_fileHandle) {
+			CloseHandle(_fileHandle);
+		}
+		_mappingHandle = nullptr;
+		_fileHandle = nullptr;
+#else
+		if (_data) {
+			munmap(const_cast<unsigned char*>(_data), _size);
+		}
+		if (_fileDescriptor >= 0) {
+			::close(_fileDescriptor);
+		}
+		_fileDescriptor = -1;
+#endif
+		_data = nullptr;
+		_size = 0;
+	}
+
+	const unsigned char* MappedFile::getData() const
+	{
+		return _data;
+	}
+
+	size_t MappedFile::getSize() const
+	{
+		return _size;
+	}
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+
+namespace leoscene {
+	/*
+	* Read-only memory mapping of a whole file. The mapping is released when the object is destroyed.
+	*/
+	class MappedFile {
+	public:
+		MappedFile() = default;
+		~MappedFile();
+
+		MappedFile(const MappedFile& other) = delete;
+		MappedFile& operator=(const MappedFile& other) = delete;
+
+	public:
+		bool open(const char* filePath);
+		void close();
+
+		const unsigned char* getData() const;
+		size_t getSize() const;
+
+	private:
+		const unsigned char* _data = nullptr;
+		size_t _size = 0;
+#ifdef _WIN32
+		void* _fileHandle = nullptr;
+		void* _mappingHandle = nullptr;
+#else
+		int _fileDescriptor = -1;
+#endif
+	};
+}
@@ -1,6 +1,16 @@
 #include "Mesh.h"
 
 namespace leoscene {
+	IndexType selectIndexType(size_t nbVertices)
+	{
+		return nbVertices <= size_t(UINT16_MAX) + 1 ? IndexType::UINT16 : IndexType::UINT32;
+	}
+
+	size_t getIndexSize(IndexType indexType)
+	{
+		return indexType == IndexType::UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+	}
+
 	Mesh::Mesh(size_t nbVertices, size_t nbIndices)
 		: vertices(nbVertices), indices(nbIndices)
 	{
@@ -3,9 +3,44 @@
 #include "Shape.h"
 #include "Vertex.h"
 
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 
 namespace leoscene {
+	// Maximum number of levels of detail of a mesh, including the full mesh.
+	static constexpr uint32_t MAX_MESH_LODS = 5;
+
+	// Width of the indices of a mesh on the device and in the asset cache. The indices are 32 bits wide in Mesh::indices either way.
+	enum class IndexType {
+		UINT16,
+		UINT32
+	};
+
+	// 16 bits indices when they can address all the vertices (there is no primitive restart index to keep apart)
+	IndexType selectIndexType(size_t nbVertices);
+
+	// Bytes per index
+	size_t getIndexSize(IndexType indexType);
+
+	// Range of the indices of a mesh drawing one of its levels of detail.
+	struct MeshLod {
+		uint32_t firstIndex = 0;
+		uint32_t nbIndices = 0;
+		float error = 0;  // Largest distance to the full mesh, relative to the radius of the bounding sphere. 0 for the full mesh.
+	};
+
+	// Range of the indices of the full mesh culled on its own (see buildClusters).
+	struct MeshCluster {
+		glm::vec4 boundingSphere = glm::vec4(0);  // Object space
+		// Normal cone: the cluster only shows its back faces when dot(center - eye, axis) >= cutoff * |center - eye| + radius.
+		// A null axis never culls (open meshes, or triangles facing too many directions).
+		glm::vec3 coneAxis = glm::vec3(0);
+		float coneCutoff = 1;
+		uint32_t firstIndex = 0;
+		uint32_t nbIndices = 0;
+	};
+
 	class Mesh : public Shape {
 	public:
 		Mesh() = default;
@@ -21,5 +56,16 @@ namespace leoscene {
 		std::vector<Vertex> vertices;
 		std::vector<uint32_t> indices;
 		glm::vec4 boundingSphere = glm::vec4(0, 0, 0, 1);
+		// Axis aligned bounding box, in object space like the sphere
+		glm::vec3 boundingBoxMin = glm::vec3(-1);
+		glm::vec3 boundingBoxMax = glm::vec3(1);
+		IndexType indexType = IndexType::UINT32;  // Chosen when the mesh is imported (see selectIndexType)
+
+		// Levels of detail, from the full mesh to the coarsest. Their indices are stored one after another in indices (see generateLods).
+		// Empty when the mesh has no simplified version: all the indices are the full mesh.
+		std::vector<MeshLod> lods;
+
+		// Clusters of the full mesh, one after another in its indices. Empty when the mesh is culled as a whole.
+		std::vector<MeshCluster> clusters;
 	};
 }
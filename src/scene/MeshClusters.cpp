@@ -0,0 +1,318 @@
+#include "MeshClusters.h"
+
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+namespace leoscene {
+	namespace {
+		// Cones wider than this (smallest cosine between the axis and a normal) are so rarely culled that they are disabled.
+		const float MIN_CONE_COSINE = 0.1f;
+
+		struct PositionHash {
+			size_t operator()(const glm::vec3& position) const;
+		};
+
+		// True if each edge between positions is used by as many triangles in both directions: the surface is closed and consistently wound.
+		bool isClosedSurface(const uint32_t* indices, size_t nbIndices, const std::vector<uint32_t>& remap);
+
+		// -1 if the triangles are mostly wound clockwise around the normals of their vertices, 1 otherwise.
+		float getWindingSign(const uint32_t* indices, size_t nbIndices, const Vertex* vertices);
+
+		glm::vec3 getTriangleCenter(const uint32_t* triangle, const Vertex* vertices);
+	}
+
+	void buildClusters(Mesh& mesh)
+	{
+		mesh.clusters.clear();
+		size_t nbFullIndices = mesh.lods.empty() ? mesh.indices.size() : mesh.lods[0].nbIndices;
+		size_t nbTriangles = nbFullIndices / 3;
+		if (nbFullIndices % 3 || nbTriangles < MIN_CLUSTERED_TRIANGLES) {
+			return;
+		}
+		const Vertex* vertices = mesh.vertices.data();
+		uint32_t nbVertices = static_cast<uint32_t>(mesh.vertices.size());
+		const uint32_t* indices = mesh.indices.data();
+
+		/*
+		* Triangles around each position, in compressed rows. Clusters grow across the seams.
+		*/
+
+		std::vector<uint32_t> remap(nbVertices);
+		{
+			std::unordered_map<glm::vec3, uint32_t, PositionHash> firstVertices;
+			firstVertices.reserve(nbVertices);
+			for (uint32_t v = 0; v < nbVertices; ++v) {
+				remap[v] = firstVertices.emplace(vertices[v].position, v).first->second;
+			}
+		}
+
+		std::vector<uint32_t> offsets(nbVertices + 1, 0);
+		for (size_t i = 0; i < nbFullIndices; ++i) {
+			++offsets[remap[indices[i]] + 1];
+		}
+		for (uint32_t v = 0; v < nbVertices; ++v) {
+			offsets[v + 1] += offsets[v];
+		}
+		std::vector<uint32_t> adjacentTriangles(nbFullIndices);
+		{
+			std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+			for (size_t i = 0; i < nbFullIndices; ++i) {
+				adjacentTriangles[fill[remap[indices[i]]]++] = static_cast<uint32_t>(i / 3);
+			}
+		}
+
+		bool backFaceCulling = isClosedSurface(indices, nbFullIndices, remap);
+		float windingSign = getWindingSign(indices, nbFullIndices, vertices);
+
+		// Distance to the cluster under which an isolated triangle (foliage, debris) still joins it, from the size of a cluster
+		// if the triangles were evenly spread on the bounding sphere.
+		float joinDistance = 2.f * mesh.boundingSphere.w * std::sqrt(float(MAX_CLUSTER_TRIANGLES) / nbTriangles);
+
+		/*
+		* Greedy growth: each cluster starts from the first triangle left in the current order, then takes the neighbouring triangle
+		* adding the fewest vertices, the closest to the cluster first.
+		*/
+
+		std::vector<uint8_t> emitted(nbTriangles, 0);
+		std::vector<uint32_t> vertexClusters(nbVertices, UINT32_MAX);  // Last cluster using each vertex
+		std::vector<uint32_t> positionClusters(nbVertices, UINT32_MAX);  // Last cluster using each position
+		std::vector<uint32_t> clusterTriangles;
+		std::vector<uint32_t> clusterPositions;
+		std::vector<uint32_t> clusterVertices;
+		std::vector<uint32_t> localVertices(nbVertices, UINT32_MAX);  // Index of each vertex in clusterVertices
+		std::vector<uint32_t> result;
+		result.reserve(nbFullIndices);
+		std::vector<MeshCluster> clusters;
+		size_t nextSeed = 0;
+
+		while (result.size() < nbFullIndices) {
+			uint32_t clusterIndex = static_cast<uint32_t>(clusters.size());
+			uint32_t nbClusterVertices = 0;
+			glm::vec3 centerSum(0);
+			clusterTriangles.clear();
+			clusterPositions.clear();
+
+			auto countNewVertices = [&](uint32_t triangle) {
+				uint32_t nbNew = 0;
+				for (int k = 0; k < 3; ++k) {
+					nbNew += vertexClusters[indices[triangle * 3 + k]] != clusterIndex;
+				}
+				return nbNew;
+			};
+			auto addTriangle = [&](uint32_t triangle) {
+				emitted[triangle] = 1;
+				clusterTriangles.push_back(triangle);
+				centerSum += getTriangleCenter(indices + triangle * 3, vertices);
+				for (int k = 0; k < 3; ++k) {
+					uint32_t v = indices[triangle * 3 + k];
+					if (vertexClusters[v] != clusterIndex) {
+						vertexClusters[v] = clusterIndex;
+						++nbClusterVertices;
+					}
+					if (positionClusters[remap[v]] != clusterIndex) {
+						positionClusters[remap[v]] = clusterIndex;
+						clusterPositions.push_back(remap[v]);
+					}
+				}
+			};
+
+			while (emitted[nextSeed]) {
+				++nextSeed;
+			}
+			addTriangle(static_cast<uint32_t>(nextSeed));
+
+			while (clusterTriangles.size() < MAX_CLUSTER_TRIANGLES) {
+				glm::vec3 center = centerSum / float(clusterTriangles.size());
+				uint32_t best = UINT32_MAX;
+				uint32_t bestNbNew = 4;
+				float bestDistance = FLT_MAX;
+				for (uint32_t position : clusterPositions) {
+					for (uint32_t a = offsets[position]; a < offsets[position + 1]; ++a) {
+						uint32_t triangle = adjacentTriangles[a];
+						if (emitted[triangle]) {
+							continue;
+						}
+						uint32_t nbNew = countNewVertices(triangle);
+						if (nbNew > bestNbNew) {
+							continue;
+						}
+						glm::vec3 offset = getTriangleCenter(indices + triangle * 3, vertices) - center;
+						float distance = glm::dot(offset, offset);
+						if (nbNew < bestNbNew || distance < bestDistance) {
+							best = triangle;
+							bestNbNew = nbNew;
+							bestDistance = distance;
+						}
+					}
+				}
+
+				// No neighbour left: the next triangle in the current order, if it is close enough
+				if (best == UINT32_MAX) {
+					while (nextSeed < nbTriangles && emitted[nextSeed]) {
+						++nextSeed;
+					}
+					if (nextSeed == nbTriangles) {
+						break;
+					}
+					best = static_cast<uint32_t>(nextSeed);
+					bestNbNew = countNewVertices(best);
+					if (glm::length(getTriangleCenter(indices + best * 3, vertices) - center) > joinDistance) {
+						break;
+					}
+				}
+
+				if (nbClusterVertices + bestNbNew > MAX_CLUSTER_VERTICES) {
+					break;
+				}
+				addTriangle(best);
+			}
+
+			// Each cluster is drawn on its own: its triangles are optimized for the vertex cache again, on the vertices of the cluster only
+			uint32_t firstIndex = static_cast<uint32_t>(result.size());
+			clusterVertices.clear();
+			for (uint32_t triangle : clusterTriangles) {
+				for (int k = 0; k < 3; ++k) {
+					uint32_t v = indices[triangle * 3 + k];
+					if (localVertices[v] == UINT32_MAX) {
+						localVertices[v] = static_cast<uint32_t>(clusterVertices.size());
+						clusterVertices.push_back(v);
+					}
+					result.push_back(localVertices[v]);
+				}
+			}
+			uint32_t nbIndices = static_cast<uint32_t>(result.size()) - firstIndex;
+			optimizeVertexCache(result.data() + firstIndex, nbIndices, clusterVertices.size());
+			for (uint32_t i = firstIndex; i < firstIndex + nbIndices; ++i) {
+				result[i] = clusterVertices[result[i]];
+			}
+			for (uint32_t v : clusterVertices) {
+				localVertices[v] = UINT32_MAX;
+			}
+			clusters.push_back(computeClusterBounds(result.data() + firstIndex, nbIndices, vertices, backFaceCulling, windingSign));
+			clusters.back().firstIndex = firstIndex;
+			clusters.back().nbIndices = nbIndices;
+		}
+
+		std::copy(result.begin(), result.end(), mesh.indices.begin());
+		if (clusters.size() > 1) {
+			mesh.clusters = std::move(clusters);
+		}
+	}
+
+	MeshCluster computeClusterBounds(const uint32_t* indices, size_t nbIndices, const Vertex* vertices, bool backFaceCulling, float windingSign)
+	{
+		MeshCluster cluster;
+		cluster.nbIndices = static_cast<uint32_t>(nbIndices);
+		if (!nbIndices) {
+			return cluster;
+		}
+
+		glm::vec3 minPosition = vertices[indices[0]].position;
+		glm::vec3 maxPosition = minPosition;
+		for (size_t i = 1; i < nbIndices; ++i) {
+			minPosition = glm::min(minPosition, vertices[indices[i]].position);
+			maxPosition = glm::max(maxPosition, vertices[indices[i]].position);
+		}
+		glm::vec3 center = (minPosition + maxPosition) * 0.5f;
+		float radius = 0;
+		for (size_t i = 0; i < nbIndices; ++i) {
+			radius = std::max(radius, glm::length(vertices[indices[i]].position - center));
+		}
+		cluster.boundingSphere = glm::vec4(center, radius);
+
+		if (!backFaceCulling) {
+			return cluster;
+		}
+
+		// Axis: average of the normals of the triangles. Degenerate triangles are never visible and do not constrain the cone.
+		std::vector<glm::vec3> normals;
+		normals.reserve(nbIndices / 3);
+		glm::vec3 normalSum(0);
+		for (size_t t = 0; t + 2 < nbIndices; t += 3) {
+			const glm::vec3& p0 = vertices[indices[t]].position;
+			glm::vec3 normal = glm::cross(vertices[indices[t + 1]].position - p0, vertices[indices[t + 2]].position - p0) * windingSign;
+			float length = glm::length(normal);
+			if (length > 0) {
+				normals.push_back(normal / length);
+				normalSum += normals.back();
+			}
+		}
+		float sumLength = glm::length(normalSum);
+		if (normals.empty() || sumLength <= 0) {
+			return cluster;
+		}
+		glm::vec3 axis = normalSum / sumLength;
+
+		float minCosine = 1;
+		for (const glm::vec3& normal : normals) {
+			minCosine = std::min(minCosine, glm::dot(normal, axis));
+		}
+		if (minCosine < MIN_CONE_COSINE) {
+			return cluster;
+		}
+		cluster.coneAxis = axis;
+		cluster.coneCutoff = std::sqrt(1.f - minCosine * minCosine);  // Sine of the half angle of the cone
+		return cluster;
+	}
+
+	bool isClusterBackFacing(const MeshCluster& cluster, const glm::vec3& eye)
+	{
+		glm::vec3 toCenter = glm::vec3(cluster.boundingSphere) - eye;
+		return glm::dot(toCenter, cluster.coneAxis) >= cluster.coneCutoff * glm::length(toCenter) + cluster.boundingSphere.w;
+	}
+
+	namespace {
+		size_t PositionHash::operator()(const glm::vec3& position) const
+		{
+			uint32_t bits[3];
+			std::memcpy(bits, &position, sizeof(bits));
+			return size_t((bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u));
+		}
+
+		bool isClosedSurface(const uint32_t* indices, size_t nbIndices, const std::vector<uint32_t>& remap)
+		{
+			// +1 for each edge going from the smaller position to the larger one, -1 the other way
+			std::unordered_map<uint64_t, int32_t> edgeBalances;
+			edgeBalances.reserve(nbIndices);
+			for (size_t i = 0; i < nbIndices; ++i) {
+				uint32_t a = remap[indices[i]];
+				uint32_t b = remap[indices[i - i % 3 + (i + 1) % 3]];
+				if (a == b) {
+					continue;
+				}
+				uint64_t key = a < b ? (uint64_t(a) << 32 | b) : (uint64_t(b) << 32 | a);
+				edgeBalances[key] += a < b ? 1 : -1;
+			}
+			for (const auto& edgeBalance : edgeBalances) {
+				if (edgeBalance.second) {
+					return false;
+				}
+			}
+			return true;
+		}
+
+		float getWindingSign(const uint32_t* indices, size_t nbIndices, const Vertex* vertices)
+		{
+			float agreement = 0;
+			for (size_t t = 0; t + 2 < nbIndices; t += 3) {
+				const Vertex& v0 = vertices[indices[t]];
+				const Vertex& v1 = vertices[indices[t + 1]];
+				const Vertex& v2 = vertices[indices[t + 2]];
+				glm::vec3 normal = glm::cross(v1.position - v0.position, v2.position - v0.position);
+				agreement += glm::dot(normal, v0.normal + v1.normal + v2.normal);
+			}
+			return agreement < 0 ? -1.f : 1.f;
+		}
+
+		glm::vec3 getTriangleCenter(const uint32_t* triangle, const Vertex* vertices)
+		{
+			return (vertices[triangle[0]].position + vertices[triangle[1]].position + vertices[triangle[2]].position) / 3.f;
+		}
+	}
+}
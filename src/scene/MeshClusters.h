@@ -0,0 +1,32 @@
+#pragma once
+
+#include "Mesh.h"
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+* Decomposition of the full meshes into clusters of neighbouring triangles, culled one by one by the renderer.
+* Each cluster has a bounding sphere for frustum and occlusion culling, and a cone bounding the normals of its triangles
+* for back-face culling (Shirman, Abi-Ezzi 1993). Only closed meshes get cones: the back faces of an open mesh may be visible.
+*/
+namespace leoscene {
+	// Limits of the size of a cluster. Vertices are counted in the vertex buffer, so seams count twice.
+	static constexpr uint32_t MAX_CLUSTER_VERTICES = 64;
+	static constexpr uint32_t MAX_CLUSTER_TRIANGLES = 124;
+
+	// Below this number of triangles, meshes are culled as a whole: a draw command per cluster would cost more than it saves.
+	static constexpr uint32_t MIN_CLUSTERED_TRIANGLES = 1024;
+
+	// Reorders the triangles of the full mesh so that each cluster is a range of indices, and fills mesh.clusters.
+	// The triangles of each cluster are optimized for the vertex cache on their own, since each cluster is drawn by a command of its own.
+	// The other levels of detail are left untouched.
+	void buildClusters(Mesh& mesh);
+
+	// Bounding sphere and normal cone of a range of triangles. The cone is disabled if backFaceCulling is false.
+	// windingSign is -1 for meshes whose triangles are wound clockwise around their normals.
+	MeshCluster computeClusterBounds(const uint32_t* indices, size_t nbIndices, const Vertex* vertices, bool backFaceCulling, float windingSign = 1.f);
+
+	// Same conservative test as the culling shader: true if all the triangles of the cluster face away from eye.
+	bool isClusterBackFacing(const MeshCluster& cluster, const glm::vec3& eye);
+}
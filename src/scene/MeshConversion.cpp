@@ -0,0 +1,88 @@
+#include "MeshConversion.h"
+
+#include "BoundingVolumes.h"
+
+#include <algorithm>
+
+namespace leoscene {
+	namespace {
+		static_assert(sizeof(aiVector3D) == sizeof(glm::vec3), "Assimp positions are read in place as glm::vec3");
+
+		// Writes the first components of each source vector to an attribute of the vertices
+		template<int NB_COMPONENTS, typename Attribute>
+		void copyAttribute(const aiVector3D* source, size_t nbVertices, Vertex* vertices, Attribute Vertex::* attribute);
+
+		template<typename Attribute>
+		void fillAttribute(const Attribute& value, size_t nbVertices, Vertex* vertices, Attribute Vertex::* attribute);
+	}
+
+	void convertMesh(const aiMesh& assimpMesh, Mesh& mesh)
+	{
+		// Indices. Faces are triangles after aiProcess_Triangulate, but point and line meshes are copied as they are.
+		size_t nbIndices = 0;
+		for (unsigned int i = 0; i < assimpMesh.mNumFaces; ++i) {
+			nbIndices += assimpMesh.mFaces[i].mNumIndices;
+		}
+		mesh.indices.resize(nbIndices);
+		uint32_t* indices = mesh.indices.data();
+		for (unsigned int i = 0; i < assimpMesh.mNumFaces; ++i) {
+			const aiFace& face = assimpMesh.mFaces[i];
+			indices = std::copy(face.mIndices, face.mIndices + face.mNumIndices, indices);
+		}
+
+		// Vertices, one attribute at a time
+		size_t nbVertices = assimpMesh.mNumVertices;
+		mesh.vertices.resize(nbVertices);
+		Vertex* vertices = mesh.vertices.data();
+		const Vertex defaultVertex;
+
+		copyAttribute<3>(assimpMesh.mVertices, nbVertices, vertices, &Vertex::position);
+
+		if (assimpMesh.HasNormals()) {
+			copyAttribute<3>(assimpMesh.mNormals, nbVertices, vertices, &Vertex::normal);
+		}
+		else {
+			fillAttribute(defaultVertex.normal, nbVertices, vertices, &Vertex::normal);
+		}
+
+		if (assimpMesh.HasTangentsAndBitangents()) {
+			copyAttribute<3>(assimpMesh.mTangents, nbVertices, vertices, &Vertex::tangent);
+		}
+		else {
+			fillAttribute(defaultVertex.tangent, nbVertices, vertices, &Vertex::tangent);
+		}
+
+		if (assimpMesh.mTextureCoords[0]) {
+			copyAttribute<2>(assimpMesh.mTextureCoords[0], nbVertices, vertices, &Vertex::uv);
+		}
+		else {
+			fillAttribute(defaultVertex.uv, nbVertices, vertices, &Vertex::uv);
+		}
+
+		// Bounds, from the packed positions of Assimp rather than the vertices: a quarter of the memory to read
+		const glm::vec3* positions = reinterpret_cast<const glm::vec3*>(assimpMesh.mVertices);
+		mesh.boundingSphere = computeBoundingSphere(positions, nbVertices);
+		computeBoundingBox(positions, nbVertices, mesh.boundingBoxMin, mesh.boundingBoxMax);
+	}
+
+	namespace {
+		template<int NB_COMPONENTS, typename Attribute>
+		void copyAttribute(const aiVector3D* source, size_t nbVertices, Vertex* vertices, Attribute Vertex::* attribute)
+		{
+			for (size_t i = 0; i < nbVertices; ++i) {
+				Attribute& destination = vertices[i].*attribute;
+				for (int k = 0; k < NB_COMPONENTS; ++k) {
+					destination[k] = source[i][k];
+				}
+			}
+		}
+
+		template<typename Attribute>
+		void fillAttribute(const Attribute& value, size_t nbVertices, Vertex* vertices, Attribute Vertex::* attribute)
+		{
+			for (size_t i = 0; i < nbVertices; ++i) {
+				vertices[i].*attribute = value;
+			}
+		}
+	}
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "Mesh.h"
+
+#include <assimp/mesh.h>
+#include <assimp/postprocess.h>
+
+/*
+* Conversion of the meshes imported by Assimp to leoscene::Mesh.
+*/
+namespace leoscene {
+	// Post-processing asked to Assimp for the imported models. convertMesh expects triangulated meshes with normals.
+	static constexpr unsigned int ASSIMP_IMPORT_FLAGS =
+		aiProcess_Triangulate | aiProcess_JoinIdenticalVertices | aiProcess_GenNormals | aiProcess_CalcTangentSpace | aiProcess_SortByPType;
+
+	// Fills the vertices, the indices and the bounding volumes of the mesh. The buffers are sized once, then each attribute is copied
+	// in a loop of its own, without branches: the attributes missing from the Assimp mesh get the default values of Vertex.
+	// Meshes are independent, so the meshes of a model can be converted on several threads.
+	void convertMesh(const aiMesh& assimpMesh, Mesh& mesh);
+}
@@ -0,0 +1,309 @@
+#include "MeshOptimizer.h"
+
+#include "Mesh.h"
+
+#include <algorithm>
+
+namespace leoscene {
+	namespace {
+		/*
+		* FIFO vertex cache. A vertex is in the cache if fewer than cacheSize vertices were transformed since it was.
+		*/
+		class VertexCacheSimulation {
+		public:
+			VertexCacheSimulation(size_t nbVertices, uint32_t cacheSize);
+
+			// Returns true if the vertex had to be transformed.
+			bool access(uint32_t vertex);
+
+			// Number of vertices transformed since the given vertex was. Larger than the cache size if it is not in the cache.
+			uint32_t getAge(uint32_t vertex) const { return _time - _insertionTimes[vertex]; }
+
+			void reset() { _time += _cacheSize + 1; }
+
+		private:
+			std::vector<uint32_t> _insertionTimes;
+			uint32_t _cacheSize = 0;
+			uint32_t _time = 0;
+		};
+
+		// Number of vertices of the triangle that had to be transformed.
+		uint32_t accessTriangle(VertexCacheSimulation& cache, const uint32_t* triangle);
+
+		// Start triangles of the groups reordered by optimizeOverdraw.
+		std::vector<uint32_t> generateClusters(const uint32_t* indices, size_t nbTriangles, size_t nbVertices, float threshold);
+
+		// Returns the next vertex to fan around, or UINT32_MAX when all triangles are emitted.
+		uint32_t skipDeadEnd(const std::vector<uint32_t>& liveTriangles, std::vector<uint32_t>& deadEndStack, uint32_t& cursor);
+	}
+
+	void optimizeMesh(Mesh& mesh)
+	{
+		if (mesh.indices.empty() || mesh.indices.size() % 3) {
+			return;
+		}
+		optimizeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size());
+		optimizeOverdraw(mesh.indices.data(), mesh.indices.size(), mesh.vertices.data(), mesh.vertices.size());
+		optimizeVertexFetch(mesh.vertices, mesh.indices);
+	}
+
+	/*
+	* Tipsify: triangles are emitted by fanning around a vertex. The next vertex is picked among the vertices of the last fan,
+	* preferring the oldest one that is still in the cache and whose remaining triangles will not push it out of the cache.
+	*/
+
+	void optimizeVertexCache(uint32_t* indices, size_t nbIndices, size_t nbVertices, uint32_t cacheSize)
+	{
+		size_t nbTriangles = nbIndices / 3;
+		if (!nbTriangles) {
+			return;
+		}
+
+		// Triangles of each vertex, in compressed rows
+		std::vector<uint32_t> liveTriangles(nbVertices, 0);
+		for (size_t i = 0; i < nbTriangles * 3; ++i) {
+			++liveTriangles[indices[i]];
+		}
+		std::vector<uint32_t> adjacencyOffsets(nbVertices + 1, 0);
+		for (size_t v = 0; v < nbVertices; ++v) {
+			adjacencyOffsets[v + 1] = adjacencyOffsets[v] + liveTriangles[v];
+		}
+		std::vector<uint32_t> adjacency(adjacencyOffsets.back());
+		{
+			std::vector<uint32_t> fillOffsets(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+			for (size_t i = 0; i < nbTriangles * 3; ++i) {
+				adjacency[fillOffsets[indices[i]]++] = static_cast<uint32_t>(i / 3);
+			}
+		}
+
+		std::vector<uint32_t> result;
+		result.reserve(nbTriangles * 3);
+		std::vector<uint8_t> emitted(nbTriangles, 0);
+		std::vector<uint32_t> deadEndStack;
+		std::vector<uint32_t> candidates;
+		VertexCacheSimulation cache(nbVertices, cacheSize);
+		uint32_t cursor = 0;
+
+		uint32_t fanningVertex = skipDeadEnd(liveTriangles, deadEndStack, cursor);
+		while (fanningVertex != UINT32_MAX) {
+			candidates.clear();
+			for (uint32_t a = adjacencyOffsets[fanningVertex]; a < adjacencyOffsets[fanningVertex + 1]; ++a) {
+				uint32_t triangle = adjacency[a];
+				if (emitted[triangle]) {
+					continue;
+				}
+				emitted[triangle] = 1;
+				for (uint32_t k = 0; k < 3; ++k) {
+					uint32_t vertex = indices[triangle * 3 + k];
+					result.push_back(vertex);
+					deadEndStack.push_back(vertex);
+					candidates.push_back(vertex);
+					--liveTriangles[vertex];
+					cache.access(vertex);
+				}
+			}
+
+			fanningVertex = UINT32_MAX;
+			uint32_t bestPriority = 0;
+			for (uint32_t vertex : candidates) {
+				if (!liveTriangles[vertex]) {
+					continue;
+				}
+				// Age of the vertex in the cache, if it will still be in it after its remaining triangles are emitted
+				uint32_t age = cache.getAge(vertex);
+				uint32_t priority = age + 2 * liveTriangles[vertex] <= cacheSize ? age : 0;
+				if (fanningVertex == UINT32_MAX || priority > bestPriority) {
+					bestPriority = priority;
+					fanningVertex = vertex;
+				}
+			}
+			if (fanningVertex == UINT32_MAX) {
+				fanningVertex = skipDeadEnd(liveTriangles, deadEndStack, cursor);
+			}
+		}
+
+		std::copy(result.begin(), result.end(), indices);
+	}
+
+	/*
+	* Overdraw: the triangles are cut into groups, which are sorted by how much they face outward of the mesh.
+	* The order of the triangles inside of a group is kept. Groups start where the cache is cold (all three vertices of a triangle
+	* are transformed), and are split further as long as each part keeps a cache efficiency close to the whole (Sander et al. 2007).
+	*/
+
+	void optimizeOverdraw(uint32_t* indices, size_t nbIndices, const Vertex* vertices, size_t nbVertices, float threshold)
+	{
+		size_t nbTriangles = nbIndices / 3;
+		if (nbTriangles < 2 || !nbVertices) {
+			return;
+		}
+
+		glm::vec3 meshCentroid(0);
+		for (size_t v = 0; v < nbVertices; ++v) {
+			meshCentroid += vertices[v].position;
+		}
+		meshCentroid /= float(nbVertices);
+
+		std::vector<uint32_t> clusters = generateClusters(indices, nbTriangles, nbVertices, threshold);
+		clusters.push_back(static_cast<uint32_t>(nbTriangles));
+		size_t nbClusters = clusters.size() - 1;
+
+		std::vector<float> sortKeys(nbClusters);
+		for (size_t c = 0; c < nbClusters; ++c) {
+			glm::vec3 weightedCentroid(0);
+			glm::vec3 weightedNormal(0);
+			float area = 0;
+			for (uint32_t t = clusters[c]; t < clusters[c + 1]; ++t) {
+				const glm::vec3& p0 = vertices[indices[t * 3]].position;
+				const glm::vec3& p1 = vertices[indices[t * 3 + 1]].position;
+				const glm::vec3& p2 = vertices[indices[t * 3 + 2]].position;
+				glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);  // Length is twice the area
+				float triangleArea = glm::length(normal);
+				weightedCentroid += (p0 + p1 + p2) * (triangleArea / 3.f);
+				weightedNormal += normal;
+				area += triangleArea;
+			}
+			float normalLength = glm::length(weightedNormal);
+			sortKeys[c] = area > 0 && normalLength > 0 ? glm::dot(weightedCentroid / area - meshCentroid, weightedNormal / normalLength) : 0;
+		}
+
+		// Most outward facing groups first
+		std::vector<uint32_t> order(nbClusters);
+		for (size_t c = 0; c < nbClusters; ++c) {
+			order[c] = static_cast<uint32_t>(c);
+		}
+		std::stable_sort(order.begin(), order.end(), [&sortKeys](uint32_t a, uint32_t b) { return sortKeys[a] > sortKeys[b]; });
+
+		std::vector<uint32_t> result;
+		result.reserve(nbTriangles * 3);
+		for (uint32_t c : order) {
+			result.insert(result.end(), indices + clusters[c] * 3, indices + clusters[c + 1] * 3);
+		}
+		std::copy(result.begin(), result.end(), indices);
+	}
+
+	void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+	{
+		std::vector<uint32_t> remap(vertices.size(), UINT32_MAX);
+		uint32_t nbReferencedVertices = 0;
+		for (uint32_t& index : indices) {
+			if (remap[index] == UINT32_MAX) {
+				remap[index] = nbReferencedVertices++;
+			}
+			index = remap[index];
+		}
+
+		std::vector<Vertex> reordered(nbReferencedVertices);
+		for (size_t v = 0; v < vertices.size(); ++v) {
+			if (remap[v] != UINT32_MAX) {
+				reordered[remap[v]] = vertices[v];
+			}
+		}
+		vertices.swap(reordered);
+	}
+
+	VertexCacheStatistics analyzeVertexCache(const uint32_t* indices, size_t nbIndices, size_t nbVertices, uint32_t cacheSize)
+	{
+		VertexCacheStatistics statistics;
+		size_t nbTriangles = nbIndices / 3;
+		if (!nbTriangles) {
+			return statistics;
+		}
+
+		VertexCacheSimulation cache(nbVertices, cacheSize);
+		std::vector<uint8_t> referenced(nbVertices, 0);
+		uint32_t nbReferencedVertices = 0;
+		for (size_t i = 0; i < nbTriangles * 3; ++i) {
+			statistics.nbTransformedVertices += cache.access(indices[i]) ? 1 : 0;
+			if (!referenced[indices[i]]) {
+				referenced[indices[i]] = 1;
+				++nbReferencedVertices;
+			}
+		}
+		statistics.acmr = float(statistics.nbTransformedVertices) / float(nbTriangles);
+		statistics.atvr = float(statistics.nbTransformedVertices) / float(nbReferencedVertices);
+		return statistics;
+	}
+
+	namespace {
+		VertexCacheSimulation::VertexCacheSimulation(size_t nbVertices, uint32_t cacheSize) :
+			_insertionTimes(nbVertices, 0), _cacheSize(cacheSize), _time(cacheSize + 1)
+		{
+		}
+
+		bool VertexCacheSimulation::access(uint32_t vertex)
+		{
+			if (getAge(vertex) <= _cacheSize) {
+				return false;
+			}
+			_insertionTimes[vertex] = _time++;
+			return true;
+		}
+
+		uint32_t accessTriangle(VertexCacheSimulation& cache, const uint32_t* triangle)
+		{
+			return (cache.access(triangle[0]) ? 1 : 0) + (cache.access(triangle[1]) ? 1 : 0) + (cache.access(triangle[2]) ? 1 : 0);
+		}
+
+		std::vector<uint32_t> generateClusters(const uint32_t* indices, size_t nbTriangles, size_t nbVertices, float threshold)
+		{
+			std::vector<uint32_t> hardBoundaries;
+			VertexCacheSimulation cache(nbVertices, VERTEX_CACHE_SIZE);
+			for (size_t t = 0; t < nbTriangles; ++t) {
+				if (accessTriangle(cache, indices + t * 3) == 3) {
+					hardBoundaries.push_back(static_cast<uint32_t>(t));
+				}
+			}
+			if (hardBoundaries.empty() || hardBoundaries[0]) {
+				hardBoundaries.insert(hardBoundaries.begin(), 0);
+			}
+			hardBoundaries.push_back(static_cast<uint32_t>(nbTriangles));
+
+			std::vector<uint32_t> clusters;
+			for (size_t h = 0; h + 1 < hardBoundaries.size(); ++h) {
+				uint32_t start = hardBoundaries[h];
+				uint32_t end = hardBoundaries[h + 1];
+
+				cache.reset();
+				uint32_t nbMisses = 0;
+				for (uint32_t t = start; t < end; ++t) {
+					nbMisses += accessTriangle(cache, indices + t * 3);
+				}
+				float maxAcmr = float(nbMisses) / float(end - start) * threshold;
+
+				clusters.push_back(start);
+				cache.reset();
+				uint32_t clusterStart = start;
+				uint32_t clusterMisses = 0;
+				for (uint32_t t = start; t + 1 < end; ++t) {
+					clusterMisses += accessTriangle(cache, indices + t * 3);
+					if (float(clusterMisses) / float(t + 1 - clusterStart) <= maxAcmr) {
+						clusterStart = t + 1;
+						clusterMisses = 0;
+						clusters.push_back(clusterStart);
+						cache.reset();
+					}
+				}
+			}
+			return clusters;
+		}
+
+		uint32_t skipDeadEnd(const std::vector<uint32_t>& liveTriangles, std::vector<uint32_t>& deadEndStack, uint32_t& cursor)
+		{
+			// Recently emitted vertices are likely still in the cache
+			while (!deadEndStack.empty()) {
+				uint32_t vertex = deadEndStack.back();
+				deadEndStack.pop_back();
+				if (liveTriangles[vertex]) {
+					return vertex;
+				}
+			}
+			for (; cursor < liveTriangles.size(); ++cursor) {
+				if (liveTriangles[cursor]) {
+					return cursor;
+				}
+			}
+			return UINT32_MAX;
+		}
+	}
+}
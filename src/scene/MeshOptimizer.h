@@ -0,0 +1,46 @@
+#pragma once
+
+#include "Vertex.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+* Reordering of the triangles and vertices of indexed triangle lists, to reduce the work of the GPU when drawing them:
+* - Vertex cache: triangles sharing vertices are drawn close to each other, so that fewer vertices are shaded again
+*   (Tipsify, Sander et al. 2007).
+* - Overdraw: groups of triangles that keep a good cache efficiency are sorted so that the ones facing outward of the mesh
+*   are drawn first, as they tend to occlude the others.
+* - Vertex fetch: vertices are stored in the order they are first referenced, so that the vertex buffer is read linearly.
+* None of them change the triangles themselves, their winding, or the values of the vertices.
+*/
+namespace leoscene {
+	class Mesh;
+
+	// Number of entries of the simulated FIFO vertex cache. Actual hardware differs, but orders optimized for 16 entries do well on all of them.
+	static constexpr uint32_t VERTEX_CACHE_SIZE = 16;
+
+	struct VertexCacheStatistics {
+		uint32_t nbTransformedVertices = 0;  // Cache misses
+		float acmr = 0;  // Average cache miss ratio: transformed vertices per triangle. 0.5 at best on large regular grids, 3 at worst.
+		float atvr = 0;  // Average transformed vertex ratio: transformed vertices per referenced vertex. 1 at best.
+	};
+
+	// Runs the three optimizations on the mesh, in order. Unreferenced vertices are removed.
+	void optimizeMesh(Mesh& mesh);
+
+	// Reorders the triangles for the vertex cache.
+	void optimizeVertexCache(uint32_t* indices, size_t nbIndices, size_t nbVertices, uint32_t cacheSize = VERTEX_CACHE_SIZE);
+
+	// Reorders groups of triangles, expected to be in a vertex cache optimized order, to reduce overdraw.
+	// Groups are cut where the ACMR of the group stays below threshold times the ACMR of the surrounding triangles,
+	// so the cache efficiency gets at most that much worse.
+	void optimizeOverdraw(uint32_t* indices, size_t nbIndices, const Vertex* vertices, size_t nbVertices, float threshold = 1.05f);
+
+	// Reorders the vertices in the order of the indices, and updates the indices. Unreferenced vertices are removed.
+	void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+	// Simulates a FIFO vertex cache on the triangles.
+	VertexCacheStatistics analyzeVertexCache(const uint32_t* indices, size_t nbIndices, size_t nbVertices, uint32_t cacheSize = VERTEX_CACHE_SIZE);
+}
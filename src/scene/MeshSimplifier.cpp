@@ -0,0 +1,471 @@
+#include "MeshSimplifier.h"
+
+#include "Mesh.h"
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+namespace leoscene {
+	namespace {
+		// Below this number of triangles, a LOD is not worth a draw command of its own.
+		const size_t MIN_LOD_TRIANGLES = 64;
+
+		// A LOD that removes less than this ratio of the triangles of the previous one is not generated.
+		const float MIN_LOD_REDUCTION = 0.2f;
+
+		// Weight of the planes keeping the border vertices on the border, relative to the faces.
+		const float BORDER_WEIGHT = 10.f;
+
+		/*
+		* Sum of squared distances to weighted planes, as the symmetric matrix A, the vector b and the scalar c of p.A.p + 2 b.p + c.
+		* Divided by the sum of the weights, the error is a squared distance.
+		*/
+		struct Quadric {
+			float a00 = 0, a11 = 0, a22 = 0, a10 = 0, a20 = 0, a21 = 0;
+			float b0 = 0, b1 = 0, b2 = 0;
+			float c = 0;
+			float weight = 0;
+
+			Quadric& operator+=(const Quadric& other);
+		};
+
+		// Plane of normal n, at distance d from the origin.
+		Quadric makePlaneQuadric(const glm::vec3& n, float d, float weight);
+		float getQuadricError(const Quadric& quadric, const glm::vec3& position);
+
+		enum class VertexKind : uint8_t {
+			MANIFOLD,  // Inside the surface, can collapse onto any neighbour
+			BORDER,  // On an open border, can only collapse along the border
+			LOCKED  // Seams, corners of borders and non-manifold vertices
+		};
+
+		struct Collapse {
+			uint32_t vertex = 0;
+			uint32_t target = 0;  // Vertex of the same triangle as the collapsed edge. The wedge of the position that belongs to the surrounding triangles.
+			float error = 0;
+		};
+
+		struct PositionHash {
+			size_t operator()(const glm::vec3& position) const;
+		};
+
+		/*
+		* Triangles around each position, in compressed rows.
+		*/
+		struct TriangleAdjacency {
+			std::vector<uint32_t> offsets;
+			std::vector<uint32_t> triangles;
+
+			void build(const std::vector<uint32_t>& indices, const std::vector<uint32_t>& remap);
+
+			// Number of triangles with the edge going from a to b, in their winding.
+			uint32_t countDirectedEdges(uint32_t a, uint32_t b, const std::vector<uint32_t>& indices, const std::vector<uint32_t>& remap) const;
+		};
+
+		// True if collapsing vertex onto target flips or degenerates one of the triangles of vertex that are kept.
+		bool hasFlippedTriangle(
+			uint32_t vertex,
+			uint32_t target,
+			const std::vector<uint32_t>& result,
+			const std::vector<uint32_t>& remap,
+			const std::vector<glm::vec3>& positions,
+			const TriangleAdjacency& adjacency);
+	}
+
+	void generateLods(Mesh& mesh, float maxError)
+	{
+		mesh.lods.clear();
+		if (mesh.indices.empty() || mesh.indices.size() % 3 || mesh.boundingSphere.w <= 0) {
+			return;
+		}
+		uint32_t nbFullIndices = static_cast<uint32_t>(mesh.indices.size());
+		mesh.lods.push_back({ 0, nbFullIndices, 0.f });
+
+		// Errors of simplifyMesh are relative to the bounding box of the vertices
+		glm::vec3 minPosition = mesh.vertices[mesh.indices[0]].position;
+		glm::vec3 maxPosition = minPosition;
+		for (uint32_t index : mesh.indices) {
+			minPosition = glm::min(minPosition, mesh.vertices[index].position);
+			maxPosition = glm::max(maxPosition, mesh.vertices[index].position);
+		}
+		glm::vec3 size = maxPosition - minPosition;
+		float extentToRadius = std::max(size.x, std::max(size.y, size.z)) / mesh.boundingSphere.w;
+		if (extentToRadius <= 0) {
+			return;
+		}
+
+		// Each LOD is simplified from the previous one, so the errors add up.
+		std::vector<uint32_t> lodIndices;
+		while (mesh.lods.size() < MAX_MESH_LODS) {
+			const MeshLod previousLod = mesh.lods.back();
+			if (previousLod.nbIndices / 3 < MIN_LOD_TRIANGLES * 2 || previousLod.error >= maxError) {
+				break;
+			}
+
+			lodIndices.resize(previousLod.nbIndices);
+			float lodError = 0;
+			size_t nbLodIndices = simplifyMesh(lodIndices.data(), mesh.indices.data() + previousLod.firstIndex, previousLod.nbIndices,
+				mesh.vertices.data(), mesh.vertices.size(), previousLod.nbIndices / 6 * 3, (maxError - previousLod.error) / extentToRadius, &lodError);
+			if (nbLodIndices > previousLod.nbIndices * (1.f - MIN_LOD_REDUCTION) || nbLodIndices / 3 < MIN_LOD_TRIANGLES) {
+				break;
+			}
+			optimizeVertexCache(lodIndices.data(), nbLodIndices, mesh.vertices.size());
+
+			MeshLod lod;
+			lod.firstIndex = static_cast<uint32_t>(mesh.indices.size());
+			lod.nbIndices = static_cast<uint32_t>(nbLodIndices);
+			lod.error = previousLod.error + lodError * extentToRadius;
+			mesh.indices.insert(mesh.indices.end(), lodIndices.begin(), lodIndices.begin() + nbLodIndices);
+			mesh.lods.push_back(lod);
+		}
+
+		if (mesh.lods.size() == 1) {
+			mesh.lods.clear();
+		}
+	}
+
+	/*
+	* Each pass collapses the cheapest edges first, at most once around each vertex so that the error and the flip tests stay exact,
+	* then removes the degenerate triangles. Passes are repeated until the target or the maximum error is reached.
+	*/
+
+	size_t simplifyMesh(
+		uint32_t* destination,
+		const uint32_t* indices,
+		size_t nbIndices,
+		const Vertex* vertices,
+		size_t nbVertices,
+		size_t targetNbIndices,
+		float maxError,
+		float* resultError)
+	{
+		if (resultError) {
+			*resultError = 0;
+		}
+		std::vector<uint32_t> result(indices, indices + nbIndices - nbIndices % 3);
+		if (result.empty() || result.size() <= targetNbIndices) {
+			std::copy(result.begin(), result.end(), destination);
+			return result.size();
+		}
+
+		/*
+		* Positions, normalized in the bounding box of the vertices. remap gives the first vertex of each position, which stores its data.
+		*/
+
+		std::vector<uint32_t> remap(nbVertices);
+		std::vector<uint32_t> nbWedges(nbVertices, 0);
+		{
+			std::unordered_map<glm::vec3, uint32_t, PositionHash> firstVertices;
+			firstVertices.reserve(nbVertices);
+			for (uint32_t v = 0; v < nbVertices; ++v) {
+				remap[v] = firstVertices.emplace(vertices[v].position, v).first->second;
+				++nbWedges[remap[v]];
+			}
+		}
+
+		glm::vec3 minPosition = vertices[result[0]].position;
+		glm::vec3 maxPosition = minPosition;
+		for (uint32_t index : result) {
+			minPosition = glm::min(minPosition, vertices[index].position);
+			maxPosition = glm::max(maxPosition, vertices[index].position);
+		}
+		glm::vec3 size = maxPosition - minPosition;
+		float extent = std::max(size.x, std::max(size.y, size.z));
+		float inverseExtent = extent > 0 ? 1.f / extent : 0.f;
+		std::vector<glm::vec3> positions(nbVertices);
+		for (size_t v = 0; v < nbVertices; ++v) {
+			positions[v] = (vertices[v].position - minPosition) * inverseExtent;
+		}
+
+		/*
+		* Vertex kinds, from the directed edges between positions. An edge without its opposite is on a border.
+		*/
+
+		TriangleAdjacency adjacency;
+		adjacency.build(result, remap);
+
+		std::vector<VertexKind> kinds(nbVertices, VertexKind::MANIFOLD);
+		std::vector<uint8_t> nbOutgoingBorders(nbVertices, 0);
+		std::vector<uint8_t> nbIncomingBorders(nbVertices, 0);
+		std::vector<uint8_t> isBorderEdge(result.size(), 0);  // For the edge starting at each index
+		for (size_t i = 0; i < result.size(); ++i) {
+			uint32_t a = remap[result[i]];
+			uint32_t b = remap[result[i - i % 3 + (i + 1) % 3]];
+			if (adjacency.countDirectedEdges(a, b, result, remap) > 1) {
+				kinds[a] = kinds[b] = VertexKind::LOCKED;
+			}
+			else if (!adjacency.countDirectedEdges(b, a, result, remap)) {
+				isBorderEdge[i] = 1;
+				nbOutgoingBorders[a] = static_cast<uint8_t>(std::min(nbOutgoingBorders[a] + 1, 2));
+				nbIncomingBorders[b] = static_cast<uint8_t>(std::min(nbIncomingBorders[b] + 1, 2));
+			}
+		}
+		for (size_t v = 0; v < nbVertices; ++v) {
+			if (nbWedges[v] > 1 || nbOutgoingBorders[v] != nbIncomingBorders[v] || nbOutgoingBorders[v] > 1) {
+				kinds[v] = VertexKind::LOCKED;
+			}
+			else if (nbOutgoingBorders[v] == 1 && kinds[v] != VertexKind::LOCKED) {
+				kinds[v] = VertexKind::BORDER;
+			}
+		}
+
+		/*
+		* Quadrics of the planes of the triangles around each position, weighted by area. Border edges add a plane orthogonal to their triangle.
+		*/
+
+		std::vector<Quadric> quadrics(nbVertices);
+		for (size_t t = 0; t < result.size(); t += 3) {
+			uint32_t r[3] = { remap[result[t]], remap[result[t + 1]], remap[result[t + 2]] };
+			glm::vec3 normal = glm::cross(positions[r[1]] - positions[r[0]], positions[r[2]] - positions[r[0]]);
+			float doubleArea = glm::length(normal);
+			if (doubleArea <= 0) {
+				continue;
+			}
+			normal /= doubleArea;
+			Quadric faceQuadric = makePlaneQuadric(normal, -glm::dot(normal, positions[r[0]]), doubleArea * 0.5f);
+			for (int k = 0; k < 3; ++k) {
+				quadrics[r[k]] += faceQuadric;
+
+				uint32_t a = r[k];
+				uint32_t b = r[(k + 1) % 3];
+				if (isBorderEdge[t + k]) {
+					glm::vec3 edge = positions[b] - positions[a];
+					float edgeLength = glm::length(edge);
+					glm::vec3 borderNormal = glm::cross(edge, normal);
+					float borderNormalLength = glm::length(borderNormal);
+					if (borderNormalLength > 0) {
+						borderNormal /= borderNormalLength;
+						Quadric borderQuadric = makePlaneQuadric(borderNormal, -glm::dot(borderNormal, positions[a]), edgeLength * edgeLength * BORDER_WEIGHT);
+						quadrics[a] += borderQuadric;
+						quadrics[b] += borderQuadric;
+					}
+				}
+			}
+		}
+
+		/*
+		* Collapse passes
+		*/
+
+		float maxSquaredError = maxError * maxError;
+		float largestSquaredError = 0;
+		size_t nbTriangles = result.size() / 3;
+		size_t targetNbTriangles = targetNbIndices / 3;
+
+		std::vector<Collapse> collapses;
+		std::vector<uint32_t> collapseTargets(nbVertices);
+		std::vector<uint8_t> lockedInPass(nbVertices);
+
+		for (bool firstPass = true; nbTriangles > targetNbTriangles; firstPass = false) {
+			if (!firstPass) {
+				adjacency.build(result, remap);
+			}
+
+			// Candidate collapses, both ways of each edge
+			collapses.clear();
+			for (size_t i = 0; i < result.size(); ++i) {
+				uint32_t ends[2] = { result[i], result[i - i % 3 + (i + 1) % 3] };
+				uint32_t a = remap[ends[0]];
+				uint32_t b = remap[ends[1]];
+				if (a == b || (kinds[a] == VertexKind::LOCKED && kinds[b] == VertexKind::LOCKED)) {
+					continue;
+				}
+				// Only border edges can have a single triangle. Edges of manifold vertices are seen once from each side.
+				bool isBorderEdge = (kinds[a] == VertexKind::BORDER || kinds[b] == VertexKind::BORDER) && !adjacency.countDirectedEdges(b, a, result, remap);
+				if (!isBorderEdge && a > b) {
+					continue;
+				}
+				for (int k = 0; k < 2; ++k) {
+					uint32_t vertex = remap[ends[k]];
+					uint32_t target = ends[1 - k];
+					VertexKind kind = kinds[vertex];
+					VertexKind targetKind = kinds[remap[target]];
+					if (kind == VertexKind::LOCKED || (kind == VertexKind::BORDER && (!isBorderEdge || targetKind == VertexKind::MANIFOLD))) {
+						continue;
+					}
+					Quadric quadric = quadrics[vertex];
+					quadric += quadrics[remap[target]];
+					float error = quadric.weight > 0 ? getQuadricError(quadric, positions[remap[target]]) / quadric.weight : 0.f;
+					if (error <= maxSquaredError) {
+						collapses.push_back({ vertex, target, error });
+					}
+				}
+			}
+			if (collapses.empty()) {
+				break;
+			}
+			std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.error < b.error; });
+
+			for (uint32_t v = 0; v < nbVertices; ++v) {
+				collapseTargets[v] = v;
+			}
+			std::fill(lockedInPass.begin(), lockedInPass.end(), 0);
+
+			size_t nbCollapses = 0;
+			size_t nbPassTriangles = nbTriangles;
+			for (const Collapse& collapse : collapses) {
+				if (nbTriangles <= targetNbTriangles) {
+					break;
+				}
+				uint32_t targetPosition = remap[collapse.target];
+				if (lockedInPass[collapse.vertex] || lockedInPass[targetPosition] ||
+					hasFlippedTriangle(collapse.vertex, targetPosition, result, remap, positions, adjacency))
+				{
+					continue;
+				}
+
+				collapseTargets[collapse.vertex] = collapse.target;
+				quadrics[targetPosition] += quadrics[collapse.vertex];
+				largestSquaredError = std::max(largestSquaredError, collapse.error);
+				++nbCollapses;
+
+				// The triangles around the collapsed vertex change: their vertices wait for the next pass
+				lockedInPass[targetPosition] = 1;
+				for (uint32_t a = adjacency.offsets[collapse.vertex]; a < adjacency.offsets[collapse.vertex + 1]; ++a) {
+					const uint32_t* triangle = result.data() + adjacency.triangles[a] * 3;
+					bool removed = false;
+					for (int k = 0; k < 3; ++k) {
+						lockedInPass[remap[triangle[k]]] = 1;
+						removed = removed || remap[triangle[k]] == targetPosition;
+					}
+					nbTriangles -= removed ? 1 : 0;
+				}
+			}
+			if (!nbCollapses) {
+				break;
+			}
+			// Passes only removing a few triangles cost as much as the others. The remaining collapses are mostly blocked by flips.
+			bool slowProgress = (nbPassTriangles - nbTriangles) * 100 < nbPassTriangles;
+
+			// Collapsed vertices have a single wedge, so they are their own position
+			size_t nbKeptIndices = 0;
+			for (size_t t = 0; t < result.size(); t += 3) {
+				uint32_t triangle[3] = { collapseTargets[result[t]], collapseTargets[result[t + 1]], collapseTargets[result[t + 2]] };
+				if (remap[triangle[0]] != remap[triangle[1]] && remap[triangle[1]] != remap[triangle[2]] && remap[triangle[2]] != remap[triangle[0]]) {
+					for (int k = 0; k < 3; ++k) {
+						result[nbKeptIndices++] = triangle[k];
+					}
+				}
+			}
+			result.resize(nbKeptIndices);
+			nbTriangles = nbKeptIndices / 3;
+			if (slowProgress) {
+				break;
+			}
+		}
+
+		if (resultError) {
+			*resultError = std::sqrt(largestSquaredError);
+		}
+		std::copy(result.begin(), result.end(), destination);
+		return result.size();
+	}
+
+	namespace {
+		Quadric& Quadric::operator+=(const Quadric& other)
+		{
+			a00 += other.a00; a11 += other.a11; a22 += other.a22;
+			a10 += other.a10; a20 += other.a20; a21 += other.a21;
+			b0 += other.b0; b1 += other.b1; b2 += other.b2;
+			c += other.c;
+			weight += other.weight;
+			return *this;
+		}
+
+		Quadric makePlaneQuadric(const glm::vec3& n, float d, float weight)
+		{
+			Quadric quadric;
+			quadric.a00 = weight * n.x * n.x;
+			quadric.a11 = weight * n.y * n.y;
+			quadric.a22 = weight * n.z * n.z;
+			quadric.a10 = weight * n.y * n.x;
+			quadric.a20 = weight * n.z * n.x;
+			quadric.a21 = weight * n.z * n.y;
+			quadric.b0 = weight * n.x * d;
+			quadric.b1 = weight * n.y * d;
+			quadric.b2 = weight * n.z * d;
+			quadric.c = weight * d * d;
+			quadric.weight = weight;
+			return quadric;
+		}
+
+		float getQuadricError(const Quadric& q, const glm::vec3& p)
+		{
+			float rx = q.a00 * p.x + q.a10 * p.y + q.a20 * p.z;
+			float ry = q.a10 * p.x + q.a11 * p.y + q.a21 * p.z;
+			float rz = q.a20 * p.x + q.a21 * p.y + q.a22 * p.z;
+			float error = rx * p.x + ry * p.y + rz * p.z + 2.f * (q.b0 * p.x + q.b1 * p.y + q.b2 * p.z) + q.c;
+			return std::max(error, 0.f);  // Rounding
+		}
+
+		void TriangleAdjacency::build(const std::vector<uint32_t>& indices, const std::vector<uint32_t>& remap)
+		{
+			offsets.assign(remap.size() + 1, 0);
+			for (uint32_t index : indices) {
+				++offsets[remap[index] + 1];
+			}
+			for (size_t v = 0; v < remap.size(); ++v) {
+				offsets[v + 1] += offsets[v];
+			}
+			triangles.resize(indices.size());
+			std::vector<uint32_t> fillOffsets(offsets.begin(), offsets.end() - 1);
+			for (size_t i = 0; i < indices.size(); ++i) {
+				triangles[fillOffsets[remap[indices[i]]]++] = static_cast<uint32_t>(i / 3);
+			}
+		}
+
+		uint32_t TriangleAdjacency::countDirectedEdges(uint32_t a, uint32_t b, const std::vector<uint32_t>& indices, const std::vector<uint32_t>& remap) const
+		{
+			uint32_t count = 0;
+			for (uint32_t t = offsets[a]; t < offsets[a + 1]; ++t) {
+				const uint32_t* triangle = indices.data() + triangles[t] * 3;
+				for (int k = 0; k < 3; ++k) {
+					count += (remap[triangle[k]] == a && remap[triangle[(k + 1) % 3]] == b) ? 1 : 0;
+				}
+			}
+			return count;
+		}
+
+		size_t PositionHash::operator()(const glm::vec3& position) const
+		{
+			uint32_t bits[3];
+			std::memcpy(bits, &position, sizeof(bits));
+			return size_t((bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u));
+		}
+
+		bool hasFlippedTriangle(
+			uint32_t vertex,
+			uint32_t target,
+			const std::vector<uint32_t>& result,
+			const std::vector<uint32_t>& remap,
+			const std::vector<glm::vec3>& positions,
+			const TriangleAdjacency& adjacency)
+		{
+			for (uint32_t a = adjacency.offsets[vertex]; a < adjacency.offsets[vertex + 1]; ++a) {
+				const uint32_t* triangle = result.data() + adjacency.triangles[a] * 3;
+				uint32_t r[3] = { remap[triangle[0]], remap[triangle[1]], remap[triangle[2]] };
+				if (r[0] == target || r[1] == target || r[2] == target) {
+					continue;  // Removed by the collapse
+				}
+				glm::vec3 before[3] = { positions[r[0]], positions[r[1]], positions[r[2]] };
+				glm::vec3 after[3] = { before[0], before[1], before[2] };
+				for (int k = 0; k < 3; ++k) {
+					if (r[k] == vertex) {
+						after[k] = positions[target];
+					}
+				}
+				glm::vec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+				glm::vec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+				// Also rejects triangles turning by more than ~75 degrees, which are close to folding over their neighbours
+				if (glm::dot(normalBefore, normalAfter) <= 0.25f * glm::length(normalBefore) * glm::length(normalAfter)) {
+					return true;
+				}
+			}
+			return false;
+		}
+	}
+}
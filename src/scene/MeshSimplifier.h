@@ -0,0 +1,33 @@
+#pragma once
+
+#include "Vertex.h"
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+* Simplification of indexed triangle lists by quadric edge collapse (Garland, Heckbert 1997), used to generate the levels of detail of the meshes.
+* Edges are collapsed onto one of their vertices, so the simplified triangles only reference vertices of the original mesh and can share its
+* vertex buffer. Vertices on the open borders of the mesh only move along the borders. Vertices whose position is shared by several vertices
+* (seams in the UVs or the normals) are never moved, so that the seams do not tear.
+*/
+namespace leoscene {
+	class Mesh;
+
+	// Appends simplified versions of the mesh to its indices, each with about half the triangles of the previous one, and fills mesh.lods.
+	// Stops before MAX_MESH_LODS when the mesh cannot be simplified further without exceeding maxError, relative to the radius of its bounding sphere.
+	void generateLods(Mesh& mesh, float maxError = 0.25f);
+
+	// Writes to destination the triangles left after collapsing edges until there are at most targetNbIndices indices, or until the next
+	// collapse would move the surface further than maxError. destination can be indices. Returns the number of indices written.
+	// Errors are distances relative to the largest side of the bounding box of the vertices. resultError is the largest error of the collapses.
+	size_t simplifyMesh(
+		uint32_t* destination,
+		const uint32_t* indices,
+		size_t nbIndices,
+		const Vertex* vertices,
+		size_t nbVertices,
+		size_t targetNbIndices,
+		float maxError,
+		float* resultError = nullptr);
+}
@@ -4,87 +4,175 @@
 
 #include "TextureLoader.h"
 #include "Texture.h"
+#include "BoundingVolumes.h"
 #include "Mesh.h"
+#include "MeshClusters.h"
+#include "MeshConversion.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
 #include "PerformanceMaterial.h"
+#include "RecordingIOSystem.h"
 #include "Scene/SceneObject.h"
 #include "Scene/Transform.h"
 
 #include <assimp/Importer.hpp>
 #include <assimp/postprocess.h>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <exception>
+#include <future>
+
 namespace leoscene {
+    namespace {
+        // Texture slots of PerformanceMaterial, in the order of getTextureSlots().
+        const size_t NB_TEXTURE_SLOTS = 5;
+        const aiTextureType TEXTURE_SLOT_TYPES[NB_TEXTURE_SLOTS] = {
+            aiTextureType_DIFFUSE,
+            aiTextureType_SPECULAR,
+            aiTextureType_AMBIENT,
+            aiTextureType_NORMALS,
+            aiTextureType_HEIGHT,
+        };
+
+        // Layout of the models stored in the asset cache. Bump it with every change to the stored data, so that older entries are not read.
+        const uint32_t MODEL_CACHE_VERSION = 5;
+
+        template<typename MaterialType>
+        auto getTextureSlots(MaterialType& material) -> std::array<decltype(&material.diffuseTexture), NB_TEXTURE_SLOTS>;
+        std::string getModelCacheKey(const char* filePath, bool optimizedMeshes, bool lods, bool clusters);
+    }
 
     ModelLoader::ModelLoader() : _defaultMaterial(std::make_shared<PerformanceMaterial>())
     {
     }
 
-    const Model ModelLoader::loadModel(const char* filePath, LoadingOptions options)
+    Model ModelLoader::loadModel(const char* filePath, LoadingOptions options)
     {
-        auto cacheIterator = _modelsCache.find(filePath);
-        if (cacheIterator != _modelsCache.end()) {
-            Model model = cacheIterator->second;
-            for (SceneObject& object : model.objects) {
-                object.transform = std::make_shared<Transform>(options.globalTransform->getMatrix() * object.transform->getMatrix());
+        {
+            std::lock_guard<std::mutex> lock(_modelsCacheMutex);
+            auto cacheIterator = _modelsCache.find(filePath);
+            if (cacheIterator != _modelsCache.end()) {
+                return _makeModelHandle(cacheIterator->second, options);
             }
-            return model;
         }
 
-        _modelsCache[filePath] = {};
-        Model& model = _modelsCache[filePath];
-
-        Assimp::Importer importer;
-        const aiScene* aiScene = importer.ReadFile(filePath,
-            aiProcess_Triangulate | aiProcess_JoinIdenticalVertices | aiProcess_GenNormals | aiProcess_CalcTangentSpace | aiProcess_SortByPType
-
-        );
-
-        if (!aiScene || aiScene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !aiScene->mRootNode) // if is Not Zero
-        {
-            return {};
-        }
+        std::vector<SceneObject> objects;
+        if (!_assetCache || !_loadModelFromAssetCache(filePath, objects)) {
+            // One importer per thread, so that several models can be imported at the same time. The importer owns its
+            // file system, which records the files read with the model file.
+            thread_local Assimp::Importer importer;
+            thread_local RecordingIOSystem* ioSystem = nullptr;
+            if (!ioSystem) {
+                ioSystem = new RecordingIOSystem();
+                importer.SetIOHandler(ioSystem);
+            }
+            ioSystem->clearFilePaths();
+            const aiScene* aiScene = nullptr;
+            {
+                ScopedLoadingPhase phase(_stats, LoadingStats::Phase::MODEL_IMPORT);
+                aiScene = importer.ReadFile(filePath, ASSIMP_IMPORT_FLAGS);
+            }
 
-        std::unordered_map<aiMaterial*, std::shared_ptr<Material>> modelMaterials;
-        std::unordered_map<aiMesh*, std::shared_ptr<Mesh>> modelMeshes;
-        std::string strFilePath = std::string(filePath);
-        std::string fileDirectoryPath = strFilePath.substr(0, strFilePath.find_last_of('/'));
-        aiMatrix4x4 transform;
-        _processNode(aiScene->mRootNode, aiScene, fileDirectoryPath, modelMaterials, modelMeshes, model.objects, transform);
+            if (!aiScene || aiScene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !aiScene->mRootNode) // if is Not Zero
+            {
+                importer.FreeScene();
+                std::lock_guard<std::mutex> lock(_modelsCacheMutex);
+                auto insertion = _modelsCache.emplace(filePath, std::make_shared<const std::vector<SceneObject>>());
+                return _makeModelHandle(insertion.first->second, options);
+            }
 
-        if (options.globalTransform) {
-            for (SceneObject& object : model.objects) {
-                if (object.transform) {
-                    object.transform = std::make_shared<Transform>(options.globalTransform->getMatrix() * object.transform->getMatrix());
+            // The textures are requested first, so that the texture threads load them while the meshes are processed
+            std::unordered_map<aiMaterial*, std::shared_ptr<Material>> modelMaterials;
+            std::vector<PendingTexture> pendingTextures;
+            std::string strFilePath = std::string(filePath);
+            std::string fileDirectoryPath = strFilePath.substr(0, strFilePath.find_last_of('/'));
+            _requestMaterials(aiScene, fileDirectoryPath, modelMaterials, pendingTextures);
+
+            // All the meshes of the file are processed in parallel. Objects are then made for the nodes, in order.
+            std::vector<std::shared_ptr<Mesh>> modelMeshes;
+            _processMeshes(aiScene, modelMeshes);
+            std::vector<std::string> failedTexturePaths = _resolveTextures(pendingTextures);
+
+            aiMatrix4x4 transform;
+            _processNode(aiScene->mRootNode, aiScene, fileDirectoryPath, modelMaterials, modelMeshes, objects, transform);
+            importer.FreeScene();
+
+            if (_assetCache) {
+                std::vector<std::string> dependencyFilePaths;
+                for (const std::string& readFilePath : ioSystem->getFilePaths()) {
+                    if (readFilePath != strFilePath) {
+                        dependencyFilePaths.push_back(readFilePath);
+                    }
                 }
+                dependencyFilePaths.insert(dependencyFilePaths.end(), failedTexturePaths.begin(), failedTexturePaths.end());
+                _storeModelInAssetCache(filePath, objects, dependencyFilePaths);
             }
         }
 
-        return model;
+        // If another thread processed the same file in the meantime, its table is kept and this one is dropped.
+        std::lock_guard<std::mutex> lock(_modelsCacheMutex);
+        auto insertion = _modelsCache.emplace(filePath, std::make_shared<const std::vector<SceneObject>>(std::move(objects)));
+        return _makeModelHandle(insertion.first->second, options);
+    }
+
+    void ModelLoader::setAssetCache(std::shared_ptr<const AssetCache> assetCache)
+    {
+        _assetCache = assetCache;
+        _textureLoader.setAssetCache(assetCache);
+    }
+
+    void ModelLoader::setLoadingStats(LoadingStats* stats)
+    {
+        _stats = stats;
+        _textureLoader.setLoadingStats(stats);
+    }
+
+    void ModelLoader::setMeshOptimization(bool enabled)
+    {
+        _optimizeMeshes = enabled;
+    }
+
+    void ModelLoader::setLodGeneration(bool enabled)
+    {
+        _generateLods = enabled;
+    }
+
+    void ModelLoader::setClusterGeneration(bool enabled)
+    {
+        _buildClusters = enabled;
+    }
+
+    void ModelLoader::setTextureCompression(bool enabled)
+    {
+        _compressTextures = enabled;
+    }
+
+    void ModelLoader::setThreadPool(std::shared_ptr<ThreadPool> threadPool)
+    {
+        _threadPool = threadPool;
+        _textureLoader.setThreadPool(threadPool);
     }
 
-    const Model ModelLoader::loadSphereModel(uint32_t xSegments, uint32_t ySegments, LoadingOptions options)
+    Model ModelLoader::loadSphereModel(uint32_t xSegments, uint32_t ySegments, LoadingOptions options)
     {
+        std::lock_guard<std::mutex> lock(_spheresCacheMutex);
         auto xSegmentFind = _spheresCache.find(xSegments);
         if (xSegmentFind != _spheresCache.end()) {
             auto ySegmentFind = xSegmentFind->second.find(ySegments);
             if (ySegmentFind != xSegmentFind->second.end()) {
-                Model model = ySegmentFind->second;
-                return model;
+                return _makeModelHandle(ySegmentFind->second, options);
             }
         }
 
-        _spheresCache[xSegments] = {};
-        _spheresCache[xSegments][ySegments] = {};
-        Model& model = _spheresCache[xSegments][ySegments];
-
-        model.objects.emplace_back();
-        SceneObject& object = model.objects.back();
+        std::vector<SceneObject> objects(1);
+        SceneObject& object = objects.back();
 
         std::shared_ptr<Mesh> mesh = std::make_shared<Mesh>();
         mesh->boundingSphere = glm::vec4(0, 0, 0, 1);
         object.shape = mesh;
 
-        object.transform = options.globalTransform;
-
         object.material = _defaultMaterial;
         
         static const float PI = 3.14159265359f;
@@ -135,7 +223,19 @@ namespace leoscene {
             }
             oddRow = !oddRow;
         }
+        mesh->indexType = selectIndexType(mesh->vertices.size());
+
+        std::shared_ptr<const std::vector<SceneObject>>& objectsTable = _spheresCache[xSegments][ySegments];
+        objectsTable = std::make_shared<const std::vector<SceneObject>>(std::move(objects));
+        return _makeModelHandle(objectsTable, options);
+    }
 
+    Model ModelLoader::_makeModelHandle(const std::shared_ptr<const std::vector<SceneObject>>& objectsTable, const LoadingOptions& options)
+    {
+        Model model;
+        model.objectsTable = objectsTable;
+        model.nbObjects = static_cast<uint32_t>(objectsTable->size());
+        model.transform = options.globalTransform;
         return model;
     }
 
@@ -143,16 +243,34 @@ namespace leoscene {
         aiNode* node,
         const aiScene* aiScene,
         const std::string& fileDirectoryPath,
-        std::unordered_map<aiMaterial*, std::shared_ptr<Material>>& modelMaterials,
-        std::unordered_map<aiMesh*, std::shared_ptr<Mesh>>& modelMeshes,
+        const std::unordered_map<aiMaterial*, std::shared_ptr<Material>>& modelMaterials,
+        const std::vector<std::shared_ptr<Mesh>>& modelMeshes,
         std::vector<SceneObject>& sceneObjects,
         aiMatrix4x4 transform)
     {
         aiMatrix4x4 childTransform = node->mTransformation * transform;
+        std::shared_ptr<Transform> nodeTransform;
+        if (!childTransform.IsIdentity()) {
+            glm::mat4 glmTransform;
+            for (int i = 0; i < 16; ++i) {
+                glmTransform[i % 4][i / 4] = *childTransform[i];
+            }
+            nodeTransform = std::make_shared<Transform>(glmTransform);
+        }
+
         for (unsigned int i = 0; i < node->mNumMeshes; i++)
         {
-            aiMesh* mesh = aiScene->mMeshes[node->mMeshes[i]];
-            _processMesh(mesh, aiScene, fileDirectoryPath, modelMaterials, modelMeshes, sceneObjects, childTransform);
+            sceneObjects.push_back({});
+            SceneObject& sceneObject = sceneObjects.back();
+            sceneObject.shape = modelMeshes[node->mMeshes[i]];
+            sceneObject.transform = nodeTransform;
+
+            // There is a material attached to the mesh. Materials were made for all the meshes by _requestMaterials.
+            aiMaterial* assimpMaterial = aiScene->mMaterials[aiScene->mMeshes[node->mMeshes[i]]->mMaterialIndex];
+            auto materialIterator = modelMaterials.find(assimpMaterial);
+            if (materialIterator != modelMaterials.end()) {
+                sceneObject.material = materialIterator->second;
+            }
         }
         for (unsigned int i = 0; i < node->mNumChildren; i++)
         {
@@ -161,126 +279,119 @@ namespace leoscene {
 
     }
 
-    void ModelLoader::_processMesh(
-        aiMesh* assimpMesh,
-        const aiScene* aiScene,
-        const std::string& fileDirectoryPath,
-        std::unordered_map<aiMaterial*, std::shared_ptr<Material>>& modelMaterials,
-        std::unordered_map<aiMesh*, std::shared_ptr<Mesh>>& modelMeshes,
-        std::vector<SceneObject>& sceneObjects,
-        aiMatrix4x4 transform)
+    void ModelLoader::_processMeshes(const aiScene* aiScene, std::vector<std::shared_ptr<Mesh>>& meshes)
     {
-        sceneObjects.push_back({});
-        SceneObject& sceneObject = sceneObjects.back();
+        // The loading thread and the helper threads take the next mesh to process until there is none left.
+        // Helpers that start after all the meshes were taken return right away.
+        meshes.resize(aiScene->mNumMeshes);
+        std::atomic<size_t> nextMesh(0);
+        auto processMeshes = [this, aiScene, &meshes, &nextMesh]() {
+            for (size_t i = nextMesh++; i < meshes.size(); i = nextMesh++) {
+                meshes[i] = _processMesh(aiScene->mMeshes[i]);
+            }
+        };
 
-        if (modelMeshes.find(assimpMesh) != modelMeshes.end()) {
-            sceneObject.shape = modelMeshes[assimpMesh];
+        std::vector<std::future<void>> helpers;
+        size_t nbHelpers = _threadPool && meshes.size() > 1 ? std::min(_threadPool->getNbThreads(), meshes.size() - 1) : 0;
+        for (size_t i = 0; i < nbHelpers; ++i) {
+            helpers.push_back(_threadPool->submitHelper(processMeshes));
         }
-        else {
-            std::shared_ptr<Mesh> mesh = std::make_shared<Mesh>();
-            sceneObject.shape = mesh;
 
-            // Populate indices vector
-            std::vector<uint32_t>& indices = mesh->indices;
-            for (unsigned int i = 0; i < assimpMesh->mNumFaces; ++i)
-            {
-                const aiFace& face = assimpMesh->mFaces[i];
-                for (unsigned int j = 0; j < face.mNumIndices; ++j) {
-                    indices.push_back(face.mIndices[j]);
-                }
-            }
+        // The helpers use the local variables of this function: they are waited for even if a mesh fails on this thread.
+        std::exception_ptr error;
+        try {
+            processMeshes();
+        }
+        catch (...) {
+            error = std::current_exception();
+            nextMesh = meshes.size();
+        }
+        for (std::future<void>& helper : helpers) {
+            _threadPool->wait(helper);
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+        for (std::future<void>& helper : helpers) {
+            helper.get();
+        }
+    }
 
-            // Populate vertices vector
-            std::vector<Vertex>& vertices = mesh->vertices;
-            bool hasUv = assimpMesh->mTextureCoords[0];
-            bool hasNormals = assimpMesh->HasNormals();
-            bool hasTangents = assimpMesh->HasTangentsAndBitangents();
-            glm::vec3 minV(assimpMesh->mVertices[0].x, assimpMesh->mVertices[0].y, assimpMesh->mVertices[0].z);
-            glm::vec3 maxV(assimpMesh->mVertices[0].x, assimpMesh->mVertices[0].y, assimpMesh->mVertices[0].z);
-            for (unsigned int i = 0; i < assimpMesh->mNumVertices; ++i) {
-                const aiVector3D& v = assimpMesh->mVertices[i];
-                for (int k = 0; k < 3; ++k) {
-                    if (v[k] < minV[k]) { minV[k] = v[k]; }
-                    if (v[k] > maxV[k]) { maxV[k] = v[k]; }
-                }
-                vertices.push_back({
-                        glm::vec3(v.x, v.y, v.z),  // Position
-                        hasNormals ? glm::vec3(assimpMesh->mNormals[i].x, assimpMesh->mNormals[i].y, assimpMesh->mNormals[i].z) : glm::vec3(0, 0, 1),  // Normal or z+ by default
-                        hasTangents ? glm::vec3(assimpMesh->mTangents[i].x, assimpMesh->mTangents[i].y, assimpMesh->mTangents[i].z) : glm::vec3(1, 0, 0),  // Tangents or x+ by default
-                        hasUv ? glm::vec2(assimpMesh->mTextureCoords[0][i].x, assimpMesh->mTextureCoords[0][i].y) : glm::vec2(0, 0)  // UVs if any
-                    });
-            }
-            glm::vec3 halfway = (maxV - minV) / 2.f;
-            glm::vec3 center = minV + halfway;
-            float radius = glm::length(halfway) * 2.0f;
-            mesh->boundingSphere = glm::vec4(center, radius);
+    std::shared_ptr<Mesh> ModelLoader::_processMesh(const aiMesh* assimpMesh)
+    {
+        std::shared_ptr<Mesh> mesh = std::make_shared<Mesh>();
+
+        {
+            ScopedLoadingPhase phase(_stats, LoadingStats::Phase::MESH_CONVERSION);
+            convertMesh(*assimpMesh, *mesh);
         }
 
-        if (!transform.IsIdentity()) {
-            glm::mat4 glmTransform;
-            for (int i = 0; i < 16; ++i) {
-                glmTransform[i % 4][i / 4] = *transform[i];
-            }
-            sceneObject.transform = std::make_shared<Transform>(glmTransform);
+        if (_optimizeMeshes) {
+            ScopedLoadingPhase optimizationPhase(_stats, LoadingStats::Phase::MESH_OPTIMIZATION);
+            optimizeMesh(*mesh);
         }
 
-        // Process material
-        aiMaterial* assimpMaterial = aiScene->mMaterials[assimpMesh->mMaterialIndex];
+        // After the optimization, whose order is kept inside each cluster
+        if (_buildClusters) {
+            ScopedLoadingPhase clusteringPhase(_stats, LoadingStats::Phase::MESH_CLUSTERING);
+            buildClusters(*mesh);
+        }
 
-        // There is a material attached to the mesh
-        if (assimpMaterial) {
-            if (modelMaterials.find(assimpMaterial) == modelMaterials.end()) {  // First time seeing the material
-                // Creating the material
-                std::shared_ptr<Material> material = _loadMaterial(assimpMaterial, fileDirectoryPath);
+        // After the optimization, so that the full mesh stays first in the indices
+        if (_generateLods) {
+            ScopedLoadingPhase simplificationPhase(_stats, LoadingStats::Phase::MESH_SIMPLIFICATION);
+            generateLods(*mesh);
+        }
 
-                // Add the material to the Scene and also the cache to avoid duplicates.
-                modelMaterials[assimpMaterial] = material;
+        mesh->indexType = selectIndexType(mesh->vertices.size());
+        return mesh;
+    }
+
+    void ModelLoader::_requestMaterials(
+        const aiScene* aiScene,
+        const std::string& fileDirectoryPath,
+        std::unordered_map<aiMaterial*, std::shared_ptr<Material>>& modelMaterials,
+        std::vector<PendingTexture>& pendingTextures)
+    {
+        for (unsigned int i = 0; i < aiScene->mNumMeshes; ++i) {
+            aiMaterial* assimpMaterial = aiScene->mMaterials[aiScene->mMeshes[i]->mMaterialIndex];
+            if (assimpMaterial && modelMaterials.find(assimpMaterial) == modelMaterials.end()) {  // First time seeing the material
+                modelMaterials[assimpMaterial] = _requestMaterial(assimpMaterial, fileDirectoryPath, pendingTextures);
             }
-            sceneObject.material = modelMaterials[assimpMaterial];
         }
     }
 
-    std::shared_ptr<Material> ModelLoader::_loadMaterial(aiMaterial* assimpMaterial, const std::string& fileDirectoryPath)
+    std::shared_ptr<Material> ModelLoader::_requestMaterial(aiMaterial* assimpMaterial, const std::string& fileDirectoryPath, std::vector<PendingTexture>& pendingTextures)
     {
         // TODO: Check which material should be created using what values and textures are present.
         std::shared_ptr<PerformanceMaterial> material = std::make_shared<PerformanceMaterial>();
-        static aiTextureType textureTypes[] = {
-            aiTextureType_DIFFUSE,
-            aiTextureType_SPECULAR,
-            aiTextureType_AMBIENT,
-            aiTextureType_NORMALS,
-            aiTextureType_HEIGHT,
-        };
-        std::unordered_map<aiTextureType, std::shared_ptr<const ImageTexture>*> materialTextureSlots = {
-            { aiTextureType_DIFFUSE, &material->diffuseTexture },
-            { aiTextureType_SPECULAR, &material->specularTexture },
-            { aiTextureType_AMBIENT, &material->ambientTexture },
-            { aiTextureType_NORMALS, &material->normalsTexture },
-            { aiTextureType_HEIGHT, &material->heightTexture },
-        };
-        for (const aiTextureType& textureType : textureTypes) {
-            std::shared_ptr<ImageTexture> texture = _loadMaterialTexture(assimpMaterial, textureType, fileDirectoryPath);
-            if (texture) {
-                *materialTextureSlots[textureType] = texture;
+        std::array<std::shared_ptr<const ImageTexture>*, NB_TEXTURE_SLOTS> materialTextureSlots = getTextureSlots(*material);
+        for (size_t i = 0; i < NB_TEXTURE_SLOTS; ++i) {
+            std::string texturePath = _getMaterialTexturePath(assimpMaterial, TEXTURE_SLOT_TYPES[i], fileDirectoryPath);
+            if (texturePath.size()) {
+                pendingTextures.push_back({ materialTextureSlots[i], _requestTextureFile(texturePath, TEXTURE_SLOT_TYPES[i]), texturePath });
             }
         }
 
         return material;
     }
 
-    std::shared_ptr<ImageTexture> ModelLoader::_loadMaterialTexture(
+    std::string ModelLoader::_getMaterialTexturePath(
         aiMaterial* assimpMaterial,
         aiTextureType assimpTextureType,
         const std::string& fileDirectoryPath)
     {
         if (!assimpMaterial->GetTextureCount(assimpTextureType)) {
-            return nullptr;
+            return {};
         }
 
         aiString str;
         assimpMaterial->GetTexture(assimpTextureType, 0, &str);  // "0" for texture at index 0. The rest is ignored because unsupported by all renderers.
-        std::string texturePath = fileDirectoryPath + "/" + str.C_Str();
+        return fileDirectoryPath + "/" + str.C_Str();
+    }
 
+    TextureLoader::TextureFuture ModelLoader::_requestTextureFile(const std::string& texturePath, aiTextureType assimpTextureType)
+    {
         TextureLoader::LoadingOptions loadingOptions = {};
         if (assimpTextureType == aiTextureType_DIFFUSE ||
             assimpTextureType == aiTextureType_SPECULAR ||
@@ -293,8 +404,260 @@ namespace leoscene {
         {
             loadingOptions.desiredChannels = 1;  // Vulkan implementation in Nvidia apparently rarely supports RGB.
         }
+        loadingOptions.srgb = assimpTextureType != aiTextureType_NORMALS;
+
+        if (_compressTextures) {
+            switch (assimpTextureType) {
+            case aiTextureType_DIFFUSE:
+            case aiTextureType_AMBIENT:
+                loadingOptions.compression = ImageTexture::Compression::BC1;  // BC7 if the texture has alpha
+                break;
+            case aiTextureType_NORMALS:
+                loadingOptions.compression = ImageTexture::Compression::BC5;
+                break;
+            case aiTextureType_SPECULAR:
+            case aiTextureType_HEIGHT:
+                loadingOptions.compression = ImageTexture::Compression::BC4;
+                break;
+            default:
+                break;
+            }
+        }
+
+        return _textureLoader.requestTexture(texturePath.c_str(), loadingOptions);
+    }
+
+    std::vector<std::string> ModelLoader::_resolveTextures(std::vector<PendingTexture>& pendingTextures)
+    {
+        std::vector<std::string> failedTexturePaths;
+        for (PendingTexture& pendingTexture : pendingTextures) {
+            if (_threadPool) {
+                _threadPool->wait(pendingTexture.texture);
+            }
+            std::shared_ptr<ImageTexture> texture = pendingTexture.texture.get();
+            if (texture) {
+                *pendingTexture.slot = texture;
+            }
+            else {
+                failedTexturePaths.push_back(pendingTexture.filePath);
+            }
+        }
+        pendingTextures.clear();
+        return failedTexturePaths;
+    }
+
+    /*
+    * Asset cache entries of models contain the processed meshes, the texture paths of the materials, and the objects
+    * referencing them. Textures have their own entries (see TextureLoader).
+    */
+
+    void ModelLoader::_storeModelInAssetCache(const char* filePath, const std::vector<SceneObject>& objects, const std::vector<std::string>& dependencyFilePaths)
+    {
+        ScopedLoadingPhase phase(_stats, LoadingStats::Phase::ASSET_CACHE);
+
+        std::vector<const Mesh*> meshes;
+        std::vector<const PerformanceMaterial*> materials;
+        std::unordered_map<const Shape*, uint32_t> meshIndices;
+        std::unordered_map<const Material*, uint32_t> materialIndices;
+        for (const SceneObject& object : objects) {
+            if (meshIndices.emplace(object.shape.get(), static_cast<uint32_t>(meshes.size())).second) {
+                meshes.push_back(static_cast<const Mesh*>(object.shape.get()));
+            }
+            if (object.material && materialIndices.emplace(object.material.get(), static_cast<uint32_t>(materials.size())).second) {
+                materials.push_back(static_cast<const PerformanceMaterial*>(object.material.get()));
+            }
+        }
+
+        std::vector<unsigned char> payload;
+        AssetCacheWriter writer(payload);
+
+        writer.writeUint32(static_cast<uint32_t>(meshes.size()));
+        for (const Mesh* mesh : meshes) {
+            writer.writeUint32(static_cast<uint32_t>(mesh->vertices.size()));
+            writer.writeUint32(static_cast<uint32_t>(mesh->indices.size()));
+            writer.write(&mesh->boundingSphere, sizeof(glm::vec4));
+            writer.write(&mesh->boundingBoxMin, sizeof(glm::vec3));
+            writer.write(&mesh->boundingBoxMax, sizeof(glm::vec3));
+            writer.write(mesh->vertices.data(), mesh->vertices.size() * sizeof(Vertex));
+            writer.writeUint32(static_cast<uint32_t>(mesh->indexType));
+            if (mesh->indexType == IndexType::UINT16) {
+                std::vector<uint16_t> shortIndices(mesh->indices.begin(), mesh->indices.end());
+                writer.write(shortIndices.data(), shortIndices.size() * sizeof(uint16_t));
+            }
+            else {
+                writer.write(mesh->indices.data(), mesh->indices.size() * sizeof(uint32_t));
+            }
+            if (_generateLods) {
+                writer.writeUint32(static_cast<uint32_t>(mesh->lods.size()));
+                writer.write(mesh->lods.data(), mesh->lods.size() * sizeof(MeshLod));
+            }
+            if (_buildClusters) {
+                writer.writeUint32(static_cast<uint32_t>(mesh->clusters.size()));
+                writer.write(mesh->clusters.data(), mesh->clusters.size() * sizeof(MeshCluster));
+            }
+        }
+
+        writer.writeUint32(static_cast<uint32_t>(materials.size()));
+        for (const PerformanceMaterial* material : materials) {
+            std::array<const std::shared_ptr<const ImageTexture>*, NB_TEXTURE_SLOTS> materialTextureSlots = getTextureSlots(*material);
+            for (size_t i = 0; i < NB_TEXTURE_SLOTS; ++i) {
+                writer.writeString(_textureLoader.getTextureFilePath(materialTextureSlots[i]->get()));  // Empty for default textures
+            }
+        }
+
+        writer.writeUint32(static_cast<uint32_t>(objects.size()));
+        for (const SceneObject& object : objects) {
+            writer.writeUint32(meshIndices[object.shape.get()]);
+            writer.writeUint32(object.material ? materialIndices[object.material.get()] : UINT32_MAX);
+            writer.writeUint32(object.transform ? 1 : 0);
+            if (object.transform) {
+                writer.write(&object.transform->getMatrix(), sizeof(glm::mat4));
+            }
+        }
+
+        _assetCache->store(getModelCacheKey(filePath, _optimizeMeshes, _generateLods, _buildClusters), filePath, payload, dependencyFilePaths);
+    }
 
-        std::shared_ptr<ImageTexture> texture = _textureLoader.loadTexture(texturePath.c_str(), loadingOptions);
-        return texture;
+    bool ModelLoader::_loadModelFromAssetCache(const char* filePath, std::vector<SceneObject>& modelObjects)
+    {
+        ScopedLoadingPhase phase(_stats, LoadingStats::Phase::ASSET_CACHE);
+
+        MappedFile file;
+        const unsigned char* payload = nullptr;
+        size_t payloadSize = 0;
+        if (!_assetCache->find(getModelCacheKey(filePath, _optimizeMeshes, _generateLods, _buildClusters), filePath, file, payload, payloadSize)) {
+            return false;
+        }
+        AssetCacheReader reader(payload, payloadSize);
+
+        uint32_t nbMeshes = 0;
+        if (!reader.readUint32(nbMeshes) || nbMeshes > payloadSize) {
+            return false;
+        }
+        std::vector<std::shared_ptr<Mesh>> meshes(nbMeshes);
+        for (std::shared_ptr<Mesh>& mesh : meshes) {
+            uint32_t nbVertices = 0, nbIndices = 0;
+            if (!reader.readUint32(nbVertices) || !reader.readUint32(nbIndices) ||
+                uint64_t(nbVertices) * sizeof(Vertex) + uint64_t(nbIndices) * sizeof(uint16_t) > payloadSize)  // Smallest size of the mesh
+            {
+                return false;
+            }
+            mesh = std::make_shared<Mesh>(nbVertices, nbIndices);
+            uint32_t indexType = 0;
+            if (!reader.read(&mesh->boundingSphere, sizeof(glm::vec4)) ||
+                !reader.read(&mesh->boundingBoxMin, sizeof(glm::vec3)) ||
+                !reader.read(&mesh->boundingBoxMax, sizeof(glm::vec3)) ||
+                !reader.read(mesh->vertices.data(), nbVertices * sizeof(Vertex)) ||
+                !reader.readUint32(indexType) ||
+                indexType != static_cast<uint32_t>(selectIndexType(nbVertices)))
+            {
+                return false;
+            }
+            mesh->indexType = static_cast<IndexType>(indexType);
+            if (mesh->indexType == IndexType::UINT16) {
+                std::vector<uint16_t> shortIndices(nbIndices);
+                if (!reader.read(shortIndices.data(), nbIndices * sizeof(uint16_t))) {
+                    return false;
+                }
+                std::copy(shortIndices.begin(), shortIndices.end(), mesh->indices.begin());
+            }
+            else if (!reader.read(mesh->indices.data(), nbIndices * sizeof(uint32_t))) {
+                return false;
+            }
+            if (_generateLods) {
+                uint32_t nbLods = 0;
+                if (!reader.readUint32(nbLods) || nbLods > MAX_MESH_LODS) {
+                    return false;
+                }
+                mesh->lods.resize(nbLods);
+                if (!reader.read(mesh->lods.data(), nbLods * sizeof(MeshLod))) {
+                    return false;
+                }
+                for (const MeshLod& lod : mesh->lods) {
+                    if (uint64_t(lod.firstIndex) + lod.nbIndices > nbIndices) {
+                        return false;
+                    }
+                }
+            }
+            if (_buildClusters) {
+                uint32_t nbClusters = 0;
+                if (!reader.readUint32(nbClusters) || nbClusters > nbIndices / 3) {
+                    return false;
+                }
+                mesh->clusters.resize(nbClusters);
+                if (!reader.read(mesh->clusters.data(), nbClusters * sizeof(MeshCluster))) {
+                    return false;
+                }
+                for (const MeshCluster& cluster : mesh->clusters) {
+                    if (uint64_t(cluster.firstIndex) + cluster.nbIndices > nbIndices) {
+                        return false;
+                    }
+                }
+            }
+        }
+
+        uint32_t nbMaterials = 0;
+        if (!reader.readUint32(nbMaterials) || nbMaterials > payloadSize) {
+            return false;
+        }
+        // All the textures are requested before waiting for any, so that they are loaded in parallel
+        std::vector<std::shared_ptr<PerformanceMaterial>> materials(nbMaterials);
+        std::vector<PendingTexture> pendingTextures;
+        for (std::shared_ptr<PerformanceMaterial>& material : materials) {
+            material = std::make_shared<PerformanceMaterial>();
+            std::array<std::shared_ptr<const ImageTexture>*, NB_TEXTURE_SLOTS> materialTextureSlots = getTextureSlots(*material);
+            for (size_t i = 0; i < NB_TEXTURE_SLOTS; ++i) {
+                std::string texturePath;
+                if (!reader.readString(texturePath)) {
+                    return false;
+                }
+                if (texturePath.size()) {
+                    pendingTextures.push_back({ materialTextureSlots[i], _requestTextureFile(texturePath, TEXTURE_SLOT_TYPES[i]), texturePath });
+                }
+            }
+        }
+
+        uint32_t nbObjects = 0;
+        if (!reader.readUint32(nbObjects) || nbObjects > payloadSize) {
+            return false;
+        }
+        std::vector<SceneObject> objects(nbObjects);
+        for (SceneObject& object : objects) {
+            uint32_t meshIndex = 0, materialIndex = 0, hasTransform = 0;
+            if (!reader.readUint32(meshIndex) || !reader.readUint32(materialIndex) || !reader.readUint32(hasTransform) ||
+                meshIndex >= nbMeshes || (materialIndex != UINT32_MAX && materialIndex >= nbMaterials))
+            {
+                return false;
+            }
+            object.shape = meshes[meshIndex];
+            if (materialIndex != UINT32_MAX) {
+                object.material = materials[materialIndex];
+            }
+            if (hasTransform) {
+                glm::mat4 matrix;
+                if (!reader.read(&matrix, sizeof(glm::mat4))) {
+                    return false;
+                }
+                object.transform = std::make_shared<Transform>(matrix);
+            }
+        }
+
+        _resolveTextures(pendingTextures);
+        modelObjects = std::move(objects);
+        return true;
+    }
+
+    namespace {
+        template<typename MaterialType>
+        auto getTextureSlots(MaterialType& material) -> std::array<decltype(&material.diffuseTexture), NB_TEXTURE_SLOTS>
+        {
+            return { &material.diffuseTexture, &material.specularTexture, &material.ambientTexture, &material.normalsTexture, &material.heightTexture };
+        }
+
+        std::string getModelCacheKey(const char* filePath, bool optimizedMeshes, bool lods, bool clusters)
+        {
+            // Each set of processing options has its own entries, and MODEL_CACHE_VERSION leaves out the entries of older layouts.
+            return std::string(optimizedMeshes ? "optimized " : "") + (lods ? "lod " : "") + (clusters ? "clustered " : "") + "model v" + std::to_string(MODEL_CACHE_VERSION) + ":" + filePath;
+        }
     }
 }
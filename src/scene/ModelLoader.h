@@ -1,66 +1,151 @@
 #pragma once
 
 #include "TextureLoader.h"
+#include "AssetCache.h"
+#include "LoadingStats.h"
+#include "Transform.h"
+#include "SceneObject.h"
+#include "ThreadPool.h"
 
 #include <assimp/scene.h>
 
 #include <unordered_map>
 #include <memory>
+#include <mutex>
 
 namespace leoscene {
-	struct SceneObject;
-	class Transform;
 	class Material;
 	class Mesh;
 
+	/*
+	* Lightweight handle on a loaded model: a range of sub-objects in an immutable table shared by all the handles
+	* of the model, plus the transform of this instance of the model. Copying a handle copies no sub-object.
+	*/
 	struct Model {
-		std::vector<SceneObject> objects;
+		std::shared_ptr<const std::vector<SceneObject>> objectsTable;
+		uint32_t firstObject = 0;
+		uint32_t nbObjects = 0;
+		glm::mat4 transform = glm::mat4(1);  // Applied on top of the sub-objects' transforms, which are relative to the model
+
+		size_t size() const { return nbObjects; }
+		bool empty() const { return !nbObjects; }
+		const SceneObject* begin() const { return objectsTable ? objectsTable->data() + firstObject : nullptr; }
+		const SceneObject* end() const { return begin() + nbObjects; }
+		const SceneObject& operator[](size_t i) const { return (*objectsTable)[firstObject + i]; }
+
+		// Matrix of a sub-object for this instance of the model
+		glm::mat4 getObjectMatrix(size_t i) const {
+			const Transform* objectTransform = (*this)[i].transform.get();
+			return objectTransform ? transform * objectTransform->getMatrix() : transform;
+		}
 	};
 
+	/*
+	* Loads models and caches them by file path. Models can be loaded from several threads at the same time.
+	*/
 	class ModelLoader {
 	public:
 		struct LoadingOptions {
-			std::shared_ptr<const Transform> globalTransform = std::make_shared<Transform>();
+			glm::mat4 globalTransform = glm::mat4(1);  // Transform of the returned handle
 		};
 
 	public:
 		ModelLoader();
 
 	public:
-		const Model loadModel(const char* filePath, LoadingOptions options = {});
-		const Model loadSphereModel(uint32_t xSegments, uint32_t ySegments, LoadingOptions options = {});
+		// Models are processed once per file. Later calls return a new handle on the same sub-objects.
+		Model loadModel(const char* filePath, LoadingOptions options = {});
+		Model loadSphereModel(uint32_t xSegments, uint32_t ySegments, LoadingOptions options = {});
+
+		// Processed models and textures are read from and written to the given cache. nullptr disables the cache.
+		void setAssetCache(std::shared_ptr<const AssetCache> assetCache);
+
+		// Time and allocations of the loading phases are added to the given stats. nullptr disables the measures.
+		void setLoadingStats(LoadingStats* stats);
+
+		// Reordering of the triangles and vertices of imported meshes for the GPU (see MeshOptimizer.h). Enabled by default.
+		void setMeshOptimization(bool enabled);
+
+		// Generation of simplified levels of detail for the imported meshes (see MeshSimplifier.h). Enabled by default.
+		void setLodGeneration(bool enabled);
+
+		// Decomposition of the full imported meshes into clusters with their own bounds (see MeshClusters.h). Enabled by default.
+		void setClusterGeneration(bool enabled);
+
+		// Block compression of the textures with their mip levels (see TextureCompression.h). Enabled by default.
+		void setTextureCompression(bool enabled);
+
+		// The meshes of a model are processed by the thread loading the model and by helper tasks of this pool, and the textures
+		// are decoded and processed on helper tasks while the meshes of their model are processed (see ThreadPool). The models can
+		// be loaded by tasks of the same pool. nullptr by default: the textures are loaded first, then the meshes one after another.
+		void setThreadPool(std::shared_ptr<ThreadPool> threadPool);
+
+	private:
+		// Texture being loaded for a slot of a material
+		struct PendingTexture {
+			std::shared_ptr<const ImageTexture>* slot = nullptr;
+			TextureLoader::TextureFuture texture;
+			std::string filePath;
+		};
 
 	private:
 		void _processNode(
 			aiNode* node,
 			const aiScene* aiScene,
 			const std::string& fileDirectoryPath,
-			std::unordered_map<aiMaterial*, std::shared_ptr<Material>>& modelMaterials,
-			std::unordered_map<aiMesh*, std::shared_ptr<Mesh>>& modelMeshes,
+			const std::unordered_map<aiMaterial*, std::shared_ptr<Material>>& modelMaterials,
+			const std::vector<std::shared_ptr<Mesh>>& modelMeshes,
 			std::vector<SceneObject>& sceneObjects,
 			aiMatrix4x4 transform);
 
-		void _processMesh(
-			aiMesh* assimpMesh,
+		// Processes all the meshes of the scene, indexed like aiScene->mMeshes
+		void _processMeshes(const aiScene* aiScene, std::vector<std::shared_ptr<Mesh>>& meshes);
+
+		// Conversion, then optimization, clusters and levels of detail depending on the options
+		std::shared_ptr<Mesh> _processMesh(const aiMesh* assimpMesh);
+
+		// Makes the materials of all the meshes of the scene. Their textures are requested, and set by _resolveTextures.
+		void _requestMaterials(
 			const aiScene* aiScene,
 			const std::string& fileDirectoryPath,
-			std::unordered_map<aiMaterial*, std::shared_ptr<Material>>& model_materials,
-			std::unordered_map<aiMesh*, std::shared_ptr<Mesh>>& modelMeshes,
-			std::vector<SceneObject>& sceneObjects,
-			aiMatrix4x4 transform);
+			std::unordered_map<aiMaterial*, std::shared_ptr<Material>>& modelMaterials,
+			std::vector<PendingTexture>& pendingTextures);
 
-		std::shared_ptr<Material> _loadMaterial(aiMaterial* assimpMaterial, const std::string& fileDirectoryPath);
+		std::shared_ptr<Material> _requestMaterial(aiMaterial* assimpMaterial, const std::string& fileDirectoryPath, std::vector<PendingTexture>& pendingTextures);
 
-		std::shared_ptr<ImageTexture> _loadMaterialTexture(
+		// Empty if the material has no texture of this type
+		static std::string _getMaterialTexturePath(
 			aiMaterial* assimpMaterial,
 			aiTextureType assimpTextureType,
 			const std::string& fileDirectoryPath);
 
+		TextureLoader::TextureFuture _requestTextureFile(const std::string& texturePath, aiTextureType assimpTextureType);
+
+		// Waits for the requested textures and sets them in the slots of their materials. Returns the paths of the textures
+		// that could not be loaded, whose slots keep their default texture.
+		std::vector<std::string> _resolveTextures(std::vector<PendingTexture>& pendingTextures);
+
+		// The entry depends on the other files read to make the model (see RecordingIOSystem), and on the textures that
+		// could not be loaded: the model is processed again when one of them is added, modified or removed.
+		void _storeModelInAssetCache(const char* filePath, const std::vector<SceneObject>& objects, const std::vector<std::string>& dependencyFilePaths);
+		bool _loadModelFromAssetCache(const char* filePath, std::vector<SceneObject>& objects);
+
+		static Model _makeModelHandle(const std::shared_ptr<const std::vector<SceneObject>>& objectsTable, const LoadingOptions& options);
+
 	private:
-		std::unordered_map<std::string, Model> _modelsCache;
-		std::unordered_map<uint32_t, std::unordered_map<uint32_t, Model>> _spheresCache;
+		std::unordered_map<std::string, std::shared_ptr<const std::vector<SceneObject>>> _modelsCache;
+		std::unordered_map<uint32_t, std::unordered_map<uint32_t, std::shared_ptr<const std::vector<SceneObject>>>> _spheresCache;
+		std::mutex _modelsCacheMutex;
+		std::mutex _spheresCacheMutex;
 		const std::shared_ptr<Material> _defaultMaterial;
 		TextureLoader _textureLoader;
+		std::shared_ptr<const AssetCache> _assetCache;
+		LoadingStats* _stats = nullptr;
+		bool _optimizeMeshes = true;
+		bool _generateLods = true;
+		bool _buildClusters = true;
+		bool _compressTextures = true;
+		std::shared_ptr<ThreadPool> _threadPool;  // nullptr when the meshes and textures are processed on the loading thread only
 
 	};
 }
@@ -0,0 +1,116 @@
+#include "PackedVertex.h"
+
+#include <glm/gtc/packing.hpp>
+
+namespace leoscene {
+	namespace {
+		// Octahedral encoding of a direction, in [-1, 1]^2. A null vector gives (0, 0), decoded as z+.
+		glm::vec2 encodeOctahedral(const glm::vec3& direction);
+		glm::vec3 decodeOctahedral(const glm::vec2& encoded);
+
+		// -1 or 1. Directions on the axes must not fold to 0.
+		glm::vec2 signNotZero(const glm::vec2& v);
+	}
+
+	VertexQuantization computeVertexQuantization(const Vertex* vertices, size_t nbVertices)
+	{
+		VertexQuantization quantization;
+		if (!nbVertices) {
+			return quantization;
+		}
+
+		glm::vec3 minPosition = vertices[0].position;
+		glm::vec3 maxPosition = vertices[0].position;
+		for (size_t i = 1; i < nbVertices; ++i) {
+			minPosition = glm::min(minPosition, vertices[i].position);
+			maxPosition = glm::max(maxPosition, vertices[i].position);
+		}
+		quantization.positionOffset = minPosition;
+		quantization.positionScale = maxPosition - minPosition;
+		return quantization;
+	}
+
+	void packVertices(
+		const Vertex* vertices,
+		size_t nbVertices,
+		const VertexQuantization& quantization,
+		PackedVertexPosition* packedPositions,
+		PackedVertexAttributes* packedAttributes)
+	{
+		// Flat axes (a planar mesh) are packed as 0.
+		glm::vec3 inverseScale(0);
+		for (int k = 0; k < 3; ++k) {
+			inverseScale[k] = quantization.positionScale[k] > 0 ? 1.f / quantization.positionScale[k] : 0.f;
+		}
+
+		for (size_t i = 0; i < nbVertices; ++i) {
+			const Vertex& vertex = vertices[i];
+			PackedVertexPosition& packedPosition = packedPositions[i];
+			PackedVertexAttributes& packedVertexAttributes = packedAttributes[i];
+
+			glm::vec3 normalizedPosition = (vertex.position - quantization.positionOffset) * inverseScale;
+			for (int k = 0; k < 3; ++k) {
+				packedPosition.position[k] = glm::packUnorm1x16(normalizedPosition[k]);
+			}
+			packedPosition.position[3] = 0;
+
+			glm::vec2 normal = encodeOctahedral(vertex.normal);
+			glm::vec2 tangent = encodeOctahedral(vertex.tangent);
+			for (int k = 0; k < 2; ++k) {
+				packedVertexAttributes.normal[k] = static_cast<int16_t>(glm::packSnorm1x16(normal[k]));
+				packedVertexAttributes.tangent[k] = static_cast<int16_t>(glm::packSnorm1x16(tangent[k]));
+				packedVertexAttributes.uv[k] = glm::packHalf1x16(vertex.uv[k]);
+			}
+		}
+	}
+
+	Vertex unpackVertex(const PackedVertexPosition& packedPosition, const PackedVertexAttributes& packedAttributes, const VertexQuantization& quantization)
+	{
+		Vertex vertex;
+		for (int k = 0; k < 3; ++k) {
+			vertex.position[k] = quantization.positionOffset[k] + glm::unpackUnorm1x16(packedPosition.position[k]) * quantization.positionScale[k];
+		}
+		glm::vec2 normal, tangent;
+		for (int k = 0; k < 2; ++k) {
+			normal[k] = glm::unpackSnorm1x16(static_cast<uint16_t>(packedAttributes.normal[k]));
+			tangent[k] = glm::unpackSnorm1x16(static_cast<uint16_t>(packedAttributes.tangent[k]));
+			vertex.uv[k] = glm::unpackHalf1x16(packedAttributes.uv[k]);
+		}
+		vertex.normal = decodeOctahedral(normal);
+		vertex.tangent = decodeOctahedral(tangent);
+		return vertex;
+	}
+
+	namespace {
+		glm::vec2 encodeOctahedral(const glm::vec3& direction)
+		{
+			float norm1 = glm::abs(direction.x) + glm::abs(direction.y) + glm::abs(direction.z);
+			if (norm1 <= 0) {
+				return glm::vec2(0);
+			}
+			glm::vec3 octahedron = direction / norm1;
+			glm::vec2 encoded(octahedron.x, octahedron.y);
+			if (octahedron.z < 0) {
+				// Lower half folded over the diagonals
+				encoded = (1.f - glm::abs(glm::vec2(encoded.y, encoded.x))) * signNotZero(encoded);
+			}
+			return encoded;
+		}
+
+		glm::vec3 decodeOctahedral(const glm::vec2& encoded)
+		{
+			glm::vec3 direction(encoded.x, encoded.y, 1.f - glm::abs(encoded.x) - glm::abs(encoded.y));
+			if (direction.z < 0) {
+				glm::vec2 unfolded = (1.f - glm::abs(glm::vec2(direction.y, direction.x))) * signNotZero(glm::vec2(direction));
+				direction.x = unfolded.x;
+				direction.y = unfolded.y;
+			}
+			return glm::normalize(direction);
+		}
+
+		glm::vec2 signNotZero(const glm::vec2& v)
+		{
+			return glm::vec2(v.x >= 0 ? 1.f : -1.f, v.y >= 0 ? 1.f : -1.f);
+		}
+	}
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "Vertex.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace leoscene {
+	/*
+	* Compact vertex layout uploaded to the GPU, decoded by the vertex shaders (see shader.vert).
+	* Positions and the other attributes are two separate streams, so that depth-only passes only read the positions.
+	* 8 + 12 bytes per vertex instead of 48 for Vertex.
+	*/
+
+	// 16 bits unsigned normalized per axis, relative to the bounds of the mesh (see VertexQuantization). w is unused:
+	// 3 components 16 bits formats are rarely supported for vertex buffers.
+	struct PackedVertexPosition {
+		uint16_t position[4] = { 0, 0, 0, 0 };
+	};
+	static_assert(sizeof(PackedVertexPosition) == 8, "PackedVertexPosition must match the vertex input attributes of the renderer");
+
+	// Normal and tangent in octahedral encoding, 16 bits signed normalized per component. Half float UVs.
+	struct PackedVertexAttributes {
+		int16_t normal[2] = { 0, 0 };
+		int16_t tangent[2] = { 0, 0 };
+		uint16_t uv[2] = { 0, 0 };
+	};
+	static_assert(sizeof(PackedVertexAttributes) == 12, "PackedVertexAttributes must match the vertex input attributes of the renderer");
+
+	// Object space position = offset + packed position * scale
+	struct VertexQuantization {
+		glm::vec3 positionOffset = glm::vec3(0);
+		glm::vec3 positionScale = glm::vec3(1);
+	};
+
+	// Quantization covering the bounding box of the vertices.
+	VertexQuantization computeVertexQuantization(const Vertex* vertices, size_t nbVertices);
+
+	void packVertices(
+		const Vertex* vertices,
+		size_t nbVertices,
+		const VertexQuantization& quantization,
+		PackedVertexPosition* packedPositions,
+		PackedVertexAttributes* packedAttributes);
+
+	// Same decoding as the vertex shader. For tools and tests.
+	Vertex unpackVertex(const PackedVertexPosition& packedPosition, const PackedVertexAttributes& packedAttributes, const VertexQuantization& quantization);
+}
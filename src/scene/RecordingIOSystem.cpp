@@ -0,0 +1,116 @@
+#include "RecordingIOSystem.h"
+
+#include <assimp/IOStream.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+
+namespace leoscene {
+	namespace {
+		// Stream on a file opened with the C library, as with the default file system of Assimp
+		class FileStream : public Assimp::IOStream {
+		public:
+			FileStream(std::FILE* file);
+			~FileStream() override;
+
+		public:
+			size_t Read(void* buffer, size_t size, size_t count) override;
+			size_t Write(const void* buffer, size_t size, size_t count) override;
+			aiReturn Seek(size_t offset, aiOrigin origin) override;
+			size_t Tell() const override;
+			size_t FileSize() const override;
+			void Flush() override;
+
+		private:
+			std::FILE* _file = nullptr;
+		};
+	}
+
+	bool RecordingIOSystem::Exists(const char* filePath) const
+	{
+		_recordFilePath(filePath);
+		std::error_code error;
+		return std::filesystem::exists(filePath, error);
+	}
+
+	char RecordingIOSystem::getOsSeparator() const
+	{
+		return '/';
+	}
+
+	Assimp::IOStream* RecordingIOSystem::Open(const char* filePath, const char* mode)
+	{
+		_recordFilePath(filePath);
+		std::FILE* file = std::fopen(filePath, mode);
+		return file ? new FileStream(file) : nullptr;
+	}
+
+	void RecordingIOSystem::Close(Assimp::IOStream* file)
+	{
+		delete file;
+	}
+
+	const std::vector<std::string>& RecordingIOSystem::getFilePaths() const
+	{
+		return _filePaths;
+	}
+
+	void RecordingIOSystem::clearFilePaths()
+	{
+		_filePaths.clear();
+	}
+
+	void RecordingIOSystem::_recordFilePath(const char* filePath) const
+	{
+		if (std::find(_filePaths.begin(), _filePaths.end(), filePath) == _filePaths.end()) {
+			_filePaths.push_back(filePath);
+		}
+	}
+
+	namespace {
+		FileStream::FileStream(std::FILE* file) : _file(file)
+		{
+		}
+
+		FileStream::~FileStream()
+		{
+			std::fclose(_file);
+		}
+
+		size_t FileStream::Read(void* buffer, size_t size, size_t count)
+		{
+			return std::fread(buffer, size, count, _file);
+		}
+
+		size_t FileStream::Write(const void* buffer, size_t size, size_t count)
+		{
+			return std::fwrite(buffer, size, count, _file);
+		}
+
+		aiReturn FileStream::Seek(size_t offset, aiOrigin origin)
+		{
+			int whence = origin == aiOrigin_SET ? SEEK_SET : origin == aiOrigin_CUR ? SEEK_CUR : SEEK_END;
+			return std::fseek(_file, static_cast<long>(offset), whence) ? aiReturn_FAILURE : aiReturn_SUCCESS;  // Negative offsets wrap around in size_t
+		}
+
+		size_t FileStream::Tell() const
+		{
+			return static_cast<size_t>(std::ftell(_file));
+		}
+
+		size_t FileStream::FileSize() const
+		{
+			long position = std::ftell(_file);
+			std::fseek(_file, 0, SEEK_END);
+			long size = std::ftell(_file);
+			std::fseek(_file, position, SEEK_SET);
+			return static_cast<size_t>(size);
+		}
+
+		void FileStream::Flush()
+		{
+			std::fflush(_file);
+		}
+	}
+}
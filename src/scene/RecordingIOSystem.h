@@ -0,0 +1,32 @@
+#pragma once
+
+#include <assimp/IOSystem.hpp>
+
+#include <string>
+#include <vector>
+
+namespace leoscene {
+	/*
+	* File system of an Assimp importer that reads files like the default one, and records the paths of all the files
+	* the importer tried to open, found or not (for example the .mtl files of .obj models). The asset cache entries of
+	* models are validated against them, in addition to the model file itself.
+	*/
+	class RecordingIOSystem : public Assimp::IOSystem {
+	public:
+		bool Exists(const char* filePath) const override;
+		char getOsSeparator() const override;
+		Assimp::IOStream* Open(const char* filePath, const char* mode) override;
+		void Close(Assimp::IOStream* file) override;
+
+	public:
+		// Paths in the order of their first access, each path once.
+		const std::vector<std::string>& getFilePaths() const;
+		void clearFilePaths();
+
+	private:
+		void _recordFilePath(const char* filePath) const;
+
+	private:
+		mutable std::vector<std::string> _filePaths;  // Exists() is const
+	};
+}
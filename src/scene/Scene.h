@@ -1,16 +1,48 @@
 #pragma once
 
-#include "Scene.h"
-#include "SceneObject.h"
+#include "GeometryIncludes.h"
 
+#include <cstdint>
+#include <memory>
 #include <vector>
 
 namespace leoscene {
 	class Light;
+	class Material;
+	class Shape;
 
+	// Objects replaced by a single proxy object when they are far enough (see HlodBuilder.h).
+	// Meant for static objects: the proxy does not follow the members that move.
+	struct HlodCluster {
+		glm::vec4 boundingSphere = glm::vec4(0);  // World space, containing the members and the proxy
+		float error = 0;  // Largest distance between the proxy and the members, in world space
+		uint32_t proxyObject = 0;  // Index of the proxy in the per-object arrays
+		uint32_t firstMember = 0;  // In Scene::hlodMembers
+		uint32_t nbMembers = 0;
+	};
+
+	/*
+	* Flat scene database. Shapes and materials are stored once in tables. Each object of the scene is one entry
+	* in the per-object arrays, which all have the same size and are indexed the same way.
+	*/
 	class Scene {
 	public:
-		std::vector<SceneObject> objects;
+		size_t getNbObjects() const { return worldMatrices.size(); }
+
+	public:
+		// Shared tables
+		std::vector<std::shared_ptr<const Shape>> shapes;
+		std::vector<std::shared_ptr<const Material>> materials;
+
+		// Per-object arrays
+		std::vector<glm::mat4> worldMatrices;
+		std::vector<uint32_t> shapeIndices;
+		std::vector<uint32_t> materialIndices;
+
+		// Hierarchical levels of detail. Empty when they were not built. An object is a member of one cluster at most.
+		std::vector<HlodCluster> hlodClusters;
+		std::vector<uint32_t> hlodMembers;  // Objects of each cluster, one cluster after another
+
 		std::vector<std::shared_ptr<Light>> lights;
 	};
 }
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+
+/*
+* On-disk layout of compiled (binary) scene files.
+*
+* The file starts with a BinarySceneHeader, followed by tables whose offsets are given in the header. All tables
+* are 16 bytes aligned so they can be read in place from a memory-mapped file:
+*	- Models: BinarySceneModelEntry[nbModels]
+*	- Transforms: BinarySceneTransformEntry[nbTransforms] (index 0 is the identity)
+*	- Instances: BinarySceneInstanceEntry[nbInstances]
+*	- Strings: model paths, not null-terminated, referenced by offset and length.
+*
+* Binary scenes are generated from the text format with LeoSceneCompiler (see SceneLoader::compileScene).
+*/
+namespace leoscene {
+	namespace binaryscene {
+		static const char MAGIC[4] = { 'L', 'E', 'O', 'S' };
+		static const uint32_t VERSION = 2;
+		static const uint32_t TABLE_ALIGNMENT = 16;
+
+		enum HeaderFlags : uint32_t {
+			HAS_CAMERA = 1 << 0,
+		};
+
+		struct BinarySceneHeader {
+			char magic[4];
+			uint32_t version;
+			uint32_t flags;
+			float camera[7];  // Position, target, fov in degrees
+			uint32_t nbModels;
+			uint32_t nbTransforms;
+			uint32_t nbInstances;
+			uint32_t padding;
+			uint64_t modelsOffset;
+			uint64_t transformsOffset;
+			uint64_t instancesOffset;
+			uint64_t stringsOffset;
+			uint64_t stringsSize;
+		};
+
+		struct BinarySceneModelEntry {
+			uint32_t pathOffset;  // Relative to the start of the strings table
+			uint32_t pathLength;
+			uint32_t xSegments;  // Non-zero for sphere models only
+			uint32_t ySegments;
+		};
+
+		struct BinarySceneTransformEntry {
+			float matrix[16];  // Column-major, like glm::mat4
+		};
+
+		struct BinarySceneInstanceEntry {
+			uint32_t modelIndex;
+			uint32_t transformIndex;
+		};
+
+		static_assert(sizeof(BinarySceneHeader) == 96, "Binary scene header layout changed. Bump VERSION.");
+		static_assert(sizeof(BinarySceneModelEntry) == 16, "Binary scene model entry layout changed. Bump VERSION.");
+		static_assert(sizeof(BinarySceneTransformEntry) == 64, "Binary scene transform entry layout changed. Bump VERSION.");
+		static_assert(sizeof(BinarySceneInstanceEntry) == 8, "Binary scene instance entry layout changed. Bump VERSION.");
+	}
+}
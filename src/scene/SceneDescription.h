@@ -0,0 +1,43 @@
+#pragma once
+
+#include "GeometryIncludes.h"
+
+#include <string>
+#include <vector>
+
+namespace leoscene {
+	/*
+	* Flat tables describing the content of a scene file, before any model is loaded.
+	* Produced by parsing a text .scene file, and written as-is in the binary scene format.
+	*/
+	struct SceneDescription {
+		struct CameraEntry {
+			glm::vec3 position = glm::vec3(0);
+			glm::vec3 target = glm::vec3(1, 0, 0);
+			float fov = 90.f;  // In degrees
+		};
+
+		struct ModelEntry {
+			std::string path;  // Relative to the scene file's directory
+			uint32_t xSegments = 0;  // Only used by sphere models ("__sphere" paths)
+			uint32_t ySegments = 0;
+
+			bool isSphere() const { return xSegments && ySegments; }
+		};
+
+		struct TransformEntry {
+			glm::mat4 matrix = glm::mat4(1);
+		};
+
+		struct InstanceEntry {
+			uint32_t modelIndex = 0;
+			uint32_t transformIndex = 0;
+		};
+
+		bool hasCamera = false;
+		CameraEntry camera;
+		std::vector<ModelEntry> models;
+		std::vector<TransformEntry> transforms;  // Index 0 is always the identity. Procedural instances (grid, scatter) have unnamed entries.
+		std::vector<InstanceEntry> instances;
+	};
+}
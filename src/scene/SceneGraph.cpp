@@ -0,0 +1,103 @@
+#include "SceneGraph.h"
+
+#include "BatchTransforms.h"
+
+namespace leoscene {
+	uint32_t SceneGraph::addNode(const glm::mat4& localMatrix, uint32_t parent, uint32_t objectIndex, bool dirty)
+	{
+		uint32_t node = static_cast<uint32_t>(_localMatrices.size());
+		_localMatrices.push_back(localMatrix);
+		_worldMatrices.push_back(parent == NO_NODE ? localMatrix : _worldMatrices[parent] * localMatrix);
+		_parents.push_back(parent);
+		_firstChildren.push_back(NO_NODE);
+		_nextSiblings.push_back(NO_NODE);
+		_objectIndices.push_back(objectIndex);
+		_dirtyFlags.push_back(dirty);
+		if (dirty) {
+			_dirtyNodes.push_back(node);
+		}
+
+		// Children are kept in a linked list. The order of siblings does not matter, so the new node goes first.
+		if (parent != NO_NODE) {
+			_nextSiblings[node] = _firstChildren[parent];
+			_firstChildren[parent] = node;
+		}
+
+		return node;
+	}
+
+	void SceneGraph::setLocalMatrix(uint32_t node, const glm::mat4& localMatrix)
+	{
+		_localMatrices[node] = localMatrix;
+		if (!_dirtyFlags[node]) {
+			_dirtyFlags[node] = 1;
+			_dirtyNodes.push_back(node);
+		}
+	}
+
+	const glm::mat4& SceneGraph::getLocalMatrix(uint32_t node) const
+	{
+		return _localMatrices[node];
+	}
+
+	const glm::mat4& SceneGraph::getWorldMatrix(uint32_t node) const
+	{
+		return _worldMatrices[node];
+	}
+
+	uint32_t SceneGraph::getParent(uint32_t node) const
+	{
+		return _parents[node];
+	}
+
+	uint32_t SceneGraph::getObjectIndex(uint32_t node) const
+	{
+		return _objectIndices[node];
+	}
+
+	void SceneGraph::update(std::vector<uint32_t>& changedObjects, std::vector<glm::mat4>& changedMatrices)
+	{
+		for (uint32_t dirtyNode : _dirtyNodes) {
+			// Already updated with the subtree of a dirty ancestor, or will be.
+			if (!_dirtyFlags[dirtyNode] || _hasDirtyAncestor(dirtyNode)) {
+				continue;
+			}
+
+			_traversalStack.clear();
+			_traversalStack.push_back(dirtyNode);
+			while (!_traversalStack.empty()) {
+				uint32_t node = _traversalStack.back();
+				_traversalStack.pop_back();
+
+				uint32_t parent = _parents[node];
+				if (parent == NO_NODE) {
+					_worldMatrices[node] = _localMatrices[node];
+				}
+				else {
+					multiplyAffineMatrices(&_worldMatrices[parent], &_localMatrices[node], &_worldMatrices[node], 1);
+				}
+				_dirtyFlags[node] = 0;
+
+				if (_objectIndices[node] != NO_OBJECT) {
+					changedObjects.push_back(_objectIndices[node]);
+					changedMatrices.push_back(_worldMatrices[node]);
+				}
+
+				for (uint32_t child = _firstChildren[node]; child != NO_NODE; child = _nextSiblings[child]) {
+					_traversalStack.push_back(child);
+				}
+			}
+		}
+		_dirtyNodes.clear();
+	}
+
+	bool SceneGraph::_hasDirtyAncestor(uint32_t node) const
+	{
+		for (uint32_t parent = _parents[node]; parent != NO_NODE; parent = _parents[parent]) {
+			if (_dirtyFlags[parent]) {
+				return true;
+			}
+		}
+		return false;
+	}
+}
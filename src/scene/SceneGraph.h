@@ -0,0 +1,60 @@
+#pragma once
+
+#include "GeometryIncludes.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace leoscene {
+	/*
+	* Hierarchy of transforms for the objects that move after loading. Each node has an affine matrix relative to its parent,
+	* and can drive the world matrix of one object of the scene.
+	* Changing a node marks it dirty. update() then recomputes the world matrices of the dirty subtrees only,
+	* and reports the objects that moved so that their data can be uploaded again.
+	*/
+	class SceneGraph {
+	public:
+		static constexpr uint32_t NO_NODE = UINT32_MAX;
+		static constexpr uint32_t NO_OBJECT = UINT32_MAX;
+
+	public:
+		// Adds a node under the given parent (or as a root). The object index is the index of the object in the renderer,
+		// in the order the objects were loaded. The node starts dirty so that its object is reported by the next update,
+		// unless the object was loaded with the world matrix of the node already.
+		uint32_t addNode(const glm::mat4& localMatrix, uint32_t parent = NO_NODE, uint32_t objectIndex = NO_OBJECT, bool dirty = true);
+
+		void setLocalMatrix(uint32_t node, const glm::mat4& localMatrix);
+		const glm::mat4& getLocalMatrix(uint32_t node) const;
+
+		// Up to date after update() only.
+		const glm::mat4& getWorldMatrix(uint32_t node) const;
+
+		uint32_t getParent(uint32_t node) const;
+		uint32_t getObjectIndex(uint32_t node) const;
+		size_t getNbNodes() const { return _localMatrices.size(); }
+		bool hasChanges() const { return !_dirtyNodes.empty(); }
+
+		// Recomputes the world matrices of the dirty subtrees. The objects of the updated nodes are appended to changedObjects,
+		// along with their new world matrix in changedMatrices.
+		void update(std::vector<uint32_t>& changedObjects, std::vector<glm::mat4>& changedMatrices);
+
+	private:
+		bool _hasDirtyAncestor(uint32_t node) const;
+
+	private:
+		// Per-node arrays. A parent is always added before its children.
+		std::vector<glm::mat4> _localMatrices;
+		std::vector<glm::mat4> _worldMatrices;
+		std::vector<uint32_t> _parents;
+		std::vector<uint32_t> _firstChildren;
+		std::vector<uint32_t> _nextSiblings;
+		std::vector<uint32_t> _objectIndices;
+		std::vector<uint8_t> _dirtyFlags;
+
+		// Nodes changed since the last update, in no particular order.
+		std::vector<uint32_t> _dirtyNodes;
+
+		// Reused by update() to walk the subtrees without allocating.
+		std::vector<uint32_t> _traversalStack;
+	};
+}
@@ -2,125 +2,463 @@
 
 #include "Scene.h"
 #include "SceneObject.h"
+#include "SceneBinaryFormat.h"
 #include "Transform.h"
 #include "ModelLoader.h"
+#include "MappedFile.h"
 #include "Camera.h"
 #include "PerformanceMaterial.h"
+#include "ThreadPool.h"
+#include "AssetCache.h"
+#include "BatchTransforms.h"
+#include "HlodBuilder.h"
 
+#include <cstring>
 #include <string>
 #include <unordered_map>
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <random>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 
 namespace leoscene {
 	namespace {
-		void loadCameraEntry(std::stringstream& entry, Camera* camera, size_t lineNb);
-		void loadTransformEntry(std::stringstream& entry, std::unordered_map<std::string, std::shared_ptr<const Transform>>& transforms, size_t lineNb);
+		void loadCameraEntry(std::stringstream& entry, SceneDescription& description, size_t lineNb);
+		void loadTransformEntry(std::stringstream& entry, SceneDescription& description, std::unordered_map<std::string, uint32_t>& transforms, size_t lineNb);
+		void loadModelEntry(std::stringstream& entry, SceneDescription& description, std::unordered_map<std::string, uint32_t>& models, size_t lineNb);
 		void addModelInstance(std::stringstream& entry,
-			Scene* scene,
-			const std::unordered_map<std::string, Model>& models,
-			const std::unordered_map<std::string, std::shared_ptr<const Transform>>& transforms,
+			SceneDescription& description,
+			const std::unordered_map<std::string, uint32_t>& models,
+			const std::unordered_map<std::string, uint32_t>& transforms,
 			size_t lineNb);
+		void loadGridEntry(std::stringstream& entry, SceneDescription& description, const std::unordered_map<std::string, uint32_t>& models, size_t lineNb);
+		void loadScatterEntry(std::stringstream& entry, SceneDescription& description, const std::unordered_map<std::string, uint32_t>& models, size_t lineNb);
+		uint32_t readModelIndex(std::stringstream& entry, const std::unordered_map<std::string, uint32_t>& models, size_t lineNb);
+		void addProceduralInstance(SceneDescription& description, uint32_t modelIndex, const TransformParameters& parameters);
+		void setCamera(const SceneDescription::CameraEntry& entry, Camera* camera);
+		uint64_t alignOffset(uint64_t offset);
+		bool streamModelInstances(const Model& model,
+			const uint32_t* modelInstances,
+			size_t nbModelInstances,
+			const SceneDescription::TransformEntry* transforms,
+			const SceneDescription::InstanceEntry* instances,
+			const SceneLoader::LoadingOptions& options);
+		void buildSceneHlods(Scene& scene, const SceneLoader::LoadingOptions& options);
 	}
 
-	SceneLoaderException::SceneLoaderException(const char* message, size_t lineNb) : message(message), lineNb(lineNb) {
+	static_assert(sizeof(SceneDescription::TransformEntry) == sizeof(binaryscene::BinarySceneTransformEntry), "Transform entries must be readable in place from a binary scene file.");
+	static_assert(sizeof(SceneDescription::InstanceEntry) == sizeof(binaryscene::BinarySceneInstanceEntry), "Instance entries must be readable in place from a binary scene file.");
+
+	SceneLoaderException::SceneLoaderException(const char* message) : message(message), lineNb(0), hasLineNb(false) {
+	}
+
+	SceneLoaderException::SceneLoaderException(const char* message, size_t lineNb) : message(message), lineNb(lineNb), hasLineNb(true) {
 	}
 
 	const char* SceneLoaderException::what() const noexcept {
-		std::cerr << "SceneLoaderException (line " << lineNb << "): " << message << std::endl;
+		if (hasLineNb) {
+			std::cerr << "SceneLoaderException (line " << lineNb << "): " << message << std::endl;
+		}
+		else {
+			std::cerr << "SceneLoaderException: " << message << std::endl;
+		}
 		return message;
 	}
 
-	void SceneLoader::loadScene(const char* filePath, Scene* scene, Camera* camera)
+	void SceneLoader::loadScene(const char* filePath, Scene* scene, Camera* camera, LoadingOptions options)
 	{
 		std::string strFilePath(filePath);
 		std::replace(strFilePath.begin(), strFilePath.end(), '\\', '/');
 		std::string fileDirectoryPath = strFilePath.substr(0, strFilePath.find_last_of('/'));
+
+		_modelLoader.setAssetCache(options.assetCacheDirectoryPath.size() ? std::make_shared<AssetCache>(options.assetCacheDirectoryPath) : nullptr);
+		_modelLoader.setLoadingStats(options.stats);
+		_modelLoader.setMeshOptimization(options.optimizeMeshes);
+		_modelLoader.setLodGeneration(options.generateLods);
+		_modelLoader.setClusterGeneration(options.buildClusters);
+		_modelLoader.setTextureCompression(options.compressTextures);
+		// The imports of the models, and the meshes and textures of the models as helper tasks, share the same threads
+		size_t nbThreads = options.nbThreads ? options.nbThreads : ThreadPool::getDefaultNbThreads();
+		if (!_threadPool || _threadPool->getNbThreads() != nbThreads) {
+			_threadPool = std::make_shared<ThreadPool>(nbThreads);
+		}
+		_modelLoader.setThreadPool(_threadPool);
+		options.hlodOptions.threadPool = _threadPool.get();
+
 		std::ifstream ifs(filePath);
-		if (ifs.is_open()) {
-			std::unordered_map<std::string, std::shared_ptr<const Transform>> transforms;
-			transforms["__identity"] = std::make_shared<Transform>();
-			std::unordered_map<std::string,  Model> models;
-			std::string line;
-			std::string entryType;
-			size_t lineNb = 0;
-			bool cameraLoaded = false;
-			while (std::getline(ifs, line)) {
-				std::stringstream ss(line);
-				ss >> entryType;
-				if (ss.fail()) {
-					throw SceneLoaderException("Could not start reading line. File is empty or the line contains an invalid character.", lineNb);
-				}
-				if (entryType == "c") {
-					if (cameraLoaded) {
-						throw SceneLoaderException("An entry for a camera was previously found. Only specify one camera entry.", lineNb);
-					}
-					cameraLoaded = true;
-					loadCameraEntry(ss, camera, lineNb);
-				}
-				else if (entryType == "t") loadTransformEntry(ss, transforms, lineNb);
-				else if (entryType == "m") _loadModelEntry(ss, models, transforms, fileDirectoryPath, lineNb);
-				else if (entryType == "o") addModelInstance(ss, scene, models, transforms, lineNb);
-				else {
-					throw SceneLoaderException("Could not start reading line. First character of the line does not correspond to any type of entry.", lineNb);
+		if (!ifs.is_open()) {
+			throw SceneLoaderException("Could not open the scene file.");
+		}
+
+		// Binary scenes are read in place from the mapped file. Text scenes are parsed into a description first, from the same stream.
+		char magic[sizeof(binaryscene::MAGIC)];
+		if (ifs.read(magic, sizeof(magic)) && !memcmp(magic, binaryscene::MAGIC, sizeof(magic))) {
+			ifs.close();
+			MappedFile file;
+			if (!file.open(filePath)) {
+				throw SceneLoaderException("Could not open the scene file.");
+			}
+			_loadBinaryScene(file.getData(), file.getSize(), fileDirectoryPath, scene, camera, options);
+			return;
+		}
+		ifs.clear();
+		ifs.seekg(0);
+
+		SceneDescription description;
+		{
+			ScopedLoadingPhase phase(options.stats, LoadingStats::Phase::SCENE_PARSING);
+			_parseTextScene(ifs, description);
+		}
+		if (description.hasCamera) {
+			setCamera(description.camera, camera);
+		}
+		_instantiateScene(description.models,
+			description.transforms.data(),
+			description.instances.data(), description.instances.size(),
+			fileDirectoryPath, scene, options);
+	}
+
+	void SceneLoader::parseTextScene(const char* filePath, SceneDescription& description)
+	{
+		std::ifstream ifs(filePath);
+		if (!ifs.is_open()) {
+			throw SceneLoaderException("Could not open the scene file.");
+		}
+		_parseTextScene(ifs, description);
+	}
+
+	void SceneLoader::_parseTextScene(std::istream& stream, SceneDescription& description)
+	{
+		std::unordered_map<std::string, uint32_t> transforms;
+		std::unordered_map<std::string, uint32_t> models;
+		description = {};
+		description.transforms.push_back({});  // Identity
+		transforms["__identity"] = 0;
+		std::string line;
+		std::string entryType;
+		size_t lineNb = 0;
+		while (std::getline(stream, line)) {
+			std::stringstream ss(line);
+			ss >> entryType;
+			if (ss.fail()) {
+				throw SceneLoaderException("Could not start reading line. File is empty or the line contains an invalid character.", lineNb);
+			}
+			if (entryType == "c") {
+				if (description.hasCamera) {
+					throw SceneLoaderException("An entry for a camera was previously found. Only specify one camera entry.", lineNb);
 				}
-				lineNb++;
+				loadCameraEntry(ss, description, lineNb);
 			}
-			ifs.close();
+			else if (entryType == "t") loadTransformEntry(ss, description, transforms, lineNb);
+			else if (entryType == "m") loadModelEntry(ss, description, models, lineNb);
+			else if (entryType == "o") addModelInstance(ss, description, models, transforms, lineNb);
+			else if (entryType == "grid") loadGridEntry(ss, description, models, lineNb);
+			else if (entryType == "scatter") loadScatterEntry(ss, description, models, lineNb);
+			else {
+				throw SceneLoaderException("Could not start reading line. First character of the line does not correspond to any type of entry.", lineNb);
+			}
+			lineNb++;
 		}
-		else {
-			throw std::runtime_error("Could not open the scene file");
+	}
+
+	void SceneLoader::compileScene(const char* textFilePath, const char* binaryFilePath)
+	{
+		using namespace binaryscene;
+
+		SceneDescription description;
+		parseTextScene(textFilePath, description);
+
+		std::string strings;
+		std::vector<BinarySceneModelEntry> models(description.models.size());
+		for (size_t i = 0; i < description.models.size(); ++i) {
+			const SceneDescription::ModelEntry& model = description.models[i];
+			models[i].pathOffset = static_cast<uint32_t>(strings.size());
+			models[i].pathLength = static_cast<uint32_t>(model.path.size());
+			models[i].xSegments = model.xSegments;
+			models[i].ySegments = model.ySegments;
+			strings += model.path;
+		}
+
+		BinarySceneHeader header = {};
+		memcpy(header.magic, MAGIC, sizeof(MAGIC));
+		header.version = VERSION;
+		header.flags = description.hasCamera ? static_cast<uint32_t>(HAS_CAMERA) : 0u;
+		const SceneDescription::CameraEntry& camera = description.camera;
+		float cameraData[7] = { camera.position.x, camera.position.y, camera.position.z, camera.target.x, camera.target.y, camera.target.z, camera.fov };
+		memcpy(header.camera, cameraData, sizeof(cameraData));
+		header.nbModels = static_cast<uint32_t>(models.size());
+		header.nbTransforms = static_cast<uint32_t>(description.transforms.size());
+		header.nbInstances = static_cast<uint32_t>(description.instances.size());
+		header.modelsOffset = alignOffset(sizeof(BinarySceneHeader));
+		header.transformsOffset = alignOffset(header.modelsOffset + models.size() * sizeof(BinarySceneModelEntry));
+		header.instancesOffset = alignOffset(header.transformsOffset + description.transforms.size() * sizeof(BinarySceneTransformEntry));
+		header.stringsOffset = alignOffset(header.instancesOffset + description.instances.size() * sizeof(BinarySceneInstanceEntry));
+		header.stringsSize = strings.size();
+
+		std::ofstream ofs(binaryFilePath, std::ios::binary | std::ios::trunc);
+		if (!ofs.is_open()) {
+			throw SceneLoaderException("Could not open the binary scene file for writing.");
+		}
+
+		uint64_t position = 0;
+		auto writeTable = [&ofs, &position](uint64_t offset, const void* data, size_t size) {
+			static const char zeros[TABLE_ALIGNMENT] = {};
+			ofs.write(zeros, offset - position);
+			ofs.write(static_cast<const char*>(data), size);
+			position = offset + size;
+		};
+		writeTable(0, &header, sizeof(header));
+		writeTable(header.modelsOffset, models.data(), models.size() * sizeof(BinarySceneModelEntry));
+		writeTable(header.transformsOffset, description.transforms.data(), description.transforms.size() * sizeof(BinarySceneTransformEntry));
+		writeTable(header.instancesOffset, description.instances.data(), description.instances.size() * sizeof(BinarySceneInstanceEntry));
+		writeTable(header.stringsOffset, strings.data(), strings.size());
+
+		if (!ofs.good()) {
+			throw SceneLoaderException("Failed to write the binary scene file.");
+		}
+		ofs.close();
+	}
+
+	void SceneLoader::_loadBinaryScene(const unsigned char* data, size_t size, const std::string& fileDirectoryPath, Scene* scene, Camera* camera, const LoadingOptions& options)
+	{
+		using namespace binaryscene;
+
+		if (size < sizeof(BinarySceneHeader)) {
+			throw SceneLoaderException("Binary scene file is truncated.");
+		}
+		const BinarySceneHeader* header = reinterpret_cast<const BinarySceneHeader*>(data);
+		if (header->version != VERSION) {
+			throw SceneLoaderException("Binary scene file was compiled with an incompatible version. Recompile it with LeoSceneCompiler.");
+		}
+
+		auto isTableValid = [size](uint64_t offset, uint64_t tableSize) {
+			return offset % TABLE_ALIGNMENT == 0 && offset <= size && tableSize <= size - offset;
+		};
+		if (!isTableValid(header->modelsOffset, uint64_t(header->nbModels) * sizeof(BinarySceneModelEntry)) ||
+			!isTableValid(header->transformsOffset, uint64_t(header->nbTransforms) * sizeof(BinarySceneTransformEntry)) ||
+			!isTableValid(header->instancesOffset, uint64_t(header->nbInstances) * sizeof(BinarySceneInstanceEntry)) ||
+			!isTableValid(header->stringsOffset, header->stringsSize) ||
+			header->nbTransforms == 0)
+		{
+			throw SceneLoaderException("Binary scene file is corrupted: a table lies outside of the file.");
 		}
+
+		if (header->flags & HAS_CAMERA) {
+			SceneDescription::CameraEntry cameraEntry;
+			cameraEntry.position = glm::vec3(header->camera[0], header->camera[1], header->camera[2]);
+			cameraEntry.target = glm::vec3(header->camera[3], header->camera[4], header->camera[5]);
+			cameraEntry.fov = header->camera[6];
+			setCamera(cameraEntry, camera);
+		}
+
+		const BinarySceneModelEntry* binaryModels = reinterpret_cast<const BinarySceneModelEntry*>(data + header->modelsOffset);
+		const char* strings = reinterpret_cast<const char*>(data + header->stringsOffset);
+		std::vector<SceneDescription::ModelEntry> models(header->nbModels);
+		for (uint32_t i = 0; i < header->nbModels; ++i) {
+			const BinarySceneModelEntry& entry = binaryModels[i];
+			if (uint64_t(entry.pathOffset) + entry.pathLength > header->stringsSize) {
+				throw SceneLoaderException("Binary scene file is corrupted: a model path lies outside of the strings table.");
+			}
+			models[i].path.assign(strings + entry.pathOffset, entry.pathLength);
+			models[i].xSegments = entry.xSegments;
+			models[i].ySegments = entry.ySegments;
+		}
+
+		const SceneDescription::InstanceEntry* instances = reinterpret_cast<const SceneDescription::InstanceEntry*>(data + header->instancesOffset);
+		for (uint32_t i = 0; i < header->nbInstances; ++i) {
+			if (instances[i].modelIndex >= header->nbModels || instances[i].transformIndex >= header->nbTransforms) {
+				throw SceneLoaderException("Binary scene file is corrupted: an instance references a model or transform that does not exist.");
+			}
+		}
+
+		_instantiateScene(models,
+			reinterpret_cast<const SceneDescription::TransformEntry*>(data + header->transformsOffset),
+			instances, header->nbInstances,
+			fileDirectoryPath, scene, options);
 	}
 
-	void SceneLoader::_loadModelEntry(
-		std::stringstream& entry,
-		std::unordered_map<std::string, Model>& models,
-		const std::unordered_map<std::string, std::shared_ptr<const Transform>>& transforms,
+	void SceneLoader::_instantiateScene(
+		const std::vector<SceneDescription::ModelEntry>& modelEntries,
+		const SceneDescription::TransformEntry* transforms,
+		const SceneDescription::InstanceEntry* instances,
+		size_t nbInstances,
 		const std::string& fileDirectoryPath,
-		size_t lineNb)
+		Scene* scene,
+		const LoadingOptions& options)
 	{
-		std::string modelPath;
-		std::string modelName;
-		entry >> modelName >> modelPath;
-		if (entry.fail() || !modelName.size() || !modelPath.size()) {
-			throw SceneLoaderException("Could not read the line. Some of the tokens are invalid or absent. Check format and values.", lineNb);
+		// All the model files are imported in parallel. Entries pointing to the same file share a single import.
+		std::vector<Model> models(modelEntries.size());
+		std::atomic<bool> stopped(false);  // Set when the chunk callback stops the loading. Imports that did not start are skipped.
+		std::unordered_map<std::string, std::shared_future<Model>> modelImports;
+		std::vector<std::shared_future<Model>> entryImports(modelEntries.size());
+
+		// The imports use the local variables of this function: they are waited for however it returns
+		struct ImportsWaiter {
+			std::unordered_map<std::string, std::shared_future<Model>>& imports;
+			std::atomic<bool>& stopped;
+			~ImportsWaiter()
+			{
+				stopped = true;
+				for (auto& import : imports) {
+					import.second.wait();
+				}
+			}
+		} importsWaiter{ modelImports, stopped };
+		for (size_t i = 0; i < modelEntries.size(); ++i) {
+			const SceneDescription::ModelEntry& entry = modelEntries[i];
+			if (entry.isSphere()) {
+				continue;
+			}
+			std::string modelPath = fileDirectoryPath + "/" + entry.path;
+			auto importIterator = modelImports.find(modelPath);
+			if (importIterator == modelImports.end()) {
+				std::shared_future<Model> import = _threadPool->submit([this, modelPath, &stopped]() -> Model {
+					return stopped ? Model() : _modelLoader.loadModel(modelPath.c_str());
+				}).share();
+				importIterator = modelImports.emplace(modelPath, import).first;
+			}
+			entryImports[i] = importIterator->second;
 		}
-		if (models.find(modelName) != models.end()) {
-			throw SceneLoaderException("A model with that name was already created. No duplicates are allowed for model entries. Choose a different name.", lineNb);
+
+		// Spheres are generated on this thread while the workers import the files.
+		for (size_t i = 0; i < modelEntries.size(); ++i) {
+			const SceneDescription::ModelEntry& entry = modelEntries[i];
+			if (entry.isSphere()) {
+				models[i] = _modelLoader.loadSphereModel(entry.xSegments, entry.ySegments);
+				// The sub-objects table is shared with the loader cache, so the sphere gets its own table with the performance material.
+				static std::shared_ptr<Material> sphereMaterial = std::make_shared<PerformanceMaterial>();
+				std::vector<SceneObject> sphereObjects(models[i].begin(), models[i].end());
+				sphereObjects[0].material = sphereMaterial;
+				models[i].objectsTable = std::make_shared<const std::vector<SceneObject>>(std::move(sphereObjects));
+				models[i].firstObject = 0;
+			}
 		}
 
-		if (modelPath.rfind("__sphere", 0) == 0) {  // Sphere
-			uint32_t xSegments;
-			uint32_t ySegments;
-			entry >> xSegments >> ySegments;
-			if (entry.fail() || !xSegments || !ySegments) {
-				throw SceneLoaderException("Could not read the line. Some of the tokens are invalid or absent. Check format and values.", lineNb);
+		if (options.onChunkLoaded) {
+			// Progressive loading: the instances are grouped by model, and the instances of a model are handed over
+			// as soon as its import is done, in the order the imports complete.
+			std::vector<uint32_t> modelInstancesOffsets(models.size() + 1, 0);
+			for (size_t i = 0; i < nbInstances; ++i) {
+				modelInstancesOffsets[instances[i].modelIndex + 1]++;
 			}
-			models[modelName] = _modelLoader.loadSphereModel(xSegments, ySegments);
-			static std::shared_ptr<Material> sphereMaterial = std::make_shared<PerformanceMaterial>();
-			models[modelName].objects[0].material = sphereMaterial;
+			for (size_t i = 0; i < models.size(); ++i) {
+				modelInstancesOffsets[i + 1] += modelInstancesOffsets[i];
+			}
+			std::vector<uint32_t> modelInstances(nbInstances);
+			{
+				std::vector<uint32_t> modelInstancesEnds(modelInstancesOffsets.begin(), modelInstancesOffsets.end() - 1);
+				for (size_t i = 0; i < nbInstances; ++i) {
+					modelInstances[modelInstancesEnds[instances[i].modelIndex]++] = static_cast<uint32_t>(i);
+				}
+			}
+
+			std::vector<size_t> pendingModels;
+			for (size_t i = 0; i < models.size(); ++i) {
+				if (modelInstancesOffsets[i + 1] > modelInstancesOffsets[i]) {
+					pendingModels.push_back(i);
+				}
+			}
+			while (pendingModels.size()) {
+				auto readyIterator = std::find_if(pendingModels.begin(), pendingModels.end(), [&entryImports](size_t i) {
+					return !entryImports[i].valid() || entryImports[i].wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+				});
+				if (readyIterator == pendingModels.end()) {
+					entryImports[pendingModels.front()].wait_for(std::chrono::milliseconds(1));
+					continue;
+				}
+				size_t modelIndex = *readyIterator;
+				pendingModels.erase(readyIterator);
+
+				const Model& model = entryImports[modelIndex].valid() ? entryImports[modelIndex].get() : models[modelIndex];
+				if (!streamModelInstances(model,
+					modelInstances.data() + modelInstancesOffsets[modelIndex], modelInstancesOffsets[modelIndex + 1] - modelInstancesOffsets[modelIndex],
+					transforms, instances, options)) {
+					stopped = true;
+					break;
+				}
+			}
+			return;
 		}
-		else {
-			models[modelName] = _modelLoader.loadModel((fileDirectoryPath + "/" + modelPath).c_str());
+
+		for (size_t i = 0; i < modelEntries.size(); ++i) {
+			if (entryImports[i].valid()) {
+				models[i] = entryImports[i].get();
+			}
 		}
+
+		ScopedLoadingPhase phase(options.stats, LoadingStats::Phase::INSTANTIATION);
+
+		// The shapes and materials of the models are added once to the scene tables.
+		// The matrices of the objects of a model are kept apart, so that they are composed with each instance matrix in one batch.
+		struct ModelObject {
+			uint32_t shapeIndex = 0;
+			uint32_t materialIndex = 0;
+		};
+		std::vector<std::vector<ModelObject>> modelObjects(models.size());
+		std::vector<std::vector<glm::mat4>> modelObjectMatrices(models.size());  // Relative to the instance
+		{
+			std::unordered_map<const Shape*, uint32_t> shapeIndices;
+			std::unordered_map<const Material*, uint32_t> materialIndices;
+			for (size_t i = 0; i < models.size(); ++i) {
+				for (size_t j = 0; j < models[i].size(); ++j) {
+					const SceneObject& object = models[i][j];
+					auto shapeIterator = shapeIndices.emplace(object.shape.get(), static_cast<uint32_t>(scene->shapes.size())).first;
+					if (shapeIterator->second == scene->shapes.size()) {
+						scene->shapes.push_back(object.shape);
+					}
+					auto materialIterator = materialIndices.emplace(object.material.get(), static_cast<uint32_t>(scene->materials.size())).first;
+					if (materialIterator->second == scene->materials.size()) {
+						scene->materials.push_back(object.material);
+					}
+
+					ModelObject modelObject;
+					modelObject.shapeIndex = shapeIterator->second;
+					modelObject.materialIndex = materialIterator->second;
+					modelObjects[i].push_back(modelObject);
+					modelObjectMatrices[i].push_back(models[i].getObjectMatrix(j));
+				}
+			}
+		}
+
+		// Objects are written straight into the per-object arrays. No Transform is created per instance.
+		size_t nbObjects = scene->getNbObjects();
+		for (size_t i = 0; i < nbInstances; ++i) {
+			nbObjects += modelObjects[instances[i].modelIndex].size();
+		}
+		size_t firstObject = scene->getNbObjects();
+		scene->worldMatrices.resize(nbObjects);
+		scene->shapeIndices.reserve(nbObjects);
+		scene->materialIndices.reserve(nbObjects);
+
+		for (size_t i = 0; i < nbInstances; ++i) {
+			const SceneDescription::InstanceEntry& instance = instances[i];
+			const std::vector<glm::mat4>& objectMatrices = modelObjectMatrices[instance.modelIndex];
+			multiplyAffineMatrices(transforms[instance.transformIndex].matrix, objectMatrices.data(), scene->worldMatrices.data() + firstObject, objectMatrices.size());
+			firstObject += objectMatrices.size();
+			for (const ModelObject& object : modelObjects[instance.modelIndex]) {
+				scene->shapeIndices.push_back(object.shapeIndex);
+				scene->materialIndices.push_back(object.materialIndex);
+			}
+		}
+
+		buildSceneHlods(*scene, options);
 	}
 
 	namespace {
-		void loadCameraEntry(std::stringstream& entry, Camera* camera, size_t lineNb)
+		void loadCameraEntry(std::stringstream& entry, SceneDescription& description, size_t lineNb)
 		{
-			glm::vec3 position(0);
-			glm::vec3 target(0);
-			float fov = 0;
-			entry >> position.x >> position.y >> position.z >> target.x >> target.y >> target.z >> fov;
-			if (fov <= 0 || glm::length(position - target) <= 0.0001f || entry.fail()) {
+			SceneDescription::CameraEntry& camera = description.camera;
+			entry >> camera.position.x >> camera.position.y >> camera.position.z >> camera.target.x >> camera.target.y >> camera.target.z >> camera.fov;
+			if (camera.fov <= 0 || glm::length(camera.position - camera.target) <= 0.0001f || entry.fail()) {
 				throw SceneLoaderException("Could not read the line. Some of the tokens are invalid or absent. Check format and values.", lineNb);
 			}
-			*camera = Camera(position, target, glm::vec3(0, 1, 0), glm::radians(fov));
+			description.hasCamera = true;
 		}
 
-		void loadTransformEntry(std::stringstream& entry, std::unordered_map<std::string, std::shared_ptr<const Transform>>& transforms, size_t lineNb)
+		void loadTransformEntry(std::stringstream& entry, SceneDescription& description, std::unordered_map<std::string, uint32_t>& transforms, size_t lineNb)
 		{
 			TransformParameters p = {};
 			std::string transformName;
@@ -143,49 +481,231 @@ namespace leoscene {
 			p.rotation_rads.x = glm::radians(p.rotation_rads.x);
 			p.rotation_rads.y = glm::radians(p.rotation_rads.y);
 			p.rotation_rads.z = glm::radians(p.rotation_rads.z);
-			transforms[transformName] = std::make_shared<Transform>(p);
+			transforms[transformName] = static_cast<uint32_t>(description.transforms.size());
+			description.transforms.push_back({ Transform::makeMatrix(p) });
+		}
+
+		void loadModelEntry(std::stringstream& entry, SceneDescription& description, std::unordered_map<std::string, uint32_t>& models, size_t lineNb)
+		{
+			SceneDescription::ModelEntry model;
+			std::string modelName;
+			entry >> modelName >> model.path;
+			if (entry.fail() || !modelName.size() || !model.path.size()) {
+				throw SceneLoaderException("Could not read the line. Some of the tokens are invalid or absent. Check format and values.", lineNb);
+			}
+			if (models.find(modelName) != models.end()) {
+				throw SceneLoaderException("A model with that name was already created. No duplicates are allowed for model entries. Choose a different name.", lineNb);
+			}
+
+			if (model.path.rfind("__sphere", 0) == 0) {  // Sphere
+				entry >> model.xSegments >> model.ySegments;
+				if (entry.fail() || !model.xSegments || !model.ySegments) {
+					throw SceneLoaderException("Could not read the line. Some of the tokens are invalid or absent. Check format and values.", lineNb);
+				}
+			}
+
+			models[modelName] = static_cast<uint32_t>(description.models.size());
+			description.models.push_back(model);
 		}
 
 		void addModelInstance(
 			std::stringstream& entry,
-			Scene* scene,
-			const std::unordered_map<std::string,
-			Model>& models,
-			const std::unordered_map<std::string, std::shared_ptr<const Transform>>& transforms,
+			SceneDescription& description,
+			const std::unordered_map<std::string, uint32_t>& models,
+			const std::unordered_map<std::string, uint32_t>& transforms,
 			size_t lineNb)
 		{
-			std::string modelName;
+			SceneDescription::InstanceEntry instance;
+			instance.modelIndex = readModelIndex(entry, models, lineNb);
 			std::string transformName;
+			entry >> transformName;
+			if (!entry.fail() && transformName.size()) {
+				auto transformIt = transforms.find(transformName);
+				if (transformIt == transforms.end()) {
+					throw SceneLoaderException("No transform was created under the given name. Specify a transform entry with that name beforehand.", lineNb);
+				}
+				instance.transformIndex = transformIt->second;
+			}
+			else {
+				instance.transformIndex = transforms.at("__identity");
+			}
+
+			description.instances.push_back(instance);
+		}
+
+		void loadGridEntry(std::stringstream& entry, SceneDescription& description, const std::unordered_map<std::string, uint32_t>& models, size_t lineNb)
+		{
+			uint32_t modelIndex = readModelIndex(entry, models, lineNb);
+			uint32_t nbX = 0, nbY = 0, nbZ = 0;
+			glm::vec3 origin(0);
+			glm::vec3 spacing(0);
+			TransformParameters p = {};
+			entry >> nbX >> nbY >> nbZ
+				>> origin.x >> origin.y >> origin.z
+				>> spacing.x >> spacing.y >> spacing.z
+				>> p.scaling.x >> p.scaling.y >> p.scaling.z
+				>> p.rotation_rads.x >> p.rotation_rads.y >> p.rotation_rads.z;
+			if (entry.fail() || !nbX || !nbY || !nbZ || p.scaling.x == 0 || p.scaling.y == 0 || p.scaling.z == 0) {
+				throw SceneLoaderException("Could not read the line. Some of the tokens are invalid or absent. Check format and values.", lineNb);
+			}
+			uint64_t nbInstances = uint64_t(nbX) * nbY * nbZ;
+			if (description.instances.size() + nbInstances > UINT32_MAX) {
+				throw SceneLoaderException("Too many instances in the grid entry.", lineNb);
+			}
+			p.rotation_rads = glm::radians(p.rotation_rads);
+
+			description.transforms.reserve(description.transforms.size() + nbInstances);
+			description.instances.reserve(description.instances.size() + nbInstances);
+			for (uint32_t x = 0; x < nbX; ++x) {
+				for (uint32_t y = 0; y < nbY; ++y) {
+					for (uint32_t z = 0; z < nbZ; ++z) {
+						p.translation = origin + spacing * glm::vec3(x, y, z);
+						addProceduralInstance(description, modelIndex, p);
+					}
+				}
+			}
+		}
+
+		void loadScatterEntry(std::stringstream& entry, SceneDescription& description, const std::unordered_map<std::string, uint32_t>& models, size_t lineNb)
+		{
+			uint32_t modelIndex = readModelIndex(entry, models, lineNb);
+			uint32_t nbInstances = 0;
+			uint32_t seed = 0;
+			glm::vec3 boundsMin(0);
+			glm::vec3 boundsMax(0);
+			TransformParameters p = {};
+			entry >> nbInstances >> seed
+				>> boundsMin.x >> boundsMin.y >> boundsMin.z
+				>> boundsMax.x >> boundsMax.y >> boundsMax.z
+				>> p.scaling.x >> p.scaling.y >> p.scaling.z;
+			if (entry.fail() || !nbInstances || glm::any(glm::lessThan(boundsMax, boundsMin)) || p.scaling.x == 0 || p.scaling.y == 0 || p.scaling.z == 0) {
+				throw SceneLoaderException("Could not read the line. Some of the tokens are invalid or absent. Check format and values.", lineNb);
+			}
+			if (description.instances.size() + nbInstances > UINT32_MAX) {
+				throw SceneLoaderException("Too many instances in the scatter entry.", lineNb);
+			}
+
+			// The generator and the conversion to floats are fully specified, so a seed gives the same scene on every platform.
+			std::mt19937 generator(seed);
+			auto random01 = [&generator]() { return (generator() >> 8) * (1.f / 16777216.f); };
+
+			description.transforms.reserve(description.transforms.size() + nbInstances);
+			description.instances.reserve(description.instances.size() + nbInstances);
+			for (uint32_t i = 0; i < nbInstances; ++i) {
+				p.translation.x = glm::mix(boundsMin.x, boundsMax.x, random01());
+				p.translation.y = glm::mix(boundsMin.y, boundsMax.y, random01());
+				p.translation.z = glm::mix(boundsMin.z, boundsMax.z, random01());
+				p.rotation_rads.y = random01() * glm::two_pi<float>();
+				addProceduralInstance(description, modelIndex, p);
+			}
+		}
+
+		uint32_t readModelIndex(std::stringstream& entry, const std::unordered_map<std::string, uint32_t>& models, size_t lineNb)
+		{
+			std::string modelName;
 			entry >> modelName;
 			if (entry.fail() || !modelName.size()) {
 				throw SceneLoaderException("Could not read the line. Some of the tokens are invalid or absent. Check format and values.", lineNb);
 			}
-			if (models.find(modelName) == models.end()) {
+			auto modelIt = models.find(modelName);
+			if (modelIt == models.end()) {
 				throw SceneLoaderException("No model was created under the given name. Specify a model entry with that name beforehand.", lineNb);
 			}
+			return modelIt->second;
+		}
 
-			std::shared_ptr<const Transform> transform;
-			entry >> transformName;
-			if (!entry.fail() && transformName.size()) {
-				if (transforms.find(transformName) == transforms.end()) {
-					throw SceneLoaderException("No transform was created under the given name. Specify a transform entry with that name beforehand.", lineNb);
-				}
-				transform = transforms.at(transformName);
+		void addProceduralInstance(SceneDescription& description, uint32_t modelIndex, const TransformParameters& parameters)
+		{
+			SceneDescription::InstanceEntry instance;
+			instance.modelIndex = modelIndex;
+			instance.transformIndex = static_cast<uint32_t>(description.transforms.size());
+			description.transforms.push_back({ Transform::makeMatrix(parameters) });
+			description.instances.push_back(instance);
+		}
+
+		void setCamera(const SceneDescription::CameraEntry& entry, Camera* camera)
+		{
+			*camera = Camera(entry.position, entry.target, glm::vec3(0, 1, 0), glm::radians(entry.fov));
+		}
+
+		uint64_t alignOffset(uint64_t offset)
+		{
+			return (offset + binaryscene::TABLE_ALIGNMENT - 1) & ~uint64_t(binaryscene::TABLE_ALIGNMENT - 1);
+		}
+
+		// Hands the instances of a model over to the chunk callback. Returns false if the callback stopped the loading.
+		bool streamModelInstances(const Model& model,
+			const uint32_t* modelInstances,
+			size_t nbModelInstances,
+			const SceneDescription::TransformEntry* transforms,
+			const SceneDescription::InstanceEntry* instances,
+			const SceneLoader::LoadingOptions& options)
+		{
+			if (model.empty()) {
+				return true;
 			}
-			else {
-				transform = transforms.at("__identity");
+
+			// Each chunk is a self-contained scene holding the shapes and materials of the model.
+			std::vector<std::shared_ptr<const Shape>> shapes;
+			std::vector<std::shared_ptr<const Material>> materials;
+			std::vector<uint32_t> shapeIndices(model.size());
+			std::vector<uint32_t> materialIndices(model.size());
+			std::vector<glm::mat4> objectMatrices(model.size());
+			{
+				std::unordered_map<const Shape*, uint32_t> shapesTable;
+				std::unordered_map<const Material*, uint32_t> materialsTable;
+				for (size_t i = 0; i < model.size(); ++i) {
+					const SceneObject& object = model[i];
+					auto shapeIterator = shapesTable.emplace(object.shape.get(), static_cast<uint32_t>(shapes.size())).first;
+					if (shapeIterator->second == shapes.size()) {
+						shapes.push_back(object.shape);
+					}
+					auto materialIterator = materialsTable.emplace(object.material.get(), static_cast<uint32_t>(materials.size())).first;
+					if (materialIterator->second == materials.size()) {
+						materials.push_back(object.material);
+					}
+					shapeIndices[i] = shapeIterator->second;
+					materialIndices[i] = materialIterator->second;
+					objectMatrices[i] = model.getObjectMatrix(i);
+				}
 			}
 
-			Model m = models.at(modelName);
-			for (SceneObject object : m.objects) {
-				if (object.transform) {
-					object.transform = std::make_shared<Transform>(*transform * *object.transform);
+			// Chunks hold whole instances, so a model with more objects than nbObjectsPerChunk gets one instance per chunk.
+			size_t nbInstancesPerChunk = std::max<size_t>(1, options.nbObjectsPerChunk / model.size());
+			for (size_t first = 0; first < nbModelInstances; first += nbInstancesPerChunk) {
+				size_t last = std::min(first + nbInstancesPerChunk, nbModelInstances);
+				std::unique_ptr<Scene> chunk = std::make_unique<Scene>();
+				chunk->shapes = shapes;
+				chunk->materials = materials;
+				size_t nbObjects = (last - first) * model.size();
+				chunk->worldMatrices.resize(nbObjects);
+				chunk->shapeIndices.reserve(nbObjects);
+				chunk->materialIndices.reserve(nbObjects);
+				for (size_t i = first; i < last; ++i) {
+					const glm::mat4& instanceMatrix = transforms[instances[modelInstances[i]].transformIndex].matrix;
+					multiplyAffineMatrices(instanceMatrix, objectMatrices.data(), chunk->worldMatrices.data() + (i - first) * model.size(), model.size());
+					for (size_t j = 0; j < model.size(); ++j) {
+						chunk->shapeIndices.push_back(shapeIndices[j]);
+						chunk->materialIndices.push_back(materialIndices[j]);
+					}
 				}
-				else {
-					object.transform = transform;
+				buildSceneHlods(*chunk, options);
+				if (!options.onChunkLoaded(std::move(chunk))) {
+					return false;
 				}
-				scene->objects.push_back(object);
 			}
+			return true;
+		}
+
+		void buildSceneHlods(Scene& scene, const SceneLoader::LoadingOptions& options)
+		{
+			if (!options.buildHlods) {
+				return;
+			}
+			ScopedLoadingPhase phase(options.stats, LoadingStats::Phase::HLOD_BUILDING);
+			HlodOptions hlodOptions = options.hlodOptions;
+			hlodOptions.nbThreads = options.nbThreads;
+			buildHlods(scene, hlodOptions);
 		}
 	}
 }
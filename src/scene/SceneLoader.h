@@ -1,9 +1,13 @@
 #pragma once
 
 #include "ModelLoader.h"
+#include "HlodBuilder.h"
+#include "SceneDescription.h"
 
 #include <memory>
 #include <exception>
+#include <functional>
+#include <istream>
 
 namespace leoscene {
 	class Scene;
@@ -11,26 +15,82 @@ namespace leoscene {
 
 	class SceneLoaderException : public std::exception {
 	public:
+		SceneLoaderException(const char* message);
 		SceneLoaderException(const char* message, size_t lineNb);
 		virtual const char* what() const noexcept;
 	private:
 		const char* message;
 		size_t lineNb;
+		bool hasLineNb;
 	};
 
 	class SceneLoader {
 	public:
-		void loadScene(const char* filePath, Scene* scene, Camera* camera);
-		
+		struct LoadingOptions {
+			// Number of threads importing the scene's models, processing the meshes of each model, loading the textures and
+			// building the HLODs, all sharing the same pool. 0 uses one thread per hardware thread.
+			uint32_t nbThreads = 0;
+
+			// Directory of the persistent cache of processed models and textures (see AssetCache). Empty disables the cache.
+			std::string assetCacheDirectoryPath = "cache";
+
+			// Progressive loading. When set, the objects are not added to the scene: they are handed over to this callback,
+			// on the loading thread, as soon as the model they come from is imported. Each chunk is a self-contained scene
+			// holding the shapes and materials of its objects. The camera is set before the first chunk.
+			// Returning false stops the loading.
+			std::function<bool(std::unique_ptr<Scene> chunk)> onChunkLoaded;
+
+			// Maximum number of objects in a chunk, unless a single instance of a model has more objects.
+			uint32_t nbObjectsPerChunk = 16384;
+
+			// When set, the time and allocations of each loading phase are added to these stats.
+			LoadingStats* stats = nullptr;
+
+			// Reorders the triangles and vertices of the imported meshes for the vertex cache, overdraw and vertex fetch (see MeshOptimizer.h).
+			bool optimizeMeshes = true;
+
+			// Generates simplified levels of detail of the imported meshes, selected by the culling shader (see MeshSimplifier.h).
+			bool generateLods = true;
+
+			// Splits the full imported meshes into clusters, culled one by one by the renderer (see MeshClusters.h).
+			bool buildClusters = true;
+
+			// Compresses the textures of the imported models into block-compressed formats with precomputed mip levels (see TextureCompression.h).
+			bool compressTextures = true;
+
+			// Merges the groups of nearby objects into proxies, drawn by the renderer instead of the objects when they are far (see HlodBuilder.h).
+			// When loading progressively, the objects are grouped within each chunk. The number of threads is nbThreads.
+			bool buildHlods = true;
+			HlodOptions hlodOptions;
+		};
+
+	public:
+		// Loads a text (.scene) or a binary (compiled) scene file. The format is detected from the file's content.
+		void loadScene(const char* filePath, Scene* scene, Camera* camera, LoadingOptions options = {});
+
+		// Compiles a text scene file into the binary scene format (see SceneBinaryFormat.h).
+		// Model paths are kept relative, so the binary file should be placed in the same directory as the text file.
+		static void compileScene(const char* textFilePath, const char* binaryFilePath);
+
+		// Parses a text scene file into flat tables. Does not load any model.
+		static void parseTextScene(const char* filePath, SceneDescription& description);
+
 	private:
-		void _loadModelEntry(
-			std::stringstream& entry,
-			std::unordered_map<std::string, Model>& models,
-			const std::unordered_map<std::string, std::shared_ptr<const Transform>>& transforms,
+		static void _parseTextScene(std::istream& stream, SceneDescription& description);
+
+		void _loadBinaryScene(const unsigned char* data, size_t size, const std::string& fileDirectoryPath, Scene* scene, Camera* camera, const LoadingOptions& options);
+
+		void _instantiateScene(
+			const std::vector<SceneDescription::ModelEntry>& models,
+			const SceneDescription::TransformEntry* transforms,
+			const SceneDescription::InstanceEntry* instances,
+			size_t nbInstances,
 			const std::string& fileDirectoryPath,
-			size_t lineNb);
+			Scene* scene,
+			const LoadingOptions& options);
 
 	private:
 		ModelLoader _modelLoader;
+		std::shared_ptr<ThreadPool> _threadPool;
 	};
 }
@@ -0,0 +1,761 @@
+#include "TextureCompression.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+namespace leoscene {
+	namespace {
+		const size_t BLOCK_SIDE = 4;
+		const size_t BLOCK_NB_TEXELS = BLOCK_SIDE * BLOCK_SIDE;
+		const size_t MIP_LEVEL_ALIGNMENT = 4;
+
+		// Interpolation weights of the 4 colors of BC1, towards the second endpoint, by index
+		const float BC1_WEIGHTS[4] = { 0.f, 1.f, 1.f / 3.f, 2.f / 3.f };
+
+		// Interpolation weights of the 16 values of BC7 mode 6, in 64ths, by index
+		const int BC7_WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+		// Refinements of the endpoints by least squares, stopped as soon as one does not lower the error
+		const int NB_REFINEMENTS = 2;
+
+		void encodeBC1Block(const unsigned char* rgba, unsigned char* block);
+		void encodeBC4Block(const unsigned char* rgba, size_t channel, unsigned char* block);
+		void encodeBC7Block(const unsigned char* rgba, unsigned char* block);
+		void decodeBC1Block(const unsigned char* block, unsigned char* rgba);
+		void decodeBC4Block(const unsigned char* block, size_t channel, unsigned char* rgba);
+		void decodeBC7Block(const unsigned char* block, unsigned char* rgba);
+
+		void computeBC1Palette(uint16_t color0, uint16_t color1, int palette[4][3]);
+		float evaluateBC1(const float texels[BLOCK_NB_TEXELS][4], uint16_t& color0, uint16_t& color1, uint32_t& indices);
+		uint16_t packColor565(const float* color);
+		void computeBC4Palette(int value0, int value1, int palette[8]);
+		float quantizeBC7(const float texels[BLOCK_NB_TEXELS][4], const float* low, const float* high, int endpoints[2][4], uint32_t pBits[2], uint8_t indices[BLOCK_NB_TEXELS]);
+		float evaluateBC7(const float texels[BLOCK_NB_TEXELS][4], const int endpoints[2][4], const uint32_t pBits[2], uint8_t indices[BLOCK_NB_TEXELS]);
+
+		void toFloatTexels(const unsigned char* rgba, float texels[BLOCK_NB_TEXELS][4]);
+		void computePrincipalEndpoints(const float texels[BLOCK_NB_TEXELS][4], size_t nbChannels, float* low, float* high);
+		bool fitEndpoints(const float texels[BLOCK_NB_TEXELS][4], const float* weights, size_t nbChannels, float* low, float* high);
+		void writeBits(unsigned char* block, size_t& bitOffset, uint32_t value, size_t nbBits);
+		uint32_t readBits(const unsigned char* block, size_t& bitOffset, size_t nbBits);
+
+		void downsample(const unsigned char* source, size_t width, size_t height, size_t nbChannels, unsigned char* destination, bool srgb);
+		float srgbToLinear(unsigned char value);
+		unsigned char linearToSrgb(float value);
+	}
+
+	size_t getCompressedBlockSize(ImageTexture::Compression compression)
+	{
+		switch (compression) {
+		case ImageTexture::Compression::BC1:
+		case ImageTexture::Compression::BC4:
+			return 8;
+		case ImageTexture::Compression::BC5:
+		case ImageTexture::Compression::BC7:
+			return 16;
+		default:
+			return 0;
+		}
+	}
+
+	size_t getCompressedImageSize(ImageTexture::Compression compression, size_t width, size_t height)
+	{
+		return ((width + BLOCK_SIDE - 1) / BLOCK_SIDE) * ((height + BLOCK_SIDE - 1) / BLOCK_SIDE) * getCompressedBlockSize(compression);
+	}
+
+	std::vector<ImageTexture::MipLevel> getMipChain(ImageTexture::Layout layout, ImageTexture::Compression compression, size_t width, size_t height)
+	{
+		std::vector<ImageTexture::MipLevel> mipLevels;
+		size_t nbChannels = ImageTexture::getNbChannelsFromLayout(layout);
+		if (!width || !height || (compression == ImageTexture::Compression::NONE ? !nbChannels : !getCompressedBlockSize(compression))) {
+			return mipLevels;
+		}
+		size_t offset = 0;
+		while (true) {
+			ImageTexture::MipLevel mipLevel;
+			mipLevel.width = width;
+			mipLevel.height = height;
+			mipLevel.offset = offset;
+			mipLevel.size = compression == ImageTexture::Compression::NONE ? width * height * nbChannels : getCompressedImageSize(compression, width, height);
+			mipLevels.push_back(mipLevel);
+			offset = (offset + mipLevel.size + MIP_LEVEL_ALIGNMENT - 1) & ~(MIP_LEVEL_ALIGNMENT - 1);
+			if (width == 1 && height == 1) {
+				return mipLevels;
+			}
+			width = std::max<size_t>(width / 2, 1);
+			height = std::max<size_t>(height / 2, 1);
+		}
+	}
+
+	std::shared_ptr<ImageTexture> generateMipLevels(const ImageTexture& texture, bool srgb)
+	{
+		std::vector<ImageTexture::MipLevel> mipLevels = getMipChain(texture.layout, ImageTexture::Compression::NONE, texture.width, texture.height);
+		if (mipLevels.empty() || texture.compression != ImageTexture::Compression::NONE) {
+			return nullptr;
+		}
+
+		unsigned char* data = new unsigned char[mipLevels.back().offset + mipLevels.back().size]();  // Zeroed alignment padding
+		memcpy(data, texture.data, mipLevels[0].size);
+		for (size_t level = 1; level < mipLevels.size(); ++level) {
+			const ImageTexture::MipLevel& previousMipLevel = mipLevels[level - 1];
+			downsample(data + previousMipLevel.offset, previousMipLevel.width, previousMipLevel.height, texture.nbChannels, data + mipLevels[level].offset, srgb);
+		}
+
+		return std::make_shared<ImageTexture>(texture.width, texture.height, texture.type, texture.layout, ImageTexture::Compression::NONE, std::move(mipLevels), data);
+	}
+
+	std::shared_ptr<ImageTexture> compressTexture(const ImageTexture& texture, ImageTexture::Compression compression)
+	{
+		ImageTexture::Layout layout = ImageTexture::getLayoutFromCompression(compression);
+		std::vector<ImageTexture::MipLevel> mipLevels = getMipChain(layout, compression, texture.width, texture.height);
+		if (mipLevels.empty() || texture.compression != ImageTexture::Compression::NONE || !texture.nbChannels) {
+			return nullptr;
+		}
+
+		// Texels of the level being compressed, expanded to RGBA. Single channel textures are gray.
+		size_t nbTexels = texture.width * texture.height;
+		std::vector<unsigned char> levelTexels(nbTexels * 4);
+		for (size_t i = 0; i < nbTexels; ++i) {
+			const unsigned char* source = texture.data + i * texture.nbChannels;
+			unsigned char* destination = levelTexels.data() + i * 4;
+			for (size_t channel = 0; channel < 3; ++channel) {
+				destination[channel] = texture.nbChannels == 1 ? source[0] : channel < texture.nbChannels ? source[channel] : 0;
+			}
+			destination[3] = texture.nbChannels == 4 ? source[3] : 255;
+		}
+
+		bool srgb = compression == ImageTexture::Compression::BC1 || compression == ImageTexture::Compression::BC7;
+		unsigned char* data = new unsigned char[mipLevels.back().offset + mipLevels.back().size];
+		std::vector<unsigned char> nextLevelTexels;
+		for (size_t level = 0; level < mipLevels.size(); ++level) {
+			const ImageTexture::MipLevel& mipLevel = mipLevels[level];
+			if (level) {
+				const ImageTexture::MipLevel& previousMipLevel = mipLevels[level - 1];
+				nextLevelTexels.resize(mipLevel.width * mipLevel.height * 4);
+				downsample(levelTexels.data(), previousMipLevel.width, previousMipLevel.height, 4, nextLevelTexels.data(), srgb);
+				levelTexels.swap(nextLevelTexels);
+			}
+			compressImage(compression, levelTexels.data(), mipLevel.width, mipLevel.height, data + mipLevel.offset);
+		}
+
+		return std::make_shared<ImageTexture>(texture.width, texture.height, texture.type, layout, compression, std::move(mipLevels), data);
+	}
+
+	void compressImage(ImageTexture::Compression compression, const unsigned char* rgba, size_t width, size_t height, unsigned char* destination)
+	{
+		size_t blockSize = getCompressedBlockSize(compression);
+		unsigned char blockTexels[BLOCK_NB_TEXELS * 4];
+		for (size_t blockY = 0; blockY < height; blockY += BLOCK_SIDE) {
+			for (size_t blockX = 0; blockX < width; blockX += BLOCK_SIDE) {
+				// The texels of partial blocks outside of the image repeat the border
+				for (size_t y = 0; y < BLOCK_SIDE; ++y) {
+					size_t imageY = std::min(blockY + y, height - 1);
+					for (size_t x = 0; x < BLOCK_SIDE; ++x) {
+						size_t imageX = std::min(blockX + x, width - 1);
+						memcpy(blockTexels + (y * BLOCK_SIDE + x) * 4, rgba + (imageY * width + imageX) * 4, 4);
+					}
+				}
+
+				switch (compression) {
+				case ImageTexture::Compression::BC1:
+					encodeBC1Block(blockTexels, destination);
+					break;
+				case ImageTexture::Compression::BC4:
+					encodeBC4Block(blockTexels, 0, destination);
+					break;
+				case ImageTexture::Compression::BC5:
+					encodeBC4Block(blockTexels, 0, destination);
+					encodeBC4Block(blockTexels, 1, destination + 8);
+					break;
+				case ImageTexture::Compression::BC7:
+					encodeBC7Block(blockTexels, destination);
+					break;
+				default:
+					break;
+				}
+				destination += blockSize;
+			}
+		}
+	}
+
+	void decompressImage(ImageTexture::Compression compression, const unsigned char* source, size_t width, size_t height, unsigned char* rgba)
+	{
+		size_t blockSize = getCompressedBlockSize(compression);
+		unsigned char blockTexels[BLOCK_NB_TEXELS * 4];
+		for (size_t blockY = 0; blockY < height; blockY += BLOCK_SIDE) {
+			for (size_t blockX = 0; blockX < width; blockX += BLOCK_SIDE) {
+				decompressBlock(compression, source, blockTexels);
+				source += blockSize;
+				for (size_t y = 0; y < BLOCK_SIDE && blockY + y < height; ++y) {
+					for (size_t x = 0; x < BLOCK_SIDE && blockX + x < width; ++x) {
+						memcpy(rgba + ((blockY + y) * width + blockX + x) * 4, blockTexels + (y * BLOCK_SIDE + x) * 4, 4);
+					}
+				}
+			}
+		}
+	}
+
+	void decompressBlock(ImageTexture::Compression compression, const unsigned char* block, unsigned char* rgba)
+	{
+		for (size_t i = 0; i < BLOCK_NB_TEXELS; ++i) {
+			rgba[i * 4] = rgba[i * 4 + 1] = rgba[i * 4 + 2] = 0;
+			rgba[i * 4 + 3] = 255;
+		}
+		switch (compression) {
+		case ImageTexture::Compression::BC1:
+			decodeBC1Block(block, rgba);
+			break;
+		case ImageTexture::Compression::BC4:
+			decodeBC4Block(block, 0, rgba);
+			break;
+		case ImageTexture::Compression::BC5:
+			decodeBC4Block(block, 0, rgba);
+			decodeBC4Block(block + 8, 1, rgba);
+			break;
+		case ImageTexture::Compression::BC7:
+			decodeBC7Block(block, rgba);
+			break;
+		default:
+			break;
+		}
+	}
+
+	namespace {
+		/*
+		* BC1
+		*/
+
+		void encodeBC1Block(const unsigned char* rgba, unsigned char* block)
+		{
+			float texels[BLOCK_NB_TEXELS][4];
+			toFloatTexels(rgba, texels);
+
+			float low[4], high[4];
+			computePrincipalEndpoints(texels, 3, low, high);
+			uint16_t color0 = packColor565(high);
+			uint16_t color1 = packColor565(low);
+			uint32_t indices = 0;
+			float error = evaluateBC1(texels, color0, color1, indices);
+
+			for (int refinement = 0; refinement < NB_REFINEMENTS && color0 != color1; ++refinement) {
+				float weights[BLOCK_NB_TEXELS];
+				for (size_t i = 0; i < BLOCK_NB_TEXELS; ++i) {
+					weights[i] = BC1_WEIGHTS[(indices >> (2 * i)) & 3];
+				}
+				if (!fitEndpoints(texels, weights, 3, high, low)) {
+					break;
+				}
+				uint16_t refinedColor0 = packColor565(high);
+				uint16_t refinedColor1 = packColor565(low);
+				uint32_t refinedIndices = 0;
+				float refinedError = evaluateBC1(texels, refinedColor0, refinedColor1, refinedIndices);
+				if (refinedError >= error) {
+					break;
+				}
+				color0 = refinedColor0;
+				color1 = refinedColor1;
+				indices = refinedIndices;
+				error = refinedError;
+			}
+
+			block[0] = static_cast<unsigned char>(color0 & 0xff);
+			block[1] = static_cast<unsigned char>(color0 >> 8);
+			block[2] = static_cast<unsigned char>(color1 & 0xff);
+			block[3] = static_cast<unsigned char>(color1 >> 8);
+			for (size_t i = 0; i < 4; ++i) {
+				block[4 + i] = static_cast<unsigned char>((indices >> (8 * i)) & 0xff);
+			}
+		}
+
+		void decodeBC1Block(const unsigned char* block, unsigned char* rgba)
+		{
+			uint16_t color0 = static_cast<uint16_t>(block[0] | (block[1] << 8));
+			uint16_t color1 = static_cast<uint16_t>(block[2] | (block[3] << 8));
+			uint32_t indices = block[4] | (block[5] << 8) | (block[6] << 16) | (uint32_t(block[7]) << 24);
+			int palette[4][3];
+			computeBC1Palette(color0, color1, palette);
+			for (size_t i = 0; i < BLOCK_NB_TEXELS; ++i) {
+				const int* color = palette[(indices >> (2 * i)) & 3];
+				for (size_t channel = 0; channel < 3; ++channel) {
+					rgba[i * 4 + channel] = static_cast<unsigned char>(color[channel]);
+				}
+			}
+		}
+
+		// With color0 > color1, the two other colors are at a third and two thirds. Otherwise, the third color is halfway and the
+		// fourth is black. The encoder only uses the second case when both endpoints are equal.
+		void computeBC1Palette(uint16_t color0, uint16_t color1, int palette[4][3])
+		{
+			uint16_t colors[2] = { color0, color1 };
+			for (size_t i = 0; i < 2; ++i) {
+				int r = (colors[i] >> 11) & 31;
+				int g = (colors[i] >> 5) & 63;
+				int b = colors[i] & 31;
+				palette[i][0] = (r << 3) | (r >> 2);
+				palette[i][1] = (g << 2) | (g >> 4);
+				palette[i][2] = (b << 3) | (b >> 2);
+			}
+			for (size_t channel = 0; channel < 3; ++channel) {
+				if (color0 > color1) {
+					palette[2][channel] = (2 * palette[0][channel] + palette[1][channel]) / 3;
+					palette[3][channel] = (palette[0][channel] + 2 * palette[1][channel]) / 3;
+				}
+				else {
+					palette[2][channel] = (palette[0][channel] + palette[1][channel]) / 2;
+					palette[3][channel] = 0;
+				}
+			}
+		}
+
+		// Orders the endpoints for the 4 colors mode, picks the nearest color of each texel and returns the squared error of the block.
+		float evaluateBC1(const float texels[BLOCK_NB_TEXELS][4], uint16_t& color0, uint16_t& color1, uint32_t& indices)
+		{
+			if (color0 < color1) {
+				std::swap(color0, color1);
+			}
+			int palette[4][3];
+			computeBC1Palette(color0, color1, palette);
+
+			indices = 0;
+			float error = 0;
+			for (size_t i = 0; i < BLOCK_NB_TEXELS; ++i) {
+				float bestError = std::numeric_limits<float>::max();
+				uint32_t bestIndex = 0;
+				for (uint32_t index = 0; index < 4; ++index) {
+					float texelError = 0;
+					for (size_t channel = 0; channel < 3; ++channel) {
+						float difference = texels[i][channel] - palette[index][channel];
+						texelError += difference * difference;
+					}
+					if (texelError < bestError) {
+						bestError = texelError;
+						bestIndex = index;
+					}
+				}
+				indices |= bestIndex << (2 * i);
+				error += bestError;
+			}
+			return error;
+		}
+
+		uint16_t packColor565(const float* color)
+		{
+			int r = static_cast<int>(std::lround(std::clamp(color[0], 0.f, 255.f) * 31.f / 255.f));
+			int g = static_cast<int>(std::lround(std::clamp(color[1], 0.f, 255.f) * 63.f / 255.f));
+			int b = static_cast<int>(std::lround(std::clamp(color[2], 0.f, 255.f) * 31.f / 255.f));
+			return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+		}
+
+		/*
+		* BC4. The endpoints are the extreme values of the block, so that the 8 values mode is used.
+		*/
+
+		void encodeBC4Block(const unsigned char* rgba, size_t channel, unsigned char* block)
+		{
+			int minValue = 255, maxValue = 0;
+			for (size_t i = 0; i < BLOCK_NB_TEXELS; ++i) {
+				minValue = std::min<int>(minValue, rgba[i * 4 + channel]);
+				maxValue = std::max<int>(maxValue, rgba[i * 4 + channel]);
+			}
+			int palette[8];
+			computeBC4Palette(maxValue, minValue, palette);
+
+			uint64_t indices = 0;
+			for (size_t i = 0; i < BLOCK_NB_TEXELS; ++i) {
+				int value = rgba[i * 4 + channel];
+				uint64_t bestIndex = 0;
+				for (uint64_t index = 1; index < 8; ++index) {
+					if (std::abs(palette[index] - value) < std::abs(palette[bestIndex] - value)) {
+						bestIndex = index;
+					}
+				}
+				indices |= bestIndex << (3 * i);
+			}
+
+			block[0] = static_cast<unsigned char>(maxValue);
+			block[1] = static_cast<unsigned char>(minValue);
+			for (size_t i = 0; i < 6; ++i) {
+				block[2 + i] = static_cast<unsigned char>((indices >> (8 * i)) & 0xff);
+			}
+		}
+
+		void decodeBC4Block(const unsigned char* block, size_t channel, unsigned char* rgba)
+		{
+			int palette[8];
+			computeBC4Palette(block[0], block[1], palette);
+			uint64_t indices = 0;
+			for (size_t i = 0; i < 6; ++i) {
+				indices |= uint64_t(block[2 + i]) << (8 * i);
+			}
+			for (size_t i = 0; i < BLOCK_NB_TEXELS; ++i) {
+				rgba[i * 4 + channel] = static_cast<unsigned char>(palette[(indices >> (3 * i)) & 7]);
+			}
+		}
+
+		// With value0 > value1, 6 values are interpolated between them. Otherwise, 4 values are, and the last two are 0 and 255.
+		void computeBC4Palette(int value0, int value1, int palette[8])
+		{
+			palette[0] = value0;
+			palette[1] = value1;
+			if (value0 > value1) {
+				for (int i = 1; i < 7; ++i) {
+					palette[i + 1] = ((7 - i) * value0 + i * value1 + 3) / 7;
+				}
+			}
+			else {
+				for (int i = 1; i < 5; ++i) {
+					palette[i + 1] = ((5 - i) * value0 + i * value1 + 2) / 5;
+				}
+				palette[6] = 0;
+				palette[7] = 255;
+			}
+		}
+
+		/*
+		* BC7 mode 6. Bits, from the lowest: the mode (0000001), the 7 highest bits of the red, green, blue and alpha channels
+		* of both endpoints, the lowest bit of each endpoint, then the 4-bit index of each texel. The index of the first texel
+		* only has its 3 lowest bits: its highest bit is 0, which the encoder ensures by swapping the endpoints.
+		*/
+
+		void encodeBC7Block(const unsigned char* rgba, unsigned char* block)
+		{
+			float texels[BLOCK_NB_TEXELS][4];
+			toFloatTexels(rgba, texels);
+
+			float low[4], high[4];
+			computePrincipalEndpoints(texels, 4, low, high);
+			int endpoints[2][4];
+			uint32_t pBits[2];
+			uint8_t indices[BLOCK_NB_TEXELS];
+			float error = quantizeBC7(texels, low, high, endpoints, pBits, indices);
+
+			for (int refinement = 0; refinement < NB_REFINEMENTS; ++refinement) {
+				float weights[BLOCK_NB_TEXELS];
+				for (size_t i = 0; i < BLOCK_NB_TEXELS; ++i) {
+					weights[i] = BC7_WEIGHTS[indices[i]] / 64.f;
+				}
+				if (!fitEndpoints(texels, weights, 4, low, high)) {
+					break;
+				}
+				int refinedEndpoints[2][4];
+				uint32_t refinedPBits[2];
+				uint8_t refinedIndices[BLOCK_NB_TEXELS];
+				float refinedError = quantizeBC7(texels, low, high, refinedEndpoints, refinedPBits, refinedIndices);
+				if (refinedError >= error) {
+					break;
+				}
+				memcpy(endpoints, refinedEndpoints, sizeof(endpoints));
+				memcpy(pBits, refinedPBits, sizeof(pBits));
+				memcpy(indices, refinedIndices, sizeof(indices));
+				error = refinedError;
+			}
+
+			// The weights are symmetric: swapping the endpoints and mirroring the indices gives the same colors.
+			if (indices[0] >= 8) {
+				std::swap(endpoints[0], endpoints[1]);
+				std::swap(pBits[0], pBits[1]);
+				for (size_t i = 0; i < BLOCK_NB_TEXELS; ++i) {
+					indices[i] = static_cast<uint8_t>(15 - indices[i]);
+				}
+			}
+
+			memset(block, 0, 16);
+			size_t bitOffset = 0;
+			writeBits(block, bitOffset, 1 << 6, 7);
+			for (size_t channel = 0; channel < 4; ++channel) {
+				writeBits(block, bitOffset, endpoints[0][channel], 7);
+				writeBits(block, bitOffset, endpoints[1][channel], 7);
+			}
+			writeBits(block, bitOffset, pBits[0], 1);
+			writeBits(block, bitOffset, pBits[1], 1);
+			for (size_t i = 0; i < BLOCK_NB_TEXELS; ++i) {
+				writeBits(block, bitOffset, indices[i], i ? 4 : 3);
+			}
+		}
+
+		// Blocks of the other modes decode to transparent black.
+		void decodeBC7Block(const unsigned char* block, unsigned char* rgba)
+		{
+			if ((block[0] & 0x7f) != (1 << 6)) {
+				memset(rgba, 0, BLOCK_NB_TEXELS * 4);
+				return;
+			}
+
+			size_t bitOffset = 7;
+			int endpoints[2][4];
+			for (size_t channel = 0; channel < 4; ++channel) {
+				endpoints[0][channel] = readBits(block, bitOffset, 7);
+				endpoints[1][channel] = readBits(block, bitOffset, 7);
+			}
+			uint32_t pBits[2];
+			pBits[0] = readBits(block, bitOffset, 1);
+			pBits[1] = readBits(block, bitOffset, 1);
+			for (size_t i = 0; i < BLOCK_NB_TEXELS; ++i) {
+				int weight = BC7_WEIGHTS[readBits(block, bitOffset, i ? 4 : 3)];
+				for (size_t channel = 0; channel < 4; ++channel) {
+					int value0 = (endpoints[0][channel] << 1) | pBits[0];
+					int value1 = (endpoints[1][channel] << 1) | pBits[1];
+					rgba[i * 4 + channel] = static_cast<unsigned char>(((64 - weight) * value0 + weight * value1 + 32) >> 6);
+				}
+			}
+		}
+
+		// Quantizes the endpoints with each of the 4 combinations of their lowest bits, and keeps the one with the smallest error.
+		float quantizeBC7(
+			const float texels[BLOCK_NB_TEXELS][4],
+			const float* low,
+			const float* high,
+			int endpoints[2][4],
+			uint32_t pBits[2],
+			uint8_t indices[BLOCK_NB_TEXELS])
+		{
+			float bestError = std::numeric_limits<float>::max();
+			for (uint32_t combination = 0; combination < 4; ++combination) {
+				uint32_t candidatePBits[2] = { combination & 1, combination >> 1 };
+				int candidateEndpoints[2][4];
+				const float* floatEndpoints[2] = { low, high };
+				for (size_t endpoint = 0; endpoint < 2; ++endpoint) {
+					for (size_t channel = 0; channel < 4; ++channel) {
+						float value = (floatEndpoints[endpoint][channel] - candidatePBits[endpoint]) * 0.5f;
+						candidateEndpoints[endpoint][channel] = std::clamp(static_cast<int>(std::lround(value)), 0, 127);
+					}
+				}
+				uint8_t candidateIndices[BLOCK_NB_TEXELS];
+				float error = evaluateBC7(texels, candidateEndpoints, candidatePBits, candidateIndices);
+				if (error < bestError) {
+					bestError = error;
+					memcpy(endpoints, candidateEndpoints, sizeof(candidateEndpoints));
+					memcpy(pBits, candidatePBits, sizeof(candidatePBits));
+					memcpy(indices, candidateIndices, sizeof(candidateIndices));
+				}
+			}
+			return bestError;
+		}
+
+		// Picks the nearest value of each texel and returns the squared error of the block.
+		float evaluateBC7(const float texels[BLOCK_NB_TEXELS][4], const int endpoints[2][4], const uint32_t pBits[2], uint8_t indices[BLOCK_NB_TEXELS])
+		{
+			int palette[16][4];
+			for (size_t channel = 0; channel < 4; ++channel) {
+				int value0 = (endpoints[0][channel] << 1) | pBits[0];
+				int value1 = (endpoints[1][channel] << 1) | pBits[1];
+				for (size_t index = 0; index < 16; ++index) {
+					palette[index][channel] = ((64 - BC7_WEIGHTS[index]) * value0 + BC7_WEIGHTS[index] * value1 + 32) >> 6;
+				}
+			}
+
+			// The values are on a line: the nearest one is next to the projection of the texel on the line.
+			float direction[4];
+			float squaredLength = 0;
+			for (size_t channel = 0; channel < 4; ++channel) {
+				direction[channel] = float(palette[15][channel] - palette[0][channel]);
+				squaredLength += direction[channel] * direction[channel];
+			}
+			float error = 0;
+			for (size_t i = 0; i < BLOCK_NB_TEXELS; ++i) {
+				float projection = 0;
+				for (size_t channel = 0; channel < 4; ++channel) {
+					projection += (texels[i][channel] - palette[0][channel]) * direction[channel];
+				}
+				int nearestWeight = squaredLength > 0 ? static_cast<int>(std::lround(std::clamp(projection / squaredLength, 0.f, 1.f) * 64.f)) : 0;
+				int firstIndex = static_cast<int>(std::lower_bound(BC7_WEIGHTS, BC7_WEIGHTS + 16, nearestWeight) - BC7_WEIGHTS);
+
+				float bestError = std::numeric_limits<float>::max();
+				for (int index = std::max(firstIndex - 1, 0); index <= std::min(firstIndex + 1, 15); ++index) {
+					float texelError = 0;
+					for (size_t channel = 0; channel < 4; ++channel) {
+						float difference = texels[i][channel] - palette[index][channel];
+						texelError += difference * difference;
+					}
+					if (texelError < bestError) {
+						bestError = texelError;
+						indices[i] = static_cast<uint8_t>(index);
+					}
+				}
+				error += bestError;
+			}
+			return error;
+		}
+
+		/*
+		* Endpoint fitting
+		*/
+
+		void toFloatTexels(const unsigned char* rgba, float texels[BLOCK_NB_TEXELS][4])
+		{
+			for (size_t i = 0; i < BLOCK_NB_TEXELS; ++i) {
+				for (size_t channel = 0; channel < 4; ++channel) {
+					texels[i][channel] = rgba[i * 4 + channel];
+				}
+			}
+		}
+
+		// Endpoints at the extreme projections of the texels on the principal axis of their covariance, found by power iteration.
+		void computePrincipalEndpoints(const float texels[BLOCK_NB_TEXELS][4], size_t nbChannels, float* low, float* high)
+		{
+			float mean[4] = {};
+			for (size_t i = 0; i < BLOCK_NB_TEXELS; ++i) {
+				for (size_t channel = 0; channel < nbChannels; ++channel) {
+					mean[channel] += texels[i][channel] / BLOCK_NB_TEXELS;
+				}
+			}
+			float covariance[4][4] = {};
+			for (size_t i = 0; i < BLOCK_NB_TEXELS; ++i) {
+				for (size_t a = 0; a < nbChannels; ++a) {
+					for (size_t b = 0; b < nbChannels; ++b) {
+						covariance[a][b] += (texels[i][a] - mean[a]) * (texels[i][b] - mean[b]);
+					}
+				}
+			}
+
+			// Starts from the column of the channel that varies the most
+			size_t largestChannel = 0;
+			for (size_t channel = 1; channel < nbChannels; ++channel) {
+				if (covariance[channel][channel] > covariance[largestChannel][largestChannel]) {
+					largestChannel = channel;
+				}
+			}
+			float axis[4] = {};
+			for (size_t channel = 0; channel < nbChannels; ++channel) {
+				axis[channel] = covariance[channel][largestChannel];
+			}
+			for (int iteration = 0; iteration < 8; ++iteration) {
+				float length = 0;
+				for (size_t channel = 0; channel < nbChannels; ++channel) {
+					length += axis[channel] * axis[channel];
+				}
+				length = std::sqrt(length);
+				if (length < 1e-6f) {
+					break;
+				}
+				float nextAxis[4] = {};
+				for (size_t a = 0; a < nbChannels; ++a) {
+					axis[a] /= length;
+				}
+				for (size_t a = 0; a < nbChannels; ++a) {
+					for (size_t b = 0; b < nbChannels; ++b) {
+						nextAxis[a] += covariance[a][b] * axis[b];
+					}
+				}
+				if (iteration < 7) {
+					memcpy(axis, nextAxis, sizeof(axis));
+				}
+			}
+
+			float minProjection = 0, maxProjection = 0;
+			for (size_t i = 0; i < BLOCK_NB_TEXELS; ++i) {
+				float projection = 0;
+				for (size_t channel = 0; channel < nbChannels; ++channel) {
+					projection += (texels[i][channel] - mean[channel]) * axis[channel];
+				}
+				minProjection = std::min(minProjection, projection);
+				maxProjection = std::max(maxProjection, projection);
+			}
+			for (size_t channel = 0; channel < 4; ++channel) {
+				low[channel] = std::clamp(mean[channel] + minProjection * axis[channel], 0.f, 255.f);
+				high[channel] = std::clamp(mean[channel] + maxProjection * axis[channel], 0.f, 255.f);
+			}
+		}
+
+		// Endpoints minimizing the squared error of the texels interpolated with the given weights (0 for low, 1 for high).
+		// Returns false if the weights do not determine them, when they are all the same.
+		bool fitEndpoints(const float texels[BLOCK_NB_TEXELS][4], const float* weights, size_t nbChannels, float* low, float* high)
+		{
+			float lowLow = 0, lowHigh = 0, highHigh = 0;
+			float lowTexels[4] = {}, highTexels[4] = {};
+			for (size_t i = 0; i < BLOCK_NB_TEXELS; ++i) {
+				float lowWeight = 1.f - weights[i];
+				float highWeight = weights[i];
+				lowLow += lowWeight * lowWeight;
+				lowHigh += lowWeight * highWeight;
+				highHigh += highWeight * highWeight;
+				for (size_t channel = 0; channel < nbChannels; ++channel) {
+					lowTexels[channel] += lowWeight * texels[i][channel];
+					highTexels[channel] += highWeight * texels[i][channel];
+				}
+			}
+			float determinant = lowLow * highHigh - lowHigh * lowHigh;
+			if (std::abs(determinant) < 1e-6f) {
+				return false;
+			}
+			for (size_t channel = 0; channel < nbChannels; ++channel) {
+				low[channel] = std::clamp((highHigh * lowTexels[channel] - lowHigh * highTexels[channel]) / determinant, 0.f, 255.f);
+				high[channel] = std::clamp((lowLow * highTexels[channel] - lowHigh * lowTexels[channel]) / determinant, 0.f, 255.f);
+			}
+			return true;
+		}
+
+		void writeBits(unsigned char* block, size_t& bitOffset, uint32_t value, size_t nbBits)
+		{
+			for (size_t i = 0; i < nbBits; ++i, ++bitOffset) {
+				if ((value >> i) & 1) {
+					block[bitOffset / 8] |= static_cast<unsigned char>(1 << (bitOffset % 8));
+				}
+			}
+		}
+
+		uint32_t readBits(const unsigned char* block, size_t& bitOffset, size_t nbBits)
+		{
+			uint32_t value = 0;
+			for (size_t i = 0; i < nbBits; ++i, ++bitOffset) {
+				value |= uint32_t((block[bitOffset / 8] >> (bitOffset % 8)) & 1) << i;
+			}
+			return value;
+		}
+
+		/*
+		* Mip levels
+		*/
+
+		// Box filter of 2x2 texels. The last row or column of odd sizes is only read by the texels of the border.
+		void downsample(const unsigned char* source, size_t width, size_t height, size_t nbChannels, unsigned char* destination, bool srgb)
+		{
+			size_t nbSrgbChannels = srgb && nbChannels >= 3 ? 3 : 0;
+			size_t destinationWidth = std::max<size_t>(width / 2, 1);
+			size_t destinationHeight = std::max<size_t>(height / 2, 1);
+			for (size_t y = 0; y < destinationHeight; ++y) {
+				size_t sourceYs[2] = { std::min(2 * y, height - 1), std::min(2 * y + 1, height - 1) };
+				for (size_t x = 0; x < destinationWidth; ++x) {
+					size_t sourceXs[2] = { std::min(2 * x, width - 1), std::min(2 * x + 1, width - 1) };
+					float sums[4] = {};
+					for (size_t sourceY : sourceYs) {
+						for (size_t sourceX : sourceXs) {
+							const unsigned char* texel = source + (sourceY * width + sourceX) * nbChannels;
+							for (size_t channel = 0; channel < nbChannels; ++channel) {
+								sums[channel] += channel < nbSrgbChannels ? srgbToLinear(texel[channel]) : texel[channel] / 255.f;
+							}
+						}
+					}
+					unsigned char* destinationTexel = destination + (y * destinationWidth + x) * nbChannels;
+					for (size_t channel = 0; channel < nbChannels; ++channel) {
+						float average = sums[channel] * 0.25f;
+						destinationTexel[channel] = channel < nbSrgbChannels ?
+							linearToSrgb(average) : static_cast<unsigned char>(std::lround(std::clamp(average, 0.f, 1.f) * 255.f));
+					}
+				}
+			}
+		}
+
+		float srgbToLinear(unsigned char value)
+		{
+			static const std::vector<float> table = [] {
+				std::vector<float> values(256);
+				for (size_t i = 0; i < values.size(); ++i) {
+					float srgb = i / 255.f;
+					values[i] = srgb <= 0.04045f ? srgb / 12.92f : std::pow((srgb + 0.055f) / 1.055f, 2.4f);
+				}
+				return values;
+			}();
+			return table[value];
+		}
+
+		unsigned char linearToSrgb(float value)
+		{
+			value = std::clamp(value, 0.f, 1.f);
+			float srgb = value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.f / 2.4f) - 0.055f;
+			return static_cast<unsigned char>(std::lround(std::clamp(srgb, 0.f, 1.f) * 255.f));
+		}
+	}
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "ImageTexture.h"
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+/*
+* Mip chains and block compression of textures, done on the CPU when the textures are loaded so that the renderer uploads them as they are.
+* Each block compression format encodes blocks of 4x4 texels in a fixed number of bytes: two endpoints per block, and for each texel the index of
+* a value interpolated between them. The endpoints are fitted along the principal axis of the texels of the block, then refined
+* by least squares on the chosen indices.
+* - BC1: 8 bytes, RGB endpoints in 5:6:5 bits and 4 colors. Opaque color textures.
+* - BC4: 8 bytes, one channel with 8 values. Height and specular textures.
+* - BC5: 16 bytes, a BC4 block for the red channel and one for the green channel. Normal maps, whose Z follows from X and Y.
+* - BC7: 16 bytes, RGBA. Only mode 6 is encoded and decoded: 7-bit endpoints plus a lowest bit shared by the channels of each
+*   endpoint, and 16 values. Color textures with alpha.
+* BC1 and BC7 textures are in sRGB: their mip levels are filtered in linear space.
+*/
+namespace leoscene {
+	// Size in bytes of a block of 4x4 texels. 0 for Compression::NONE.
+	size_t getCompressedBlockSize(ImageTexture::Compression compression);
+
+	// Size in bytes of a compressed image. The partial blocks on the right and bottom borders take a full block.
+	size_t getCompressedImageSize(ImageTexture::Compression compression, size_t width, size_t height);
+
+	// Levels of the full mip chain of a texture, stored one after another from the largest. The size of the levels of uncompressed textures
+	// follows from the layout, and their offsets are rounded up to a multiple of 4 bytes, as the copies to the GPU require.
+	std::vector<ImageTexture::MipLevel> getMipChain(ImageTexture::Layout layout, ImageTexture::Compression compression, size_t width, size_t height);
+
+	// Returns a copy of the uncompressed texture with its full mip chain, filtered with a box filter. The RGB channels of sRGB textures
+	// are filtered in linear space.
+	std::shared_ptr<ImageTexture> generateMipLevels(const ImageTexture& texture, bool srgb);
+
+	// Returns a texture with the full mip chain of the uncompressed texture, each level compressed. BC4 keeps the first channel
+	// of the texels and BC5 their first two channels.
+	std::shared_ptr<ImageTexture> compressTexture(const ImageTexture& texture, ImageTexture::Compression compression);
+
+	// Compresses an image of RGBA texels into getCompressedImageSize(compression, width, height) bytes.
+	void compressImage(ImageTexture::Compression compression, const unsigned char* rgba, size_t width, size_t height, unsigned char* destination);
+
+	// Decompresses an image into RGBA texels. The channels missing from the format are 0, and alpha is 255.
+	void decompressImage(ImageTexture::Compression compression, const unsigned char* source, size_t width, size_t height, unsigned char* rgba);
+
+	// Decompresses a single block into its 16 RGBA texels, row after row.
+	void decompressBlock(ImageTexture::Compression compression, const unsigned char* block, unsigned char* rgba);
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+
+/*
+* On-disk layout of texture containers (.ltex files).
+*
+* A container holds a texture with its full mip chain, already in the format the renderer uploads, so that loading it is
+* a single read and no mip level is generated at runtime. The file starts with a TextureContainerHeader, followed by:
+*	- Levels: TextureContainerLevelEntry[nbMipLevels], from the largest level.
+*	- Texels: the levels one after another, at the offsets given by getMipChain (see TextureCompression.h), starting at dataOffset,
+*	  which is 16 bytes aligned.
+*
+* Containers are generated from images with LeoTextureCompiler (see TextureLoader::writeTextureContainer), and are also
+* the payload of the asset cache entries of textures. Models can reference them in place of the images.
+*/
+namespace leoscene {
+	namespace texturecontainer {
+		static const char MAGIC[4] = { 'L', 'E', 'O', 'T' };
+		static const uint32_t VERSION = 1;
+		static const uint32_t DATA_ALIGNMENT = 16;
+
+		struct TextureContainerHeader {
+			char magic[4];
+			uint32_t version;
+			uint32_t width;
+			uint32_t height;
+			uint32_t layout;  // ImageTexture::Layout
+			uint32_t compression;  // ImageTexture::Compression
+			uint32_t nbMipLevels;
+			uint32_t padding;
+			uint64_t dataOffset;
+			uint64_t dataSize;
+		};
+
+		struct TextureContainerLevelEntry {
+			uint32_t width;
+			uint32_t height;
+			uint64_t offset;  // Relative to dataOffset
+			uint64_t size;
+		};
+
+		static_assert(sizeof(TextureContainerHeader) == 48, "Texture container header layout changed. Bump VERSION.");
+		static_assert(sizeof(TextureContainerLevelEntry) == 24, "Texture container level entry layout changed. Bump VERSION.");
+	}
+}
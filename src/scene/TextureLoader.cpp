@@ -1,27 +1,162 @@
 #include "TextureLoader.h"
 
 #include "ImageTexture.h"
+#include "MappedFile.h"
+#include "TextureCompression.h"
+#include "TextureContainerFormat.h"
 
 #define STB_IMAGE_IMPLEMENTATION
+#define STBI_NO_FAILURE_STRINGS  // The failure reason is a global written by every failed load, from any loading thread
 #include <stb_image.h>
 
+#include <climits>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
 namespace leoscene {
     namespace {
         ImageTexture::Layout pickLayout(TextureLoader::LoadingOptions options, int nbChannels);
         bool isImageInfoValid(ImageTexture::Layout& layout, int nbChannels);
+        bool isOpaque(const ImageTexture& texture);
+        bool isTextureContainer(const unsigned char* data, size_t size);
+        void serializeTextureContainer(const ImageTexture& texture, std::vector<unsigned char>& bytes);
+        std::shared_ptr<ImageTexture> parseTextureContainer(const unsigned char* data, size_t size);
         void rgbToLuminance(const unsigned char* src, unsigned char* dest, int width, int height, int srcNbCHannels);
     }
 
+    TextureLoader::TextureFuture TextureLoader::requestTexture(const char* filePath, TextureLoader::LoadingOptions options)
+    {
+        // The first request of a file adds its future to the cache, then loads the texture outside of the lock
+        std::shared_ptr<std::promise<std::shared_ptr<ImageTexture>>> promise;
+        TextureFuture texture;
+        {
+            std::lock_guard<std::mutex> lock(_fileTexturesCacheMutex);
+            auto cacheIterator = _fileTexturesCache.find(filePath);
+            if (cacheIterator != _fileTexturesCache.end()) {
+                return cacheIterator->second;
+            }
+            promise = std::make_shared<std::promise<std::shared_ptr<ImageTexture>>>();
+            texture = promise->get_future().share();
+            _fileTexturesCache.emplace(filePath, texture);
+        }
+
+        auto load = [this, promise, path = std::string(filePath), options]() {
+            try {
+                std::shared_ptr<ImageTexture> loadedTexture = _loadTexture(path.c_str(), options);
+                if (loadedTexture) {
+                    std::lock_guard<std::mutex> lock(_fileTexturesCacheMutex);
+                    _textureFilePaths[loadedTexture.get()] = path;
+                }
+                promise->set_value(loadedTexture);
+            }
+            catch (...) {
+                promise->set_exception(std::current_exception());
+            }
+        };
+        if (_threadPool) {
+            _threadPool->submitHelper(load);
+        }
+        else {
+            load();
+        }
+        return texture;
+    }
+
     std::shared_ptr<ImageTexture> TextureLoader::loadTexture(const char* filePath, TextureLoader::LoadingOptions options)
     {
-        auto cacheIterator = _fileTexturesCache.find(filePath);
-        if (cacheIterator != _fileTexturesCache.end()) {
-            return cacheIterator->second;
+        TextureFuture texture = requestTexture(filePath, options);
+        if (_threadPool) {
+            _threadPool->wait(texture);
         }
+        return texture.get();
+    }
+
+    std::string TextureLoader::getTextureFilePath(const ImageTexture* texture)
+    {
+        std::lock_guard<std::mutex> lock(_fileTexturesCacheMutex);
+        auto pathIterator = _textureFilePaths.find(texture);
+        return pathIterator != _textureFilePaths.end() ? pathIterator->second : std::string();
+    }
 
-        stbi_set_flip_vertically_on_load(false);
+    bool TextureLoader::writeTextureContainer(const ImageTexture& texture, const char* filePath)
+    {
+        std::vector<unsigned char> bytes;
+        serializeTextureContainer(texture, bytes);
+        if (bytes.empty()) {
+            return false;
+        }
+
+        std::ofstream ofs(filePath, std::ios::binary | std::ios::trunc);
+        if (!ofs.is_open()) {
+            return false;
+        }
+        ofs.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+        return ofs.good();
+    }
+
+    void TextureLoader::setAssetCache(std::shared_ptr<const AssetCache> assetCache)
+    {
+        _assetCache = assetCache;
+    }
+
+    void TextureLoader::setLoadingStats(LoadingStats* stats)
+    {
+        _stats = stats;
+    }
+
+    void TextureLoader::setNbThreads(size_t nbThreads)
+    {
+        if (nbThreads != (_threadPool ? _threadPool->getNbThreads() : 0)) {
+            _threadPool = nbThreads ? std::make_shared<ThreadPool>(nbThreads) : nullptr;
+        }
+    }
+
+    void TextureLoader::setThreadPool(std::shared_ptr<ThreadPool> threadPool)
+    {
+        _threadPool = threadPool;
+    }
+
+    std::shared_ptr<ImageTexture> TextureLoader::_loadTexture(const char* filePath, TextureLoader::LoadingOptions options)
+    {
+        std::string cacheKey;
+        if (_assetCache) {
+            std::stringstream key;
+            key << "texture:" << filePath << ":" << options.desiredChannels << ":" << static_cast<int>(options.forceLayout) << ":" << static_cast<int>(options.compression) << ":" << options.srgb;
+            cacheKey = key.str();
+            std::shared_ptr<ImageTexture> texture = _loadTextureFromAssetCache(filePath, cacheKey);
+            if (texture) {
+                return texture;
+            }
+        }
+
+        bool isContainer = false;
+        std::shared_ptr<ImageTexture> texture = _decodeTexture(filePath, options, isContainer);
+        // Containers are already processed, and reading them is as fast as reading a cache entry
+        if (texture && !isContainer) {
+            texture = _processTexture(texture, options);
+            if (_assetCache) {
+                _storeTextureInAssetCache(filePath, cacheKey, *texture);
+            }
+        }
+        return texture;
+    }
+
+    std::shared_ptr<ImageTexture> TextureLoader::_decodeTexture(const char* filePath, TextureLoader::LoadingOptions options, bool& isContainer)
+    {
+        ScopedLoadingPhase phase(_stats, LoadingStats::Phase::TEXTURE_DECODING);
+        MappedFile file;
+        if (!file.open(filePath) || file.getSize() > INT_MAX) {
+            return nullptr;
+        }
+        if (isTextureContainer(file.getData(), file.getSize())) {
+            isContainer = true;
+            return parseTextureContainer(file.getData(), file.getSize());
+        }
+
+        // Images are not flipped, stb_image's default. stbi_set_flip_vertically_on_load is not called: it sets a global shared by the loading threads.
         int width = 0, height = 0, nbChannels = 0;
-        unsigned char* data = stbi_load(filePath, &width, &height, &nbChannels, options.desiredChannels);
+        unsigned char* data = stbi_load_from_memory(file.getData(), static_cast<int>(file.getSize()), &width, &height, &nbChannels, options.desiredChannels);
 
         if (!data) {
             return nullptr;
@@ -47,14 +182,56 @@ namespace leoscene {
             }
         }
 
-        _fileTexturesCache[filePath] = std::make_shared<ImageTexture>(
+        return std::make_shared<ImageTexture>(
             static_cast<size_t>(width),
             static_cast<size_t>(height),
             ImageTexture::Type::FLOAT,
             layout,
             data);
+    }
+
+    std::shared_ptr<ImageTexture> TextureLoader::_processTexture(std::shared_ptr<ImageTexture> texture, TextureLoader::LoadingOptions options)
+    {
+        ScopedLoadingPhase phase(_stats, LoadingStats::Phase::TEXTURE_PROCESSING);
+        if (options.compression != ImageTexture::Compression::NONE) {
+            ImageTexture::Compression compression = options.compression;
+            if (compression == ImageTexture::Compression::BC1 && !isOpaque(*texture)) {
+                compression = ImageTexture::Compression::BC7;
+            }
+            std::shared_ptr<ImageTexture> compressedTexture = compressTexture(*texture, compression);
+            if (compressedTexture) {
+                return compressedTexture;
+            }
+        }
+        std::shared_ptr<ImageTexture> mipmappedTexture = generateMipLevels(*texture, options.srgb && texture->nbChannels >= 3);
+        return mipmappedTexture ? mipmappedTexture : texture;
+    }
+
+    /*
+    * Asset cache entries of textures contain a texture container, so that loading them is a single copy.
+    */
 
-        return _fileTexturesCache[filePath];
+    void TextureLoader::_storeTextureInAssetCache(const char* filePath, const std::string& cacheKey, const ImageTexture& texture)
+    {
+        ScopedLoadingPhase phase(_stats, LoadingStats::Phase::ASSET_CACHE);
+        std::vector<unsigned char> payload;
+        serializeTextureContainer(texture, payload);
+        if (!payload.empty()) {
+            _assetCache->store(cacheKey, filePath, payload);
+        }
+    }
+
+    std::shared_ptr<ImageTexture> TextureLoader::_loadTextureFromAssetCache(const char* filePath, const std::string& cacheKey)
+    {
+        ScopedLoadingPhase phase(_stats, LoadingStats::Phase::ASSET_CACHE);
+        MappedFile file;
+        const unsigned char* payload = nullptr;
+        size_t payloadSize = 0;
+        if (!_assetCache->find(cacheKey, filePath, file, payload, payloadSize)) {
+            return nullptr;
+        }
+
+        return parseTextureContainer(payload, payloadSize);
     }
 
     namespace {
@@ -91,6 +268,95 @@ namespace leoscene {
             }
         }
 
+        bool isOpaque(const ImageTexture& texture) {
+            if (texture.nbChannels != 4) {
+                return true;
+            }
+            size_t nbTexels = texture.width * texture.height;
+            for (size_t i = 0; i < nbTexels; ++i) {
+                if (texture.data[i * 4 + 3] != 255) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        bool isTextureContainer(const unsigned char* data, size_t size) {
+            return size >= sizeof(texturecontainer::MAGIC) && !memcmp(data, texturecontainer::MAGIC, sizeof(texturecontainer::MAGIC));
+        }
+
+        void serializeTextureContainer(const ImageTexture& texture, std::vector<unsigned char>& bytes) {
+            using namespace texturecontainer;
+
+            if (texture.mipLevels.empty()) {
+                return;
+            }
+
+            TextureContainerHeader header = {};
+            memcpy(header.magic, MAGIC, sizeof(MAGIC));
+            header.version = VERSION;
+            header.width = static_cast<uint32_t>(texture.width);
+            header.height = static_cast<uint32_t>(texture.height);
+            header.layout = static_cast<uint32_t>(texture.layout);
+            header.compression = static_cast<uint32_t>(texture.compression);
+            header.nbMipLevels = static_cast<uint32_t>(texture.mipLevels.size());
+            size_t levelsSize = texture.mipLevels.size() * sizeof(TextureContainerLevelEntry);
+            header.dataOffset = (sizeof(TextureContainerHeader) + levelsSize + DATA_ALIGNMENT - 1) & ~uint64_t(DATA_ALIGNMENT - 1);
+            header.dataSize = texture.getDataSize();
+
+            bytes.assign(header.dataOffset + header.dataSize, 0);
+            memcpy(bytes.data(), &header, sizeof(header));
+            for (size_t level = 0; level < texture.mipLevels.size(); ++level) {
+                const ImageTexture::MipLevel& mipLevel = texture.mipLevels[level];
+                TextureContainerLevelEntry entry = { static_cast<uint32_t>(mipLevel.width), static_cast<uint32_t>(mipLevel.height), mipLevel.offset, mipLevel.size };
+                memcpy(bytes.data() + sizeof(header) + level * sizeof(entry), &entry, sizeof(entry));
+            }
+            memcpy(bytes.data() + header.dataOffset, texture.data, header.dataSize);
+        }
+
+        std::shared_ptr<ImageTexture> parseTextureContainer(const unsigned char* data, size_t size) {
+            using namespace texturecontainer;
+
+            TextureContainerHeader header;
+            if (size < sizeof(header)) {
+                return nullptr;
+            }
+            memcpy(&header, data, sizeof(header));
+            if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) || header.version != VERSION ||
+                header.layout == static_cast<uint32_t>(ImageTexture::Layout::INVALID) || header.layout > static_cast<uint32_t>(ImageTexture::Layout::RG) ||
+                header.compression > static_cast<uint32_t>(ImageTexture::Compression::BC7))
+            {
+                return nullptr;
+            }
+
+            // The levels are recomputed from the size and format, and must match the ones of the file
+            ImageTexture::Layout layout = static_cast<ImageTexture::Layout>(header.layout);
+            ImageTexture::Compression compression = static_cast<ImageTexture::Compression>(header.compression);
+            if (compression != ImageTexture::Compression::NONE && layout != ImageTexture::getLayoutFromCompression(compression)) {
+                return nullptr;
+            }
+            std::vector<ImageTexture::MipLevel> mipLevels = getMipChain(layout, compression, header.width, header.height);
+            uint64_t levelsEnd = sizeof(header) + uint64_t(header.nbMipLevels) * sizeof(TextureContainerLevelEntry);
+            if (mipLevels.empty() || header.nbMipLevels != mipLevels.size() || levelsEnd > size ||
+                header.dataOffset < levelsEnd || header.dataOffset % DATA_ALIGNMENT != 0 || header.dataOffset > size ||
+                header.dataSize != mipLevels.back().offset + mipLevels.back().size || header.dataSize > size - header.dataOffset)
+            {
+                return nullptr;
+            }
+            for (size_t level = 0; level < mipLevels.size(); ++level) {
+                TextureContainerLevelEntry entry;
+                memcpy(&entry, data + sizeof(header) + level * sizeof(entry), sizeof(entry));
+                const ImageTexture::MipLevel& mipLevel = mipLevels[level];
+                if (entry.width != mipLevel.width || entry.height != mipLevel.height || entry.offset != mipLevel.offset || entry.size != mipLevel.size) {
+                    return nullptr;
+                }
+            }
+
+            unsigned char* texels = new unsigned char[header.dataSize];
+            memcpy(texels, data + header.dataOffset, header.dataSize);
+            return std::make_shared<ImageTexture>(header.width, header.height, ImageTexture::Type::FLOAT, layout, compression, std::move(mipLevels), texels);
+        }
+
         void rgbToLuminance(const unsigned char* src, unsigned char* dest, int width, int height, int srcNbCHannels) {
             for (int i = 0; i < width * height * srcNbCHannels; i += srcNbCHannels) {
                 dest[i / 3] = (unsigned char)((float)src[i] * 0.3f + (float)src[i + 1] * 0.59f + (float)src[i + 2] * 0.11f);
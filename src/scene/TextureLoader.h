@@ -1,22 +1,79 @@
 #pragma once
 
 #include "ImageTexture.h"
+#include "AssetCache.h"
+#include "LoadingStats.h"
+#include "ThreadPool.h"
 
+#include <future>
 #include <unordered_map>
 #include <memory>
+#include <mutex>
 
 namespace leoscene {
+	/*
+	* Loads image textures and caches them by file path. Textures can be requested from several threads at the same time,
+	* and are decoded and processed on the threads of the loader, so that the requesting threads can go on meanwhile.
+	*/
 	class TextureLoader {
 	public:
 		struct LoadingOptions {
 			ImageTexture::Layout forceLayout = ImageTexture::Layout::INVALID;
 			int desiredChannels = 0;
+
+			// Block compression of the texture and of its mip levels, applied before it is written to the asset cache (see TextureCompression.h).
+			// Textures compressed to BC1 whose alpha is not opaque everywhere are compressed to BC7 instead, which keeps alpha.
+			ImageTexture::Compression compression = ImageTexture::Compression::NONE;
+
+			// The RGB channels of sRGB textures are filtered in linear space when generating their mip levels.
+			bool srgb = true;
 		};
 
+		// Texture being loaded. Its value is nullptr if the file could not be loaded.
+		using TextureFuture = std::shared_future<std::shared_ptr<ImageTexture>>;
+
 	public:
+		// Starts loading an image, or a texture container (see TextureContainerFormat.h), which is detected from the file content.
+		// Textures are returned with their full mip chain. The options do not apply to containers, which are loaded as they are.
+		// Each file is loaded once, with the options of its first request: later requests return the same future.
+		TextureFuture requestTexture(const char* filePath, TextureLoader::LoadingOptions options = {});
+
+		// Same as requestTexture, waiting for the texture.
 		std::shared_ptr<ImageTexture> loadTexture(const char* filePath, TextureLoader::LoadingOptions options = {});
 
+		// Writes the texture to a texture container. The texture must have its mip chain (see TextureCompression.h).
+		static bool writeTextureContainer(const ImageTexture& texture, const char* filePath);
+
+		// Path of the file a texture was loaded from. Empty if the texture was not loaded by this loader.
+		std::string getTextureFilePath(const ImageTexture* texture);
+
+		// Decoded textures are read from and written to the given cache. nullptr disables the cache.
+		void setAssetCache(std::shared_ptr<const AssetCache> assetCache);
+
+		// Time and allocations of the loading phases are added to the given stats. nullptr disables the measures.
+		void setLoadingStats(LoadingStats* stats);
+
+		// Textures are decoded and processed on this many threads. 0 by default: each texture is loaded by the thread requesting it.
+		// Must not be called while textures are being loaded.
+		void setNbThreads(size_t nbThreads);
+
+		// Same as setNbThreads, with helper tasks of a pool shared with other work (see ThreadPool). nullptr: each texture is loaded
+		// by the thread requesting it. Threads of the pool must wait for the textures with ThreadPool::wait.
+		void setThreadPool(std::shared_ptr<ThreadPool> threadPool);
+
+	private:
+		std::shared_ptr<ImageTexture> _loadTexture(const char* filePath, TextureLoader::LoadingOptions options);
+		std::shared_ptr<ImageTexture> _decodeTexture(const char* filePath, TextureLoader::LoadingOptions options, bool& isContainer);
+		std::shared_ptr<ImageTexture> _processTexture(std::shared_ptr<ImageTexture> texture, TextureLoader::LoadingOptions options);
+		void _storeTextureInAssetCache(const char* filePath, const std::string& cacheKey, const ImageTexture& texture);
+		std::shared_ptr<ImageTexture> _loadTextureFromAssetCache(const char* filePath, const std::string& cacheKey);
+
 	private:
-		std::unordered_map<std::string, std::shared_ptr<ImageTexture>> _fileTexturesCache;
+		std::unordered_map<std::string, TextureFuture> _fileTexturesCache;
+		std::unordered_map<const ImageTexture*, std::string> _textureFilePaths;
+		std::mutex _fileTexturesCacheMutex;
+		std::shared_ptr<const AssetCache> _assetCache;
+		LoadingStats* _stats = nullptr;
+		std::shared_ptr<ThreadPool> _threadPool;  // nullptr when the textures are loaded by the requesting threads. Last, so that it finishes its tasks first.
 	};
 }
@@ -0,0 +1,227 @@
+#include "TextureResidency.h"
+
+#include "ImageTexture.h"
+
+#include <algorithm>
+
+namespace leoscene {
+	TextureResidency::TextureResidency(const TextureResidencyOptions& options)
+		: _options(options)
+	{
+	}
+
+	uint32_t TextureResidency::addTexture(const ImageTexture& texture)
+	{
+		std::vector<size_t> levelSizes;
+		for (const ImageTexture::MipLevel& level : texture.mipLevels) {
+			levelSizes.push_back(level.size);
+		}
+		if (levelSizes.empty()) {
+			levelSizes.push_back(texture.getDataSize());
+		}
+		return addTexture(static_cast<uint32_t>(texture.width), static_cast<uint32_t>(texture.height), levelSizes);
+	}
+
+	uint32_t TextureResidency::addTexture(uint32_t width, uint32_t height, const std::vector<size_t>& levelSizes)
+	{
+		_textures.emplace_back();
+		_Texture& texture = _textures.back();
+		texture.width = width;
+		texture.height = height;
+		texture.residentSizes.resize(std::max<size_t>(levelSizes.size(), 1), 0);
+		for (size_t level = levelSizes.size(); level > 0; --level) {
+			texture.residentSizes[level - 1] = levelSizes[level - 1] + (level < levelSizes.size() ? texture.residentSizes[level] : 0);
+		}
+
+		uint32_t lastLevel = static_cast<uint32_t>(texture.residentSizes.size() - 1);
+		while (texture.initialLevel < lastLevel && std::max(width >> texture.initialLevel, height >> texture.initialLevel) > _options.initialMaxSize) {
+			texture.initialLevel++;
+		}
+		texture.firstResidentLevel = texture.initialLevel;
+		texture.requestedLevel = lastLevel;
+
+		_residentSize += texture.residentSizes[texture.firstResidentLevel];
+		_statistics.residentSize = _residentSize;
+		return static_cast<uint32_t>(_textures.size() - 1);
+	}
+
+	size_t TextureResidency::getNbTextures() const
+	{
+		return _textures.size();
+	}
+
+	void TextureResidency::requestLevel(uint32_t textureId, uint32_t level, uint64_t frame)
+	{
+		_Texture& texture = _textures[textureId];
+		level = std::min(level, static_cast<uint32_t>(texture.residentSizes.size() - 1));
+		if (!texture.requested || texture.lastRequestFrame != frame) {
+			texture.requestedLevel = level;
+		}
+		else {
+			texture.requestedLevel = std::min(texture.requestedLevel, level);
+		}
+		texture.lastRequestFrame = frame;
+		texture.requested = true;
+	}
+
+	void TextureResidency::requestFeedbackLevel(uint32_t textureId, uint32_t feedbackLevel, uint64_t frame)
+	{
+		const _Texture& texture = _textures[textureId];
+		requestLevel(textureId, getLevelFromFeedback(feedbackLevel, texture.width, texture.height, getNbLevels(textureId)), frame);
+	}
+
+	void TextureResidency::update(uint64_t frame, std::vector<Change>& changes)
+	{
+		changes.clear();
+
+		// Textures missing levels they sample, the ones missing the most levels first
+		_upgradeCandidates.clear();
+		for (uint32_t textureId = 0; textureId < _textures.size(); ++textureId) {
+			const _Texture& texture = _textures[textureId];
+			if (_isInUse(texture, frame) && texture.requestedLevel < texture.firstResidentLevel) {
+				_upgradeCandidates.push_back(textureId);
+			}
+		}
+		std::stable_sort(_upgradeCandidates.begin(), _upgradeCandidates.end(), [this](uint32_t a, uint32_t b) {
+			return _textures[a].firstResidentLevel - _textures[a].requestedLevel > _textures[b].firstResidentLevel - _textures[b].requestedLevel;
+		});
+		if (_upgradeCandidates.empty()) {
+			return;
+		}
+
+		// Bytes the evictions could free. The candidates have nothing to evict, since they keep the levels they sample.
+		size_t evictableSize = 0;
+		for (const _Texture& texture : _textures) {
+			uint32_t keptLevel = _getKeptLevel(texture, frame);
+			if (texture.firstResidentLevel < keptLevel) {
+				evictableSize += texture.residentSizes[texture.firstResidentLevel] - texture.residentSizes[keptLevel];
+			}
+		}
+
+		size_t uploadedSize = 0;
+		for (uint32_t textureId : _upgradeCandidates) {
+			if (uploadedSize && uploadedSize >= _options.uploadBudget) {
+				break;
+			}
+
+			// Finest level that fits in the budget once the other textures are evicted, if any
+			const _Texture& texture = _textures[textureId];
+			size_t availableSize = _options.memoryBudget + evictableSize > _residentSize ? _options.memoryBudget + evictableSize - _residentSize : 0;
+			size_t currentSize = texture.residentSizes[texture.firstResidentLevel];
+			uint32_t level = texture.requestedLevel;
+			while (level < texture.firstResidentLevel && texture.residentSizes[level] - currentSize > availableSize) {
+				level++;
+			}
+			if (level == texture.firstResidentLevel) {
+				_statistics.nbDeniedUpgrades++;
+				continue;
+			}
+
+			size_t addedSize = texture.residentSizes[level] - currentSize;
+			if (_residentSize + addedSize > _options.memoryBudget) {
+				size_t residentSizeBefore = _residentSize;
+				_evict(_residentSize + addedSize - _options.memoryBudget, frame, changes);
+				evictableSize -= std::min(evictableSize, residentSizeBefore - _residentSize);
+			}
+
+			_setFirstResidentLevel(textureId, level, frame, changes);
+			uploadedSize += addedSize;
+			_statistics.uploadedSize += addedSize;
+			_statistics.nbUpgrades++;
+		}
+	}
+
+	uint32_t TextureResidency::getFirstResidentLevel(uint32_t texture) const
+	{
+		return _textures[texture].firstResidentLevel;
+	}
+
+	uint32_t TextureResidency::getNbLevels(uint32_t texture) const
+	{
+		return static_cast<uint32_t>(_textures[texture].residentSizes.size());
+	}
+
+	size_t TextureResidency::getResidentSize() const
+	{
+		return _residentSize;
+	}
+
+	const TextureResidencyStatistics& TextureResidency::getStatistics() const
+	{
+		return _statistics;
+	}
+
+	uint32_t TextureResidency::getLevelFromFeedback(uint32_t feedbackLevel, uint32_t width, uint32_t height, uint32_t nbLevels)
+	{
+		if (!nbLevels) {
+			return 0;
+		}
+
+		// The level of detail in a texture is the one in a texture of size 1, plus the log2 of its size
+		uint32_t maxSize = std::max(std::max(width, height), 1u);
+		int64_t sizeLog2 = 0;
+		while (maxSize >> (sizeLog2 + 1)) {
+			sizeLog2++;
+		}
+		int64_t level = static_cast<int64_t>(feedbackLevel) - FEEDBACK_LOD_BIAS + sizeLog2;
+		return static_cast<uint32_t>(std::clamp<int64_t>(level, 0, nbLevels - 1));
+	}
+
+	bool TextureResidency::_isInUse(const _Texture& texture, uint64_t frame) const
+	{
+		return texture.requested && frame >= texture.lastRequestFrame && frame - texture.lastRequestFrame <= _options.evictionDelay;
+	}
+
+	uint32_t TextureResidency::_getKeptLevel(const _Texture& texture, uint64_t frame) const
+	{
+		if (texture.lastChangeFrame == frame) {
+			return texture.firstResidentLevel;  // A single change per texture and per frame
+		}
+		return _isInUse(texture, frame) ? std::min(texture.requestedLevel, texture.initialLevel) : texture.initialLevel;
+	}
+
+	void TextureResidency::_setFirstResidentLevel(uint32_t textureId, uint32_t level, uint64_t frame, std::vector<Change>& changes)
+	{
+		_Texture& texture = _textures[textureId];
+		_residentSize = _residentSize - texture.residentSizes[texture.firstResidentLevel] + texture.residentSizes[level];
+		_statistics.residentSize = _residentSize;
+		texture.firstResidentLevel = level;
+		texture.lastChangeFrame = frame;
+		changes.push_back({ textureId, level });
+	}
+
+	void TextureResidency::_evict(size_t size, uint64_t frame, std::vector<Change>& changes)
+	{
+		_evictionCandidates.clear();
+		for (uint32_t textureId = 0; textureId < _textures.size(); ++textureId) {
+			const _Texture& texture = _textures[textureId];
+			if (texture.firstResidentLevel < _getKeptLevel(texture, frame)) {
+				_evictionCandidates.push_back(textureId);
+			}
+		}
+
+		// Least recently used first. Textures never sampled come before all the others.
+		std::stable_sort(_evictionCandidates.begin(), _evictionCandidates.end(), [this](uint32_t a, uint32_t b) {
+			const _Texture& textureA = _textures[a];
+			const _Texture& textureB = _textures[b];
+			if (textureA.requested != textureB.requested) {
+				return !textureA.requested;
+			}
+			return textureA.lastRequestFrame < textureB.lastRequestFrame;
+		});
+
+		size_t freedSize = 0;
+		for (uint32_t textureId : _evictionCandidates) {
+			if (freedSize >= size) {
+				break;
+			}
+			const _Texture& texture = _textures[textureId];
+			uint32_t keptLevel = _getKeptLevel(texture, frame);
+			size_t evictedSize = texture.residentSizes[texture.firstResidentLevel] - texture.residentSizes[keptLevel];
+			_setFirstResidentLevel(textureId, keptLevel, frame, changes);
+			freedSize += evictedSize;
+			_statistics.evictedSize += evictedSize;
+			_statistics.nbEvictions++;
+		}
+	}
+}
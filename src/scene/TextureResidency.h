@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+* Residency of the mip levels of streamed textures. A texture starts with its coarse levels only, and its finer levels are made
+* resident when the shaders sample them (see VulkanRenderer, which reads the finest level sampled in the textures of each material
+* from a feedback buffer written by shader.frag). The resident levels of all the textures fit in a memory budget: to make room,
+* the levels that were not sampled for the longest time are evicted first (least recently used).
+* Only the decisions are made here. The renderer uploads and frees the levels.
+*/
+namespace leoscene {
+	class ImageTexture;
+
+	struct TextureResidencyOptions {
+		// Bytes of the resident levels of all the textures. The coarse levels a texture starts with are always resident.
+		size_t memoryBudget = 256 * 1024 * 1024;
+
+		// Bytes of levels made resident per frame. At least one texture gets its levels each frame.
+		size_t uploadBudget = 16 * 1024 * 1024;
+
+		// Largest side of the finest level a texture starts with
+		uint32_t initialMaxSize = 64;
+
+		// Frames after its last sample during which a texture keeps the levels it sampled. They are only evicted past this delay,
+		// or when they are finer than the level it samples.
+		uint32_t evictionDelay = 120;
+	};
+
+	// Statistics of the calls to TextureResidency::update
+	struct TextureResidencyStatistics {
+		size_t residentSize = 0;  // Bytes of the resident levels of all the textures
+		size_t uploadedSize = 0;  // Bytes of the levels made resident
+		size_t evictedSize = 0;  // Bytes of the levels evicted
+		uint32_t nbUpgrades = 0;  // Textures given finer levels
+		uint32_t nbEvictions = 0;  // Textures whose finer levels were evicted
+		uint32_t nbDeniedUpgrades = 0;  // Textures missing sampled levels that did not fit in the budget
+	};
+
+	class TextureResidency {
+	public:
+		// Finest level sampled in a material during a frame, as written in the feedback buffer by shader.frag: the level of detail
+		// the sample would have in a texture of 2^FEEDBACK_LOD_BIAS texels, clamped to 0. The buffer is reset to NO_FEEDBACK.
+		static const uint32_t FEEDBACK_LOD_BIAS = 16;
+		static const uint32_t NO_FEEDBACK = 0xFFFFFFFF;
+
+		// New first resident level of a texture. The texture holds this level and all the coarser ones.
+		struct Change {
+			uint32_t texture = 0;
+			uint32_t firstLevel = 0;
+		};
+
+	public:
+		TextureResidency(const TextureResidencyOptions& options = {});
+
+		// Returns the id of the texture, in the order the textures are added. Textures without mip levels are always fully resident.
+		uint32_t addTexture(const ImageTexture& texture);
+		uint32_t addTexture(uint32_t width, uint32_t height, const std::vector<size_t>& levelSizes);
+		size_t getNbTextures() const;
+
+		// The texture was sampled at this level during the given frame. Several requests in a frame keep the finest level.
+		void requestLevel(uint32_t texture, uint32_t level, uint64_t frame);
+
+		// Same with a value of the feedback buffer, converted to the levels of the texture
+		void requestFeedbackLevel(uint32_t texture, uint32_t feedbackLevel, uint64_t frame);
+
+		// Changes of the resident levels for this frame, at most one per texture. They are considered applied once returned.
+		void update(uint64_t frame, std::vector<Change>& changes);
+
+		uint32_t getFirstResidentLevel(uint32_t texture) const;
+		uint32_t getNbLevels(uint32_t texture) const;
+		size_t getResidentSize() const;
+		const TextureResidencyStatistics& getStatistics() const;
+
+		// Level of a texture of the given size matching a value of the feedback buffer, clamped to its levels
+		static uint32_t getLevelFromFeedback(uint32_t feedbackLevel, uint32_t width, uint32_t height, uint32_t nbLevels);
+
+	private:
+		struct _Texture {
+			std::vector<size_t> residentSizes;  // Bytes resident when each level is the first resident one
+			uint32_t width = 0;
+			uint32_t height = 0;
+			uint32_t initialLevel = 0;  // Finest level of the levels always resident
+			uint32_t firstResidentLevel = 0;
+			uint32_t requestedLevel = 0;  // Finest level sampled during lastRequestFrame
+			uint64_t lastRequestFrame = 0;
+			bool requested = false;  // False until the first request
+			uint64_t lastChangeFrame = UINT64_MAX;
+		};
+
+	private:
+		bool _isInUse(const _Texture& texture, uint64_t frame) const;
+		uint32_t _getKeptLevel(const _Texture& texture, uint64_t frame) const;  // Finest level that cannot be evicted
+		void _setFirstResidentLevel(uint32_t texture, uint32_t level, uint64_t frame, std::vector<Change>& changes);
+
+		// Evicts the levels of the least recently used textures until at least size bytes are freed
+		void _evict(size_t size, uint64_t frame, std::vector<Change>& changes);
+
+	private:
+		TextureResidencyOptions _options;
+		std::vector<_Texture> _textures;
+		size_t _residentSize = 0;
+		TextureResidencyStatistics _statistics;
+		std::vector<uint32_t> _upgradeCandidates;  // Reused by update
+		std::vector<uint32_t> _evictionCandidates;  // Reused by _evict
+	};
+}
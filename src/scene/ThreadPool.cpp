@@ -0,0 +1,68 @@
+#include "ThreadPool.h"
+
+namespace leoscene {
+
+	ThreadPool::ThreadPool(size_t nbThreads)
+	{
+		_workers.reserve(nbThreads);
+		for (size_t i = 0; i < nbThreads; ++i) {
+			_workers.emplace_back(&ThreadPool::_workerLoop, this);
+		}
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_stopping = true;
+		}
+		_condition.notify_all();
+		for (std::thread& worker : _workers) {
+			worker.join();
+		}
+	}
+
+	size_t ThreadPool::getNbThreads() const
+	{
+		return _workers.size();
+	}
+
+	size_t ThreadPool::getDefaultNbThreads()
+	{
+		size_t nbThreads = std::thread::hardware_concurrency();
+		return nbThreads ? nbThreads : 1;
+	}
+
+	bool ThreadPool::_runHelperTask()
+	{
+		std::function<void()> task;
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			if (_helperTasks.empty()) {
+				return false;
+			}
+			task = std::move(_helperTasks.front());
+			_helperTasks.pop();
+		}
+		task();
+		return true;
+	}
+
+	void ThreadPool::_workerLoop()
+	{
+		while (true) {
+			std::function<void()> task;
+			{
+				std::unique_lock<std::mutex> lock(_mutex);
+				_condition.wait(lock, [this]() { return _stopping || !_tasks.empty() || !_helperTasks.empty(); });
+				std::queue<std::function<void()>>& tasks = _helperTasks.empty() ? _tasks : _helperTasks;
+				if (tasks.empty()) {  // Stopping, and all the remaining tasks were executed
+					return;
+				}
+				task = std::move(tasks.front());
+				tasks.pop();
+			}
+			task();
+		}
+	}
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace leoscene {
+	/*
+	* Fixed-size pool of worker threads executing tasks in submission order.
+	* A pool created with 0 threads runs every task synchronously in submit().
+	*
+	* Tasks can wait for helper tasks of the same pool (submitHelper), which never wait themselves. Such waits go through wait(),
+	* which runs the queued helper tasks on the waiting thread, so the pool makes progress even when all its threads wait.
+	* The workers run the helper tasks before the other tasks.
+	*/
+	class ThreadPool {
+	public:
+		ThreadPool(size_t nbThreads);
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool& other) = delete;
+		ThreadPool& operator=(const ThreadPool& other) = delete;
+
+	public:
+		template<typename Task>
+		auto submit(Task&& task) -> std::future<decltype(task())>;
+
+		// Same as submit, for a task that does not wait for other tasks of the pool.
+		template<typename Task>
+		auto submitHelper(Task&& task) -> std::future<decltype(task())>;
+
+		// Waits for the future of a helper task, running the queued helper tasks on this thread meanwhile.
+		template<typename Future>
+		void wait(const Future& future);
+
+		size_t getNbThreads() const;
+
+		// Number of threads to use when the user did not ask for a specific number.
+		static size_t getDefaultNbThreads();
+
+	private:
+		template<typename Task>
+		auto _submit(Task&& task, std::queue<std::function<void()>>& tasks) -> std::future<decltype(task())>;
+
+		// Runs the next queued helper task on the calling thread. Returns false if there was none.
+		bool _runHelperTask();
+
+		void _workerLoop();
+
+	private:
+		std::vector<std::thread> _workers;
+		std::queue<std::function<void()>> _tasks;
+		std::queue<std::function<void()>> _helperTasks;
+		std::mutex _mutex;
+		std::condition_variable _condition;
+		bool _stopping = false;
+	};
+
+	template<typename Task>
+	auto ThreadPool::submit(Task&& task) -> std::future<decltype(task())>
+	{
+		return _submit(std::forward<Task>(task), _tasks);
+	}
+
+	template<typename Task>
+	auto ThreadPool::submitHelper(Task&& task) -> std::future<decltype(task())>
+	{
+		return _submit(std::forward<Task>(task), _helperTasks);
+	}
+
+	template<typename Future>
+	void ThreadPool::wait(const Future& future)
+	{
+		while (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+			if (!_runHelperTask()) {
+				// The task is running on another thread, and does not wait for anything
+				future.wait();
+				return;
+			}
+		}
+	}
+
+	template<typename Task>
+	auto ThreadPool::_submit(Task&& task, std::queue<std::function<void()>>& tasks) -> std::future<decltype(task())>
+	{
+		using Result = decltype(task());
+		// std::function needs a copyable callable, so the packaged task is shared.
+		auto packagedTask = std::make_shared<std::packaged_task<Result()>>(std::forward<Task>(task));
+		std::future<Result> result = packagedTask->get_future();
+
+		if (_workers.empty()) {
+			(*packagedTask)();
+			return result;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			tasks.emplace([packagedTask]() { (*packagedTask)(); });
+		}
+		_condition.notify_one();
+		return result;
+	}
+}
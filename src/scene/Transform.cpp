@@ -12,7 +12,34 @@ namespace leoscene {
 	}
 
 	Transform::Transform(const glm::vec3& translation, const glm::vec3& rotation_rads, const glm::vec3& scaling)
+		: _matrix(makeMatrix({ translation, rotation_rads, scaling }))
 	{
+		// The inverse of translation * rotation * scaling is scaling^-1 * rotation^T * translation^-1, so no general inverse is needed.
+		// Transposing the linear part gives scaling * rotation^T, whose rows only have to be divided by the squared scales.
+		glm::mat3 invLinear = glm::transpose(glm::mat3(_matrix));
+		for (int i = 0; i < 3; ++i) {
+			invLinear[i] /= scaling * scaling;
+		}
+		_invMatrix = glm::mat4(invLinear);
+		_invMatrix[3] = glm::vec4(-(invLinear * translation), 1);
+	}
+
+	Transform::Transform(const glm::mat4& matrix)
+		: _matrix(matrix), _invMatrix(glm::inverse(matrix))
+	{
+	}
+
+	Transform::Transform(const glm::mat4& matrix, const glm::mat4& invMatrix)
+		: _matrix(matrix), _invMatrix(invMatrix)
+	{
+	}
+
+	glm::mat4 Transform::makeMatrix(const TransformParameters& params)
+	{
+		const glm::vec3& translation = params.translation;
+		const glm::vec3& rotation_rads = params.rotation_rads;
+		const glm::vec3& scaling = params.scaling;
+
 		// NOTE: glm::mat4 are column-major. The first index is the column number.
 
 		glm::mat4 translationMatrix(1.f);
@@ -48,18 +75,7 @@ namespace leoscene {
 		rotationZ[0][1] = sinZ;
 		rotationZ[1][1] = cosZ;
 
-		_matrix *= translationMatrix * rotationZ * rotationY * rotationX * scalingMatrix;
-		_invMatrix = glm::inverse(_matrix);
-	}
-
-	Transform::Transform(const glm::mat4& matrix)
-		: _matrix(matrix), _invMatrix(glm::inverse(matrix))
-	{
-	}
-
-	Transform::Transform(const glm::mat4& matrix, const glm::mat4& invMatrix)
-		: _matrix(matrix), _invMatrix(invMatrix)
-	{
+		return translationMatrix * rotationZ * rotationY * rotationX * scalingMatrix;
 	}
 
 	Transform Transform::inverse() const
@@ -89,8 +105,9 @@ namespace leoscene {
 
 	Transform& Transform::operator*=(const Transform& other)
 	{
+		// (A * B)^-1 = B^-1 * A^-1
 		_matrix *= other._matrix;
-		_invMatrix = glm::inverse(_matrix);
+		_invMatrix = other._invMatrix * _invMatrix;
 		return *this;
 	}
 
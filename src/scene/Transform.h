@@ -16,6 +16,10 @@ namespace leoscene {
         Transform(const glm::vec3& translation, const glm::vec3& rotation_rads, const glm::vec3& scaling);
         Transform(const glm::mat4& matrix);
         Transform(const glm::mat4& matrix, const glm::mat4& invMatrix);
+
+        // Matrix of a Transform built from the parameters, without computing its inverse.
+        static glm::mat4 makeMatrix(const TransformParameters& params);
+
         Transform inverse() const;
         Transform transpose() const;
         bool swapsHandedness() const;
@@ -0,0 +1,103 @@
+#include <scene/SceneLoader.h>
+#include <scene/Scene.h>
+#include <scene/Camera.h>
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+namespace {
+	void printUsage();
+	bool loadScene(const char* scenePath, const leoscene::SceneLoader::LoadingOptions& options, double& milliseconds, size_t& nbObjects);
+}
+
+int main(int argc, const char** argv) {
+	if (argc < 2 || !strcmp(argv[1], "--help")) {
+		printUsage();
+		return argc < 2 ? 1 : 0;
+	}
+
+	const char* scenePath = argv[1];
+	leoscene::SceneLoader::LoadingOptions options;
+	options.assetCacheDirectoryPath = "cache_bench";
+	for (int i = 2; i < argc; ++i) {
+		if (!strcmp(argv[i], "--cache-dir") && i + 1 < argc) {
+			options.assetCacheDirectoryPath = argv[++i];
+		}
+		else if (!strcmp(argv[i], "--load-threads") && i + 1 < argc) {
+			options.nbThreads = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else {
+			std::cerr << "Error: unknown argument \"" << argv[i] << "\"." << std::endl;
+			printUsage();
+			return 1;
+		}
+	}
+
+	// The cold run must start from an empty cache.
+	std::error_code error;
+	std::filesystem::remove_all(options.assetCacheDirectoryPath, error);
+
+	leoscene::SceneLoader::LoadingOptions noCacheOptions = options;
+	noCacheOptions.assetCacheDirectoryPath.clear();
+
+	struct Run {
+		const char* name;
+		const leoscene::SceneLoader::LoadingOptions* options;
+	};
+	const Run runs[] = {
+		{ "No cache", &noCacheOptions },
+		{ "Cold cache", &options },
+		{ "Warm cache", &options },
+	};
+
+	for (const Run& run : runs) {
+		double milliseconds = 0;
+		size_t nbObjects = 0;
+		if (!loadScene(scenePath, *run.options, milliseconds, nbObjects)) {
+			std::cerr << "Error: Scene loading failed." << std::endl;
+			return 2;
+		}
+		std::cout << run.name << ":\t" << milliseconds << " ms\t(" << nbObjects << " objects)" << std::endl;
+	}
+
+	size_t cacheSize = 0;
+	for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(options.assetCacheDirectoryPath, error)) {
+		cacheSize += static_cast<size_t>(entry.file_size(error));
+	}
+	std::cout << "Cache size:\t" << cacheSize / (1024 * 1024) << " MB in \"" << options.assetCacheDirectoryPath << "\"" << std::endl;
+
+	return 0;
+}
+
+namespace {
+	void printUsage() {
+		std::cout << "Usage:" << std::endl
+			<< "\t" << "LeoAssetCacheBench.exe my_file.scene [--cache-dir DIR] [--load-threads N]" << "\t" << "Time the loading of a scene without asset cache, then with a cold and a warm cache." << std::endl
+			<< "\t" << "LeoAssetCacheBench.exe --help" << "\t" << "Print this help." << std::endl;
+		std::cout << "Notes:" << std::endl
+			<< "\t" << "The cache directory (\"cache_bench\" by default) is deleted before the cold run." << std::endl
+			<< "\t" << "Only the CPU side of the loading is measured. Nothing is uploaded to the GPU." << std::endl << std::endl;
+	}
+
+	bool loadScene(const char* scenePath, const leoscene::SceneLoader::LoadingOptions& options, double& milliseconds, size_t& nbObjects)
+	{
+		// A new loader for each run, so that its in-memory caches do not hide the asset cache.
+		leoscene::SceneLoader sceneLoader;
+		leoscene::Scene scene;
+		leoscene::Camera camera;
+		auto start = std::chrono::steady_clock::now();
+		try {
+			sceneLoader.loadScene(scenePath, &scene, &camera, options);
+		}
+		catch (const leoscene::SceneLoaderException& e) {
+			std::cerr << e.what() << std::endl;
+			return false;
+		}
+		milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		nbObjects = scene.getNbObjects();
+		return true;
+	}
+}
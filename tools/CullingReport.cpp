@@ -0,0 +1,683 @@
+#include <scene/SceneLoader.h>
+#include <scene/Scene.h>
+#include <scene/Camera.h>
+#include <scene/Mesh.h>
+#include <scene/BatchTransforms.h>
+#include <scene/BoundingVolumes.h>
+#include <scene/ThreadPool.h>
+
+#include "SelfTest.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <future>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+/*
+* Culling of the objects of a scene computed on the CPU, with the tests of indirect_cull.comp, from fixed viewpoints.
+* The occluders are the full meshes of the objects in the frustum, rasterized in a depth buffer. Its pyramid is the one
+* the renderer would build if the camera did not move, so occlusion is at its best.
+*/
+
+namespace {
+	// Same projection as the renderer
+	const float FOV_DEGREES = 45.f;
+	const float Z_NEAR = 0.1f;
+	const float Z_FAR = 300.f;
+
+	struct Viewpoint {
+		std::string name;
+		glm::vec3 eye = glm::vec3(0);
+		glm::vec3 target = glm::vec3(0, 0, 1);
+		glm::vec3 up = glm::vec3(0, 1, 0);
+	};
+
+	struct View {
+		glm::mat4 viewMatrix = glm::mat4(1);
+		float P00 = 1;
+		float P11 = 1;
+		uint32_t width = 0;
+		uint32_t height = 0;
+	};
+
+	/*
+	* Depth buffer of the occluders and its pyramid, reduced with max like the one of the renderer.
+	* Depths are positive distances along the view axis. The sizes are powers of two.
+	*/
+	struct DepthPyramid {
+		uint32_t width = 0;
+		uint32_t height = 0;
+		std::vector<std::vector<float>> levels;
+
+		void build(std::vector<float> depths, uint32_t depthsWidth, uint32_t depthsHeight);
+
+		// Farthest depth of the 2x2 texels read by the culling shader around the center of the rectangle (in uv).
+		float getFarthestDepth(const glm::vec4& rect) const;
+	};
+
+	// Bounds used by the culling of the objects, from the previous version of the renderer to the current one
+	enum class BoundsMethod {
+		LOOSE_SPHERE,  // Sphere of twice the half diagonal of the bounding box, used before the tight spheres
+		TIGHT_SPHERE,  // computeBoundingSphere
+		TIGHT_SPHERE_AND_BOX,  // Tight sphere for the frustum, sphere and projected bounding box for the occlusion
+		NB_METHODS
+	};
+	const size_t NB_METHODS = static_cast<size_t>(BoundsMethod::NB_METHODS);
+	const char* METHOD_NAMES[NB_METHODS] = { "Loose sphere", "Tight sphere", "Tight sphere + box" };
+
+	struct CullingResult {
+		size_t nbFrustumCulled = 0;
+		size_t nbOccluded = 0;
+		uint64_t nbDrawnTriangles = 0;
+	};
+
+	// Bounds of the shape of each object, in object space
+	struct ObjectBounds {
+		glm::vec4 looseSphere = glm::vec4(0);
+		glm::vec4 tightSphere = glm::vec4(0);
+		glm::vec3 boxCenter = glm::vec3(0);
+		glm::vec3 boxExtents = glm::vec3(0);
+		uint32_t nbTriangles = 0;
+	};
+
+	void printUsage();
+
+	// Checks the bounding volumes and the projections on generated data.
+	int runSelfTest();
+	using leotools::check;
+
+	View makeView(const Viewpoint& viewpoint, uint32_t width, uint32_t height);
+
+	// Viewpoints inside and around the bounding box of the scene, so that they fit any scene.
+	std::vector<Viewpoint> makeFixedViewpoints(const glm::vec3& sceneMin, const glm::vec3& sceneMax);
+
+	/*
+	* Tests of indirect_cull.comp. Centers are in view space, with a positive z in front of the camera.
+	*/
+
+	bool isSphereInFrustum(const glm::vec3& center, float radius, const View& view);
+
+	// 2D Polyhedral Bounds of a Clipped, Perspective-Projected 3D Sphere. Michael Mara, Morgan McGuire. 2013
+	bool projectSphere(glm::vec3 center, float radius, const View& view, glm::vec4& rect);
+
+	bool projectBox(const glm::mat4& modelView, const glm::vec3& boxCenter, const glm::vec3& boxExtents, const View& view, glm::vec4& rect, float& zMin);
+
+	/*
+	* Rasterization of the occluders
+	*/
+
+	// Depths of the triangles of the full meshes of the objects, on several threads. Triangles crossing the near plane are skipped,
+	// which can only make the occlusion weaker.
+	std::vector<float> rasterizeObjects(const leoscene::Scene& scene, const std::vector<uint32_t>& objects, const View& view, leoscene::ThreadPool& threadPool);
+
+	// a, b and c are in pixels, with their positive view depth as z. Both windings are drawn, as the renderer does not cull back faces.
+	void rasterizeTriangle(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, uint32_t width, uint32_t height, float* depths);
+}
+
+int main(int argc, const char** argv) {
+	if (argc < 2 || !strcmp(argv[1], "--help")) {
+		printUsage();
+		return argc < 2 ? 1 : 0;
+	}
+
+	if (!strcmp(argv[1], "--self-test")) {
+		return runSelfTest() ? 1 : 0;
+	}
+
+	const char* scenePath = argv[1];
+	uint32_t width = 1024;
+	uint32_t height = 512;
+	uint32_t nbThreads = 0;
+	std::vector<Viewpoint> customViewpoints;
+	for (int i = 2; i < argc; ++i) {
+		if (!strcmp(argv[i], "--resolution") && i + 2 < argc) {
+			width = static_cast<uint32_t>(atoi(argv[++i]));
+			height = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else if (!strcmp(argv[i], "--view") && i + 6 < argc) {
+			Viewpoint viewpoint;
+			viewpoint.name = "custom " + std::to_string(customViewpoints.size() + 1);
+			for (int k = 0; k < 3; ++k) {
+				viewpoint.eye[k] = static_cast<float>(atof(argv[++i]));
+			}
+			for (int k = 0; k < 3; ++k) {
+				viewpoint.target[k] = static_cast<float>(atof(argv[++i]));
+			}
+			customViewpoints.push_back(viewpoint);
+		}
+		else if (!strcmp(argv[i], "--threads") && i + 1 < argc) {
+			nbThreads = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else {
+			std::cerr << "Error: unknown argument \"" << argv[i] << "\"." << std::endl;
+			printUsage();
+			return 1;
+		}
+	}
+	if (!width || !height || (width & (width - 1)) || (height & (height - 1))) {
+		std::cerr << "Error: the resolution must be made of powers of two, like the depth pyramid of the renderer." << std::endl;
+		return 1;
+	}
+
+	// Only the full meshes are used
+	leoscene::SceneLoader::LoadingOptions options;
+	options.optimizeMeshes = false;
+	options.generateLods = false;
+	options.buildClusters = false;
+
+	leoscene::SceneLoader sceneLoader;
+	leoscene::Scene scene;
+	leoscene::Camera camera;
+	try {
+		sceneLoader.loadScene(scenePath, &scene, &camera, options);
+	}
+	catch (const leoscene::SceneLoaderException& e) {
+		std::cerr << e.what() << std::endl;
+		std::cerr << "Error: Scene loading failed." << std::endl;
+		return 2;
+	}
+	size_t nbObjects = scene.getNbObjects();
+	if (!nbObjects) {
+		std::cerr << "Error: The scene has no object." << std::endl;
+		return 2;
+	}
+
+	/*
+	* Bounds of the objects
+	*/
+
+	std::vector<ObjectBounds> shapeBounds(scene.shapes.size());
+	double looseVolume = 0, tightVolume = 0;
+	for (size_t s = 0; s < scene.shapes.size(); ++s) {
+		const leoscene::Mesh* mesh = static_cast<const leoscene::Mesh*>(scene.shapes[s].get());
+		ObjectBounds& bounds = shapeBounds[s];
+		bounds.boxCenter = (mesh->boundingBoxMin + mesh->boundingBoxMax) * 0.5f;
+		bounds.boxExtents = (mesh->boundingBoxMax - mesh->boundingBoxMin) * 0.5f;
+		bounds.looseSphere = glm::vec4(bounds.boxCenter, glm::length(bounds.boxExtents) * 2.f);
+		bounds.tightSphere = mesh->boundingSphere;
+		bounds.nbTriangles = static_cast<uint32_t>((mesh->lods.empty() ? mesh->indices.size() : mesh->lods[0].nbIndices) / 3);
+		looseVolume += std::pow(double(bounds.looseSphere.w), 3);
+		tightVolume += std::pow(double(bounds.tightSphere.w), 3);
+	}
+
+	std::vector<glm::vec4> looseSpheres(nbObjects), tightSpheres(nbObjects);
+	for (size_t o = 0; o < nbObjects; ++o) {
+		looseSpheres[o] = shapeBounds[scene.shapeIndices[o]].looseSphere;
+		tightSpheres[o] = shapeBounds[scene.shapeIndices[o]].tightSphere;
+	}
+	leoscene::transformBoundingSpheres(scene.worldMatrices.data(), looseSpheres.data(), looseSpheres.data(), nbObjects);
+	leoscene::transformBoundingSpheres(scene.worldMatrices.data(), tightSpheres.data(), tightSpheres.data(), nbObjects);
+
+	glm::vec3 sceneMin(FLT_MAX), sceneMax(-FLT_MAX);
+	for (size_t o = 0; o < nbObjects; ++o) {
+		const ObjectBounds& bounds = shapeBounds[scene.shapeIndices[o]];
+		const glm::mat4& matrix = scene.worldMatrices[o];
+		glm::vec3 center = glm::vec3(matrix * glm::vec4(bounds.boxCenter, 1));
+		glm::vec3 extents = glm::abs(glm::vec3(matrix[0])) * bounds.boxExtents.x + glm::abs(glm::vec3(matrix[1])) * bounds.boxExtents.y + glm::abs(glm::vec3(matrix[2])) * bounds.boxExtents.z;
+		sceneMin = glm::min(sceneMin, center - extents);
+		sceneMax = glm::max(sceneMax, center + extents);
+	}
+
+	std::vector<Viewpoint> viewpoints = makeFixedViewpoints(sceneMin, sceneMax);
+	viewpoints.insert(viewpoints.end(), customViewpoints.begin(), customViewpoints.end());
+
+	std::cout << "Objects:\t" << nbObjects << ", " << scene.shapes.size() << " shapes" << std::endl;
+	std::cout << "Volume of the tight spheres:\t" << (looseVolume > 0 ? tightVolume / looseVolume * 100 : 0) << "% of the loose ones (sum over the shapes)" << std::endl;
+	std::cout << "Resolution:\t" << width << "x" << height << std::endl << std::endl;
+
+	/*
+	* Culling from each viewpoint
+	*/
+
+	leoscene::ThreadPool threadPool(nbThreads ? nbThreads : leoscene::ThreadPool::getDefaultNbThreads());
+	std::vector<CullingResult> totals(NB_METHODS);
+	std::cout << "Viewpoint\tBounds\tFrustum culled\tOccluded\tVisible\tCulling rate\tTriangles drawn" << std::endl;
+	for (const Viewpoint& viewpoint : viewpoints) {
+		View view = makeView(viewpoint, width, height);
+
+		std::vector<glm::vec3> tightCenters(nbObjects);
+		std::vector<uint32_t> objectsInFrustum;
+		for (size_t o = 0; o < nbObjects; ++o) {
+			tightCenters[o] = glm::vec3(view.viewMatrix * glm::vec4(glm::vec3(tightSpheres[o]), 1));
+			tightCenters[o].z *= -1;
+			if (isSphereInFrustum(tightCenters[o], tightSpheres[o].w, view)) {
+				objectsInFrustum.push_back(static_cast<uint32_t>(o));
+			}
+		}
+		DepthPyramid pyramid;
+		pyramid.build(rasterizeObjects(scene, objectsInFrustum, view, threadPool), width, height);
+
+		std::vector<CullingResult> results(NB_METHODS);
+		for (size_t o = 0; o < nbObjects; ++o) {
+			const ObjectBounds& bounds = shapeBounds[scene.shapeIndices[o]];
+			glm::vec3 looseCenter = glm::vec3(view.viewMatrix * glm::vec4(glm::vec3(looseSpheres[o]), 1));
+			looseCenter.z *= -1;
+
+			for (size_t m = 0; m < NB_METHODS; ++m) {
+				BoundsMethod method = static_cast<BoundsMethod>(m);
+				bool loose = method == BoundsMethod::LOOSE_SPHERE;
+				const glm::vec3& center = loose ? looseCenter : tightCenters[o];
+				float radius = loose ? looseSpheres[o].w : tightSpheres[o].w;
+				if (!isSphereInFrustum(center, radius, view)) {
+					++results[m].nbFrustumCulled;
+					continue;
+				}
+
+				glm::vec4 rect;
+				bool projected = projectSphere(center, radius, view, rect);
+				float zMin = center.z - radius;
+				glm::vec4 boxRect;
+				float boxZMin = 0;
+				if (method == BoundsMethod::TIGHT_SPHERE_AND_BOX &&
+					projectBox(view.viewMatrix * scene.worldMatrices[o], bounds.boxCenter, bounds.boxExtents, view, boxRect, boxZMin))
+				{
+					// Same intersection of the bounds as the culling shader
+					rect = projected ? glm::vec4(glm::max(glm::vec2(rect), glm::vec2(boxRect)), glm::min(glm::vec2(rect.z, rect.w), glm::vec2(boxRect.z, boxRect.w))) : boxRect;
+					zMin = projected ? std::max(zMin, boxZMin) : boxZMin;
+					projected = true;
+				}
+				if (projected && zMin > pyramid.getFarthestDepth(rect)) {
+					++results[m].nbOccluded;
+					continue;
+				}
+				results[m].nbDrawnTriangles += bounds.nbTriangles;
+			}
+		}
+
+		for (size_t m = 0; m < NB_METHODS; ++m) {
+			size_t nbCulled = results[m].nbFrustumCulled + results[m].nbOccluded;
+			std::cout << viewpoint.name << "\t" << METHOD_NAMES[m] << "\t" << results[m].nbFrustumCulled << "\t" << results[m].nbOccluded << "\t"
+				<< nbObjects - nbCulled << "\t" << double(nbCulled) / nbObjects * 100 << "%\t" << results[m].nbDrawnTriangles << std::endl;
+			totals[m].nbFrustumCulled += results[m].nbFrustumCulled;
+			totals[m].nbOccluded += results[m].nbOccluded;
+			totals[m].nbDrawnTriangles += results[m].nbDrawnTriangles;
+		}
+	}
+
+	std::cout << std::endl << "Average over the " << viewpoints.size() << " viewpoints:" << std::endl;
+	for (size_t m = 0; m < NB_METHODS; ++m) {
+		size_t nbCulled = totals[m].nbFrustumCulled + totals[m].nbOccluded;
+		std::cout << "\t" << METHOD_NAMES[m] << ":\t" << double(nbCulled) / (nbObjects * viewpoints.size()) * 100 << "% culled, "
+			<< totals[m].nbDrawnTriangles / viewpoints.size() << " triangles drawn" << std::endl;
+	}
+
+	return 0;
+}
+
+namespace {
+	void printUsage() {
+		std::cout << "Usage:" << std::endl
+			<< "\t" << "LeoCullingReport.exe my_file.scene [--resolution WIDTH HEIGHT] [--view EYE_X EYE_Y EYE_Z TARGET_X TARGET_Y TARGET_Z]... [--threads N]" << "\t"
+			<< "Print how many objects the culling shader would cull from fixed viewpoints, with the previous and the current bounding volumes." << std::endl
+			<< "\t" << "LeoCullingReport.exe --self-test" << "\t" << "Check the bounding volumes and their projections on generated data. Returns 1 if a check fails." << std::endl
+			<< "\t" << "LeoCullingReport.exe --help" << "\t" << "Print this help." << std::endl;
+		std::cout << "Notes:" << std::endl
+			<< "\t" << "The fixed viewpoints are placed in the bounding box of the scene: four from its center at eye level, one from a corner, one from above." << std::endl
+			<< "\t" << "--view adds a viewpoint. It can be repeated." << std::endl
+			<< "\t" << "The occluders are the full meshes of the objects in the frustum, as if the camera had not moved since the previous frame." << std::endl
+			<< "\t" << "The resolution is the one of the depth pyramid (1024x512 by default). LODs and clusters are not taken into account." << std::endl
+			<< "\t" << "No GPU is needed." << std::endl << std::endl;
+	}
+
+	int runSelfTest()
+	{
+		int nbFailures = 0;
+		std::mt19937 generator(42);
+		std::uniform_real_distribution<float> unit(-1.f, 1.f);
+
+		// Bounding spheres
+		{
+			std::vector<glm::vec3> positions(2000);
+			for (glm::vec3& position : positions) {
+				do {
+					position = glm::vec3(unit(generator), unit(generator), unit(generator));
+				} while (glm::length(position) < 0.01f);
+				position = glm::normalize(position) * 3.f + glm::vec3(10, -5, 2);
+			}
+			glm::vec4 sphere = leoscene::computeBoundingSphere(positions.data(), positions.size());
+			bool contained = true;
+			for (const glm::vec3& position : positions) {
+				contained = contained && glm::length(position - glm::vec3(sphere)) <= sphere.w * 1.0001f;
+			}
+			nbFailures += !check(contained, "The bounding sphere contains all the positions");
+			nbFailures += !check(sphere.w <= 3.f * 1.05f, "The bounding sphere of points on a sphere is within 5% of it");
+
+			std::vector<glm::vec3> cube(5000);
+			for (glm::vec3& position : cube) {
+				position = glm::vec3(unit(generator), unit(generator), unit(generator));
+			}
+			for (int corner = 0; corner < 8; ++corner) {
+				cube[corner] = glm::vec3(corner & 1 ? 1 : -1, corner & 2 ? 1 : -1, corner & 4 ? 1 : -1);
+			}
+			sphere = leoscene::computeBoundingSphere(cube.data(), cube.size());
+			float looseRadius = std::sqrt(3.f) * 2.f;  // Previous sphere: twice the half diagonal
+			nbFailures += !check(sphere.w <= std::sqrt(3.f) * 1.05f && sphere.w < looseRadius * 0.55f, "The bounding sphere of a cube is within 5% of its circumscribed sphere");
+
+			leoscene::Vertex vertices[2];
+			vertices[0].position = glm::vec3(1, 2, 3);
+			vertices[1].position = glm::vec3(1, 2, 7);
+			sphere = leoscene::computeBoundingSphere(&vertices[0].position, 2, sizeof(leoscene::Vertex));
+			nbFailures += !check(sphere == glm::vec4(1, 2, 5, 2), "Positions are read with the stride of the vertices");
+			nbFailures += !check(leoscene::computeBoundingSphere(&vertices[0].position, 1, sizeof(leoscene::Vertex)) == glm::vec4(1, 2, 3, 0), "The sphere of one position has a radius of 0");
+
+			glm::vec3 boxMin, boxMax;
+			leoscene::computeBoundingBox(&vertices[0].position, 2, boxMin, boxMax, sizeof(leoscene::Vertex));
+			nbFailures += !check(boxMin == glm::vec3(1, 2, 3) && boxMax == glm::vec3(1, 2, 7), "The bounding box is made of the smallest and largest coordinates");
+		}
+
+		// Projections: the rectangles and the nearest depths bound the projected positions
+		{
+			View view = makeView({ "test", glm::vec3(0), glm::vec3(0, 0, -1) }, 1024, 512);
+			auto projectToUv = [&](const glm::vec3& viewPosition) {
+				float z = -viewPosition.z;
+				return glm::vec3(0.5f + 0.5f * view.P00 * viewPosition.x / z, 0.5f + 0.5f * view.P11 * viewPosition.y / z, z);
+			};
+			auto contains = [](const glm::vec4& rect, const glm::vec3& uv) {
+				const float epsilon = 1e-4f;
+				return uv.x >= rect.x - epsilon && uv.x <= rect.z + epsilon && uv.y >= rect.y - epsilon && uv.y <= rect.w + epsilon;
+			};
+
+			bool boxesBounded = true, spheresBounded = true;
+			size_t nbProjected = 0;
+			for (int i = 0; i < 1000; ++i) {
+				glm::mat4 model = glm::translate(glm::mat4(1), glm::vec3(unit(generator) * 10, unit(generator) * 5, -15 + unit(generator) * 10));
+				model = glm::rotate(model, unit(generator) * 3.14f, glm::normalize(glm::vec3(unit(generator), unit(generator), unit(generator)) + glm::vec3(0.01f)));
+				model = glm::scale(model, glm::vec3(1.5f + unit(generator), 1.5f + unit(generator), 1.5f + unit(generator)));
+				glm::vec3 boxCenter(unit(generator), unit(generator), unit(generator));
+				glm::vec3 boxExtents = glm::abs(glm::vec3(unit(generator), unit(generator), unit(generator))) + 0.1f;
+
+				glm::vec4 rect;
+				float zMin = 0;
+				if (!projectBox(model, boxCenter, boxExtents, view, rect, zMin)) {
+					continue;
+				}
+				++nbProjected;
+				for (int corner = 0; corner < 8; ++corner) {
+					glm::vec3 offset(corner & 1 ? 1 : -1, corner & 2 ? 1 : -1, corner & 4 ? 1 : -1);
+					glm::vec3 uv = projectToUv(glm::vec3(model * glm::vec4(boxCenter + offset * boxExtents, 1)));
+					boxesBounded = boxesBounded && contains(rect, uv) && uv.z >= zMin - 1e-4f;
+				}
+
+				glm::vec3 sphereCenter = glm::vec3(model * glm::vec4(boxCenter, 1));
+				float radius = 0.5f + std::abs(unit(generator));
+				glm::vec3 positiveCenter(sphereCenter.x, sphereCenter.y, -sphereCenter.z);
+				if (projectSphere(positiveCenter, radius, view, rect)) {
+					for (int k = 0; k < 3; ++k) {
+						for (float side : { -1.f, 1.f }) {
+							glm::vec3 extreme = sphereCenter;
+							extreme[k] += side * radius;
+							spheresBounded = spheresBounded && contains(rect, projectToUv(extreme));
+						}
+					}
+				}
+			}
+			nbFailures += !check(nbProjected > 500, "Most of the boxes in front of the camera are projected");
+			nbFailures += !check(boxesBounded, "The rectangles of the boxes contain their projected corners, behind their nearest depth");
+			nbFailures += !check(spheresBounded, "The rectangles of the spheres contain their projected extreme points");
+
+			glm::vec4 rect;
+			float zMin = 0;
+			nbFailures += !check(!projectBox(glm::mat4(1), glm::vec3(0, 0, -0.05f), glm::vec3(0.1f), view, rect, zMin), "Boxes crossing the near plane are not projected");
+		}
+
+		// Occlusion: objects partially in front of an uncovered area are never occluded, whatever the level they are tested at
+		{
+			const uint32_t size = 256;
+			std::vector<float> depths(size * size, FLT_MAX);
+			for (uint32_t y = 0; y < size; ++y) {
+				for (uint32_t x = 0; x < size / 2 + 37; ++x) {
+					depths[y * size + x] = 10.f;
+				}
+			}
+			DepthPyramid pyramid;
+			pyramid.build(depths, size, size);
+
+			bool conservative = true, occludes = true;
+			for (int i = 0; i < 2000; ++i) {
+				float x0 = (unit(generator) * 0.5f + 0.5f) * 0.9f;
+				float rectWidth = std::pow(2.f, unit(generator) * 6.f - 3.f) / size;
+				glm::vec4 rect(x0, 0.3f, std::min(x0 + rectWidth, 1.f), 0.3f + rectWidth);
+				bool partiallyUncovered = rect.z * size > size / 2 + 37;
+				bool occluded = 20.f > pyramid.getFarthestDepth(rect);
+				conservative = conservative && !(partiallyUncovered && occluded);
+				if (rect.z * size < size / 2 + 37 - 8) {
+					occludes = occludes && occluded;
+				}
+			}
+			nbFailures += !check(conservative, "Rectangles over an uncovered texel are never occluded");
+			nbFailures += !check(occludes, "Small rectangles far from the uncovered texels are occluded");
+		}
+
+		std::cout << (nbFailures ? "Self test failed." : "Self test passed.") << std::endl;
+		return nbFailures;
+	}
+
+	View makeView(const Viewpoint& viewpoint, uint32_t width, uint32_t height)
+	{
+		View view;
+		view.viewMatrix = glm::lookAt(viewpoint.eye, viewpoint.target, viewpoint.up);
+		glm::mat4 projection = glm::perspective(glm::radians(FOV_DEGREES), static_cast<float>(width) / height, Z_NEAR, Z_FAR);
+		view.P00 = projection[0][0];
+		view.P11 = projection[1][1];
+		view.width = width;
+		view.height = height;
+		return view;
+	}
+
+	std::vector<Viewpoint> makeFixedViewpoints(const glm::vec3& sceneMin, const glm::vec3& sceneMax)
+	{
+		glm::vec3 size = sceneMax - sceneMin;
+		glm::vec3 center = (sceneMin + sceneMax) * 0.5f;
+		glm::vec3 eye(center.x, sceneMin.y + size.y * 0.1f, center.z);
+		float distance = std::max(size.x, std::max(size.y, size.z));
+
+		std::vector<Viewpoint> viewpoints;
+		viewpoints.push_back({ "center +x", eye, eye + glm::vec3(1, 0, 0) });
+		viewpoints.push_back({ "center -x", eye, eye + glm::vec3(-1, 0, 0) });
+		viewpoints.push_back({ "center +z", eye, eye + glm::vec3(0, 0, 1) });
+		viewpoints.push_back({ "center -z", eye, eye + glm::vec3(0, 0, -1) });
+		viewpoints.push_back({ "corner", glm::vec3(sceneMin.x, sceneMax.y, sceneMin.z), center });
+		viewpoints.push_back({ "above", center + glm::vec3(0, size.y * 0.5f + distance * 0.1f, 0), center, glm::vec3(0, 0, 1) });
+		return viewpoints;
+	}
+
+	bool isSphereInFrustum(const glm::vec3& center, float radius, const View& view)
+	{
+		// Side planes through the eye, for x / z and y / z within [-1 / P, 1 / P]
+		float xLength = std::sqrt(view.P00 * view.P00 + 1);
+		float yLength = std::sqrt(view.P11 * view.P11 + 1);
+		return (center.z + view.P00 * center.x) / xLength > -radius && (center.z - view.P00 * center.x) / xLength > -radius &&
+			(center.z + view.P11 * center.y) / yLength > -radius && (center.z - view.P11 * center.y) / yLength > -radius &&
+			center.z + radius > Z_NEAR && center.z - radius < Z_FAR;
+	}
+
+	bool projectSphere(glm::vec3 center, float radius, const View& view, glm::vec4& rect)
+	{
+		center.y *= -1;  // Convention used by the function
+		if (center.z - radius < Z_NEAR) {
+			return false;
+		}
+
+		glm::vec2 cx(-center.x, -center.z);
+		glm::vec2 vx(std::sqrt(glm::dot(cx, cx) - radius * radius), radius);
+		glm::vec2 minx = glm::mat2(vx.x, vx.y, -vx.y, vx.x) * cx;
+		glm::vec2 maxx = glm::mat2(vx.x, -vx.y, vx.y, vx.x) * cx;
+
+		glm::vec2 cy(-center.y, -center.z);
+		glm::vec2 vy(std::sqrt(glm::dot(cy, cy) - radius * radius), radius);
+		glm::vec2 miny = glm::mat2(vy.x, vy.y, -vy.y, vy.x) * cy;
+		glm::vec2 maxy = glm::mat2(vy.x, -vy.y, vy.y, vy.x) * cy;
+
+		rect = glm::vec4(minx.x / minx.y * view.P00, miny.x / miny.y * view.P11, maxx.x / maxx.y * view.P00, maxy.x / maxy.y * view.P11);
+		rect = glm::vec4(rect.x, rect.w, rect.z, rect.y) * glm::vec4(0.5f, -0.5f, 0.5f, -0.5f) + glm::vec4(0.5f);  // Clip space -> uv space
+		return true;
+	}
+
+	bool projectBox(const glm::mat4& modelView, const glm::vec3& boxCenter, const glm::vec3& boxExtents, const View& view, glm::vec4& rect, float& zMin)
+	{
+		glm::vec3 center = glm::vec3(modelView * glm::vec4(boxCenter, 1));
+		glm::vec2 minXY(FLT_MAX), maxXY(-FLT_MAX);
+		zMin = FLT_MAX;
+		for (int i = 0; i < 8; ++i) {
+			glm::vec3 corner = center + glm::vec3(modelView[0]) * (boxExtents.x * (i & 1 ? 1 : -1)) +
+				glm::vec3(modelView[1]) * (boxExtents.y * (i & 2 ? 1 : -1)) + glm::vec3(modelView[2]) * (boxExtents.z * (i & 4 ? 1 : -1));
+			corner.z *= -1;
+			if (corner.z < Z_NEAR) {
+				return false;
+			}
+			minXY = glm::min(minXY, glm::vec2(corner) / corner.z);
+			maxXY = glm::max(maxXY, glm::vec2(corner) / corner.z);
+			zMin = std::min(zMin, corner.z);
+		}
+
+		glm::vec2 P(view.P00, view.P11);
+		rect = glm::vec4(minXY * P, maxXY * P) * 0.5f + glm::vec4(0.5f);
+		return true;
+	}
+
+	void DepthPyramid::build(std::vector<float> depths, uint32_t depthsWidth, uint32_t depthsHeight)
+	{
+		width = depthsWidth;
+		height = depthsHeight;
+		levels.clear();
+		levels.push_back(std::move(depths));
+		for (uint32_t levelWidth = width, levelHeight = height; levelWidth > 1 || levelHeight > 1;) {
+			uint32_t nextWidth = std::max(levelWidth / 2, 1u);
+			uint32_t nextHeight = std::max(levelHeight / 2, 1u);
+			const std::vector<float>& level = levels.back();
+			std::vector<float> next(nextWidth * nextHeight);
+			for (uint32_t y = 0; y < nextHeight; ++y) {
+				for (uint32_t x = 0; x < nextWidth; ++x) {
+					uint32_t x0 = std::min(x * 2, levelWidth - 1), x1 = std::min(x * 2 + 1, levelWidth - 1);
+					uint32_t y0 = std::min(y * 2, levelHeight - 1), y1 = std::min(y * 2 + 1, levelHeight - 1);
+					next[y * nextWidth + x] = std::max(std::max(level[y0 * levelWidth + x0], level[y0 * levelWidth + x1]),
+						std::max(level[y1 * levelWidth + x0], level[y1 * levelWidth + x1]));
+				}
+			}
+			levels.push_back(std::move(next));
+			levelWidth = nextWidth;
+			levelHeight = nextHeight;
+		}
+	}
+
+	float DepthPyramid::getFarthestDepth(const glm::vec4& rect) const
+	{
+		float rectWidth = (rect.z - rect.x) * width;
+		float rectHeight = (rect.w - rect.y) * height;
+		float level = std::max(std::ceil(std::log2(std::max(rectWidth, rectHeight))), 0.f);
+		uint32_t levelIndex = std::min(static_cast<uint32_t>(level), static_cast<uint32_t>(levels.size() - 1));
+		int levelWidth = static_cast<int>(std::max(width >> levelIndex, 1u));
+		int levelHeight = static_cast<int>(std::max(height >> levelIndex, 1u));
+
+		// Texels of the bilinear footprint around the center, clamped to the edges
+		float u = (rect.x + rect.z) * 0.5f * levelWidth - 0.5f;
+		float v = (rect.y + rect.w) * 0.5f * levelHeight - 0.5f;
+		int x0 = static_cast<int>(std::floor(std::min(std::max(u, -1.f), float(levelWidth))));
+		int y0 = static_cast<int>(std::floor(std::min(std::max(v, -1.f), float(levelHeight))));
+		float depth = 0;
+		for (int y = y0; y <= y0 + 1; ++y) {
+			for (int x = x0; x <= x0 + 1; ++x) {
+				int clampedX = std::min(std::max(x, 0), levelWidth - 1);
+				int clampedY = std::min(std::max(y, 0), levelHeight - 1);
+				depth = std::max(depth, levels[levelIndex][clampedY * levelWidth + clampedX]);
+			}
+		}
+		return depth;
+	}
+
+	std::vector<float> rasterizeObjects(const leoscene::Scene& scene, const std::vector<uint32_t>& objects, const View& view, leoscene::ThreadPool& threadPool)
+	{
+		// Each thread draws a share of the objects in a depth buffer of its own. The buffers are merged afterwards.
+		size_t nbTasks = std::max<size_t>(threadPool.getNbThreads(), 1);
+		std::vector<std::vector<float>> taskDepths(nbTasks);
+		std::vector<std::future<void>> tasks;
+		for (size_t t = 0; t < nbTasks; ++t) {
+			tasks.push_back(threadPool.submit([&, t]() {
+				std::vector<float>& depths = taskDepths[t];
+				depths.assign(size_t(view.width) * view.height, FLT_MAX);
+				std::vector<glm::vec3> screenPositions;
+				for (size_t i = t; i < objects.size(); i += nbTasks) {
+					uint32_t object = objects[i];
+					const leoscene::Mesh* mesh = static_cast<const leoscene::Mesh*>(scene.shapes[scene.shapeIndices[object]].get());
+					glm::mat4 modelView = view.viewMatrix * scene.worldMatrices[object];
+
+					screenPositions.resize(mesh->vertices.size());
+					for (size_t v = 0; v < mesh->vertices.size(); ++v) {
+						glm::vec3 position = glm::vec3(modelView * glm::vec4(mesh->vertices[v].position, 1));
+						float z = -position.z;
+						screenPositions[v] = z >= Z_NEAR ?
+							glm::vec3((0.5f + 0.5f * view.P00 * position.x / z) * view.width, (0.5f + 0.5f * view.P11 * position.y / z) * view.height, z) :
+							glm::vec3(0, 0, -1);
+					}
+
+					size_t nbIndices = mesh->lods.empty() ? mesh->indices.size() : mesh->lods[0].nbIndices;
+					for (size_t k = 0; k + 2 < nbIndices; k += 3) {
+						const glm::vec3& a = screenPositions[mesh->indices[k]];
+						const glm::vec3& b = screenPositions[mesh->indices[k + 1]];
+						const glm::vec3& c = screenPositions[mesh->indices[k + 2]];
+						if (a.z > 0 && b.z > 0 && c.z > 0) {
+							rasterizeTriangle(a, b, c, view.width, view.height, depths.data());
+						}
+					}
+				}
+			}));
+		}
+		for (std::future<void>& task : tasks) {
+			task.get();
+		}
+
+		std::vector<float> depths = std::move(taskDepths[0]);
+		for (size_t t = 1; t < nbTasks; ++t) {
+			for (size_t i = 0; i < depths.size(); ++i) {
+				depths[i] = std::min(depths[i], taskDepths[t][i]);
+			}
+		}
+		return depths;
+	}
+
+	void rasterizeTriangle(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, uint32_t width, uint32_t height, float* depths)
+	{
+		// Pixels whose center is in the bounding rectangle of the triangle
+		float minX = std::min(a.x, std::min(b.x, c.x)), maxX = std::max(a.x, std::max(b.x, c.x));
+		float minY = std::min(a.y, std::min(b.y, c.y)), maxY = std::max(a.y, std::max(b.y, c.y));
+		if (maxX < 0.5f || maxY < 0.5f || minX > width - 0.5f || minY > height - 0.5f) {
+			return;
+		}
+		int x0 = static_cast<int>(std::ceil(std::max(minX - 0.5f, 0.f)));
+		int x1 = static_cast<int>(std::floor(std::min(maxX - 0.5f, float(width - 1))));
+		int y0 = static_cast<int>(std::ceil(std::max(minY - 0.5f, 0.f)));
+		int y1 = static_cast<int>(std::floor(std::min(maxY - 0.5f, float(height - 1))));
+		if (x0 > x1 || y0 > y1) {
+			return;
+		}
+		float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+		if (area == 0) {
+			return;
+		}
+		float inverseArea = 1.f / area;
+
+		// The inverse of the depth is linear in screen space
+		float inverseDepths[3] = { 1.f / a.z, 1.f / b.z, 1.f / c.z };
+		for (int y = y0; y <= y1; ++y) {
+			float py = y + 0.5f;
+			for (int x = x0; x <= x1; ++x) {
+				float px = x + 0.5f;
+				float weightA = ((b.x - px) * (c.y - py) - (b.y - py) * (c.x - px)) * inverseArea;
+				float weightB = ((c.x - px) * (a.y - py) - (c.y - py) * (a.x - px)) * inverseArea;
+				float weightC = 1.f - weightA - weightB;
+				if (weightA < 0 || weightB < 0 || weightC < 0) {
+					continue;
+				}
+				float depth = 1.f / (weightA * inverseDepths[0] + weightB * inverseDepths[1] + weightC * inverseDepths[2]);
+				float& pixelDepth = depths[size_t(y) * width + x];
+				pixelDepth = std::min(pixelDepth, depth);
+			}
+		}
+	}
+}
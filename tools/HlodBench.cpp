@@ -0,0 +1,428 @@
+#include <scene/SceneLoader.h>
+#include <scene/Scene.h>
+#include <scene/Camera.h>
+#include <scene/Mesh.h>
+#include <scene/PerformanceMaterial.h>
+#include <scene/ImageTexture.h>
+#include <scene/BatchTransforms.h>
+#include <scene/BoundingVolumes.h>
+#include <scene/HlodBuilder.h>
+
+#include "SelfTest.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <set>
+#include <string>
+#include <vector>
+
+/*
+* Building of the HLOD clusters of a scene, and the instances and draw commands left when the culling shader swaps the far clusters
+* for their proxies. The swap is computed on the CPU with the same test as indirect_cull.comp.
+*/
+
+namespace {
+	// Same projection and error as the renderer
+	const float FOV_DEGREES = 45.f;
+	const float HLOD_PIXEL_ERROR = 4.f;
+
+	// Instances and draw commands left from a viewpoint. Frustum and occlusion culling are not applied, so that only the HLOD counts.
+	struct DrawCounts {
+		size_t nbInstances = 0;
+		size_t nbBatches = 0;  // Pairs of material and shape with at least one instance: a draw command in the renderer
+	};
+
+	void printUsage();
+
+	// Checks the clusters, the proxies and the swap test on generated objects.
+	int runSelfTest();
+	using leotools::check;
+
+	// Objects drawn from the eye. Without HLOD, the proxies are skipped and all the other objects are drawn.
+	DrawCounts countDraws(const leoscene::Scene& scene, const glm::vec3& eye, float projectionScale, float errorThreshold, bool useHlods);
+
+	// Grid of nbQuads * nbQuads quads on a bump of the given height, in the unit square of the xz plane
+	std::shared_ptr<leoscene::Mesh> makeBump(uint32_t nbQuads, float height);
+
+	// Material with a 2x2 diffuse texture of a single color
+	std::shared_ptr<leoscene::PerformanceMaterial> makeColoredMaterial(const glm::u8vec3& color);
+}
+
+int main(int argc, const char** argv) {
+	if (argc < 2 || !strcmp(argv[1], "--help")) {
+		printUsage();
+		return argc < 2 ? 1 : 0;
+	}
+
+	if (!strcmp(argv[1], "--self-test")) {
+		return runSelfTest() ? 1 : 0;
+	}
+
+	const char* scenePath = argv[1];
+	leoscene::HlodOptions hlodOptions;
+	uint32_t screenHeight = 1080;
+	for (int i = 2; i < argc; ++i) {
+		if (!strcmp(argv[i], "--threads") && i + 1 < argc) {
+			hlodOptions.nbThreads = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else if (!strcmp(argv[i], "--cell-size") && i + 1 < argc) {
+			hlodOptions.cellSize = static_cast<float>(atof(argv[++i]));
+		}
+		else if (!strcmp(argv[i], "--max-triangles") && i + 1 < argc) {
+			hlodOptions.maxNbTriangles = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else if (!strcmp(argv[i], "--height") && i + 1 < argc) {
+			screenHeight = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else {
+			std::cerr << "Error: unknown argument \"" << argv[i] << "\"." << std::endl;
+			printUsage();
+			return 1;
+		}
+	}
+	if (!screenHeight) {
+		std::cerr << "Error: the screen height must be positive." << std::endl;
+		return 1;
+	}
+
+	// The clusters are built below, on the whole scene at once
+	leoscene::SceneLoader::LoadingOptions options;
+	options.nbThreads = hlodOptions.nbThreads;
+	options.buildHlods = false;
+
+	leoscene::SceneLoader sceneLoader;
+	leoscene::Scene scene;
+	leoscene::Camera camera;
+	try {
+		sceneLoader.loadScene(scenePath, &scene, &camera, options);
+	}
+	catch (const leoscene::SceneLoaderException& e) {
+		std::cerr << e.what() << std::endl;
+		std::cerr << "Error: Scene loading failed." << std::endl;
+		return 2;
+	}
+	size_t nbObjects = scene.getNbObjects();
+	if (!nbObjects) {
+		std::cerr << "Error: The scene has no object." << std::endl;
+		return 2;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	leoscene::HlodStatistics statistics = leoscene::buildHlods(scene, hlodOptions);
+	double buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	std::cout << "Objects:\t" << nbObjects << std::endl;
+	std::cout << "HLOD building:\t" << buildMs << " ms" << std::endl;
+	std::cout << "Clusters:\t" << statistics.nbClusters << ", " << statistics.nbMembers << " member objects" << std::endl;
+	std::cout << "Triangles:\t" << statistics.nbMemberTriangles << " in the members, " << statistics.nbProxyTriangles << " in the proxies" << std::endl;
+	std::cout << "Atlas:\t" << statistics.atlasWidth << "x" << statistics.atlasHeight << ", " << statistics.atlasTexelsPerTriangle << " texels per triangle" << std::endl << std::endl;
+	if (!statistics.nbClusters) {
+		std::cout << "No cluster was built: the scene has fewer than " << hlodOptions.minNbObjects << " objects in each cell." << std::endl;
+		return 0;
+	}
+
+	/*
+	* Draws from viewpoints farther and farther from the center of the scene, along a diagonal
+	*/
+
+	std::vector<glm::vec4> spheres(nbObjects);
+	for (size_t o = 0; o < nbObjects; ++o) {
+		spheres[o] = static_cast<const leoscene::Mesh*>(scene.shapes[scene.shapeIndices[o]].get())->boundingSphere;
+	}
+	leoscene::transformBoundingSpheres(scene.worldMatrices.data(), spheres.data(), spheres.data(), nbObjects);
+	glm::vec3 sceneMin(FLT_MAX), sceneMax(-FLT_MAX);
+	for (const glm::vec4& sphere : spheres) {
+		sceneMin = glm::min(sceneMin, glm::vec3(sphere) - sphere.w);
+		sceneMax = glm::max(sceneMax, glm::vec3(sphere) + sphere.w);
+	}
+	glm::vec3 sceneCenter = (sceneMin + sceneMax) * 0.5f;
+	float sceneRadius = glm::length(sceneMax - sceneMin) * 0.5f;
+	glm::vec3 direction = glm::normalize(glm::vec3(1, 0.5f, 1));
+
+	float projectionScale = 1.f / std::tan(glm::radians(FOV_DEGREES) * 0.5f);
+	float errorThreshold = HLOD_PIXEL_ERROR / screenHeight;
+	const float distances[] = { 0.f, 0.5f, 1.f, 2.f, 4.f, 8.f };
+	std::cout << "Distance (scene radii)\tInstances\tInstances with HLOD\tDraw commands\tDraw commands with HLOD" << std::endl;
+	for (float distance : distances) {
+		glm::vec3 eye = sceneCenter + direction * sceneRadius * distance;
+		DrawCounts withoutHlods = countDraws(scene, eye, projectionScale, errorThreshold, false);
+		DrawCounts withHlods = countDraws(scene, eye, projectionScale, errorThreshold, true);
+		std::cout << distance << "\t" << withoutHlods.nbInstances << "\t" << withHlods.nbInstances << "\t"
+			<< withoutHlods.nbBatches << "\t" << withHlods.nbBatches << std::endl;
+	}
+
+	return 0;
+}
+
+namespace {
+	void printUsage() {
+		std::cout << "Usage:" << std::endl
+			<< "\t" << "LeoHlodBench.exe my_file.scene [--threads N] [--cell-size SIZE] [--max-triangles N] [--height PIXELS]" << "\t"
+			<< "Time the HLOD building of a scene, and print the instances and draw commands left from farther and farther viewpoints." << std::endl
+			<< "\t" << "LeoHlodBench.exe --self-test" << "\t" << "Check the HLOD clusters on generated objects. Returns 1 if a check fails." << std::endl
+			<< "\t" << "LeoHlodBench.exe --help" << "\t" << "Print this help." << std::endl;
+		std::cout << "Notes:" << std::endl
+			<< "\t" << "--cell-size sets the side of the cells grouping the objects, in world units. By default, it gives about 2048 objects per cell." << std::endl
+			<< "\t" << "--max-triangles sets the largest number of triangles of a proxy (8192 by default)." << std::endl
+			<< "\t" << "--height is the height of the screen, in pixels (1080 by default). A proxy is drawn when its error covers less than 4 pixels." << std::endl
+			<< "\t" << "Frustum and occlusion culling are not applied: the counts are the instances and the draw commands given to the culling shader." << std::endl
+			<< "\t" << "No GPU is needed." << std::endl << std::endl;
+	}
+
+	int runSelfTest()
+	{
+		int nbFailures = 0;
+
+		// 32x32 bumps, 3 units apart, with two shapes and two materials. Cells of 24 units hold 8x8 of them.
+		const uint32_t gridSize = 32;
+		const glm::u8vec3 color(200, 60, 20);
+		const uint32_t maxNbTriangles = 1000;
+		leoscene::Scene scene;
+		scene.shapes.push_back(makeBump(10, 0.5f));
+		scene.shapes.push_back(makeBump(6, 1.f));
+		scene.materials.push_back(makeColoredMaterial(color));
+		scene.materials.push_back(makeColoredMaterial(color));
+		for (uint32_t x = 0; x < gridSize; ++x) {
+			for (uint32_t z = 0; z < gridSize; ++z) {
+				scene.worldMatrices.push_back(glm::translate(glm::mat4(1), glm::vec3(x * 3.f + 0.5f, 0, z * 3.f + 0.5f)) * glm::scale(glm::mat4(1), glm::vec3(2.f)));
+				scene.shapeIndices.push_back((x + z) % 2);
+				scene.materialIndices.push_back(x % 2);
+			}
+		}
+		size_t nbObjects = scene.getNbObjects();
+
+		leoscene::HlodOptions options;
+		options.cellSize = 24.f;
+		options.minNbObjects = 16;
+		options.maxNbTriangles = maxNbTriangles;
+		leoscene::HlodStatistics statistics = leoscene::buildHlods(scene, options);
+
+		nbFailures += !check(statistics.nbClusters == 16 && scene.hlodClusters.size() == 16, "The objects are grouped by cell");
+		nbFailures += !check(statistics.nbMembers == nbObjects && scene.hlodMembers.size() == nbObjects, "Every object is a member of a cluster");
+		nbFailures += !check(scene.getNbObjects() == nbObjects + statistics.nbClusters && scene.shapeIndices.size() == scene.getNbObjects()
+			&& scene.materialIndices.size() == scene.getNbObjects(), "Each cluster adds one object to the scene");
+
+		// Membership
+		{
+			std::vector<uint32_t> nbClusters(scene.getNbObjects(), 0);
+			bool proxiesAreNew = true;
+			bool membersInSphere = true;
+			for (const leoscene::HlodCluster& cluster : scene.hlodClusters) {
+				proxiesAreNew = proxiesAreNew && cluster.proxyObject >= nbObjects && cluster.proxyObject < scene.getNbObjects();
+				for (uint32_t i = 0; i < cluster.nbMembers; ++i) {
+					uint32_t member = scene.hlodMembers[cluster.firstMember + i];
+					nbClusters[member]++;
+					glm::vec4 sphere = static_cast<const leoscene::Mesh*>(scene.shapes[scene.shapeIndices[member]].get())->boundingSphere;
+					leoscene::transformBoundingSpheres(&scene.worldMatrices[member], &sphere, &sphere, 1);
+					membersInSphere = membersInSphere &&
+						glm::length(glm::vec3(sphere) - glm::vec3(cluster.boundingSphere)) + sphere.w <= cluster.boundingSphere.w * 1.0001f;
+				}
+			}
+			bool uniqueMembers = true;
+			for (size_t o = 0; o < nbObjects; ++o) {
+				uniqueMembers = uniqueMembers && nbClusters[o] == 1;
+			}
+			nbFailures += !check(uniqueMembers, "Each object is a member of a single cluster");
+			nbFailures += !check(proxiesAreNew, "The proxies are the new objects");
+			nbFailures += !check(membersInSphere, "The bounding sphere of each cluster holds its members");
+		}
+
+		// Proxies
+		{
+			bool fewTriangles = true;
+			bool uvsInAtlas = true;
+			bool proxiesInSphere = true;
+			bool finiteErrors = true;
+			std::set<uint32_t> proxyMaterials;
+			for (const leoscene::HlodCluster& cluster : scene.hlodClusters) {
+				const leoscene::Mesh* proxy = static_cast<const leoscene::Mesh*>(scene.shapes[scene.shapeIndices[cluster.proxyObject]].get());
+				proxyMaterials.insert(scene.materialIndices[cluster.proxyObject]);
+				fewTriangles = fewTriangles && proxy->indices.size() / 3 <= maxNbTriangles && proxy->indices.size() >= 3;
+				for (const leoscene::Vertex& vertex : proxy->vertices) {
+					uvsInAtlas = uvsInAtlas && vertex.uv.x >= 0 && vertex.uv.x <= 1 && vertex.uv.y >= 0 && vertex.uv.y <= 1;
+					glm::vec3 position = glm::vec3(scene.worldMatrices[cluster.proxyObject] * glm::vec4(vertex.position, 1));
+					proxiesInSphere = proxiesInSphere && glm::length(position - glm::vec3(cluster.boundingSphere)) <= cluster.boundingSphere.w * 1.0001f;
+				}
+				finiteErrors = finiteErrors && std::isfinite(cluster.error) && cluster.error > 0 && cluster.error < cluster.boundingSphere.w;
+			}
+			nbFailures += !check(fewTriangles, "The proxies are simplified down to the largest number of triangles");
+			nbFailures += !check(uvsInAtlas, "The texture coordinates of the proxies are in the atlas");
+			nbFailures += !check(proxiesInSphere, "The proxies are in the bounding spheres of their clusters");
+			nbFailures += !check(finiteErrors, "The errors of the proxies are positive and smaller than their clusters");
+			nbFailures += !check(proxyMaterials.size() == 1 && statistics.atlasWidth && statistics.atlasHeight, "The proxies share a single material");
+
+			// The members all have the same color, so the whole atlas has it
+			const leoscene::PerformanceMaterial* material =
+				static_cast<const leoscene::PerformanceMaterial*>(scene.materials[*proxyMaterials.begin()].get());
+			const leoscene::ImageTexture* atlas = material->diffuseTexture.get();
+			bool atlasColored = atlas->width == statistics.atlasWidth && atlas->height == statistics.atlasHeight && atlas->nbChannels == 4;
+			for (const leoscene::HlodCluster& cluster : scene.hlodClusters) {
+				const leoscene::Mesh* proxy = static_cast<const leoscene::Mesh*>(scene.shapes[scene.shapeIndices[cluster.proxyObject]].get());
+				for (const leoscene::Vertex& vertex : proxy->vertices) {
+					glm::vec4 texel = atlas->getTexel(vertex.uv.x, vertex.uv.y);
+					atlasColored = atlasColored && std::abs(texel.r - color.r) <= 1 && std::abs(texel.g - color.g) <= 1 && std::abs(texel.b - color.b) <= 1;
+				}
+			}
+			nbFailures += !check(atlasColored, "The atlas is baked from the colors of the materials");
+		}
+
+		// Swap test
+		{
+			const leoscene::HlodCluster& cluster = scene.hlodClusters[0];
+			glm::vec3 center = glm::vec3(cluster.boundingSphere);
+			float radius = cluster.boundingSphere.w;
+			float projectionScale = 1.f / std::tan(glm::radians(FOV_DEGREES) * 0.5f);
+			float threshold = HLOD_PIXEL_ERROR / 1080.f;
+			nbFailures += !check(!leoscene::isHlodProxyVisible(cluster.boundingSphere, cluster.error, center, projectionScale, threshold),
+				"The members are drawn from the center of their cluster");
+			nbFailures += !check(leoscene::isHlodProxyVisible(cluster.boundingSphere, cluster.error, center + glm::vec3(0, 1e6f, 0), projectionScale, threshold),
+				"The proxy is drawn from far away");
+			nbFailures += !check(!leoscene::isHlodProxyVisible(cluster.boundingSphere, cluster.error, center + glm::vec3(0, 1e6f, 0), projectionScale, 0.f),
+				"The members are always drawn with a threshold of 0");
+
+			// The proxy stays drawn when moving away
+			bool monotonic = true;
+			bool visible = false;
+			for (float distance = 0; distance < radius * 1000; distance += radius * 0.5f) {
+				bool proxyVisible = leoscene::isHlodProxyVisible(cluster.boundingSphere, cluster.error, center + glm::vec3(distance, 0, 0), projectionScale, threshold);
+				monotonic = monotonic && (proxyVisible || !visible);
+				visible = proxyVisible;
+			}
+			nbFailures += !check(monotonic, "The proxy is drawn beyond a single distance");
+
+			DrawCounts near = countDraws(scene, center, projectionScale, threshold, true);
+			DrawCounts far = countDraws(scene, center + glm::vec3(0, 1e6f, 0), projectionScale, threshold, true);
+			nbFailures += !check(near.nbInstances > nbObjects - 64 && far.nbInstances == statistics.nbClusters && far.nbBatches == statistics.nbClusters,
+				"Far away, each cluster is a single instance");
+		}
+
+		// A second call does not cluster the members nor the proxies again
+		{
+			leoscene::HlodStatistics secondStatistics = leoscene::buildHlods(scene, options);
+			nbFailures += !check(secondStatistics.nbClusters == 0 && scene.hlodClusters.size() == statistics.nbClusters, "The clusters are only built once");
+		}
+
+		// Cell size picked from the number of objects
+		{
+			leoscene::Scene autoScene;
+			autoScene.shapes = scene.shapes;
+			autoScene.materials = scene.materials;
+			autoScene.worldMatrices.assign(scene.worldMatrices.begin(), scene.worldMatrices.begin() + nbObjects);
+			autoScene.shapeIndices.assign(scene.shapeIndices.begin(), scene.shapeIndices.begin() + nbObjects);
+			autoScene.materialIndices.assign(scene.materialIndices.begin(), scene.materialIndices.begin() + nbObjects);
+			leoscene::HlodOptions autoOptions;
+			autoOptions.targetNbObjects = 128;
+			autoOptions.minNbObjects = 16;
+			autoOptions.maxNbTriangles = maxNbTriangles;
+			leoscene::HlodStatistics autoStatistics = leoscene::buildHlods(autoScene, autoOptions);
+			nbFailures += !check(autoStatistics.nbClusters >= nbObjects / 128 && autoStatistics.nbMembers / autoStatistics.nbClusters <= 128,
+				"The cell size gives the target number of objects per cluster");
+		}
+
+		// Atlases smaller than the squares of the triangles: the squares are lowered, then shared past one texel per triangle
+		for (uint32_t maxAtlasSize : { 256u, 32u }) {
+			leoscene::Scene smallAtlasScene;
+			smallAtlasScene.shapes.assign(scene.shapes.begin(), scene.shapes.begin() + 2);
+			smallAtlasScene.materials.assign(scene.materials.begin(), scene.materials.begin() + 2);
+			smallAtlasScene.worldMatrices.assign(scene.worldMatrices.begin(), scene.worldMatrices.begin() + nbObjects);
+			smallAtlasScene.shapeIndices.assign(scene.shapeIndices.begin(), scene.shapeIndices.begin() + nbObjects);
+			smallAtlasScene.materialIndices.assign(scene.materialIndices.begin(), scene.materialIndices.begin() + nbObjects);
+			leoscene::HlodOptions smallAtlasOptions = options;
+			smallAtlasOptions.maxAtlasSize = maxAtlasSize;
+			leoscene::HlodStatistics smallAtlasStatistics = leoscene::buildHlods(smallAtlasScene, smallAtlasOptions);
+
+			const leoscene::PerformanceMaterial* material = static_cast<const leoscene::PerformanceMaterial*>(smallAtlasScene.materials.back().get());
+			const leoscene::ImageTexture* atlas = material->diffuseTexture.get();
+			bool atlasFits = atlas->width == smallAtlasStatistics.atlasWidth && atlas->height == smallAtlasStatistics.atlasHeight &&
+				atlas->width <= maxAtlasSize && atlas->height <= maxAtlasSize && smallAtlasStatistics.atlasTexelsPerTriangle < options.atlasTexelsPerTriangle;
+			bool atlasColored = true;
+			for (const leoscene::HlodCluster& cluster : smallAtlasScene.hlodClusters) {
+				const leoscene::Mesh* proxy = static_cast<const leoscene::Mesh*>(smallAtlasScene.shapes[smallAtlasScene.shapeIndices[cluster.proxyObject]].get());
+				for (const leoscene::Vertex& vertex : proxy->vertices) {
+					glm::vec4 texel = atlas->getTexel(vertex.uv.x, vertex.uv.y);
+					atlasColored = atlasColored && vertex.uv.x >= 0 && vertex.uv.x <= 1 && vertex.uv.y >= 0 && vertex.uv.y <= 1 &&
+						std::abs(texel.r - color.r) <= 1 && std::abs(texel.g - color.g) <= 1 && std::abs(texel.b - color.b) <= 1;
+				}
+			}
+			std::string description = "The atlas fits in " + std::to_string(maxAtlasSize) + "x" + std::to_string(maxAtlasSize) + " texels";
+			nbFailures += !check(smallAtlasStatistics.nbClusters == statistics.nbClusters && atlasFits && atlasColored, description.c_str());
+		}
+
+		std::cout << (nbFailures ? "Self test failed." : "Self test passed.") << std::endl;
+		return nbFailures;
+	}
+
+	DrawCounts countDraws(const leoscene::Scene& scene, const glm::vec3& eye, float projectionScale, float errorThreshold, bool useHlods)
+	{
+		// Same codes as the renderer: the cluster of each object, shifted left by one with the lowest bit set on the proxies
+		const uint32_t noHlod = 0xFFFFFFFF;
+		std::vector<uint32_t> objectsHlod(scene.getNbObjects(), noHlod);
+		std::vector<uint8_t> isProxyVisible(scene.hlodClusters.size());
+		for (uint32_t c = 0; c < scene.hlodClusters.size(); ++c) {
+			const leoscene::HlodCluster& cluster = scene.hlodClusters[c];
+			objectsHlod[cluster.proxyObject] = (c << 1) | 1;
+			for (uint32_t i = 0; i < cluster.nbMembers; ++i) {
+				objectsHlod[scene.hlodMembers[cluster.firstMember + i]] = c << 1;
+			}
+			isProxyVisible[c] = useHlods && leoscene::isHlodProxyVisible(cluster.boundingSphere, cluster.error, eye, projectionScale, errorThreshold);
+		}
+
+		DrawCounts counts;
+		std::set<std::pair<uint32_t, uint32_t>> batches;
+		for (size_t o = 0; o < scene.getNbObjects(); ++o) {
+			uint32_t hlod = objectsHlod[o];
+			if (hlod != noHlod && bool(isProxyVisible[hlod >> 1]) != bool(hlod & 1)) {
+				continue;
+			}
+			counts.nbInstances++;
+			batches.emplace(scene.materialIndices[o], scene.shapeIndices[o]);
+		}
+		counts.nbBatches = batches.size();
+		return counts;
+	}
+
+	std::shared_ptr<leoscene::Mesh> makeBump(uint32_t nbQuads, float height)
+	{
+		std::shared_ptr<leoscene::Mesh> mesh = std::make_shared<leoscene::Mesh>();
+		for (uint32_t j = 0; j <= nbQuads; ++j) {
+			for (uint32_t i = 0; i <= nbQuads; ++i) {
+				leoscene::Vertex vertex;
+				float x = float(i) / nbQuads;
+				float z = float(j) / nbQuads;
+				vertex.position = glm::vec3(x, height * std::sin(x * glm::pi<float>()) * std::sin(z * glm::pi<float>()), z);
+				vertex.normal = glm::vec3(0, 1, 0);
+				vertex.uv = glm::vec2(x, z);
+				mesh->vertices.push_back(vertex);
+			}
+		}
+		for (uint32_t j = 0; j < nbQuads; ++j) {
+			for (uint32_t i = 0; i < nbQuads; ++i) {
+				uint32_t corner = j * (nbQuads + 1) + i;
+				uint32_t quad[6] = { corner, corner + nbQuads + 1, corner + 1, corner + 1, corner + nbQuads + 1, corner + nbQuads + 2 };
+				mesh->indices.insert(mesh->indices.end(), quad, quad + 6);
+			}
+		}
+		mesh->boundingSphere = leoscene::computeBoundingSphere(&mesh->vertices[0].position, mesh->vertices.size(), sizeof(leoscene::Vertex));
+		leoscene::computeBoundingBox(&mesh->vertices[0].position, mesh->vertices.size(), mesh->boundingBoxMin, mesh->boundingBoxMax, sizeof(leoscene::Vertex));
+		mesh->indexType = leoscene::selectIndexType(mesh->vertices.size());
+		return mesh;
+	}
+
+	std::shared_ptr<leoscene::PerformanceMaterial> makeColoredMaterial(const glm::u8vec3& color)
+	{
+		unsigned char* data = new unsigned char[2 * 2 * 3];
+		for (size_t i = 0; i < 4; ++i) {
+			data[i * 3] = color.r;
+			data[i * 3 + 1] = color.g;
+			data[i * 3 + 2] = color.b;
+		}
+		std::shared_ptr<leoscene::PerformanceMaterial> material = std::make_shared<leoscene::PerformanceMaterial>();
+		material->diffuseTexture = std::make_shared<leoscene::ImageTexture>(2, 2, leoscene::ImageTexture::Type::FLOAT, leoscene::ImageTexture::Layout::RGB, data);
+		return material;
+	}
+}
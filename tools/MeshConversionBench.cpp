@@ -0,0 +1,425 @@
+#include <scene/SceneLoader.h>
+#include <scene/MeshConversion.h>
+#include <scene/MeshClusters.h>
+#include <scene/MeshOptimizer.h>
+#include <scene/MeshSimplifier.h>
+#include <scene/BoundingVolumes.h>
+#include <scene/ThreadPool.h>
+#include <scene/Mesh.h>
+
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+
+#include "SelfTest.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace {
+	void printUsage();
+
+	// Checks the conversion against the reference on generated meshes.
+	int runSelfTest();
+
+	// Conversion as it was done before convertMesh: vertices and indices appended one by one, the presence of each attribute tested for each vertex.
+	void convertMeshReference(const aiMesh& assimpMesh, leoscene::Mesh& mesh);
+
+	// Conversion, then optimization, clusters and levels of detail, as in ModelLoader
+	void processMesh(const aiMesh& assimpMesh, leoscene::Mesh& mesh);
+
+	// Calls function(i) for each i < count, on the calling thread and on the threads of the pool, like ModelLoader does for the meshes of a model
+	template<typename Function>
+	void parallelFor(leoscene::ThreadPool& threadPool, size_t count, Function function);
+
+	// Best time over the iterations, in milliseconds
+	template<typename Function>
+	double timeBest(uint32_t nbIterations, Function function);
+
+	// Grid of nbQuadsX * nbQuadsY quads, with the attributes that Assimp would give, or without normals, tangents and UVs
+	std::unique_ptr<aiMesh> makeAssimpGrid(uint32_t nbQuadsX, uint32_t nbQuadsY, bool withAttributes);
+
+	// Largest difference between the vertices and the bounds of two meshes. Infinite if their sizes or their indices differ.
+	float getMaxDifference(const leoscene::Mesh& a, const leoscene::Mesh& b);
+
+	void printResult(const char* name, double referenceMs, double newMs);
+
+	using leotools::check;
+}
+
+int main(int argc, const char** argv) {
+	if (argc < 2 || !strcmp(argv[1], "--help")) {
+		printUsage();
+		return argc < 2 ? 1 : 0;
+	}
+
+	if (!strcmp(argv[1], "--self-test")) {
+		return runSelfTest() ? 1 : 0;
+	}
+
+	size_t nbThreads = leoscene::ThreadPool::getDefaultNbThreads();
+	uint32_t nbIterations = 5;
+	uint32_t nbGeneratedMeshes = 0;
+	for (int i = 2; i < argc; ++i) {
+		if (!strcmp(argv[i], "--threads") && i + 1 < argc) {
+			nbThreads = static_cast<size_t>(atoi(argv[++i]));
+		}
+		else if (!strcmp(argv[i], "--iterations") && i + 1 < argc) {
+			nbIterations = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else if (!strcmp(argv[1], "--generated") && !nbGeneratedMeshes && atoi(argv[i]) > 0) {
+			nbGeneratedMeshes = static_cast<uint32_t>(atoi(argv[i]));
+		}
+		else {
+			std::cerr << "Error: unknown argument \"" << argv[i] << "\"." << std::endl;
+			printUsage();
+			return 1;
+		}
+	}
+	if (!nbThreads || !nbIterations) {
+		std::cerr << "Error: --threads and --iterations must be positive." << std::endl;
+		return 1;
+	}
+
+	// Assimp meshes of all the models of the scene, or generated ones. The importers own the meshes of their models.
+	std::vector<std::unique_ptr<Assimp::Importer>> importers;
+	std::vector<std::unique_ptr<aiMesh>> generatedMeshes;
+	std::vector<const aiMesh*> assimpMeshes;
+	if (!strcmp(argv[1], "--generated")) {
+		// Sizes spread like the meshes of Sponza: many small meshes and a few large ones
+		for (uint32_t i = 0; i < (nbGeneratedMeshes ? nbGeneratedMeshes : 32); ++i) {
+			uint32_t nbQuads = 8 << (i % 6);
+			generatedMeshes.push_back(makeAssimpGrid(nbQuads, nbQuads, true));
+			assimpMeshes.push_back(generatedMeshes.back().get());
+		}
+	}
+	else {
+		const char* scenePath = argv[1];
+		leoscene::SceneDescription description;
+		try {
+			leoscene::SceneLoader::parseTextScene(scenePath, description);
+		}
+		catch (const leoscene::SceneLoaderException& e) {
+			std::cerr << e.what() << std::endl;
+			std::cerr << "Error: Scene parsing failed." << std::endl;
+			return 2;
+		}
+		std::string strScenePath = scenePath;
+		std::string fileDirectoryPath = strScenePath.substr(0, strScenePath.find_last_of('/'));
+
+		std::set<std::string> modelPaths;
+		for (const leoscene::SceneDescription::ModelEntry& entry : description.models) {
+			if (!entry.isSphere()) {
+				modelPaths.insert(fileDirectoryPath + "/" + entry.path);
+			}
+		}
+		for (const std::string& modelPath : modelPaths) {
+			importers.push_back(std::make_unique<Assimp::Importer>());
+			const aiScene* aiScene = importers.back()->ReadFile(modelPath, leoscene::ASSIMP_IMPORT_FLAGS);
+			if (!aiScene || aiScene->mFlags & AI_SCENE_FLAGS_INCOMPLETE) {
+				std::cerr << "Warning: could not import " << modelPath << "." << std::endl;
+				continue;
+			}
+			assimpMeshes.insert(assimpMeshes.end(), aiScene->mMeshes, aiScene->mMeshes + aiScene->mNumMeshes);
+		}
+	}
+
+	size_t nbVertices = 0;
+	size_t nbIndices = 0;
+	for (const aiMesh* assimpMesh : assimpMeshes) {
+		nbVertices += assimpMesh->mNumVertices;
+		nbIndices += assimpMesh->mNumFaces * 3;
+	}
+	if (!nbVertices) {
+		std::cerr << "Error: The scene has no mesh." << std::endl;
+		return 2;
+	}
+	std::cout << "Meshes:\t" << assimpMeshes.size() << " (" << nbVertices << " vertices, about " << nbIndices / 3 << " triangles)" << std::endl;
+	std::cout << "Threads:\t" << nbThreads << ", best of " << nbIterations << " runs" << std::endl << std::endl;
+
+	leoscene::ThreadPool threadPool(nbThreads - 1);  // The calling thread works too
+	std::vector<leoscene::Mesh> referenceMeshes(assimpMeshes.size());
+	std::vector<leoscene::Mesh> meshes(assimpMeshes.size());
+
+	// The meshes are emptied before each run, so that every run allocates them again like an import does
+	double referenceMs = timeBest(nbIterations, [&]() {
+		for (size_t i = 0; i < assimpMeshes.size(); ++i) {
+			referenceMeshes[i] = leoscene::Mesh();
+			convertMeshReference(*assimpMeshes[i], referenceMeshes[i]);
+		}
+	});
+	double sequentialMs = timeBest(nbIterations, [&]() {
+		for (size_t i = 0; i < assimpMeshes.size(); ++i) {
+			meshes[i] = leoscene::Mesh();
+			leoscene::convertMesh(*assimpMeshes[i], meshes[i]);
+		}
+	});
+	double parallelMs = timeBest(nbIterations, [&]() {
+		parallelFor(threadPool, assimpMeshes.size(), [&](size_t i) {
+			meshes[i] = leoscene::Mesh();
+			leoscene::convertMesh(*assimpMeshes[i], meshes[i]);
+		});
+	});
+
+	float maxDifference = 0;
+	for (size_t i = 0; i < assimpMeshes.size(); ++i) {
+		maxDifference = std::max(maxDifference, getMaxDifference(referenceMeshes[i], meshes[i]));
+	}
+
+	std::cout << "Conversion:" << std::endl
+		<< "\t" << "Previous conversion:\t" << referenceMs << " ms" << std::endl
+		<< "\t" << "convertMesh:\t" << sequentialMs << " ms\t(" << referenceMs / sequentialMs << "x)" << std::endl
+		<< "\t" << "convertMesh, parallel:\t" << parallelMs << " ms\t(" << referenceMs / parallelMs << "x)" << std::endl
+		<< "\t" << "Max difference:\t" << maxDifference << std::endl;
+
+	// Whole processing of the meshes of an import, with the default options of ModelLoader
+	double processingMs = timeBest(nbIterations, [&]() {
+		for (size_t i = 0; i < assimpMeshes.size(); ++i) {
+			meshes[i] = leoscene::Mesh();
+			processMesh(*assimpMeshes[i], meshes[i]);
+		}
+	});
+	double parallelProcessingMs = timeBest(nbIterations, [&]() {
+		parallelFor(threadPool, assimpMeshes.size(), [&](size_t i) {
+			meshes[i] = leoscene::Mesh();
+			processMesh(*assimpMeshes[i], meshes[i]);
+		});
+	});
+	printResult("Conversion, optimization, clusters and LODs", processingMs, parallelProcessingMs);
+
+	return 0;
+}
+
+namespace {
+	void printUsage() {
+		std::cout << "Usage:" << std::endl
+			<< "\t" << "LeoMeshConversionBench.exe my_file.scene [--threads N] [--iterations N]" << "\t" << "Time the conversion and the processing of the meshes of the models of a text scene." << std::endl
+			<< "\t" << "LeoMeshConversionBench.exe --generated [N] [--threads N] [--iterations N]" << "\t" << "Same with N generated meshes (32 by default) instead of model files." << std::endl
+			<< "\t" << "LeoMeshConversionBench.exe --self-test" << "\t" << "Check the conversion on generated meshes. Returns 1 if a check fails." << std::endl
+			<< "\t" << "LeoMeshConversionBench.exe --help" << "\t" << "Print this help." << std::endl;
+		std::cout << "Notes:" << std::endl
+			<< "\t" << "The previous conversion appended the vertices and indices one by one. It is kept in this bench as the reference." << std::endl
+			<< "\t" << "Parallel runs process the meshes on --threads threads (one per hardware thread by default), as ModelLoader does for the meshes of a model." << std::endl
+			<< "\t" << "Assimp imports the models once, outside of the measures. No GPU is needed. The asset cache is not used." << std::endl << std::endl;
+	}
+
+	int runSelfTest()
+	{
+		int nbFailures = 0;
+
+		// Same result as the reference conversion, with or without the optional attributes
+		{
+			std::unique_ptr<aiMesh> grid = makeAssimpGrid(17, 9, true);
+			leoscene::Mesh reference, mesh;
+			convertMeshReference(*grid, reference);
+			leoscene::convertMesh(*grid, mesh);
+			nbFailures += !check(getMaxDifference(reference, mesh) == 0, "A mesh with normals, tangents and UVs is converted like the reference");
+			nbFailures += !check(mesh.indices.size() == 17 * 9 * 6 && mesh.vertices.size() == 18 * 10, "All the vertices and indices are converted");
+		}
+
+		{
+			std::unique_ptr<aiMesh> grid = makeAssimpGrid(5, 5, false);
+			leoscene::Mesh reference, mesh;
+			convertMeshReference(*grid, reference);
+			leoscene::convertMesh(*grid, mesh);
+			nbFailures += !check(getMaxDifference(reference, mesh) == 0, "A mesh with positions only is converted like the reference");
+			leoscene::Vertex defaultVertex;
+			bool defaultAttributes = true;
+			for (const leoscene::Vertex& vertex : mesh.vertices) {
+				defaultAttributes = defaultAttributes && vertex.normal == defaultVertex.normal && vertex.tangent == defaultVertex.tangent && vertex.uv == defaultVertex.uv;
+			}
+			nbFailures += !check(defaultAttributes, "Missing attributes get the default values of Vertex");
+		}
+
+		// Point and line faces, left by aiProcess_SortByPType in their own meshes, are copied as they are
+		{
+			std::unique_ptr<aiMesh> grid = makeAssimpGrid(2, 2, true);
+			delete[] grid->mFaces[1].mIndices;
+			grid->mFaces[1].mNumIndices = 2;
+			grid->mFaces[1].mIndices = new unsigned int[2]{ 4, 5 };
+			delete[] grid->mFaces[2].mIndices;
+			grid->mFaces[2].mNumIndices = 1;
+			grid->mFaces[2].mIndices = new unsigned int[1]{ 7 };
+			leoscene::Mesh reference, mesh;
+			convertMeshReference(*grid, reference);
+			leoscene::convertMesh(*grid, mesh);
+			nbFailures += !check(getMaxDifference(reference, mesh) == 0 && mesh.indices.size() == 2 * 2 * 6 - 3, "Faces that are not triangles keep their indices");
+		}
+
+		// Empty mesh
+		{
+			aiMesh empty;
+			leoscene::Mesh mesh;
+			leoscene::convertMesh(empty, mesh);
+			nbFailures += !check(mesh.vertices.empty() && mesh.indices.empty() && mesh.boundingSphere == glm::vec4(0), "An empty mesh gives an empty mesh");
+		}
+
+		// Parallel conversion gives the same meshes as the sequential one, whatever the number of threads
+		{
+			std::vector<std::unique_ptr<aiMesh>> grids;
+			for (uint32_t i = 0; i < 24; ++i) {
+				grids.push_back(makeAssimpGrid(3 + i * 5, 2 + i, i % 3 != 0));
+			}
+			std::vector<leoscene::Mesh> reference(grids.size());
+			for (size_t i = 0; i < grids.size(); ++i) {
+				convertMeshReference(*grids[i], reference[i]);
+			}
+			bool identical = true;
+			for (size_t nbThreads : { 0, 1, 3, 8 }) {
+				leoscene::ThreadPool threadPool(nbThreads);
+				std::vector<leoscene::Mesh> meshes(grids.size());
+				parallelFor(threadPool, grids.size(), [&](size_t i) { leoscene::convertMesh(*grids[i], meshes[i]); });
+				for (size_t i = 0; i < grids.size(); ++i) {
+					identical = identical && getMaxDifference(reference[i], meshes[i]) == 0;
+				}
+			}
+			nbFailures += !check(identical, "Meshes converted on 1, 2, 4 and 9 threads are the same as the reference");
+		}
+
+		std::cout << (nbFailures ? "Self test failed." : "Self test passed.") << std::endl;
+		return nbFailures;
+	}
+
+	void convertMeshReference(const aiMesh& assimpMesh, leoscene::Mesh& mesh)
+	{
+		std::vector<uint32_t>& indices = mesh.indices;
+		for (unsigned int i = 0; i < assimpMesh.mNumFaces; ++i)
+		{
+			const aiFace& face = assimpMesh.mFaces[i];
+			for (unsigned int j = 0; j < face.mNumIndices; ++j) {
+				indices.push_back(face.mIndices[j]);
+			}
+		}
+
+		std::vector<leoscene::Vertex>& vertices = mesh.vertices;
+		bool hasUv = assimpMesh.mTextureCoords[0];
+		bool hasNormals = assimpMesh.HasNormals();
+		bool hasTangents = assimpMesh.HasTangentsAndBitangents();
+		for (unsigned int i = 0; i < assimpMesh.mNumVertices; ++i) {
+			const aiVector3D& v = assimpMesh.mVertices[i];
+			vertices.push_back({
+					glm::vec3(v.x, v.y, v.z),
+					hasNormals ? glm::vec3(assimpMesh.mNormals[i].x, assimpMesh.mNormals[i].y, assimpMesh.mNormals[i].z) : glm::vec3(0, 0, 1),
+					hasTangents ? glm::vec3(assimpMesh.mTangents[i].x, assimpMesh.mTangents[i].y, assimpMesh.mTangents[i].z) : glm::vec3(1, 0, 0),
+					hasUv ? glm::vec2(assimpMesh.mTextureCoords[0][i].x, assimpMesh.mTextureCoords[0][i].y) : glm::vec2(0, 0)
+				});
+		}
+		if (vertices.size()) {
+			mesh.boundingSphere = leoscene::computeBoundingSphere(&vertices[0].position, vertices.size(), sizeof(leoscene::Vertex));
+			leoscene::computeBoundingBox(&vertices[0].position, vertices.size(), mesh.boundingBoxMin, mesh.boundingBoxMax, sizeof(leoscene::Vertex));
+		}
+	}
+
+	void processMesh(const aiMesh& assimpMesh, leoscene::Mesh& mesh)
+	{
+		leoscene::convertMesh(assimpMesh, mesh);
+		leoscene::optimizeMesh(mesh);
+		leoscene::buildClusters(mesh);
+		leoscene::generateLods(mesh);
+	}
+
+	template<typename Function>
+	void parallelFor(leoscene::ThreadPool& threadPool, size_t count, Function function)
+	{
+		std::atomic<size_t> next(0);
+		auto work = [&]() {
+			for (size_t i = next++; i < count; i = next++) {
+				function(i);
+			}
+		};
+		std::vector<std::future<void>> helpers;
+		for (size_t i = 0; i < threadPool.getNbThreads(); ++i) {
+			helpers.push_back(threadPool.submit(work));
+		}
+		work();
+		for (std::future<void>& helper : helpers) {
+			helper.get();
+		}
+	}
+
+	template<typename Function>
+	double timeBest(uint32_t nbIterations, Function function)
+	{
+		double best = 0;
+		for (uint32_t i = 0; i < nbIterations; ++i) {
+			auto start = std::chrono::steady_clock::now();
+			function();
+			double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			best = i ? std::min(best, milliseconds) : milliseconds;
+		}
+		return best;
+	}
+
+	std::unique_ptr<aiMesh> makeAssimpGrid(uint32_t nbQuadsX, uint32_t nbQuadsY, bool withAttributes)
+	{
+		std::unique_ptr<aiMesh> mesh = std::make_unique<aiMesh>();
+		mesh->mPrimitiveTypes = aiPrimitiveType_TRIANGLE;
+		mesh->mNumVertices = (nbQuadsX + 1) * (nbQuadsY + 1);
+		mesh->mVertices = new aiVector3D[mesh->mNumVertices];
+		if (withAttributes) {
+			mesh->mNormals = new aiVector3D[mesh->mNumVertices];
+			mesh->mTangents = new aiVector3D[mesh->mNumVertices];
+			mesh->mBitangents = new aiVector3D[mesh->mNumVertices];
+			mesh->mTextureCoords[0] = new aiVector3D[mesh->mNumVertices];
+			mesh->mNumUVComponents[0] = 2;
+		}
+		for (uint32_t y = 0; y <= nbQuadsY; ++y) {
+			for (uint32_t x = 0; x <= nbQuadsX; ++x) {
+				uint32_t i = y * (nbQuadsX + 1) + x;
+				float height = std::sin(x * 0.7f) * std::cos(y * 0.3f);
+				mesh->mVertices[i] = aiVector3D(float(x), float(y), height);
+				if (withAttributes) {
+					mesh->mNormals[i] = aiVector3D(-height * 0.5f, 0.25f, 1.f).Normalize();
+					mesh->mTangents[i] = aiVector3D(1.f, 0.f, height * 0.5f).Normalize();
+					mesh->mBitangents[i] = aiVector3D(0.f, 1.f, 0.f);
+					mesh->mTextureCoords[0][i] = aiVector3D(float(x) / nbQuadsX, float(y) / nbQuadsY, 0.f);
+				}
+			}
+		}
+		mesh->mNumFaces = nbQuadsX * nbQuadsY * 2;
+		mesh->mFaces = new aiFace[mesh->mNumFaces];
+		for (uint32_t y = 0; y < nbQuadsY; ++y) {
+			for (uint32_t x = 0; x < nbQuadsX; ++x) {
+				unsigned int corner = y * (nbQuadsX + 1) + x;
+				aiFace* faces = &mesh->mFaces[(y * nbQuadsX + x) * 2];
+				faces[0].mNumIndices = faces[1].mNumIndices = 3;
+				faces[0].mIndices = new unsigned int[3]{ corner, corner + 1, corner + nbQuadsX + 2 };
+				faces[1].mIndices = new unsigned int[3]{ corner, corner + nbQuadsX + 2, corner + nbQuadsX + 1 };
+			}
+		}
+		return mesh;
+	}
+
+	float getMaxDifference(const leoscene::Mesh& a, const leoscene::Mesh& b)
+	{
+		if (a.vertices.size() != b.vertices.size() || a.indices != b.indices) {
+			return INFINITY;
+		}
+		float difference = glm::length(a.boundingSphere - b.boundingSphere);
+		difference = std::max(difference, glm::length(a.boundingBoxMin - b.boundingBoxMin));
+		difference = std::max(difference, glm::length(a.boundingBoxMax - b.boundingBoxMax));
+		for (size_t i = 0; i < a.vertices.size(); ++i) {
+			difference = std::max(difference, glm::length(a.vertices[i].position - b.vertices[i].position));
+			difference = std::max(difference, glm::length(a.vertices[i].normal - b.vertices[i].normal));
+			difference = std::max(difference, glm::length(a.vertices[i].tangent - b.vertices[i].tangent));
+			difference = std::max(difference, glm::length(a.vertices[i].uv - b.vertices[i].uv));
+		}
+		return difference;
+	}
+
+	void printResult(const char* name, double referenceMs, double newMs)
+	{
+		std::cout << name << ":" << std::endl
+			<< "\t" << "One thread:\t" << referenceMs << " ms" << std::endl
+			<< "\t" << "Parallel:\t" << newMs << " ms" << std::endl
+			<< "\t" << "Speedup:\t" << referenceMs / newMs << "x" << std::endl;
+	}
+}
@@ -0,0 +1,604 @@
+#include <scene/SceneLoader.h>
+#include <scene/ModelLoader.h>
+#include <scene/MeshClusters.h>
+#include <scene/MeshOptimizer.h>
+#include <scene/MeshSimplifier.h>
+#include <scene/PackedVertex.h>
+#include <scene/Mesh.h>
+
+#include "SelfTest.h"
+
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+	void printUsage();
+
+	// Checks the optimizations on generated meshes, with the simulated cache only.
+	int runSelfTest();
+
+	// Triangles as their vertex positions, rotated to start with the smallest one (which keeps the winding), and sorted.
+	// Equal for two meshes made of the same triangles, whatever the order of the triangles and vertices.
+	std::vector<std::array<float, 9>> getTriangleSet(const leoscene::Mesh& mesh);
+
+	leoscene::Mesh makeShuffledGrid(uint32_t nbQuadsX, uint32_t nbQuadsY, uint32_t seed);
+
+	// Closed sphere without seams: the poles and the first meridian are shared by their triangles.
+	leoscene::Mesh makeSphere(uint32_t nbRings, uint32_t nbSegments, float radius);
+
+	// Largest distance between the center of a triangle of the LOD and the sphere, relative to the radius.
+	float getMaxSphereDistance(const leoscene::Mesh& sphere, const leoscene::MeshLod& lod);
+
+	// True if all the triangles of the LOD face z+, without being degenerate.
+	bool facesUp(const leoscene::Mesh& mesh, const leoscene::MeshLod& lod);
+
+	// True if no triangle of the cluster can be seen from its front side from eye. Triangles are wound counter-clockwise.
+	bool facesAway(const leoscene::Mesh& mesh, const leoscene::MeshCluster& cluster, const glm::vec3& eye);
+
+	// Largest distance between the vertices and their packed version, relative to the size of the mesh
+	float getMaxPackingError(const std::vector<leoscene::Vertex>& vertices);
+
+	using leotools::check;
+}
+
+int main(int argc, const char** argv) {
+	if (argc < 2 || !strcmp(argv[1], "--help")) {
+		printUsage();
+		return argc < 2 ? 1 : 0;
+	}
+
+	if (!strcmp(argv[1], "--self-test")) {
+		return runSelfTest() ? 1 : 0;
+	}
+
+	const char* scenePath = argv[1];
+	leoscene::SceneDescription description;
+	try {
+		leoscene::SceneLoader::parseTextScene(scenePath, description);
+	}
+	catch (const leoscene::SceneLoaderException& e) {
+		std::cerr << e.what() << std::endl;
+		std::cerr << "Error: Scene parsing failed." << std::endl;
+		return 2;
+	}
+	std::string strScenePath = scenePath;
+	std::string fileDirectoryPath = strScenePath.substr(0, strScenePath.find_last_of('/'));
+
+	// Meshes as they are in the model files
+	leoscene::ModelLoader modelLoader;
+	modelLoader.setMeshOptimization(false);
+	modelLoader.setLodGeneration(false);
+	modelLoader.setClusterGeneration(false);
+
+	std::cout << "Model\tMesh\tTriangles\tACMR before\tACMR after\tATVR before\tATVR after\tTime (ms)\tClusters\tACMR clustered\tLOD triangles\tCoarsest LOD error\tLOD time (ms)" << std::endl;
+	uint64_t totalNbTriangles = 0;
+	uint64_t totalNbClusteredTriangles = 0;
+	uint64_t totalTransformedClustered = 0;
+	size_t totalNbClusters = 0;
+	size_t totalNbClustersWithCone = 0;
+	double totalClusteringMilliseconds = 0;
+	uint64_t totalNbLodTriangles = 0;
+	double totalLodMilliseconds = 0;
+	uint64_t totalTransformedBefore = 0, totalTransformedAfter = 0;
+	uint64_t totalNbVertices = 0;
+	double totalMilliseconds = 0;
+	float maxPackingError = 0;
+	std::unordered_set<const leoscene::Shape*> visitedMeshes;
+	for (const leoscene::SceneDescription::ModelEntry& entry : description.models) {
+		if (entry.isSphere()) {
+			continue;
+		}
+		std::string modelPath = fileDirectoryPath + "/" + entry.path;
+		leoscene::Model model = modelLoader.loadModel(modelPath.c_str());
+		for (size_t i = 0; i < model.size(); ++i) {
+			const leoscene::Shape* shape = model[i].shape.get();
+			if (!shape || shape->getType() != leoscene::Shape::Type::MESH || !visitedMeshes.insert(shape).second) {
+				continue;
+			}
+
+			leoscene::Mesh mesh = *static_cast<const leoscene::Mesh*>(shape);
+			leoscene::VertexCacheStatistics before = leoscene::analyzeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size());
+			auto start = std::chrono::steady_clock::now();
+			leoscene::optimizeMesh(mesh);
+			double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			leoscene::VertexCacheStatistics after = leoscene::analyzeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size());
+			size_t nbTriangles = mesh.indices.size() / 3;
+
+			start = std::chrono::steady_clock::now();
+			leoscene::buildClusters(mesh);
+			totalClusteringMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			leoscene::VertexCacheStatistics clustered = leoscene::analyzeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size());
+			totalTransformedClustered += clustered.nbTransformedVertices;
+			if (mesh.clusters.size()) {
+				totalNbClusteredTriangles += nbTriangles;
+				totalNbClusters += mesh.clusters.size();
+				for (const leoscene::MeshCluster& cluster : mesh.clusters) {
+					totalNbClustersWithCone += cluster.coneAxis != glm::vec3(0);
+				}
+			}
+
+			start = std::chrono::steady_clock::now();
+			leoscene::generateLods(mesh);
+			double lodMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			std::string lodTriangles = std::to_string(nbTriangles);
+			for (size_t lod = 1; lod < mesh.lods.size(); ++lod) {
+				lodTriangles += "/" + std::to_string(mesh.lods[lod].nbIndices / 3);
+				totalNbLodTriangles += mesh.lods[lod].nbIndices / 3;
+			}
+
+			std::cout << entry.path << "\t" << i << "\t" << nbTriangles << "\t"
+				<< before.acmr << "\t" << after.acmr << "\t" << before.atvr << "\t" << after.atvr << "\t" << milliseconds << "\t"
+				<< mesh.clusters.size() << "\t" << clustered.acmr << "\t"
+				<< lodTriangles << "\t" << (mesh.lods.empty() ? 0.f : mesh.lods.back().error) << "\t" << lodMilliseconds << std::endl;
+
+			totalNbTriangles += nbTriangles;
+			totalTransformedBefore += before.nbTransformedVertices;
+			totalTransformedAfter += after.nbTransformedVertices;
+			totalNbVertices += mesh.vertices.size();
+			totalMilliseconds += milliseconds;
+			totalLodMilliseconds += lodMilliseconds;
+			maxPackingError = std::max(maxPackingError, getMaxPackingError(mesh.vertices));
+		}
+	}
+
+	if (!totalNbTriangles) {
+		std::cerr << "Error: The scene has no triangle mesh." << std::endl;
+		return 2;
+	}
+	std::cout << "Total\t" << visitedMeshes.size() << "\t" << totalNbTriangles << "\t"
+		<< double(totalTransformedBefore) / totalNbTriangles << "\t" << double(totalTransformedAfter) / totalNbTriangles << "\t"
+		<< double(totalTransformedBefore) / totalNbVertices << "\t" << double(totalTransformedAfter) / totalNbVertices << "\t"
+		<< totalMilliseconds << "\t" << totalNbClusters << "\t" << double(totalTransformedClustered) / totalNbTriangles << "\t"
+		<< totalNbTriangles + totalNbLodTriangles << "\t\t" << totalLodMilliseconds << std::endl << std::endl;
+
+	std::cout << "Clusters:\t" << totalNbClusters << " for " << totalNbClusteredTriangles << " triangles ("
+		<< (totalNbClusters ? double(totalNbClusteredTriangles) / totalNbClusters : 0.0) << " per cluster), "
+		<< (totalNbClusters ? 100.0 * totalNbClustersWithCone / totalNbClusters : 0.0) << "% with a normal cone, "
+		<< totalClusteringMilliseconds << " ms" << std::endl;
+
+	std::cout << "LOD indices:\t+" << 100.0 * totalNbLodTriangles / totalNbTriangles << "% of the full meshes" << std::endl;
+
+	size_t packedVertexSize = sizeof(leoscene::PackedVertexPosition) + sizeof(leoscene::PackedVertexAttributes);
+	std::cout << "Vertex memory:\t" << totalNbVertices * sizeof(leoscene::Vertex) / (1024.0 * 1024.0) << " MB unpacked, "
+		<< totalNbVertices * packedVertexSize / (1024.0 * 1024.0) << " MB packed ("
+		<< double(sizeof(leoscene::Vertex)) / packedVertexSize << "x smaller), of which "
+		<< totalNbVertices * sizeof(leoscene::PackedVertexPosition) / (1024.0 * 1024.0) << " MB read by depth-only passes" << std::endl;
+	std::cout << "Max packed position error:\t" << maxPackingError << " of the mesh size" << std::endl;
+
+	return 0;
+}
+
+namespace {
+	void printUsage() {
+		std::cout << "Usage:" << std::endl
+			<< "\t" << "LeoMeshOptimizationBench.exe my_file.scene" << "\t" << "Print the vertex cache statistics of the meshes of a text scene, before and after optimization, their LODs, and their packed vertex memory." << std::endl
+			<< "\t" << "LeoMeshOptimizationBench.exe --self-test" << "\t" << "Check the optimizations on generated meshes. Returns 1 if a check fails." << std::endl
+			<< "\t" << "LeoMeshOptimizationBench.exe --help" << "\t" << "Print this help." << std::endl;
+		std::cout << "Notes:" << std::endl
+			<< "\t" << "ACMR is the number of vertices transformed per triangle, ATVR per vertex, in a simulated 16 entries FIFO cache. Lower is better." << std::endl
+			<< "\t" << "The totals are weighted by the number of triangles (ACMR) and vertices (ATVR) of the meshes." << std::endl
+			<< "\t" << "ACMR clustered is the ACMR of the full mesh after its triangles are grouped into clusters." << std::endl
+			<< "\t" << "Only closed meshes get normal cones, used for back-face culling." << std::endl
+			<< "\t" << "LOD errors are relative to the radius of the bounding sphere of the mesh." << std::endl
+			<< "\t" << "No GPU is needed. The asset cache is not used." << std::endl << std::endl;
+	}
+
+	int runSelfTest()
+	{
+		int nbFailures = 0;
+
+		// Simulated cache on trivial cases
+		{
+			uint32_t separateTriangles[] = { 0, 1, 2, 3, 4, 5 };
+			leoscene::VertexCacheStatistics statistics = leoscene::analyzeVertexCache(separateTriangles, 6, 6);
+			nbFailures += !check(statistics.acmr == 3.f && statistics.atvr == 1.f, "Separate triangles have an ACMR of 3 and an ATVR of 1");
+
+			uint32_t repeatedTriangle[] = { 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2 };
+			statistics = leoscene::analyzeVertexCache(repeatedTriangle, 12, 3);
+			nbFailures += !check(statistics.acmr == 0.75f && statistics.atvr == 1.f, "A repeated triangle is transformed once");
+
+			// Fan around vertex 0. The 16 vertices transformed after it push it out of the cache, so the 17th triangle transforms it again.
+			std::vector<uint32_t> fan;
+			for (uint32_t i = 1; i <= 17; ++i) {
+				fan.insert(fan.end(), { i, i + 1, 0 });
+			}
+			statistics = leoscene::analyzeVertexCache(fan.data(), fan.size(), 19);
+			nbFailures += !check(statistics.nbTransformedVertices == 20, "The simulated cache evicts the oldest vertex first");
+		}
+
+		// Shuffled grid: the worst case for the cache, with a known good order
+		{
+			leoscene::Mesh grid = makeShuffledGrid(128, 128, 1);
+			std::vector<std::array<float, 9>> triangleSet = getTriangleSet(grid);
+			leoscene::VertexCacheStatistics before = leoscene::analyzeVertexCache(grid.indices.data(), grid.indices.size(), grid.vertices.size());
+
+			auto start = std::chrono::steady_clock::now();
+			leoscene::optimizeMesh(grid);
+			double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			leoscene::VertexCacheStatistics after = leoscene::analyzeVertexCache(grid.indices.data(), grid.indices.size(), grid.vertices.size());
+			std::cout << "Shuffled grid, " << grid.indices.size() / 3 << " triangles: ACMR " << before.acmr << " -> " << after.acmr
+				<< ", ATVR " << before.atvr << " -> " << after.atvr << ", " << milliseconds << " ms" << std::endl;
+
+			nbFailures += !check(getTriangleSet(grid) == triangleSet, "The optimized grid has the same triangles, with the same winding");
+			nbFailures += !check(after.acmr < 0.8f, "The optimized grid has an ACMR below 0.8");
+			nbFailures += !check(after.atvr < 1.6f, "The optimized grid has an ATVR below 1.6");
+
+			uint32_t nbReferencedVertices = 0;
+			bool firstUsesInOrder = true;
+			for (uint32_t index : grid.indices) {
+				if (index == nbReferencedVertices) {
+					++nbReferencedVertices;
+				}
+				else if (index > nbReferencedVertices) {
+					firstUsesInOrder = false;
+				}
+			}
+			nbFailures += !check(firstUsesInOrder && nbReferencedVertices == grid.vertices.size(), "Vertices are stored in the order of their first use");
+		}
+
+		// Unreferenced vertices are dropped, and the reordering keeps working on meshes with holes in their vertex range.
+		{
+			leoscene::Mesh grid = makeShuffledGrid(16, 16, 2);
+			size_t nbVertices = grid.vertices.size();
+			grid.vertices.resize(nbVertices * 2);
+			for (uint32_t& index : grid.indices) {
+				index *= 2;
+			}
+			std::vector<std::array<float, 9>> triangleSet = getTriangleSet(grid);
+			leoscene::optimizeMesh(grid);
+			nbFailures += !check(grid.vertices.size() == nbVertices && getTriangleSet(grid) == triangleSet, "Unreferenced vertices are removed");
+		}
+
+		// Packed vertices, decoded like the vertex shader does
+		{
+			std::mt19937 generator(3);
+			std::uniform_real_distribution<float> unit(-1.f, 1.f);
+			std::vector<leoscene::Vertex> vertices(10000);
+			for (leoscene::Vertex& vertex : vertices) {
+				vertex.position = glm::vec3(unit(generator), unit(generator), unit(generator)) * 20.f;
+				vertex.normal = glm::normalize(glm::vec3(unit(generator), unit(generator), unit(generator)));
+				vertex.tangent = glm::normalize(glm::vec3(unit(generator), unit(generator), unit(generator)));
+				vertex.uv = glm::vec2(unit(generator), unit(generator)) * 0.5f + 0.5f;
+			}
+			vertices[0].normal = glm::vec3(0, 0, -1);
+			vertices[1].normal = glm::vec3(0, -1, 0);
+			vertices[2].normal = glm::vec3(-1, 0, 0);
+
+			leoscene::VertexQuantization quantization = leoscene::computeVertexQuantization(vertices.data(), vertices.size());
+			std::vector<leoscene::PackedVertexPosition> packedPositions(vertices.size());
+			std::vector<leoscene::PackedVertexAttributes> packedAttributes(vertices.size());
+			leoscene::packVertices(vertices.data(), vertices.size(), quantization, packedPositions.data(), packedAttributes.data());
+			float maxNormalError = 0, maxTangentError = 0, maxUvError = 0;
+			for (size_t i = 0; i < vertices.size(); ++i) {
+				leoscene::Vertex unpacked = leoscene::unpackVertex(packedPositions[i], packedAttributes[i], quantization);
+				maxNormalError = std::max(maxNormalError, glm::length(unpacked.normal - vertices[i].normal));
+				maxTangentError = std::max(maxTangentError, glm::length(unpacked.tangent - vertices[i].tangent));
+				maxUvError = std::max(maxUvError, glm::length(unpacked.uv - vertices[i].uv));
+			}
+			nbFailures += !check(getMaxPackingError(vertices) < 2e-5f, "Packed positions are within 2e-5 of the mesh size");
+			nbFailures += !check(maxNormalError < 1e-3f && maxTangentError < 1e-3f, "Packed normals and tangents are within 0.06 degrees, including on the axes");
+			nbFailures += !check(maxUvError < 1e-3f, "Packed UVs in [0, 1] are within 1e-3");
+		}
+
+		// LODs of a plane: no error, each LOD halves the triangles, and the borders do not move.
+		{
+			leoscene::Mesh grid = makeShuffledGrid(64, 64, 4);
+			grid.boundingSphere = glm::vec4(32, 32, 0, 46);
+			leoscene::optimizeMesh(grid);
+			leoscene::generateLods(grid);
+
+			bool halved = grid.lods.size() == leoscene::MAX_MESH_LODS;
+			bool noError = true;
+			bool sameBounds = true;
+			bool notFlipped = true;
+			for (size_t lod = 0; lod < grid.lods.size(); ++lod) {
+				const leoscene::MeshLod& meshLod = grid.lods[lod];
+				if (lod) {
+					halved = halved && meshLod.nbIndices <= grid.lods[lod - 1].nbIndices * 0.55f && meshLod.firstIndex == grid.lods[lod - 1].firstIndex + grid.lods[lod - 1].nbIndices;
+				}
+				noError = noError && meshLod.error < 1e-4f;
+				notFlipped = notFlipped && facesUp(grid, meshLod);
+				glm::vec3 minPosition(FLT_MAX), maxPosition(-FLT_MAX);
+				for (uint32_t i = meshLod.firstIndex; i < meshLod.firstIndex + meshLod.nbIndices; ++i) {
+					minPosition = glm::min(minPosition, grid.vertices[grid.indices[i]].position);
+					maxPosition = glm::max(maxPosition, grid.vertices[grid.indices[i]].position);
+				}
+				sameBounds = sameBounds && minPosition == glm::vec3(0) && maxPosition == glm::vec3(64, 64, 0);
+			}
+			std::cout << "Plane LODs:";
+			for (const leoscene::MeshLod& lod : grid.lods) {
+				std::cout << " " << lod.nbIndices / 3;
+			}
+			std::cout << " triangles" << std::endl;
+			nbFailures += !check(halved, "A plane gets all its LODs, stored one after another, each with at most 55% of the triangles of the previous one");
+			nbFailures += !check(noError, "Simplifying a plane has no error");
+			nbFailures += !check(sameBounds, "The borders of a plane are kept");
+			nbFailures += !check(notFlipped, "No triangle of the simplified plane is flipped or degenerate");
+		}
+
+		// LODs of a sphere stay close to the sphere, within their error
+		{
+			leoscene::Mesh sphere = makeSphere(64, 128, 10.f);
+			leoscene::optimizeMesh(sphere);
+			auto start = std::chrono::steady_clock::now();
+			leoscene::generateLods(sphere);
+			double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+			bool withinError = sphere.lods.size() >= 3;
+			std::cout << "Sphere LODs:";
+			for (const leoscene::MeshLod& lod : sphere.lods) {
+				float distance = getMaxSphereDistance(sphere, lod);
+				std::cout << " " << lod.nbIndices / 3 << " (error " << lod.error << ", distance " << distance << ")";
+				withinError = withinError && distance <= lod.error + getMaxSphereDistance(sphere, sphere.lods[0]);
+			}
+			std::cout << ", " << milliseconds << " ms" << std::endl;
+			nbFailures += !check(withinError, "The LODs of a sphere are within their error of the sphere");
+		}
+
+		// Vertices sharing a position with another one (seams) are kept
+		{
+			leoscene::Mesh grid = makeShuffledGrid(64, 64, 5);
+			grid.boundingSphere = glm::vec4(32, 32, 0, 46);
+			size_t seamX = 32;
+			for (uint32_t& index : grid.indices) {
+				// Triangles right of the seam use a copy of the seam vertices
+				if (grid.vertices[index].position.x == seamX) {
+					uint32_t triangleStart = static_cast<uint32_t>(&index - grid.indices.data()) / 3 * 3;
+					bool rightOfSeam = false;
+					for (int k = 0; k < 3; ++k) {
+						rightOfSeam = rightOfSeam || grid.vertices[grid.indices[triangleStart + k]].position.x > seamX;
+					}
+					if (rightOfSeam) {
+						leoscene::Vertex copy = grid.vertices[index];
+						copy.uv = glm::vec2(1, 0);
+						grid.vertices.push_back(copy);
+						index = static_cast<uint32_t>(grid.vertices.size() - 1);
+					}
+				}
+			}
+			leoscene::generateLods(grid);
+
+			std::unordered_set<float> seamYs;
+			for (uint32_t i = grid.lods.back().firstIndex; i < grid.lods.back().firstIndex + grid.lods.back().nbIndices; ++i) {
+				if (grid.vertices[grid.indices[i]].position.x == seamX) {
+					seamYs.insert(grid.vertices[grid.indices[i]].position.y);
+				}
+			}
+			nbFailures += !check(grid.lods.size() > 1 && seamYs.size() == 65, "Seam vertices are kept by the LODs");
+		}
+
+		// Clusters of a closed sphere: same triangles, within the limits, inside their bounds, and conservative back-face culling
+		{
+			leoscene::Mesh sphere = makeSphere(64, 128, 10.f);
+			leoscene::optimizeMesh(sphere);
+			std::vector<std::array<float, 9>> triangleSet = getTriangleSet(sphere);
+			float acmr = leoscene::analyzeVertexCache(sphere.indices.data(), sphere.indices.size(), sphere.vertices.size()).acmr;
+			auto start = std::chrono::steady_clock::now();
+			leoscene::buildClusters(sphere);
+			double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			float clusteredAcmr = leoscene::analyzeVertexCache(sphere.indices.data(), sphere.indices.size(), sphere.vertices.size()).acmr;
+
+			bool contiguous = !sphere.clusters.empty();
+			bool withinLimits = true;
+			bool bounded = true;
+			uint32_t nextIndex = 0;
+			size_t nbWithCone = 0;
+			size_t nbClusterVertices = 0;
+			for (const leoscene::MeshCluster& cluster : sphere.clusters) {
+				contiguous = contiguous && cluster.firstIndex == nextIndex;
+				nextIndex = cluster.firstIndex + cluster.nbIndices;
+				std::unordered_set<uint32_t> clusterVertices(sphere.indices.begin() + cluster.firstIndex, sphere.indices.begin() + nextIndex);
+				nbClusterVertices += clusterVertices.size();
+				withinLimits = withinLimits && cluster.nbIndices / 3 <= leoscene::MAX_CLUSTER_TRIANGLES && clusterVertices.size() <= leoscene::MAX_CLUSTER_VERTICES;
+				for (uint32_t v : clusterVertices) {
+					bounded = bounded && glm::length(sphere.vertices[v].position - glm::vec3(cluster.boundingSphere)) <= cluster.boundingSphere.w * 1.0001f;
+				}
+				nbWithCone += cluster.coneAxis != glm::vec3(0);
+			}
+			contiguous = contiguous && nextIndex == sphere.indices.size();
+
+			// Eyes around the sphere: about half of the clusters face away, and the test never culls a visible triangle
+			std::mt19937 generator(6);
+			std::uniform_real_distribution<float> unit(-1.f, 1.f);
+			bool conservative = true;
+			size_t nbCulled = 0, nbTested = 0;
+			for (int i = 0; i < 32; ++i) {
+				glm::vec3 eye = glm::normalize(glm::vec3(unit(generator), unit(generator), unit(generator))) * (15.f + 30.f * (unit(generator) + 1.f));
+				for (const leoscene::MeshCluster& cluster : sphere.clusters) {
+					bool culled = leoscene::isClusterBackFacing(cluster, eye);
+					conservative = conservative && (!culled || facesAway(sphere, cluster, eye));
+					nbCulled += culled;
+					++nbTested;
+				}
+			}
+			float culledRatio = nbTested ? float(nbCulled) / nbTested : 0.f;
+			std::cout << "Sphere clusters: " << sphere.clusters.size() << " for " << sphere.indices.size() / 3 << " triangles, ACMR "
+				<< acmr << " -> " << clusteredAcmr << ", " << 100.f * culledRatio << "% back-facing, " << milliseconds << " ms" << std::endl;
+
+			nbFailures += !check(getTriangleSet(sphere) == triangleSet, "The clustered sphere has the same triangles, with the same winding");
+			nbFailures += !check(contiguous, "Clusters are ranges of indices covering the full mesh, one after another");
+			nbFailures += !check(withinLimits, "Clusters have at most 124 triangles and 64 vertices");
+			nbFailures += !check(bounded, "The bounding sphere of a cluster contains its vertices");
+			nbFailures += !check(sphere.clusters.size() < sphere.indices.size() / 3 / 64, "Clusters have more than 64 triangles on average");
+			nbFailures += !check(nbWithCone == sphere.clusters.size(), "All the clusters of a finely tessellated sphere have a normal cone");
+			nbFailures += !check(conservative, "Back-face culling of clusters never culls a visible triangle");
+			nbFailures += !check(culledRatio > 0.3f, "More than 30% of the clusters of a sphere face away from the eye");
+			// Each cluster is a draw command of its own, so its vertices are transformed at least once per cluster
+			float minClusteredAcmr = float(nbClusterVertices) / (sphere.indices.size() / 3);
+			nbFailures += !check(clusteredAcmr < minClusteredAcmr * 1.1f, "The ACMR of the clusters is within 10% of one transform per vertex of each cluster");
+		}
+
+		// Open meshes are never back-face culled, and small meshes are culled as a whole
+		{
+			leoscene::Mesh grid = makeShuffledGrid(64, 64, 7);
+			grid.boundingSphere = glm::vec4(32, 32, 0, 46);
+			leoscene::optimizeMesh(grid);
+			leoscene::buildClusters(grid);
+			bool noCone = grid.clusters.size() > 1;
+			for (const leoscene::MeshCluster& cluster : grid.clusters) {
+				noCone = noCone && cluster.coneAxis == glm::vec3(0) && !leoscene::isClusterBackFacing(cluster, glm::vec3(32, 32, -10));
+			}
+			nbFailures += !check(noCone, "The clusters of an open mesh have no normal cone");
+
+			leoscene::Mesh smallGrid = makeShuffledGrid(16, 16, 8);
+			leoscene::buildClusters(smallGrid);
+			nbFailures += !check(smallGrid.clusters.empty(), "Meshes with fewer than 1024 triangles are not clustered");
+		}
+
+		std::cout << (nbFailures ? "Self test failed." : "Self test passed.") << std::endl;
+		return nbFailures;
+	}
+
+	std::vector<std::array<float, 9>> getTriangleSet(const leoscene::Mesh& mesh)
+	{
+		std::vector<std::array<float, 9>> triangles;
+		for (size_t t = 0; t + 2 < mesh.indices.size(); t += 3) {
+			std::array<std::array<float, 3>, 3> corners;
+			for (size_t k = 0; k < 3; ++k) {
+				const glm::vec3& position = mesh.vertices[mesh.indices[t + k]].position;
+				corners[k] = { position.x, position.y, position.z };
+			}
+			size_t first = std::min_element(corners.begin(), corners.end()) - corners.begin();
+			std::array<float, 9> triangle;
+			for (size_t k = 0; k < 3; ++k) {
+				std::copy(corners[(first + k) % 3].begin(), corners[(first + k) % 3].end(), triangle.begin() + k * 3);
+			}
+			triangles.push_back(triangle);
+		}
+		std::sort(triangles.begin(), triangles.end());
+		return triangles;
+	}
+
+	leoscene::Mesh makeShuffledGrid(uint32_t nbQuadsX, uint32_t nbQuadsY, uint32_t seed)
+	{
+		leoscene::Mesh mesh;
+		for (uint32_t y = 0; y <= nbQuadsY; ++y) {
+			for (uint32_t x = 0; x <= nbQuadsX; ++x) {
+				leoscene::Vertex vertex;
+				vertex.position = glm::vec3(float(x), float(y), 0);
+				mesh.vertices.push_back(vertex);
+			}
+		}
+
+		std::vector<std::array<uint32_t, 3>> triangles;
+		for (uint32_t y = 0; y < nbQuadsY; ++y) {
+			for (uint32_t x = 0; x < nbQuadsX; ++x) {
+				uint32_t corner = y * (nbQuadsX + 1) + x;
+				triangles.push_back({ corner, corner + 1, corner + nbQuadsX + 1 });
+				triangles.push_back({ corner + 1, corner + nbQuadsX + 2, corner + nbQuadsX + 1 });
+			}
+		}
+		std::shuffle(triangles.begin(), triangles.end(), std::mt19937(seed));
+
+		std::vector<uint32_t> vertexOrder(mesh.vertices.size());
+		for (uint32_t v = 0; v < vertexOrder.size(); ++v) {
+			vertexOrder[v] = v;
+		}
+		std::shuffle(vertexOrder.begin(), vertexOrder.end(), std::mt19937(seed + 1));
+		std::vector<leoscene::Vertex> shuffledVertices(mesh.vertices.size());
+		for (uint32_t v = 0; v < vertexOrder.size(); ++v) {
+			shuffledVertices[vertexOrder[v]] = mesh.vertices[v];
+		}
+		mesh.vertices.swap(shuffledVertices);
+
+		for (const std::array<uint32_t, 3>& triangle : triangles) {
+			for (uint32_t index : triangle) {
+				mesh.indices.push_back(vertexOrder[index]);
+			}
+		}
+		return mesh;
+	}
+
+	leoscene::Mesh makeSphere(uint32_t nbRings, uint32_t nbSegments, float radius)
+	{
+		leoscene::Mesh mesh;
+		leoscene::Vertex pole;
+		pole.position = glm::vec3(0, radius, 0);
+		mesh.vertices.push_back(pole);
+		for (uint32_t ring = 1; ring < nbRings; ++ring) {
+			float theta = glm::pi<float>() * ring / nbRings;
+			for (uint32_t segment = 0; segment < nbSegments; ++segment) {
+				float phi = 2.f * glm::pi<float>() * segment / nbSegments;
+				leoscene::Vertex vertex;
+				vertex.position = radius * glm::vec3(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+				vertex.normal = vertex.position / radius;
+				mesh.vertices.push_back(vertex);
+			}
+		}
+		pole.position = glm::vec3(0, -radius, 0);
+		mesh.vertices.push_back(pole);
+
+		uint32_t southPole = static_cast<uint32_t>(mesh.vertices.size() - 1);
+		auto ringVertex = [nbSegments](uint32_t ring, uint32_t segment) { return 1 + (ring - 1) * nbSegments + segment % nbSegments; };
+		for (uint32_t segment = 0; segment < nbSegments; ++segment) {
+			mesh.indices.insert(mesh.indices.end(), { 0, ringVertex(1, segment + 1), ringVertex(1, segment) });
+			mesh.indices.insert(mesh.indices.end(), { southPole, ringVertex(nbRings - 1, segment), ringVertex(nbRings - 1, segment + 1) });
+			for (uint32_t ring = 1; ring + 1 < nbRings; ++ring) {
+				mesh.indices.insert(mesh.indices.end(), { ringVertex(ring, segment), ringVertex(ring, segment + 1), ringVertex(ring + 1, segment) });
+				mesh.indices.insert(mesh.indices.end(), { ringVertex(ring, segment + 1), ringVertex(ring + 1, segment + 1), ringVertex(ring + 1, segment) });
+			}
+		}
+		mesh.boundingSphere = glm::vec4(0, 0, 0, radius);
+		return mesh;
+	}
+
+	float getMaxSphereDistance(const leoscene::Mesh& sphere, const leoscene::MeshLod& lod)
+	{
+		float maxDistance = 0;
+		for (uint32_t t = lod.firstIndex; t < lod.firstIndex + lod.nbIndices; t += 3) {
+			glm::vec3 center = (sphere.vertices[sphere.indices[t]].position + sphere.vertices[sphere.indices[t + 1]].position
+				+ sphere.vertices[sphere.indices[t + 2]].position) / 3.f;
+			maxDistance = std::max(maxDistance, std::abs(glm::length(center) - sphere.boundingSphere.w));
+		}
+		return maxDistance / sphere.boundingSphere.w;
+	}
+
+	bool facesUp(const leoscene::Mesh& mesh, const leoscene::MeshLod& lod)
+	{
+		for (uint32_t t = lod.firstIndex; t < lod.firstIndex + lod.nbIndices; t += 3) {
+			const glm::vec3& a = mesh.vertices[mesh.indices[t]].position;
+			const glm::vec3& b = mesh.vertices[mesh.indices[t + 1]].position;
+			const glm::vec3& c = mesh.vertices[mesh.indices[t + 2]].position;
+			if (glm::cross(b - a, c - a).z <= 0) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool facesAway(const leoscene::Mesh& mesh, const leoscene::MeshCluster& cluster, const glm::vec3& eye)
+	{
+		for (uint32_t t = cluster.firstIndex; t < cluster.firstIndex + cluster.nbIndices; t += 3) {
+			const glm::vec3& a = mesh.vertices[mesh.indices[t]].position;
+			const glm::vec3& b = mesh.vertices[mesh.indices[t + 1]].position;
+			const glm::vec3& c = mesh.vertices[mesh.indices[t + 2]].position;
+			if (glm::dot(glm::cross(b - a, c - a), a - eye) < 0) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	float getMaxPackingError(const std::vector<leoscene::Vertex>& vertices)
+	{
+		leoscene::VertexQuantization quantization = leoscene::computeVertexQuantization(vertices.data(), vertices.size());
+		std::vector<leoscene::PackedVertexPosition> packedPositions(vertices.size());
+		std::vector<leoscene::PackedVertexAttributes> packedAttributes(vertices.size());
+		leoscene::packVertices(vertices.data(), vertices.size(), quantization, packedPositions.data(), packedAttributes.data());
+		float meshSize = glm::length(quantization.positionScale);
+		float maxError = 0;
+		for (size_t i = 0; i < vertices.size(); ++i) {
+			maxError = std::max(maxError, glm::length(leoscene::unpackVertex(packedPositions[i], packedAttributes[i], quantization).position - vertices[i].position));
+		}
+		return meshSize > 0 ? maxError / meshSize : 0;
+	}
+}
@@ -0,0 +1,54 @@
+#include <scene/SceneLoader.h>
+
+#include <iostream>
+#include <string>
+#include <cstring>
+
+namespace {
+	void printUsage();
+}
+
+int main(int argc, const char** argv) {
+	if (argc < 2 || argc > 3) {
+		std::cerr << "Error: wrong number of arguments." << std::endl;
+		printUsage();
+		return 1;
+	}
+
+	if (!strcmp(argv[1], "--help")) {
+		printUsage();
+		return 0;
+	}
+
+	std::string textFilePath = argv[1];
+	std::string binaryFilePath;
+	if (argc == 3) {
+		binaryFilePath = argv[2];
+	}
+	else {
+		binaryFilePath = textFilePath.substr(0, textFilePath.find_last_of('.')) + ".bscene";
+	}
+
+	try {
+		leoscene::SceneLoader::compileScene(textFilePath.c_str(), binaryFilePath.c_str());
+	}
+	catch (const leoscene::SceneLoaderException& e) {
+		std::cerr << e.what() << std::endl;
+		std::cerr << "Error: Scene compilation failed." << std::endl;
+		return 2;
+	}
+
+	std::cout << "Compiled \"" << textFilePath << "\" into \"" << binaryFilePath << "\"" << std::endl;
+	return 0;
+}
+
+namespace {
+	void printUsage() {
+		std::cout << "Usage:" << std::endl
+			<< "\t" << "LeoSceneCompiler.exe my_file.scene [my_file.bscene]" << "\t" << "Compile a text scene into the binary scene format." << std::endl
+			<< "\t" << "LeoSceneCompiler.exe --help" << "\t" << "Print this help." << std::endl;
+		std::cout << "Notes:" << std::endl
+			<< "\t" << "If no output path is provided, the binary scene is written next to the text scene with the .bscene extension." << std::endl
+			<< "\t" << "Model paths are relative to the scene file, so keep the binary scene in the same directory as the text scene." << std::endl << std::endl;
+	}
+}
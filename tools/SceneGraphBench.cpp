@@ -0,0 +1,268 @@
+#include <scene/SceneGraph.h>
+
+#include "SelfTest.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+/*
+* Updates of the scene graph (see SceneGraph): time of update() when a fraction of the scenes move, against recomputing
+* the world matrices of all the objects, and checks of the matrices and of the objects reported.
+*/
+
+namespace {
+	// One root node per scene, with one child node per object, like the nodes the application adds for each loaded scene
+	struct Hierarchy {
+		leoscene::SceneGraph graph;
+		std::vector<uint32_t> rootNodes;
+		std::vector<glm::mat4> objectMatrices;  // Local matrix of each object
+	};
+
+	void printUsage();
+
+	// Checks the world matrices and the objects reported by update() on small graphs.
+	int runSelfTest();
+	using leotools::check;
+
+	Hierarchy makeHierarchy(uint32_t nbScenes, uint32_t nbObjectsPerScene);
+
+	// Best time over the iterations, in milliseconds
+	template<typename Function>
+	double timeBest(uint32_t nbIterations, Function function);
+
+	// Relative to the magnitude of the values, like in the transform bench
+	float maxDifference(const glm::mat4& a, const glm::mat4& b);
+}
+
+int main(int argc, const char** argv) {
+	if (argc >= 2 && !strcmp(argv[1], "--help")) {
+		printUsage();
+		return 0;
+	}
+
+	if (argc >= 2 && !strcmp(argv[1], "--self-test")) {
+		return runSelfTest() ? 1 : 0;
+	}
+
+	uint32_t nbScenes = 1000;
+	uint32_t nbObjectsPerScene = 1000;
+	uint32_t nbIterations = 10;
+	for (int i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "--scenes") && i + 1 < argc) {
+			nbScenes = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else if (!strcmp(argv[i], "--objects") && i + 1 < argc) {
+			nbObjectsPerScene = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else if (!strcmp(argv[i], "--iterations") && i + 1 < argc) {
+			nbIterations = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else {
+			std::cerr << "Error: unknown argument \"" << argv[i] << "\"." << std::endl;
+			printUsage();
+			return 1;
+		}
+	}
+	if (!nbScenes || !nbObjectsPerScene || !nbIterations) {
+		std::cerr << "Error: --scenes, --objects and --iterations must be positive." << std::endl;
+		return 1;
+	}
+
+	Hierarchy hierarchy = makeHierarchy(nbScenes, nbObjectsPerScene);
+	size_t nbObjects = hierarchy.objectMatrices.size();
+	std::vector<uint32_t> changedObjects;
+	std::vector<glm::mat4> changedMatrices;
+	changedObjects.reserve(nbObjects);
+	changedMatrices.reserve(nbObjects);
+
+	std::cout << nbScenes << " scenes of " << nbObjectsPerScene << " objects, best of " << nbIterations << " runs" << std::endl;
+
+	// Reference: the world matrices of all the objects, recomputed without hierarchy nor dirty flags
+	std::vector<glm::mat4> worldMatrices(nbObjects);
+	double fullMs = timeBest(nbIterations, [&]() {
+		for (uint32_t scene = 0; scene < nbScenes; ++scene) {
+			const glm::mat4& rootMatrix = hierarchy.graph.getLocalMatrix(hierarchy.rootNodes[scene]);
+			for (uint32_t i = 0; i < nbObjectsPerScene; ++i) {
+				size_t object = static_cast<size_t>(scene) * nbObjectsPerScene + i;
+				worldMatrices[object] = rootMatrix * hierarchy.objectMatrices[object];
+			}
+		}
+	});
+	std::cout << "All objects recomputed:\t" << fullMs << " ms" << std::endl;
+	std::cout << "Moving scenes (%)\tObjects reported\tupdate() (ms)\tns per reported object" << std::endl;
+
+	std::mt19937 generator(42);
+	for (uint32_t percentage : { 1, 10, 100 }) {
+		uint32_t nbMovingScenes = std::max(1u, nbScenes * percentage / 100);
+		size_t nbReported = 0;
+		double updateMs = 0;
+		std::vector<uint32_t> movingScenes(nbScenes);
+		for (uint32_t iteration = 0; iteration < nbIterations; ++iteration) {
+			// Every run moves other scenes, and only the update is timed
+			for (uint32_t scene = 0; scene < nbScenes; ++scene) {
+				movingScenes[scene] = scene;
+			}
+			std::shuffle(movingScenes.begin(), movingScenes.end(), generator);
+			for (uint32_t i = 0; i < nbMovingScenes; ++i) {
+				float height = static_cast<float>(generator() % 100) * 0.01f;
+				hierarchy.graph.setLocalMatrix(hierarchy.rootNodes[movingScenes[i]], glm::translate(glm::mat4(1), glm::vec3(0, height, 0)));
+			}
+
+			changedObjects.clear();
+			changedMatrices.clear();
+			auto start = std::chrono::steady_clock::now();
+			hierarchy.graph.update(changedObjects, changedMatrices);
+			double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			updateMs = iteration ? std::min(updateMs, milliseconds) : milliseconds;
+			nbReported = changedObjects.size();
+		}
+		std::cout << percentage << "\t" << nbReported << "\t" << updateMs << "\t" << (nbReported ? updateMs * 1e6 / nbReported : 0.) << std::endl;
+	}
+
+	return 0;
+}
+
+namespace {
+	void printUsage() {
+		std::cout << "Usage:" << std::endl
+			<< "\t" << "LeoSceneGraphBench.exe [--scenes N] [--objects N] [--iterations N]" << "\t"
+			<< "Time the updates of the scene graph when a fraction of the scenes move." << std::endl
+			<< "\t" << "LeoSceneGraphBench.exe --self-test" << "\t" << "Check the world matrices and the objects reported by the updates. Returns 1 if a check fails." << std::endl
+			<< "\t" << "LeoSceneGraphBench.exe --help" << "\t" << "Print this help." << std::endl;
+		std::cout << "Notes:" << std::endl
+			<< "\t" << "Each scene is a root node with one child node per object, like the scenes loaded by LeoEngine.exe (1000 scenes of 1000 objects by default)." << std::endl
+			<< "\t" << "Only the objects of the scenes that moved are reported, and the renderer uploads them again in the next frames." << std::endl << std::endl;
+	}
+
+	int runSelfTest()
+	{
+		int nbFailures = 0;
+		const float epsilon = 1e-5f;
+		const glm::mat4 translation = glm::translate(glm::mat4(1), glm::vec3(1, 2, 3));
+		const glm::mat4 rotation = glm::rotate(glm::mat4(1), glm::radians(90.f), glm::vec3(0, 1, 0));
+		const glm::mat4 scaling = glm::scale(glm::mat4(1), glm::vec3(2));
+		std::vector<uint32_t> changedObjects;
+		std::vector<glm::mat4> changedMatrices;
+
+		{
+			leoscene::SceneGraph graph;
+			uint32_t root = graph.addNode(translation);
+			uint32_t child = graph.addNode(rotation, root, 0);
+			uint32_t grandChild = graph.addNode(scaling, child, 1);
+			graph.update(changedObjects, changedMatrices);
+			nbFailures += !check(changedObjects.size() == 2 && std::count(changedObjects.begin(), changedObjects.end(), 0u) == 1 &&
+				std::count(changedObjects.begin(), changedObjects.end(), 1u) == 1, "New nodes are reported once by the next update, except the nodes without object");
+			nbFailures += !check(maxDifference(graph.getWorldMatrix(grandChild), translation * rotation * scaling) < epsilon &&
+				maxDifference(graph.getWorldMatrix(child), translation * rotation) < epsilon, "World matrices are the products of the local matrices from the root");
+
+			bool reportedMatrices = true;
+			for (size_t i = 0; i < changedObjects.size(); ++i) {
+				uint32_t node = changedObjects[i] == 0 ? child : grandChild;
+				reportedMatrices &= maxDifference(changedMatrices[i], graph.getWorldMatrix(node)) < epsilon;
+			}
+			nbFailures += !check(reportedMatrices, "Reported matrices are the world matrices of the objects");
+
+			changedObjects.clear();
+			changedMatrices.clear();
+			graph.update(changedObjects, changedMatrices);
+			nbFailures += !check(!graph.hasChanges() && changedObjects.empty(), "Nothing is reported when nothing moved");
+		}
+
+		{
+			leoscene::SceneGraph graph;
+			uint32_t root = graph.addNode(glm::mat4(1), leoscene::SceneGraph::NO_NODE, leoscene::SceneGraph::NO_OBJECT, false);
+			uint32_t object = graph.addNode(rotation, root, 7, false);
+			changedObjects.clear();
+			changedMatrices.clear();
+			graph.update(changedObjects, changedMatrices);
+			nbFailures += !check(!graph.hasChanges() && changedObjects.empty() && maxDifference(graph.getWorldMatrix(object), rotation) < epsilon,
+				"Nodes of loaded objects start clean, with their world matrix");
+
+			graph.setLocalMatrix(root, translation);
+			graph.update(changedObjects, changedMatrices);
+			nbFailures += !check(changedObjects.size() == 1 && changedObjects[0] == 7 && maxDifference(changedMatrices[0], translation * rotation) < epsilon,
+				"Moving the root of clean nodes reports their objects");
+		}
+
+		{
+			Hierarchy hierarchy = makeHierarchy(4, 8);
+			changedObjects.clear();
+			changedMatrices.clear();
+			hierarchy.graph.setLocalMatrix(hierarchy.rootNodes[2], translation);
+			hierarchy.graph.update(changedObjects, changedMatrices);
+			std::sort(changedObjects.begin(), changedObjects.end());
+			bool onlySubtree = changedObjects.size() == 8;
+			for (uint32_t i = 0; onlySubtree && i < 8; ++i) {
+				onlySubtree = changedObjects[i] == 16 + i;
+			}
+			nbFailures += !check(onlySubtree, "Only the objects under the moved node are reported");
+
+			changedObjects.clear();
+			changedMatrices.clear();
+			uint32_t objectNode = hierarchy.rootNodes[1] + 3;  // Children are added right after their root
+			hierarchy.graph.setLocalMatrix(objectNode, scaling);
+			hierarchy.graph.setLocalMatrix(hierarchy.rootNodes[1], rotation);
+			hierarchy.graph.setLocalMatrix(objectNode, translation);
+			hierarchy.graph.update(changedObjects, changedMatrices);
+			nbFailures += !check(changedObjects.size() == 8 && std::count(changedObjects.begin(), changedObjects.end(), 10u) == 1,
+				"An object moved along with its parent, or several times, is reported once");
+			nbFailures += !check(maxDifference(hierarchy.graph.getWorldMatrix(objectNode), rotation * translation) < epsilon,
+				"The last local matrix set is used");
+		}
+
+		std::cout << (nbFailures ? "Self test failed." : "Self test passed.") << std::endl;
+		return nbFailures;
+	}
+
+	Hierarchy makeHierarchy(uint32_t nbScenes, uint32_t nbObjectsPerScene)
+	{
+		// Random positions and rotations around the vertical axis, like the instances of a scatter entry
+		std::mt19937 generator(42);
+		std::uniform_real_distribution<float> unit(-1.f, 1.f);
+
+		Hierarchy hierarchy;
+		hierarchy.objectMatrices.reserve(static_cast<size_t>(nbScenes) * nbObjectsPerScene);
+		for (uint32_t scene = 0; scene < nbScenes; ++scene) {
+			uint32_t rootNode = hierarchy.graph.addNode(glm::mat4(1), leoscene::SceneGraph::NO_NODE, leoscene::SceneGraph::NO_OBJECT, false);
+			hierarchy.rootNodes.push_back(rootNode);
+			for (uint32_t i = 0; i < nbObjectsPerScene; ++i) {
+				glm::mat4 matrix = glm::translate(glm::mat4(1), glm::vec3(unit(generator), unit(generator), unit(generator)) * 100.f);
+				matrix = glm::rotate(matrix, unit(generator) * 3.14f, glm::vec3(0, 1, 0));
+				uint32_t object = static_cast<uint32_t>(hierarchy.objectMatrices.size());
+				hierarchy.objectMatrices.push_back(matrix);
+				hierarchy.graph.addNode(matrix, rootNode, object, false);
+			}
+		}
+		return hierarchy;
+	}
+
+	template<typename Function>
+	double timeBest(uint32_t nbIterations, Function function)
+	{
+		double best = 0;
+		for (uint32_t i = 0; i < nbIterations; ++i) {
+			auto start = std::chrono::steady_clock::now();
+			function();
+			double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			best = i ? std::min(best, milliseconds) : milliseconds;
+		}
+		return best;
+	}
+
+	float maxDifference(const glm::mat4& a, const glm::mat4& b)
+	{
+		float difference = 0;
+		for (int column = 0; column < 4; ++column) {
+			for (int row = 0; row < 4; ++row) {
+				difference = std::max(difference, std::abs(a[column][row] - b[column][row]) / std::max(1.f, std::abs(a[column][row])));
+			}
+		}
+		return difference;
+	}
+}
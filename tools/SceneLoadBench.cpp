@@ -0,0 +1,207 @@
+#include <scene/SceneLoader.h>
+#include <scene/LoadingStats.h>
+#include <scene/Scene.h>
+#include <scene/Camera.h>
+#include <scene/ThreadPool.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+/*
+* Allocations made through operator new are counted globally and per thread. The per-thread counters let the
+* loading phases know how many allocations they made (see leoscene::LoadingStats).
+* Allocations made with malloc, like the texels decoded by stb_image, are not counted.
+*/
+
+namespace {
+	std::atomic<uint64_t> nbAllocations(0);
+	std::atomic<uint64_t> allocatedBytes(0);
+
+	void* trackedAllocate(size_t size)
+	{
+		nbAllocations.fetch_add(1, std::memory_order_relaxed);
+		allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+		leoscene::LoadingStats::threadNbAllocations++;
+		leoscene::LoadingStats::threadAllocatedBytes += size;
+		if (void* memory = std::malloc(size ? size : 1)) {
+			return memory;
+		}
+		throw std::bad_alloc();
+	}
+}
+
+void* operator new(size_t size) { return trackedAllocate(size); }
+void* operator new[](size_t size) { return trackedAllocate(size); }
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, size_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, size_t) noexcept { std::free(memory); }
+
+namespace {
+	void printUsage();
+	uint64_t getPeakResidentSetSize();
+	std::string escapeJsonString(const std::string& value);
+}
+
+int main(int argc, const char** argv) {
+	if (argc < 2 || !strcmp(argv[1], "--help")) {
+		printUsage();
+		return argc < 2 ? 1 : 0;
+	}
+
+	const char* scenePath = argv[1];
+	const char* outputPath = nullptr;
+	leoscene::SceneLoader::LoadingOptions options;
+	options.assetCacheDirectoryPath.clear();  // Measure the actual import unless a cache is asked for
+	for (int i = 2; i < argc; ++i) {
+		if (!strcmp(argv[i], "--load-threads") && i + 1 < argc) {
+			options.nbThreads = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else if (!strcmp(argv[i], "--asset-cache") && i + 1 < argc) {
+			options.assetCacheDirectoryPath = argv[++i];
+		}
+		else if (!strcmp(argv[i], "--no-mesh-optimization")) {
+			options.optimizeMeshes = false;
+		}
+		else if (!strcmp(argv[i], "--no-lods")) {
+			options.generateLods = false;
+		}
+		else if (!strcmp(argv[i], "--no-clusters")) {
+			options.buildClusters = false;
+		}
+		else if (!strcmp(argv[i], "--no-texture-compression")) {
+			options.compressTextures = false;
+		}
+		else if (!strcmp(argv[i], "--output") && i + 1 < argc) {
+			outputPath = argv[++i];
+		}
+		else {
+			std::cerr << "Error: unknown argument \"" << argv[i] << "\"." << std::endl;
+			printUsage();
+			return 1;
+		}
+	}
+
+	leoscene::LoadingStats stats;
+	options.stats = &stats;
+
+	leoscene::SceneLoader sceneLoader;
+	leoscene::Scene scene;
+	leoscene::Camera camera;
+	uint64_t startNbAllocations = nbAllocations;
+	uint64_t startAllocatedBytes = allocatedBytes;
+	auto start = std::chrono::steady_clock::now();
+	try {
+		sceneLoader.loadScene(scenePath, &scene, &camera, options);
+	}
+	catch (const leoscene::SceneLoaderException& e) {
+		std::cerr << e.what() << std::endl;
+		std::cerr << "Error: Scene loading failed." << std::endl;
+		return 2;
+	}
+	double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	// Phase times are summed over the loading threads, so they can add up to more than the wall time.
+	std::stringstream json;
+	json << "{" << std::endl
+		<< "  \"scene\": \"" << escapeJsonString(scenePath) << "\"," << std::endl
+		<< "  \"loadThreads\": " << (options.nbThreads ? options.nbThreads : leoscene::ThreadPool::getDefaultNbThreads()) << "," << std::endl
+		<< "  \"assetCache\": " << (options.assetCacheDirectoryPath.empty() ? "false" : "true") << "," << std::endl
+		<< "  \"meshOptimization\": " << (options.optimizeMeshes ? "true" : "false") << "," << std::endl
+		<< "  \"lods\": " << (options.generateLods ? "true" : "false") << "," << std::endl
+		<< "  \"clusters\": " << (options.buildClusters ? "true" : "false") << "," << std::endl
+		<< "  \"textureCompression\": " << (options.compressTextures ? "true" : "false") << "," << std::endl
+		<< "  \"nbObjects\": " << scene.getNbObjects() << "," << std::endl
+		<< "  \"nbShapes\": " << scene.shapes.size() << "," << std::endl
+		<< "  \"nbMaterials\": " << scene.materials.size() << "," << std::endl
+		<< "  \"wallTimeMs\": " << milliseconds << "," << std::endl
+		<< "  \"nbAllocations\": " << nbAllocations - startNbAllocations << "," << std::endl
+		<< "  \"allocatedBytes\": " << allocatedBytes - startAllocatedBytes << "," << std::endl
+		<< "  \"peakRssBytes\": " << getPeakResidentSetSize() << "," << std::endl
+		<< "  \"phases\": {" << std::endl;
+	for (size_t i = 0; i < static_cast<size_t>(leoscene::LoadingStats::Phase::NB_PHASES); ++i) {
+		leoscene::LoadingStats::Phase phase = static_cast<leoscene::LoadingStats::Phase>(i);
+		const leoscene::LoadingStats::PhaseStats& phaseStats = stats.getPhaseStats(phase);
+		json << "    \"" << leoscene::LoadingStats::getPhaseName(phase) << "\": { "
+			<< "\"timeMs\": " << phaseStats.nanoseconds / 1e6 << ", "
+			<< "\"nbCalls\": " << phaseStats.nbCalls << ", "
+			<< "\"nbAllocations\": " << phaseStats.nbAllocations << ", "
+			<< "\"allocatedBytes\": " << phaseStats.allocatedBytes << " }"
+			<< (i + 1 < static_cast<size_t>(leoscene::LoadingStats::Phase::NB_PHASES) ? "," : "") << std::endl;
+	}
+	json << "  }" << std::endl
+		<< "}" << std::endl;
+
+	if (outputPath) {
+		std::ofstream ofs(outputPath);
+		ofs << json.str();
+		if (!ofs) {
+			std::cerr << "Error: Could not write \"" << outputPath << "\"." << std::endl;
+			return 2;
+		}
+	}
+	else {
+		std::cout << json.str();
+	}
+
+	return 0;
+}
+
+namespace {
+	void printUsage() {
+		std::cout << "Usage:" << std::endl
+			<< "\t" << "LeoSceneLoadBench.exe my_file.scene [--load-threads N] [--asset-cache DIR] [--no-mesh-optimization] [--no-lods] [--no-clusters] [--no-texture-compression] [--output FILE]" << "\t" << "Load a scene without window nor GPU, and print its loading statistics as JSON." << std::endl
+			<< "\t" << "LeoSceneLoadBench.exe --help" << "\t" << "Print this help." << std::endl;
+		std::cout << "Notes:" << std::endl
+			<< "\t" << "The asset cache is disabled unless --asset-cache is given." << std::endl
+			<< "\t" << "Phase times are summed over the loading threads. A phase nested in another one only counts for itself." << std::endl
+			<< "\t" << "Only allocations made through operator new are counted." << std::endl << std::endl;
+	}
+
+	uint64_t getPeakResidentSetSize()
+	{
+#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS counters = {};
+		if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+			return static_cast<uint64_t>(counters.PeakWorkingSetSize);
+		}
+		return 0;
+#else
+		rusage usage = {};
+		getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+		return static_cast<uint64_t>(usage.ru_maxrss);  // Bytes
+#else
+		return static_cast<uint64_t>(usage.ru_maxrss) * 1024;  // Kilobytes
+#endif
+#endif
+	}
+
+	std::string escapeJsonString(const std::string& value)
+	{
+		std::string escaped;
+		for (char c : value) {
+			if (c == '"' || c == '\\') {
+				escaped += '\\';
+			}
+			escaped += c;
+		}
+		return escaped;
+	}
+}
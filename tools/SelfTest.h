@@ -0,0 +1,17 @@
+#pragma once
+
+#include <iostream>
+
+namespace leotools {
+	/*
+	* Checks of the --self-test mode of the tools. The self test of a tool prints the result of each check and exits with 1
+	* when one of them failed, which is how CTest runs it.
+	*/
+
+	// Prints the description of a check with its result. Returns the result.
+	inline bool check(bool condition, const char* description)
+	{
+		std::cout << (condition ? "[PASS] " : "[FAIL] ") << description << std::endl;
+		return condition;
+	}
+}
@@ -0,0 +1,103 @@
+#include <scene/ImageTexture.h>
+#include <scene/TextureLoader.h>
+
+#include <iostream>
+#include <string>
+#include <cstring>
+
+namespace {
+	void printUsage();
+	bool parseCompression(const char* name, leoscene::ImageTexture::Compression& compression);
+}
+
+int main(int argc, const char** argv) {
+	if (argc < 2) {
+		std::cerr << "Error: wrong number of arguments." << std::endl;
+		printUsage();
+		return 1;
+	}
+
+	if (!strcmp(argv[1], "--help")) {
+		printUsage();
+		return 0;
+	}
+
+	std::string imageFilePath = argv[1];
+	std::string containerFilePath;
+	leoscene::TextureLoader::LoadingOptions options;
+	options.desiredChannels = 4;
+	options.compression = leoscene::ImageTexture::Compression::BC1;
+	for (int i = 2; i < argc; ++i) {
+		if (!strcmp(argv[i], "--format") && i + 1 < argc) {
+			if (!parseCompression(argv[++i], options.compression)) {
+				std::cerr << "Error: unknown format \"" << argv[i] << "\"." << std::endl;
+				printUsage();
+				return 1;
+			}
+		}
+		else if (!strcmp(argv[i], "--linear")) {
+			options.srgb = false;
+		}
+		else if (argv[i][0] != '-' && containerFilePath.empty()) {
+			containerFilePath = argv[i];
+		}
+		else {
+			std::cerr << "Error: unknown argument \"" << argv[i] << "\"." << std::endl;
+			printUsage();
+			return 1;
+		}
+	}
+	if (containerFilePath.empty()) {
+		containerFilePath = imageFilePath.substr(0, imageFilePath.find_last_of('.')) + ".ltex";
+	}
+
+	leoscene::TextureLoader textureLoader;
+	std::shared_ptr<leoscene::ImageTexture> texture = textureLoader.loadTexture(imageFilePath.c_str(), options);
+	if (!texture) {
+		std::cerr << "Error: could not load the image \"" << imageFilePath << "\"." << std::endl;
+		return 2;
+	}
+	if (!leoscene::TextureLoader::writeTextureContainer(*texture, containerFilePath.c_str())) {
+		std::cerr << "Error: could not write the texture container \"" << containerFilePath << "\"." << std::endl;
+		return 2;
+	}
+
+	std::cout << "Compiled \"" << imageFilePath << "\" into \"" << containerFilePath << "\" (" << texture->width << "x" << texture->height << ", "
+		<< texture->mipLevels.size() << " mip levels, " << texture->getDataSize() / 1024 << " KB)" << std::endl;
+	return 0;
+}
+
+namespace {
+	void printUsage() {
+		std::cout << "Usage:" << std::endl
+			<< "\t" << "LeoTextureCompiler.exe image.png [image.ltex] [--format none|bc1|bc4|bc5|bc7] [--linear]" << "\t" << "Compile an image into a texture container with its mip chain." << std::endl
+			<< "\t" << "LeoTextureCompiler.exe --help" << "\t" << "Print this help." << std::endl;
+		std::cout << "Notes:" << std::endl
+			<< "\t" << "If no output path is provided, the container is written next to the image with the .ltex extension." << std::endl
+			<< "\t" << "The default format is bc1, or bc7 when the image has alpha. Use bc5 for normal maps and bc4 for height and specular maps, like the model loader." << std::endl
+			<< "\t" << "--linear filters the mip levels of uncompressed images in their own space instead of sRGB. Use it for normal maps." << std::endl
+			<< "\t" << "Models can reference the container in place of the image: textures are recognized from their content." << std::endl << std::endl;
+	}
+
+	bool parseCompression(const char* name, leoscene::ImageTexture::Compression& compression) {
+		if (!strcmp(name, "none")) {
+			compression = leoscene::ImageTexture::Compression::NONE;
+		}
+		else if (!strcmp(name, "bc1")) {
+			compression = leoscene::ImageTexture::Compression::BC1;
+		}
+		else if (!strcmp(name, "bc4")) {
+			compression = leoscene::ImageTexture::Compression::BC4;
+		}
+		else if (!strcmp(name, "bc5")) {
+			compression = leoscene::ImageTexture::Compression::BC5;
+		}
+		else if (!strcmp(name, "bc7")) {
+			compression = leoscene::ImageTexture::Compression::BC7;
+		}
+		else {
+			return false;
+		}
+		return true;
+	}
+}
@@ -0,0 +1,360 @@
+#include <scene/ImageTexture.h>
+#include <scene/TextureCompression.h>
+#include <scene/TextureLoader.h>
+
+#include "SelfTest.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/*
+* Block compression of textures: time, size and quality of each format on image files, and checks of the encoders on generated images.
+*/
+
+namespace {
+	struct FormatInfo {
+		const char* name;
+		leoscene::ImageTexture::Compression compression;
+		size_t nbChannels;  // Channels compared with the source
+	};
+
+	const FormatInfo FORMATS[] = {
+		{ "bc1", leoscene::ImageTexture::Compression::BC1, 3 },
+		{ "bc4", leoscene::ImageTexture::Compression::BC4, 1 },
+		{ "bc5", leoscene::ImageTexture::Compression::BC5, 2 },
+		{ "bc7", leoscene::ImageTexture::Compression::BC7, 4 },
+	};
+
+	void printUsage();
+
+	// Checks the encoders, the decoders and the mip chains on generated images.
+	int runSelfTest();
+	using leotools::check;
+
+	// Compresses the RGBA image, decompresses it, and returns the PSNR of the first nbChannels channels, in dB. maxError is the largest
+	// difference of a channel.
+	double measureRoundTrip(leoscene::ImageTexture::Compression compression, const std::vector<unsigned char>& rgba, size_t width, size_t height,
+		size_t nbChannels, int* maxError = nullptr);
+	double computePsnr(const unsigned char* a, const unsigned char* b, size_t nbTexels, size_t nbChannels, int* maxError);
+
+	// Generated RGBA images
+	std::vector<unsigned char> makeGradient(size_t width, size_t height);
+	std::vector<unsigned char> makeNoise(size_t width, size_t height, unsigned int seed);
+	std::vector<unsigned char> makeConstant(size_t width, size_t height, const unsigned char color[4]);
+}
+
+int main(int argc, const char** argv) {
+	if (argc < 2 || !strcmp(argv[1], "--help")) {
+		printUsage();
+		return argc < 2 ? 1 : 0;
+	}
+
+	if (!strcmp(argv[1], "--self-test")) {
+		return runSelfTest() ? 1 : 0;
+	}
+
+	std::vector<const char*> imagePaths;
+	std::vector<FormatInfo> formats;
+	for (int i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "--format") && i + 1 < argc) {
+			const char* name = argv[++i];
+			const FormatInfo* format = std::find_if(std::begin(FORMATS), std::end(FORMATS), [name](const FormatInfo& f) { return !strcmp(f.name, name); });
+			if (format == std::end(FORMATS)) {
+				std::cerr << "Error: unknown format \"" << name << "\"." << std::endl;
+				printUsage();
+				return 1;
+			}
+			formats.push_back(*format);
+		}
+		else if (argv[i][0] == '-') {
+			std::cerr << "Error: unknown argument \"" << argv[i] << "\"." << std::endl;
+			printUsage();
+			return 1;
+		}
+		else {
+			imagePaths.push_back(argv[i]);
+		}
+	}
+	if (formats.empty()) {
+		formats.assign(std::begin(FORMATS), std::end(FORMATS));
+	}
+
+	leoscene::TextureLoader textureLoader;
+	leoscene::TextureLoader::LoadingOptions loadingOptions;
+	loadingOptions.desiredChannels = 4;
+	std::cout << "Image\tFormat\tSize\tCompression (ms)\tMTexels/s\tSize of the mip chain (KB)\tRatio to RGBA8\tPSNR of the first level (dB)" << std::endl;
+	for (const char* imagePath : imagePaths) {
+		std::shared_ptr<leoscene::ImageTexture> texture = textureLoader.loadTexture(imagePath, loadingOptions);
+		if (!texture) {
+			std::cerr << "Error: could not load \"" << imagePath << "\"." << std::endl;
+			return 2;
+		}
+		std::vector<unsigned char> rgba(texture->data, texture->data + texture->getDataSize());
+
+		// The uncompressed mip chain is about 4/3 of the first level
+		double uncompressedSize = texture->width * texture->height * 4 * 4. / 3.;
+		for (const FormatInfo& format : formats) {
+			auto start = std::chrono::steady_clock::now();
+			std::shared_ptr<leoscene::ImageTexture> compressedTexture = leoscene::compressTexture(*texture, format.compression);
+			double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			double psnr = measureRoundTrip(format.compression, rgba, texture->width, texture->height, format.nbChannels);
+			std::cout << imagePath << "\t" << format.name << "\t" << texture->width << "x" << texture->height << "\t" << milliseconds << "\t"
+				<< texture->width * texture->height / (milliseconds * 1000.) << "\t" << compressedTexture->getDataSize() / 1024. << "\t"
+				<< compressedTexture->getDataSize() / uncompressedSize << "\t" << psnr << std::endl;
+		}
+	}
+
+	return 0;
+}
+
+namespace {
+	void printUsage() {
+		std::cout << "Usage:" << std::endl
+			<< "\t" << "LeoTextureCompressionBench.exe image.png [more images] [--format bc1|bc4|bc5|bc7]" << "\t"
+			<< "Time the compression of the images with their mip levels, and print their size and quality." << std::endl
+			<< "\t" << "LeoTextureCompressionBench.exe --self-test" << "\t" << "Check the encoders on generated images. Returns 1 if a check fails." << std::endl
+			<< "\t" << "LeoTextureCompressionBench.exe --help" << "\t" << "Print this help." << std::endl;
+		std::cout << "Notes:" << std::endl
+			<< "\t" << "--format can be repeated. All the formats are measured by default." << std::endl
+			<< "\t" << "The PSNR only compares the channels kept by the format: RGB for BC1, R for BC4, RG for BC5 and RGBA for BC7." << std::endl
+			<< "\t" << "The compression runs on a single thread. No GPU is needed." << std::endl << std::endl;
+	}
+
+	int runSelfTest()
+	{
+		int nbFailures = 0;
+		using Compression = leoscene::ImageTexture::Compression;
+
+		// Smooth images are compressed with little loss
+		{
+			std::vector<unsigned char> gradient = makeGradient(64, 64);
+			nbFailures += !check(measureRoundTrip(Compression::BC1, gradient, 64, 64, 3) > 35., "BC1 keeps a color gradient above 35 dB");
+			nbFailures += !check(measureRoundTrip(Compression::BC4, gradient, 64, 64, 1) > 40., "BC4 keeps a gradient above 40 dB");
+			nbFailures += !check(measureRoundTrip(Compression::BC5, gradient, 64, 64, 2) > 40., "BC5 keeps a two channel gradient above 40 dB");
+			nbFailures += !check(measureRoundTrip(Compression::BC7, gradient, 64, 64, 4) > 40., "BC7 keeps a color and alpha gradient above 40 dB");
+		}
+
+		// Noise is the worst case: every block uses its whole range
+		{
+			std::vector<unsigned char> noise = makeNoise(64, 64, 1);
+			double bc1Psnr = measureRoundTrip(Compression::BC1, noise, 64, 64, 3);
+			double bc7Psnr = measureRoundTrip(Compression::BC7, noise, 64, 64, 4);
+			nbFailures += !check(bc1Psnr > 12. && bc7Psnr > 12., "Noise is compressed above 12 dB");
+			nbFailures += !check(measureRoundTrip(Compression::BC4, noise, 64, 64, 1) > 25., "BC4 compresses noise above 25 dB");
+		}
+
+		// Constant images
+		{
+			const unsigned char color[4] = { 37, 150, 222, 90 };
+			std::vector<unsigned char> constant = makeConstant(8, 8, color);
+			int bc1MaxError = 0, bc4MaxError = 0, bc7MaxError = 0;
+			measureRoundTrip(Compression::BC1, constant, 8, 8, 3, &bc1MaxError);
+			measureRoundTrip(Compression::BC4, constant, 8, 8, 1, &bc4MaxError);
+			measureRoundTrip(Compression::BC7, constant, 8, 8, 4, &bc7MaxError);
+			nbFailures += !check(bc1MaxError <= 4, "BC1 keeps a constant color within the precision of 5:6:5 endpoints");
+			nbFailures += !check(bc4MaxError == 0, "BC4 keeps a constant value exactly");
+			nbFailures += !check(bc7MaxError <= 1, "BC7 keeps a constant color within one step");
+		}
+
+		// Blocks of two colors that are endpoints exactly
+		{
+			std::vector<unsigned char> checker(8 * 8 * 4);
+			for (size_t i = 0; i < 8 * 8; ++i) {
+				unsigned char value = ((i % 8) + (i / 8)) % 2 ? 255 : 0;
+				checker[i * 4] = checker[i * 4 + 1] = checker[i * 4 + 2] = checker[i * 4 + 3] = value;
+			}
+			int bc1MaxError = 0, bc5MaxError = 0, bc7MaxError = 0;
+			measureRoundTrip(Compression::BC1, checker, 8, 8, 3, &bc1MaxError);
+			measureRoundTrip(Compression::BC5, checker, 8, 8, 2, &bc5MaxError);
+			measureRoundTrip(Compression::BC7, checker, 8, 8, 4, &bc7MaxError);
+			nbFailures += !check(!bc1MaxError && !bc5MaxError && !bc7MaxError, "A black and white checker is compressed exactly");
+		}
+
+		// BC7 blocks are mode 6, with the highest bit of the first index implied
+		{
+			std::vector<unsigned char> noise = makeNoise(16, 16, 2);
+			size_t size = leoscene::getCompressedImageSize(Compression::BC7, 16, 16);
+			std::vector<unsigned char> blocks(size);
+			leoscene::compressImage(Compression::BC7, noise.data(), 16, 16, blocks.data());
+			bool allMode6 = true;
+			for (size_t offset = 0; offset < size; offset += 16) {
+				allMode6 = allMode6 && (blocks[offset] & 0x7f) == 0x40;
+			}
+			nbFailures += !check(size == 16 * 16 && allMode6, "BC7 blocks are 16 bytes in mode 6");
+		}
+
+		// Sizes that are not a multiple of the blocks, and mip chains
+		{
+			std::vector<leoscene::ImageTexture::MipLevel> chain = leoscene::getMipChain(leoscene::ImageTexture::Layout::RGB, Compression::BC1, 13, 7);
+			bool chainValid = chain.size() == 4 && chain[1].width == 6 && chain[1].height == 3 && chain[2].width == 3 && chain[2].height == 1 &&
+				chain.back().width == 1 && chain.back().height == 1 && chain[0].size == 4 * 2 * 8 && chain[1].offset == chain[0].size;
+			nbFailures += !check(chainValid, "The mip chain of a 13x7 texture has 4 levels of whole blocks");
+
+			// Top left corner of the 64x64 gradient, as smooth
+			std::vector<unsigned char> largeGradient = makeGradient(64, 64);
+			std::vector<unsigned char> gradient(13 * 7 * 4);
+			for (size_t y = 0; y < 7; ++y) {
+				memcpy(&gradient[y * 13 * 4], &largeGradient[y * 64 * 4], 13 * 4);
+			}
+			nbFailures += !check(measureRoundTrip(Compression::BC7, gradient, 13, 7, 4) > 35., "Partial blocks on the borders are compressed");
+
+			unsigned char* data = new unsigned char[13 * 7 * 4];
+			memcpy(data, gradient.data(), gradient.size());
+			leoscene::ImageTexture texture(13, 7, leoscene::ImageTexture::Type::FLOAT, leoscene::ImageTexture::Layout::RGBA, data);
+			std::shared_ptr<leoscene::ImageTexture> compressedTexture = leoscene::compressTexture(texture, Compression::BC7);
+			nbFailures += !check(compressedTexture && compressedTexture->mipLevels.size() == 4 && compressedTexture->layout == leoscene::ImageTexture::Layout::RGBA &&
+				compressedTexture->getDataSize() == 2 * (chain.back().offset + chain.back().size),
+				"compressTexture stores the compressed mip chain");
+
+			// getTexel reads the decompressed first level. Row 0 is at v = 1.
+			std::vector<unsigned char> decompressed(13 * 7 * 4);
+			leoscene::decompressImage(Compression::BC7, compressedTexture->data, 13, 7, decompressed.data());
+			glm::vec4 texel = compressedTexture->getTexel((9 + 0.5f) / 13.f, 1.f - (5 + 0.5f) / 7.f);
+			const unsigned char* expected = &decompressed[(5 * 13 + 9) * 4];
+			nbFailures += !check(texel == glm::vec4(expected[0], expected[1], expected[2], expected[3]), "getTexel decompresses the texel of a compressed texture");
+		}
+
+		// Mip levels of sRGB textures are filtered in linear space: black and white average to 188, not 128
+		{
+			std::vector<unsigned char> checker(4 * 4 * 4);
+			for (size_t i = 0; i < 4 * 4; ++i) {
+				unsigned char value = ((i % 4) + (i / 4)) % 2 ? 255 : 0;
+				checker[i * 4] = checker[i * 4 + 1] = checker[i * 4 + 2] = value;
+				checker[i * 4 + 3] = 255;
+			}
+			unsigned char* data = new unsigned char[checker.size()];
+			memcpy(data, checker.data(), checker.size());
+			leoscene::ImageTexture texture(4, 4, leoscene::ImageTexture::Type::FLOAT, leoscene::ImageTexture::Layout::RGBA, data);
+			std::shared_ptr<leoscene::ImageTexture> srgbTexture = leoscene::compressTexture(texture, Compression::BC1);
+			std::shared_ptr<leoscene::ImageTexture> linearTexture = leoscene::compressTexture(texture, Compression::BC4);
+			unsigned char srgbTexels[16 * 4], linearTexels[16 * 4];
+			leoscene::decompressBlock(Compression::BC1, srgbTexture->data + srgbTexture->mipLevels.back().offset, srgbTexels);
+			leoscene::decompressBlock(Compression::BC4, linearTexture->data + linearTexture->mipLevels.back().offset, linearTexels);
+			nbFailures += !check(std::abs(srgbTexels[0] - 188) <= 4 && std::abs(linearTexels[0] - 128) <= 1,
+				"The mip levels of BC1 and BC7 are filtered in linear space, the others in their own space");
+		}
+
+		// Uncompressed mip chains, whose levels are 4 bytes aligned
+		{
+			unsigned char* data = new unsigned char[5 * 3]{
+				0, 40, 80, 120, 160,
+				8, 48, 88, 128, 168,
+				16, 56, 96, 136, 176 };
+			leoscene::ImageTexture texture(5, 3, leoscene::ImageTexture::Type::FLOAT, leoscene::ImageTexture::Layout::R, data);
+			std::shared_ptr<leoscene::ImageTexture> mipmappedTexture = leoscene::generateMipLevels(texture, false);
+			bool chainValid = mipmappedTexture && mipmappedTexture->mipLevels.size() == 3 &&
+				mipmappedTexture->mipLevels[1].width == 2 && mipmappedTexture->mipLevels[1].height == 1 && mipmappedTexture->mipLevels[1].offset == 16 &&
+				mipmappedTexture->mipLevels[2].offset == 20 && mipmappedTexture->getDataSize() == 21 &&
+				!memcmp(mipmappedTexture->data, data, 5 * 3);
+			nbFailures += !check(chainValid, "generateMipLevels keeps the first level and aligns the levels on 4 bytes");
+		}
+
+		// Texture containers hold the mip chain as it is, and are detected from their content whatever their extension
+		{
+			std::vector<unsigned char> gradient = makeGradient(64, 32);
+			unsigned char* data = new unsigned char[gradient.size()];
+			memcpy(data, gradient.data(), gradient.size());
+			leoscene::ImageTexture texture(64, 32, leoscene::ImageTexture::Type::FLOAT, leoscene::ImageTexture::Layout::RGBA, data);
+			const char* containerPath = "LeoTextureCompressionBench_selftest.png";
+			bool roundTripValid = true;
+			for (Compression compression : { Compression::NONE, Compression::BC5 }) {
+				std::shared_ptr<leoscene::ImageTexture> processedTexture = compression == Compression::NONE ?
+					leoscene::generateMipLevels(texture, true) : leoscene::compressTexture(texture, compression);
+				leoscene::TextureLoader loader;
+				std::shared_ptr<leoscene::ImageTexture> loadedTexture;
+				if (leoscene::TextureLoader::writeTextureContainer(*processedTexture, containerPath)) {
+					loadedTexture = loader.loadTexture(containerPath, { leoscene::ImageTexture::Layout::RGBA, 4, Compression::BC1 });
+				}
+				roundTripValid = roundTripValid && loadedTexture && loadedTexture->width == 64 && loadedTexture->height == 32 &&
+					loadedTexture->layout == processedTexture->layout && loadedTexture->compression == compression &&
+					loadedTexture->mipLevels.size() == 7 && loadedTexture->getDataSize() == processedTexture->getDataSize() &&
+					!memcmp(loadedTexture->data, processedTexture->data, processedTexture->getDataSize());
+			}
+			std::remove(containerPath);
+			nbFailures += !check(roundTripValid, "Texture containers are loaded with their mip chain, ignoring the loading options");
+		}
+
+		// Sizes of the formats
+		{
+			bool sizesValid = leoscene::getCompressedImageSize(Compression::BC1, 256, 256) == 256 * 256 / 2 &&
+				leoscene::getCompressedImageSize(Compression::BC4, 256, 256) == 256 * 256 / 2 &&
+				leoscene::getCompressedImageSize(Compression::BC5, 256, 256) == 256 * 256 &&
+				leoscene::getCompressedImageSize(Compression::BC7, 256, 256) == 256 * 256 &&
+				leoscene::getCompressedImageSize(Compression::BC7, 1, 1) == 16;
+			nbFailures += !check(sizesValid, "BC1 and BC4 take 4 bits per texel, BC5 and BC7 take 8 bits");
+		}
+
+		std::cout << (nbFailures ? "Self test failed." : "Self test passed.") << std::endl;
+		return nbFailures;
+	}
+
+	double measureRoundTrip(leoscene::ImageTexture::Compression compression, const std::vector<unsigned char>& rgba, size_t width, size_t height,
+		size_t nbChannels, int* maxError)
+	{
+		std::vector<unsigned char> compressed(leoscene::getCompressedImageSize(compression, width, height));
+		std::vector<unsigned char> decompressed(width * height * 4);
+		leoscene::compressImage(compression, rgba.data(), width, height, compressed.data());
+		leoscene::decompressImage(compression, compressed.data(), width, height, decompressed.data());
+		return computePsnr(rgba.data(), decompressed.data(), width * height, nbChannels, maxError);
+	}
+
+	double computePsnr(const unsigned char* a, const unsigned char* b, size_t nbTexels, size_t nbChannels, int* maxError)
+	{
+		double squaredError = 0;
+		int largestError = 0;
+		for (size_t i = 0; i < nbTexels; ++i) {
+			for (size_t channel = 0; channel < nbChannels; ++channel) {
+				int difference = int(a[i * 4 + channel]) - int(b[i * 4 + channel]);
+				squaredError += double(difference) * difference;
+				largestError = std::max(largestError, std::abs(difference));
+			}
+		}
+		if (maxError) {
+			*maxError = largestError;
+		}
+		double meanSquaredError = squaredError / double(nbTexels * nbChannels);
+		return meanSquaredError > 0 ? 10. * std::log10(255. * 255. / meanSquaredError) : 99.;
+	}
+
+	std::vector<unsigned char> makeGradient(size_t width, size_t height)
+	{
+		std::vector<unsigned char> rgba(width * height * 4);
+		for (size_t y = 0; y < height; ++y) {
+			for (size_t x = 0; x < width; ++x) {
+				unsigned char* texel = &rgba[(y * width + x) * 4];
+				texel[0] = static_cast<unsigned char>(x * 255 / std::max<size_t>(width - 1, 1));
+				texel[1] = static_cast<unsigned char>(y * 255 / std::max<size_t>(height - 1, 1));
+				texel[2] = static_cast<unsigned char>(128 + 64 * std::sin(x * 0.1) * std::cos(y * 0.1));
+				texel[3] = static_cast<unsigned char>((x + y) * 255 / std::max<size_t>(width + height - 2, 1));
+			}
+		}
+		return rgba;
+	}
+
+	std::vector<unsigned char> makeNoise(size_t width, size_t height, unsigned int seed)
+	{
+		std::vector<unsigned char> rgba(width * height * 4);
+		unsigned int state = seed;
+		for (unsigned char& value : rgba) {
+			state = state * 1664525u + 1013904223u;
+			value = static_cast<unsigned char>(state >> 24);
+		}
+		return rgba;
+	}
+
+	std::vector<unsigned char> makeConstant(size_t width, size_t height, const unsigned char color[4])
+	{
+		std::vector<unsigned char> rgba(width * height * 4);
+		for (size_t i = 0; i < width * height; ++i) {
+			memcpy(&rgba[i * 4], color, 4);
+		}
+		return rgba;
+	}
+}
@@ -0,0 +1,328 @@
+#include <scene/ImageTexture.h>
+#include <scene/TextureLoader.h>
+#include <scene/ThreadPool.h>
+
+#include "SelfTest.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+/*
+* Loading of textures on the threads of TextureLoader: time from 1 thread to N, and checks of the requests on generated images.
+*/
+
+namespace {
+	void printUsage();
+
+	// Checks the requests and the cache of TextureLoader on generated images.
+	int runSelfTest();
+	using leotools::check;
+
+	// Requests all the textures from a new loader with the given number of threads, then waits for them. Returns the time in milliseconds,
+	// or a negative time if a texture could not be loaded.
+	double loadTextures(const std::vector<std::string>& imagePaths, const leoscene::TextureLoader::LoadingOptions& options, size_t nbThreads,
+		size_t& nbTexels);
+
+	// Image files in the directory, or the path itself if it is a file
+	void listImages(const std::string& path, std::vector<std::string>& imagePaths);
+
+	// Uncompressed 32 bits TGA file
+	bool writeTga(const char* filePath, const std::vector<unsigned char>& rgba, size_t width, size_t height);
+	std::vector<unsigned char> makeGradient(size_t width, size_t height, unsigned char seed);
+}
+
+int main(int argc, const char** argv) {
+	if (argc < 2 || !strcmp(argv[1], "--help")) {
+		printUsage();
+		return argc < 2 ? 1 : 0;
+	}
+
+	if (!strcmp(argv[1], "--self-test")) {
+		return runSelfTest() ? 1 : 0;
+	}
+
+	std::vector<std::string> imagePaths;
+	size_t maxNbThreads = leoscene::ThreadPool::getDefaultNbThreads();
+	uint32_t nbIterations = 1;
+	leoscene::TextureLoader::LoadingOptions options;
+	options.desiredChannels = 4;
+	options.compression = leoscene::ImageTexture::Compression::BC1;  // Like the diffuse textures of the models
+	for (int i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "--threads") && i + 1 < argc) {
+			maxNbThreads = static_cast<size_t>(atoi(argv[++i]));
+		}
+		else if (!strcmp(argv[i], "--iterations") && i + 1 < argc) {
+			nbIterations = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else if (!strcmp(argv[i], "--no-texture-compression")) {
+			options.compression = leoscene::ImageTexture::Compression::NONE;
+		}
+		else if (argv[i][0] == '-') {
+			std::cerr << "Error: unknown argument \"" << argv[i] << "\"." << std::endl;
+			printUsage();
+			return 1;
+		}
+		else {
+			listImages(argv[i], imagePaths);
+		}
+	}
+	if (!maxNbThreads || !nbIterations) {
+		std::cerr << "Error: --threads and --iterations must be positive." << std::endl;
+		return 1;
+	}
+	if (imagePaths.empty()) {
+		std::cerr << "Error: no image to load." << std::endl;
+		return 1;
+	}
+
+	// Powers of two up to the maximum number of threads, which is always measured
+	std::vector<size_t> threadCounts;
+	for (size_t nbThreads = 1; nbThreads < maxNbThreads; nbThreads *= 2) {
+		threadCounts.push_back(nbThreads);
+	}
+	threadCounts.push_back(maxNbThreads);
+
+	std::cout << imagePaths.size() << " images, " << (options.compression == leoscene::ImageTexture::Compression::NONE ? "uncompressed" : "compressed") << std::endl;
+	std::cout << "Threads\tTime (ms)\tMTexels/s\tSpeedup" << std::endl;
+	double oneThreadMilliseconds = 0;
+	for (size_t nbThreads : threadCounts) {
+		double bestMilliseconds = -1;
+		size_t nbTexels = 0;
+		for (uint32_t iteration = 0; iteration < nbIterations; ++iteration) {
+			double milliseconds = loadTextures(imagePaths, options, nbThreads, nbTexels);
+			if (milliseconds < 0) {
+				std::cerr << "Error: an image could not be loaded." << std::endl;
+				return 2;
+			}
+			bestMilliseconds = bestMilliseconds < 0 ? milliseconds : std::min(bestMilliseconds, milliseconds);
+		}
+		if (nbThreads == 1) {
+			oneThreadMilliseconds = bestMilliseconds;
+		}
+		std::cout << nbThreads << "\t" << bestMilliseconds << "\t" << nbTexels / (bestMilliseconds * 1000.) << "\t"
+			<< oneThreadMilliseconds / bestMilliseconds << std::endl;
+	}
+
+	return 0;
+}
+
+namespace {
+	void printUsage() {
+		std::cout << "Usage:" << std::endl
+			<< "\t" << "LeoTextureLoadBench.exe images_directory [more images or directories] [--threads N] [--iterations N] [--no-texture-compression]" << "\t"
+			<< "Time the loading of the images by TextureLoader on 1 to N threads." << std::endl
+			<< "\t" << "LeoTextureLoadBench.exe --self-test" << "\t" << "Check the texture requests on generated images. Returns 1 if a check fails." << std::endl
+			<< "\t" << "LeoTextureLoadBench.exe --help" << "\t" << "Print this help." << std::endl;
+		std::cout << "Notes:" << std::endl
+			<< "\t" << "Directories are searched for .png, .jpg, .tga, .bmp and .ltex files, not recursively." << std::endl
+			<< "\t" << "The images are decoded, given their mip levels and compressed to BC1 (BC7 with alpha) like the diffuse textures of the models, without asset cache." << std::endl
+			<< "\t" << "The thread counts are the powers of two below N, then N. N defaults to one per hardware thread. The speedup is relative to 1 thread." << std::endl << std::endl;
+	}
+
+	int runSelfTest()
+	{
+		int nbFailures = 0;
+
+		const size_t nbImages = 6;
+		std::vector<std::string> imagePaths;
+		for (size_t i = 0; i < nbImages; ++i) {
+			imagePaths.push_back("LeoTextureLoadBench_selftest_" + std::to_string(i) + ".tga");
+			if (!writeTga(imagePaths.back().c_str(), makeGradient(96 + i * 16, 64, static_cast<unsigned char>(i * 40)), 96 + i * 16, 64)) {
+				std::cerr << "Error: could not write the test images." << std::endl;
+				return 1;
+			}
+		}
+
+		leoscene::TextureLoader::LoadingOptions options;
+		options.desiredChannels = 4;
+		options.compression = leoscene::ImageTexture::Compression::BC1;
+
+		// Reference: textures loaded by the requesting thread
+		std::vector<std::shared_ptr<leoscene::ImageTexture>> references;
+		{
+			leoscene::TextureLoader loader;
+			for (const std::string& imagePath : imagePaths) {
+				references.push_back(loader.loadTexture(imagePath.c_str(), options));
+			}
+			bool referencesValid = std::all_of(references.begin(), references.end(), [](const std::shared_ptr<leoscene::ImageTexture>& texture) {
+				return texture && texture->compression == leoscene::ImageTexture::Compression::BC1 && texture->mipLevels.size() > 1;
+			});
+			nbFailures += !check(referencesValid, "Textures are loaded on the requesting thread without loading threads");
+		}
+
+		{
+			leoscene::TextureLoader loader;
+			loader.setNbThreads(4);
+
+			// Several threads request all the textures at the same time, in different orders
+			const size_t nbRequestingThreads = 4;
+			std::vector<std::future<std::vector<leoscene::TextureLoader::TextureFuture>>> requests;
+			for (size_t thread = 0; thread < nbRequestingThreads; ++thread) {
+				requests.push_back(std::async(std::launch::async, [&loader, &imagePaths, &options, thread]() {
+					std::vector<leoscene::TextureLoader::TextureFuture> futures(imagePaths.size());
+					for (size_t i = 0; i < imagePaths.size(); ++i) {
+						size_t image = (i + thread) % imagePaths.size();
+						futures[image] = loader.requestTexture(imagePaths[image].c_str(), options);
+					}
+					return futures;
+				}));
+			}
+
+			bool sameTextures = true;
+			bool sameTexels = true;
+			for (std::future<std::vector<leoscene::TextureLoader::TextureFuture>>& request : requests) {
+				std::vector<leoscene::TextureLoader::TextureFuture> futures = request.get();
+				for (size_t i = 0; i < imagePaths.size(); ++i) {
+					std::shared_ptr<leoscene::ImageTexture> texture = futures[i].get();
+					sameTextures = sameTextures && texture && texture == loader.loadTexture(imagePaths[i].c_str(), options);
+					sameTexels = sameTexels && texture && texture->getDataSize() == references[i]->getDataSize() &&
+						!memcmp(texture->data, references[i]->data, texture->getDataSize());
+				}
+			}
+			nbFailures += !check(sameTextures, "Concurrent requests of the same file share a single texture");
+			nbFailures += !check(sameTexels, "Textures loaded on the loading threads are the same as on the requesting thread");
+
+			bool pathsValid = true;
+			for (size_t i = 0; i < imagePaths.size(); ++i) {
+				pathsValid = pathsValid && loader.getTextureFilePath(loader.loadTexture(imagePaths[i].c_str(), options).get()) == imagePaths[i];
+			}
+			nbFailures += !check(pathsValid, "The file paths of the textures loaded on the loading threads are known");
+
+			leoscene::TextureLoader::TextureFuture missingTexture = loader.requestTexture("LeoTextureLoadBench_selftest_missing.tga", options);
+			nbFailures += !check(missingTexture.valid() && !missingTexture.get(), "A missing file gives a null texture");
+		}
+
+		{
+			// More tasks waiting for textures than threads in the pool, as when models are imported on the pool of the textures
+			std::shared_ptr<leoscene::ThreadPool> threadPool = std::make_shared<leoscene::ThreadPool>(2);
+			leoscene::TextureLoader loader;
+			loader.setThreadPool(threadPool);
+			std::vector<std::future<bool>> tasks;
+			for (size_t task = 0; task < 4; ++task) {
+				tasks.push_back(threadPool->submit([&loader, &imagePaths, &options, &references, task]() {
+					bool sameTexels = true;
+					for (size_t i = 0; i < imagePaths.size(); ++i) {
+						size_t image = (i + task) % imagePaths.size();
+						std::shared_ptr<leoscene::ImageTexture> texture = loader.loadTexture(imagePaths[image].c_str(), options);
+						sameTexels = sameTexels && texture && texture->getDataSize() == references[image]->getDataSize();
+					}
+					return sameTexels;
+				}));
+			}
+			bool tasksDone = true;
+			for (std::future<bool>& task : tasks) {
+				tasksDone = tasksDone && task.wait_for(std::chrono::seconds(60)) == std::future_status::ready && task.get();
+			}
+			nbFailures += !check(tasksDone, "Tasks of a pool waiting for textures loaded on the same pool finish");
+			if (!tasksDone) {
+				std::cout << "Self test failed." << std::endl;
+				std::exit(1);  // The pool is stuck and cannot be destroyed
+			}
+		}
+
+		{
+			size_t nbTexels = 0;
+			bool timesValid = loadTextures(imagePaths, options, 1, nbTexels) >= 0 && loadTextures(imagePaths, options, 3, nbTexels) >= 0 &&
+				nbTexels == 64 * (96 * nbImages + 16 * nbImages * (nbImages - 1) / 2);
+			nbFailures += !check(timesValid, "The benchmark loads all the images with any number of threads");
+		}
+
+		for (const std::string& imagePath : imagePaths) {
+			std::remove(imagePath.c_str());
+		}
+
+		std::cout << (nbFailures ? "Self test failed." : "Self test passed.") << std::endl;
+		return nbFailures;
+	}
+
+	double loadTextures(const std::vector<std::string>& imagePaths, const leoscene::TextureLoader::LoadingOptions& options, size_t nbThreads,
+		size_t& nbTexels)
+	{
+		leoscene::TextureLoader loader;
+		loader.setNbThreads(nbThreads);
+		auto start = std::chrono::steady_clock::now();
+		std::vector<leoscene::TextureLoader::TextureFuture> futures;
+		for (const std::string& imagePath : imagePaths) {
+			futures.push_back(loader.requestTexture(imagePath.c_str(), options));
+		}
+		nbTexels = 0;
+		bool loaded = true;
+		for (leoscene::TextureLoader::TextureFuture& future : futures) {
+			std::shared_ptr<leoscene::ImageTexture> texture = future.get();
+			loaded = loaded && texture;
+			nbTexels += texture ? texture->width * texture->height : 0;
+		}
+		double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		return loaded ? milliseconds : -1;
+	}
+
+	void listImages(const std::string& path, std::vector<std::string>& imagePaths)
+	{
+		std::error_code error;
+		if (!std::filesystem::is_directory(path, error)) {
+			imagePaths.push_back(path);
+			return;
+		}
+		const char* extensions[] = { ".png", ".jpg", ".jpeg", ".tga", ".bmp", ".ltex" };
+		std::vector<std::string> directoryImages;
+		for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(path, error)) {
+			std::string extension = entry.path().extension().string();
+			std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return static_cast<char>(tolower(c)); });
+			if (entry.is_regular_file(error) && std::find(std::begin(extensions), std::end(extensions), extension) != std::end(extensions)) {
+				directoryImages.push_back(entry.path().generic_string());
+			}
+		}
+		std::sort(directoryImages.begin(), directoryImages.end());
+		imagePaths.insert(imagePaths.end(), directoryImages.begin(), directoryImages.end());
+	}
+
+	bool writeTga(const char* filePath, const std::vector<unsigned char>& rgba, size_t width, size_t height)
+	{
+		unsigned char header[18] = {};
+		header[2] = 2;  // Uncompressed true color
+		header[12] = static_cast<unsigned char>(width & 0xFF);
+		header[13] = static_cast<unsigned char>(width >> 8);
+		header[14] = static_cast<unsigned char>(height & 0xFF);
+		header[15] = static_cast<unsigned char>(height >> 8);
+		header[16] = 32;
+		header[17] = 0x28;  // 8 bits of alpha, first row at the top
+
+		std::vector<unsigned char> bgra(rgba.size());
+		for (size_t i = 0; i < width * height; ++i) {
+			bgra[i * 4] = rgba[i * 4 + 2];
+			bgra[i * 4 + 1] = rgba[i * 4 + 1];
+			bgra[i * 4 + 2] = rgba[i * 4];
+			bgra[i * 4 + 3] = rgba[i * 4 + 3];
+		}
+
+		std::ofstream ofs(filePath, std::ios::binary | std::ios::trunc);
+		ofs.write(reinterpret_cast<const char*>(header), sizeof(header));
+		ofs.write(reinterpret_cast<const char*>(bgra.data()), bgra.size());
+		return ofs.good();
+	}
+
+	std::vector<unsigned char> makeGradient(size_t width, size_t height, unsigned char seed)
+	{
+		std::vector<unsigned char> rgba(width * height * 4);
+		for (size_t y = 0; y < height; ++y) {
+			for (size_t x = 0; x < width; ++x) {
+				unsigned char* texel = &rgba[(y * width + x) * 4];
+				texel[0] = static_cast<unsigned char>(x * 255 / (width - 1));
+				texel[1] = static_cast<unsigned char>(y * 255 / (height - 1));
+				texel[2] = static_cast<unsigned char>(seed + (x + y) / 2);
+				texel[3] = 255;
+			}
+		}
+		return rgba;
+	}
+}
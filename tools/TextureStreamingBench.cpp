@@ -0,0 +1,353 @@
+#include <scene/ImageTexture.h>
+#include <scene/TextureCompression.h>
+#include <scene/TextureResidency.h>
+
+#include "SelfTest.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/*
+* Streaming of the mip levels of textures (see TextureResidency): memory, uploads and sharpness of a camera walking along
+* a corridor of textured objects under several memory budgets, and checks of the residency decisions.
+*/
+
+namespace {
+	struct SimulationOptions {
+		uint32_t nbTextures = 512;
+		uint32_t textureSize = 2048;
+		uint32_t nbFrames = 2000;
+		size_t uploadBudget = 16 * 1024 * 1024;
+	};
+
+	struct SimulationResult {
+		size_t peakResidentSize = 0;
+		size_t uploadedSize = 0;
+		size_t maxFrameUploadedSize = 0;
+		uint32_t nbEvictions = 0;
+		uint32_t nbDeniedUpgrades = 0;
+		size_t nbSamples = 0;  // Textures sampled, summed over the frames
+		size_t nbSharpSamples = 0;  // Samples with their level resident
+		size_t nbMissingLevels = 0;  // Levels missing to the samples, summed
+	};
+
+	// Distance between two objects of the corridor, and distance at which they are seen, in world units
+	const float OBJECT_SPACING = 4.f;
+	const float VIEW_DISTANCE = 400.f;
+
+	// Frames between a sample and the residency update reading it, like the feedback buffer read after the fence of its frame
+	const uint64_t FEEDBACK_LATENCY = 2;
+
+	void printUsage();
+
+	// Checks the residency decisions on small sets of textures.
+	int runSelfTest();
+	using leotools::check;
+
+	SimulationResult simulate(const SimulationOptions& options, size_t memoryBudget);
+
+	// Level sampled in the texture of an object at this distance from the camera. The objects cover about as many pixels
+	// as their texture has texels when they are OBJECT_SPACING units away.
+	uint32_t getSampledLevel(float distance, uint32_t nbLevels);
+
+	// Value of the feedback buffer for a sample of this level in a texture of this size
+	uint32_t getFeedbackLevel(uint32_t level, uint32_t textureSize);
+
+	std::vector<size_t> getLevelSizes(uint32_t textureSize);
+	size_t getResidentSize(const std::vector<size_t>& levelSizes, uint32_t firstLevel);
+}
+
+int main(int argc, const char** argv) {
+	if (argc >= 2 && !strcmp(argv[1], "--help")) {
+		printUsage();
+		return 0;
+	}
+
+	if (argc >= 2 && !strcmp(argv[1], "--self-test")) {
+		return runSelfTest() ? 1 : 0;
+	}
+
+	SimulationOptions options;
+	for (int i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "--textures") && i + 1 < argc) {
+			options.nbTextures = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else if (!strcmp(argv[i], "--size") && i + 1 < argc) {
+			options.textureSize = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else if (!strcmp(argv[i], "--frames") && i + 1 < argc) {
+			options.nbFrames = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else if (!strcmp(argv[i], "--upload-budget") && i + 1 < argc) {
+			options.uploadBudget = static_cast<size_t>(atof(argv[++i]) * 1024 * 1024);
+		}
+		else {
+			std::cerr << "Error: unknown argument \"" << argv[i] << "\"." << std::endl;
+			printUsage();
+			return 1;
+		}
+	}
+	if (!options.nbTextures || !options.textureSize || !options.nbFrames) {
+		std::cerr << "Error: --textures, --size and --frames must be positive." << std::endl;
+		return 1;
+	}
+
+	std::vector<size_t> levelSizes = getLevelSizes(options.textureSize);
+	size_t fullSize = getResidentSize(levelSizes, 0) * options.nbTextures;
+	size_t initialSize = 0;
+	{
+		leoscene::TextureResidency residency;
+		for (uint32_t i = 0; i < options.nbTextures; ++i) {
+			residency.addTexture(options.textureSize, options.textureSize, levelSizes);
+		}
+		initialSize = residency.getResidentSize();
+	}
+
+	const double megabyte = 1024. * 1024.;
+	std::cout << options.nbTextures << " BC1 textures of " << options.textureSize << "x" << options.textureSize << ", " << options.nbFrames << " frames" << std::endl;
+	std::cout << "All levels resident: " << fullSize / megabyte << " MB, initial levels only: " << initialSize / megabyte << " MB" << std::endl;
+	std::cout << "Budget (MB)\tPeak (MB)\tUploaded (MB)\tMax per frame (MB)\tEvictions\tDenied\tSharp samples (%)\tMissing levels per sample" << std::endl;
+	for (size_t divisor : { 16, 8, 4, 2, 1 }) {
+		size_t memoryBudget = fullSize / divisor;
+		SimulationResult result = simulate(options, memoryBudget);
+		std::cout << memoryBudget / megabyte << "\t" << result.peakResidentSize / megabyte << "\t" << result.uploadedSize / megabyte << "\t"
+			<< result.maxFrameUploadedSize / megabyte << "\t" << result.nbEvictions << "\t" << result.nbDeniedUpgrades << "\t"
+			<< (result.nbSamples ? 100. * result.nbSharpSamples / result.nbSamples : 100.) << "\t"
+			<< (result.nbSamples ? static_cast<double>(result.nbMissingLevels) / result.nbSamples : 0.) << std::endl;
+	}
+
+	return 0;
+}
+
+namespace {
+	void printUsage() {
+		std::cout << "Usage:" << std::endl
+			<< "\t" << "LeoTextureStreamingBench.exe [--textures N] [--size N] [--frames N] [--upload-budget MB]" << "\t"
+			<< "Simulate the streaming of the mip levels of textures under several memory budgets." << std::endl
+			<< "\t" << "LeoTextureStreamingBench.exe --self-test" << "\t" << "Check the residency decisions. Returns 1 if a check fails." << std::endl
+			<< "\t" << "LeoTextureStreamingBench.exe --help" << "\t" << "Print this help." << std::endl;
+		std::cout << "Notes:" << std::endl
+			<< "\t" << "The camera walks along a corridor of objects, each with its own BC1 texture (512 textures of 2048x2048 by default)." << std::endl
+			<< "\t" << "The levels sampled in each frame are read 2 frames later, like the feedback buffer of the renderer." << std::endl
+			<< "\t" << "The budgets are fractions of the size of all the levels of all the textures. --upload-budget defaults to 16 MB per frame." << std::endl
+			<< "\t" << "A sample is sharp when the level it needs is resident. Missing levels per sample tells how blurry the others are." << std::endl << std::endl;
+	}
+
+	int runSelfTest()
+	{
+		int nbFailures = 0;
+		const uint32_t textureSize = 1024;  // 11 levels
+		std::vector<size_t> levelSizes = getLevelSizes(textureSize);
+		std::vector<leoscene::TextureResidency::Change> changes;
+
+		{
+			leoscene::TextureResidency residency;
+			uint32_t texture = residency.addTexture(textureSize, textureSize, levelSizes);
+			nbFailures += !check(residency.getNbLevels(texture) == 11 && residency.getFirstResidentLevel(texture) == 4 &&
+				residency.getResidentSize() == getResidentSize(levelSizes, 4), "Textures start with the levels of 64 texels and less");
+
+			uint32_t defaultTexture = residency.addTexture(*leoscene::ImageTexture::white);
+			residency.requestLevel(defaultTexture, 0, 1);
+			residency.update(1, changes);
+			nbFailures += !check(residency.getNbLevels(defaultTexture) == 1 && residency.getFirstResidentLevel(defaultTexture) == 0 && changes.empty(),
+				"Textures without mip levels are resident and never change");
+
+			residency.update(2, changes);
+			nbFailures += !check(changes.empty() && residency.getFirstResidentLevel(texture) == 4, "Textures that are not sampled keep their initial levels");
+
+			residency.requestLevel(texture, 3, 3);
+			residency.requestLevel(texture, 1, 3);
+			residency.requestLevel(texture, 2, 3);
+			residency.update(3, changes);
+			nbFailures += !check(changes.size() == 1 && changes[0].texture == texture && changes[0].firstLevel == 1 &&
+				residency.getResidentSize() == getResidentSize(levelSizes, 1) + leoscene::ImageTexture::white->getDataSize(), "Sampled levels are made resident at once, with the finest request of the frame");
+
+			residency.requestLevel(texture, 5, 4);
+			residency.update(4, changes);
+			nbFailures += !check(changes.empty() && residency.getFirstResidentLevel(texture) == 1, "Levels are not evicted under the budget");
+		}
+
+		{
+			nbFailures += !check(leoscene::TextureResidency::getLevelFromFeedback(getFeedbackLevel(3, textureSize), textureSize, textureSize, 11) == 3 &&
+				leoscene::TextureResidency::getLevelFromFeedback(getFeedbackLevel(3, textureSize), 2 * textureSize, textureSize / 2, 12) == 4 &&
+				leoscene::TextureResidency::getLevelFromFeedback(0, textureSize, textureSize, 11) == 0 &&
+				leoscene::TextureResidency::getLevelFromFeedback(leoscene::TextureResidency::FEEDBACK_LOD_BIAS + 4, textureSize, textureSize, 11) == 10,
+				"Feedback values are converted to the levels of each texture, from its largest side, and clamped to its levels");
+		}
+
+		{
+			// Room for one texture with all its levels, one from level 1, and two with their initial levels
+			leoscene::TextureResidencyOptions options;
+			options.memoryBudget = getResidentSize(levelSizes, 0) + getResidentSize(levelSizes, 1) + 2 * getResidentSize(levelSizes, 4);
+			options.evictionDelay = 10;
+			leoscene::TextureResidency residency(options);
+			std::vector<uint32_t> textures;
+			for (int i = 0; i < 4; ++i) {
+				textures.push_back(residency.addTexture(textureSize, textureSize, levelSizes));
+			}
+
+			residency.requestLevel(textures[0], 0, 1);
+			residency.update(1, changes);
+			residency.requestLevel(textures[1], 1, 5);
+			residency.update(5, changes);
+			residency.requestLevel(textures[2], 1, 8);
+			residency.update(8, changes);
+			nbFailures += !check(residency.getFirstResidentLevel(textures[0]) == 0 && residency.getFirstResidentLevel(textures[1]) == 1 &&
+				residency.getFirstResidentLevel(textures[2]) == 4 && residency.getResidentSize() <= options.memoryBudget,
+				"Levels sampled by textures in use are not evicted, even when others need room");
+
+			// Texture 0 was sampled the longest time ago: its levels are evicted first, down to its initial levels
+			residency.requestLevel(textures[1], 1, 14);
+			residency.requestLevel(textures[2], 1, 14);
+			residency.update(14, changes);
+			bool evictedFirst = std::any_of(changes.begin(), changes.end(), [&textures](const leoscene::TextureResidency::Change& change) {
+				return change.texture == textures[0] && change.firstLevel == 4;
+			});
+			nbFailures += !check(evictedFirst && residency.getFirstResidentLevel(textures[1]) == 1 && residency.getFirstResidentLevel(textures[2]) == 1 &&
+				residency.getResidentSize() <= options.memoryBudget, "The least recently used textures are evicted to make room");
+
+			residency.requestLevel(textures[3], 0, 15);
+			residency.requestLevel(textures[1], 1, 15);
+			residency.requestLevel(textures[2], 1, 15);
+			residency.update(15, changes);
+			nbFailures += !check(residency.getFirstResidentLevel(textures[3]) > 0 && residency.getFirstResidentLevel(textures[3]) < 4 &&
+				residency.getResidentSize() <= options.memoryBudget && residency.getStatistics().nbEvictions == 1,
+				"Textures get the finest levels that fit when their sampled levels do not");
+		}
+
+		{
+			leoscene::TextureResidencyOptions options;
+			options.uploadBudget = 1;
+			leoscene::TextureResidency residency(options);
+			for (uint32_t texture = 0; texture < 3; ++texture) {
+				residency.addTexture(textureSize, textureSize, levelSizes);
+			}
+			std::vector<size_t> nbChangesPerFrame;
+			for (uint64_t frame = 1; frame <= 3; ++frame) {
+				for (uint32_t texture = 0; texture < 3; ++texture) {
+					residency.requestLevel(texture, 0, frame);
+				}
+				residency.update(frame, changes);
+				nbChangesPerFrame.push_back(changes.size());
+			}
+			nbFailures += !check(nbChangesPerFrame == std::vector<size_t>({ 1, 1, 1 }) && residency.getFirstResidentLevel(0) == 0 &&
+				residency.getFirstResidentLevel(1) == 0 && residency.getFirstResidentLevel(2) == 0,
+				"Past the upload budget, textures wait for the next frames, and one texture still gets its levels each frame");
+		}
+
+		{
+			SimulationOptions simulationOptions;
+			simulationOptions.nbTextures = 64;
+			simulationOptions.textureSize = 512;
+			simulationOptions.nbFrames = 300;
+			std::vector<size_t> simulationLevelSizes = getLevelSizes(simulationOptions.textureSize);
+			size_t fullSize = getResidentSize(simulationLevelSizes, 0) * simulationOptions.nbTextures;
+			SimulationResult fullBudget = simulate(simulationOptions, fullSize);
+			SimulationResult smallBudget = simulate(simulationOptions, fullSize / 8);
+			nbFailures += !check(fullBudget.nbSamples && fullBudget.nbSharpSamples > fullBudget.nbSamples * 9 / 10 && fullBudget.nbEvictions == 0,
+				"With room for every level, the samples are sharp once their levels are uploaded");
+			nbFailures += !check(smallBudget.peakResidentSize <= fullSize / 8 && smallBudget.nbEvictions > 0 && smallBudget.nbSharpSamples > 0,
+				"With a small budget, the resident levels fit in it and levels are evicted as the camera moves");
+		}
+
+		std::cout << (nbFailures ? "Self test failed." : "Self test passed.") << std::endl;
+		return nbFailures;
+	}
+
+	SimulationResult simulate(const SimulationOptions& options, size_t memoryBudget)
+	{
+		leoscene::TextureResidencyOptions residencyOptions;
+		residencyOptions.memoryBudget = memoryBudget;
+		residencyOptions.uploadBudget = options.uploadBudget;
+		leoscene::TextureResidency residency(residencyOptions);
+		std::vector<size_t> levelSizes = getLevelSizes(options.textureSize);
+		for (uint32_t i = 0; i < options.nbTextures; ++i) {
+			residency.addTexture(options.textureSize, options.textureSize, levelSizes);
+		}
+		uint32_t nbLevels = static_cast<uint32_t>(levelSizes.size());
+
+		// The camera walks from the first object to the last one
+		float corridorLength = OBJECT_SPACING * options.nbTextures;
+		auto getCameraPosition = [&](uint64_t frame) {
+			return corridorLength * static_cast<float>(frame) / options.nbFrames - VIEW_DISTANCE / 4;
+		};
+
+		SimulationResult result;
+		std::vector<leoscene::TextureResidency::Change> changes;
+		for (uint64_t frame = 1; frame <= options.nbFrames; ++frame) {
+			if (frame > FEEDBACK_LATENCY) {
+				float sampledPosition = getCameraPosition(frame - FEEDBACK_LATENCY);
+				for (uint32_t texture = 0; texture < options.nbTextures; ++texture) {
+					float distance = OBJECT_SPACING * texture - sampledPosition;
+					if (distance > 0 && distance < VIEW_DISTANCE) {
+						uint32_t level = getSampledLevel(distance, nbLevels);
+						residency.requestFeedbackLevel(texture, getFeedbackLevel(level, options.textureSize), frame);
+					}
+				}
+			}
+
+			size_t uploadedSizeBefore = residency.getStatistics().uploadedSize;
+			residency.update(frame, changes);
+			result.maxFrameUploadedSize = std::max(result.maxFrameUploadedSize, residency.getStatistics().uploadedSize - uploadedSizeBefore);
+			result.peakResidentSize = std::max(result.peakResidentSize, residency.getResidentSize());
+
+			float cameraPosition = getCameraPosition(frame);
+			for (uint32_t texture = 0; texture < options.nbTextures; ++texture) {
+				float distance = OBJECT_SPACING * texture - cameraPosition;
+				if (distance > 0 && distance < VIEW_DISTANCE) {
+					uint32_t level = getSampledLevel(distance, nbLevels);
+					uint32_t firstLevel = residency.getFirstResidentLevel(texture);
+					result.nbSamples++;
+					result.nbSharpSamples += firstLevel <= level;
+					result.nbMissingLevels += firstLevel > level ? firstLevel - level : 0;
+				}
+			}
+		}
+
+		result.uploadedSize = residency.getStatistics().uploadedSize;
+		result.nbEvictions = residency.getStatistics().nbEvictions;
+		result.nbDeniedUpgrades = residency.getStatistics().nbDeniedUpgrades;
+		return result;
+	}
+
+	uint32_t getSampledLevel(float distance, uint32_t nbLevels)
+	{
+		float texelsPerPixel = distance / OBJECT_SPACING;
+		uint32_t level = static_cast<uint32_t>(std::max(std::floor(std::log2(std::max(texelsPerPixel, 1.f))), 0.f));
+		return std::min(level, nbLevels - 1);
+	}
+
+	uint32_t getFeedbackLevel(uint32_t level, uint32_t textureSize)
+	{
+		uint32_t sizeLog2 = 0;
+		while (textureSize >> (sizeLog2 + 1)) {
+			sizeLog2++;
+		}
+		return level + leoscene::TextureResidency::FEEDBACK_LOD_BIAS - sizeLog2;
+	}
+
+	std::vector<size_t> getLevelSizes(uint32_t textureSize)
+	{
+		std::vector<size_t> levelSizes;
+		leoscene::ImageTexture::Compression compression = leoscene::ImageTexture::Compression::BC1;
+		for (const leoscene::ImageTexture::MipLevel& level : leoscene::getMipChain(leoscene::ImageTexture::getLayoutFromCompression(compression), compression, textureSize, textureSize)) {
+			levelSizes.push_back(level.size);
+		}
+		return levelSizes;
+	}
+
+	size_t getResidentSize(const std::vector<size_t>& levelSizes, uint32_t firstLevel)
+	{
+		size_t size = 0;
+		for (size_t level = firstLevel; level < levelSizes.size(); ++level) {
+			size += levelSizes[level];
+		}
+		return size;
+	}
+}
@@ -0,0 +1,180 @@
+#include <scene/BatchTransforms.h>
+#include <scene/Transform.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace {
+	void printUsage();
+
+	// Best time over the iterations, in milliseconds
+	template<typename Function>
+	double timeBest(uint32_t nbIterations, Function function);
+
+	float maxDifference(const float* a, const float* b, size_t nbFloats);
+	void printResult(const char* name, size_t count, double referenceMs, double kernelMs, float difference);
+}
+
+int main(int argc, const char** argv) {
+	size_t count = 1000000;
+	uint32_t nbIterations = 10;
+	for (int i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "--help")) {
+			printUsage();
+			return 0;
+		}
+		else if (!strcmp(argv[i], "--count") && i + 1 < argc) {
+			count = static_cast<size_t>(atoll(argv[++i]));
+		}
+		else if (!strcmp(argv[i], "--iterations") && i + 1 < argc) {
+			nbIterations = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else {
+			std::cerr << "Error: unknown argument \"" << argv[i] << "\"." << std::endl;
+			printUsage();
+			return 1;
+		}
+	}
+	if (!count || !nbIterations) {
+		std::cerr << "Error: --count and --iterations must be positive." << std::endl;
+		return 1;
+	}
+
+	// Random translation, rotation and scaling, like the instances of a scatter entry
+	std::mt19937 generator(42);
+	std::uniform_real_distribution<float> unit(-1.f, 1.f);
+	auto randomParameters = [&]() {
+		leoscene::TransformParameters parameters;
+		parameters.translation = glm::vec3(unit(generator), unit(generator), unit(generator)) * 100.f;
+		parameters.rotation_rads = glm::vec3(unit(generator), unit(generator), unit(generator)) * 3.14f;
+		parameters.scaling = glm::vec3(unit(generator), unit(generator), unit(generator)) * 0.5f + 1.f;
+		return parameters;
+	};
+
+	glm::mat4 instanceMatrix = leoscene::Transform::makeMatrix(randomParameters());
+	std::vector<glm::mat4> matrices(count);
+	std::vector<glm::vec4> spheres(count);
+	std::vector<leoscene::Transform> transforms(count);
+	for (size_t i = 0; i < count; ++i) {
+		leoscene::TransformParameters parameters = randomParameters();
+		matrices[i] = leoscene::Transform::makeMatrix(parameters);
+		transforms[i] = leoscene::Transform(parameters);
+		spheres[i] = glm::vec4(unit(generator), unit(generator), unit(generator), std::abs(unit(generator)) + 0.1f);
+	}
+
+	std::cout << "Instruction set:\t" << leoscene::getBatchTransformsInstructionSet() << std::endl;
+	std::cout << "Objects:\t" << count << ", best of " << nbIterations << " runs" << std::endl << std::endl;
+
+	/*
+	* Composition of an instance matrix with the matrices of the objects of a model (scene instantiation)
+	*/
+
+	{
+		std::vector<glm::mat4> reference(count);
+		std::vector<glm::mat4> results(count);
+		double referenceMs = timeBest(nbIterations, [&]() {
+			for (size_t i = 0; i < count; ++i) {
+				reference[i] = instanceMatrix * matrices[i];
+			}
+		});
+		double kernelMs = timeBest(nbIterations, [&]() {
+			leoscene::multiplyAffineMatrices(instanceMatrix, matrices.data(), results.data(), count);
+		});
+		printResult("Matrix composition", count, referenceMs, kernelMs, maxDifference(&reference[0][0][0], &results[0][0][0], count * 16));
+	}
+
+	/*
+	* World space bounding spheres (renderer upload)
+	*/
+
+	{
+		std::vector<glm::vec4> reference(count);
+		std::vector<glm::vec4> results(count);
+		double referenceMs = timeBest(nbIterations, [&]() {
+			for (size_t i = 0; i < count; ++i) {
+				const glm::mat4& modelMatrix = matrices[i];
+				const glm::vec4& sphereBounds = spheres[i];
+				glm::vec4 transformedSphere = modelMatrix * glm::vec4(sphereBounds.x, sphereBounds.y, sphereBounds.z, 1);
+				float maxScale = glm::max(glm::max(glm::length(modelMatrix[0]), glm::length(modelMatrix[1])), glm::length(modelMatrix[2]));
+				transformedSphere.w = maxScale * sphereBounds.w;
+				reference[i] = transformedSphere;
+			}
+		});
+		double kernelMs = timeBest(nbIterations, [&]() {
+			leoscene::transformBoundingSpheres(matrices.data(), spheres.data(), results.data(), count);
+		});
+		printResult("Bounding spheres", count, referenceMs, kernelMs, maxDifference(&reference[0][0], &results[0][0], count * 4));
+	}
+
+	/*
+	* Transform composition, with its inverse. The reference is the previous Transform::operator*=, which inverted the product.
+	*/
+
+	{
+		leoscene::Transform instanceTransform(instanceMatrix);
+		std::vector<glm::mat4> reference(count);
+		std::vector<glm::mat4> results(count);
+		double referenceMs = timeBest(nbIterations, [&]() {
+			for (size_t i = 0; i < count; ++i) {
+				glm::mat4 matrix = instanceTransform.getMatrix() * transforms[i].getMatrix();
+				reference[i] = glm::inverse(matrix);
+			}
+		});
+		double kernelMs = timeBest(nbIterations, [&]() {
+			for (size_t i = 0; i < count; ++i) {
+				results[i] = (instanceTransform * transforms[i]).getInvMatrix();
+			}
+		});
+		printResult("Transform composition", count, referenceMs, kernelMs, maxDifference(&reference[0][0][0], &results[0][0][0], count * 16));
+	}
+
+	return 0;
+}
+
+namespace {
+	void printUsage() {
+		std::cout << "Usage:" << std::endl
+			<< "\t" << "LeoTransformBench.exe [--count N] [--iterations N]" << "\t" << "Time the batch transform kernels against the equivalent glm loops." << std::endl
+			<< "\t" << "LeoTransformBench.exe --help" << "\t" << "Print this help." << std::endl;
+		std::cout << "Notes:" << std::endl
+			<< "\t" << "Defaults to 1000000 objects and 10 runs. The best run of each version is kept." << std::endl
+			<< "\t" << "The instruction set is chosen at build time (see LEO_ENABLE_AVX2 in CMakeLists.txt)." << std::endl << std::endl;
+	}
+
+	template<typename Function>
+	double timeBest(uint32_t nbIterations, Function function)
+	{
+		double best = 0;
+		for (uint32_t i = 0; i < nbIterations; ++i) {
+			auto start = std::chrono::steady_clock::now();
+			function();
+			double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			best = i ? std::min(best, milliseconds) : milliseconds;
+		}
+		return best;
+	}
+
+	// Relative to the magnitude of the values, so that large translations do not hide errors on small values
+	float maxDifference(const float* a, const float* b, size_t nbFloats)
+	{
+		float difference = 0;
+		for (size_t i = 0; i < nbFloats; ++i) {
+			difference = std::max(difference, std::abs(a[i] - b[i]) / std::max(1.f, std::abs(a[i])));
+		}
+		return difference;
+	}
+
+	void printResult(const char* name, size_t count, double referenceMs, double kernelMs, float difference)
+	{
+		std::cout << name << ":" << std::endl
+			<< "\t" << "glm loop:\t" << referenceMs << " ms\t(" << referenceMs * 1e6 / count << " ns per object)" << std::endl
+			<< "\t" << "Batch kernel:\t" << kernelMs << " ms\t(" << kernelMs * 1e6 / count << " ns per object)" << std::endl
+			<< "\t" << "Speedup:\t" << referenceMs / kernelMs << "x" << std::endl
+			<< "\t" << "Max relative difference:\t" << difference << std::endl;
+	}
+}